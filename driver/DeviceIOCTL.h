@@ -12,3 +12,18 @@ typedef struct _USER_RULE_REQUEST {
 #define IOCTL_ADD_RULE CTL_CODE(DEVICE_KARMOR, 0x800, METHOD_BUFFERED, FILE_WRITE_DATA)
 #define IOCTL_REMOVE_RULE CTL_CODE(DEVICE_KARMOR, 0x801, METHOD_BUFFERED, FILE_WRITE_DATA)
 
+//
+// Maps the event ring (EVENT_RING_HEADER) into the calling process, it stays
+// mapped until the handle the request was sent on is closed
+//
+typedef struct _EVENT_RING_MAP_REQUEST {
+    ULONGLONG Doorbell;         // event handle, signalled when the ring goes non-empty
+} EVENT_RING_MAP_REQUEST, * PEVENT_RING_MAP_REQUEST;
+
+typedef struct _EVENT_RING_MAP_RESPONSE {
+    ULONGLONG Base;             // section address in the calling process
+    ULONGLONG Size;
+} EVENT_RING_MAP_RESPONSE, * PEVENT_RING_MAP_RESPONSE;
+
+#define IOCTL_MAP_EVENT_RING CTL_CODE(DEVICE_KARMOR, 0x802, METHOD_BUFFERED, FILE_READ_DATA | FILE_WRITE_DATA)
+
@@ -0,0 +1,271 @@
+#include "EventBatch.h"
+#include "FastMutex.h"
+
+constexpr auto BATCH_TAG = 'btaB';
+
+typedef struct _EVENT_STAGING_AREA {
+    FastMutex Lock;
+    PUCHAR Frame;                   // EVENT_BATCH_FRAME_SIZE bytes, NULL if allocation failed
+    ULONG Used;
+    USHORT Count;
+    LARGE_INTEGER FirstEventTime;
+} EVENT_STAGING_AREA, * PEVENT_STAGING_AREA;
+
+static PEVENT_STAGING_AREA g_StagingAreas = NULL;
+static ULONG g_StagingAreaCount = 0;
+static NPAGED_LOOKASIDE_LIST g_FrameLookaside;
+static PETHREAD g_FlushThread = NULL;
+static KEVENT g_FlushStop;
+
+static PUCHAR AllocateFrame()
+{
+    return (PUCHAR)ExAllocateFromNPagedLookasideList(&g_FrameLookaside);
+}
+
+//
+//  Writes the frame header and hands the frame to the caller, the area
+//  continues with a fresh frame. Called with the area lock held.
+//
+static PUCHAR SealFrame(
+    _Inout_ PEVENT_STAGING_AREA Area,
+    _Out_ PULONG Length
+)
+{
+    PEVENT_BATCH_HEADER header = (PEVENT_BATCH_HEADER)Area->Frame;
+    header->magic = EVENT_BATCH_MAGIC;
+    header->version = EVENT_BATCH_VERSION;
+    header->count = Area->Count;
+    header->length = Area->Used;
+
+    PUCHAR frame = Area->Frame;
+    *Length = Area->Used;
+
+    Area->Frame = AllocateFrame();
+    Area->Used = sizeof(EVENT_BATCH_HEADER);
+    Area->Count = 0;
+
+    return frame;
+}
+
+//
+//  Sends a sealed frame without a reply buffer, so no thread waits on
+//  user-mode, and returns it to the lookaside list
+//
+static VOID SendFrame(
+    _In_ PUCHAR Frame,
+    _In_ ULONG Length
+)
+{
+    LARGE_INTEGER timeOut = { 0 };
+    timeOut.QuadPart = -10 * 1000 * 100; // 100 ms
+
+    NTSTATUS status = FltSendMessage(g_ScannerData.Filter,
+        &g_ScannerData.ClientPort,
+        Frame,
+        Length,
+        NULL,
+        NULL,
+        &timeOut);
+
+    if (status != STATUS_SUCCESS) {
+        DbgPrint("!!! couldn't send batch of %u events to user-mode, status 0x%X\n",
+            ((PEVENT_BATCH_HEADER)Frame)->count, status);
+    }
+
+    ExFreeToNPagedLookasideList(&g_FrameLookaside, Frame);
+}
+
+static VOID FlushThreadRoutine(
+    _In_ PVOID Context
+)
+{
+    UNREFERENCED_PARAMETER(Context);
+
+    LARGE_INTEGER interval = { 0 };
+    interval.QuadPart = -10 * 1000 * EVENT_BATCH_FLUSH_INTERVAL_MS;
+
+    while (KeWaitForSingleObject(&g_FlushStop, Executive, KernelMode, FALSE, &interval) == STATUS_TIMEOUT) {
+        FlushEventBatches(FALSE);
+    }
+
+    FlushEventBatches(TRUE);
+    PsTerminateSystemThread(STATUS_SUCCESS);
+}
+
+NTSTATUS InitializeEventBatching()
+{
+    ULONG count = KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS);
+
+    PEVENT_STAGING_AREA areas = (PEVENT_STAGING_AREA)ExAllocatePool2(POOL_FLAG_NON_PAGED,
+        count * sizeof(EVENT_STAGING_AREA), BATCH_TAG);
+    if (areas == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    ExInitializeNPagedLookasideList(&g_FrameLookaside, NULL, NULL, POOL_NX_ALLOCATION,
+        EVENT_BATCH_FRAME_SIZE, BATCH_TAG, 0);
+
+    for (ULONG i = 0; i < count; ++i) {
+        areas[i].Lock.Init();
+        areas[i].Frame = AllocateFrame();
+        areas[i].Used = sizeof(EVENT_BATCH_HEADER);
+        areas[i].Count = 0;
+    }
+
+    g_StagingAreas = areas;
+    g_StagingAreaCount = count;
+
+    KeInitializeEvent(&g_FlushStop, NotificationEvent, FALSE);
+
+    HANDLE thread = NULL;
+    NTSTATUS status = PsCreateSystemThread(&thread, THREAD_ALL_ACCESS, NULL, NULL, NULL,
+        FlushThreadRoutine, NULL);
+    if (NT_SUCCESS(status)) {
+        status = ObReferenceObjectByHandle(thread, THREAD_ALL_ACCESS, *PsThreadType,
+            KernelMode, (PVOID*)&g_FlushThread, NULL);
+        ZwClose(thread);
+    }
+
+    if (!NT_SUCCESS(status)) {
+        KdPrint(("failed to start batch flush thread (0x%08X)\n", status));
+        CleanupEventBatching();
+        return status;
+    }
+
+    KdPrint(("event batching enabled on %lu staging areas\n", count));
+    return STATUS_SUCCESS;
+}
+
+VOID StopEventBatching()
+{
+    //
+    //  The flush thread sends what is still staged before it exits
+    //
+    if (g_FlushThread != NULL) {
+        KeSetEvent(&g_FlushStop, IO_NO_INCREMENT, FALSE);
+        KeWaitForSingleObject(g_FlushThread, Executive, KernelMode, FALSE, NULL);
+        ObDereferenceObject(g_FlushThread);
+        g_FlushThread = NULL;
+    }
+}
+
+VOID CleanupEventBatching()
+{
+    if (g_StagingAreas == NULL) {
+        return;
+    }
+
+    PEVENT_STAGING_AREA areas = g_StagingAreas;
+    ULONG count = g_StagingAreaCount;
+    g_StagingAreas = NULL;
+    g_StagingAreaCount = 0;
+
+    for (ULONG i = 0; i < count; ++i) {
+        if (areas[i].Frame != NULL) {
+            ExFreeToNPagedLookasideList(&g_FrameLookaside, areas[i].Frame);
+        }
+    }
+
+    ExDeleteNPagedLookasideList(&g_FrameLookaside);
+    ExFreePoolWithTag(areas, BATCH_TAG);
+}
+
+NTSTATUS StageEvent(
+    _In_reads_bytes_(EventLength) PEVENT Event,
+    _In_ ULONG EventLength
+)
+{
+    ULONG recordLength = sizeof(EVENT_RECORD_HEADER) + EventLength;
+    ULONG alignedLength = ALIGN_UP_BY(recordLength, EVENT_RECORD_ALIGNMENT);
+    PUCHAR fullFrame = NULL;
+    ULONG fullLength = 0;
+
+    if (g_StagingAreas == NULL || g_ScannerData.ClientPort == NULL) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    if (sizeof(EVENT_BATCH_HEADER) + alignedLength > EVENT_BATCH_FRAME_SIZE) {
+        return STATUS_BUFFER_OVERFLOW;
+    }
+
+    //
+    //  The thread may move to another CPU after this, the area lock keeps
+    //  that correct; the index only spreads producers over the areas
+    //
+    PEVENT_STAGING_AREA area = &g_StagingAreas[KeGetCurrentProcessorNumberEx(NULL) % g_StagingAreaCount];
+
+    NTSTATUS status = STATUS_SUCCESS;
+
+    {
+        Locker<FastMutex> locker(area->Lock);
+
+        if (area->Frame == NULL) {
+            area->Frame = AllocateFrame();
+        }
+
+        if (area->Frame != NULL && area->Used + alignedLength > EVENT_BATCH_FRAME_SIZE) {
+            fullFrame = SealFrame(area, &fullLength);
+        }
+
+        if (area->Frame == NULL) {
+            //
+            //  No frame to stage into, the caller sends the event on its own
+            //
+            status = STATUS_INSUFFICIENT_RESOURCES;
+        }
+        else {
+            if (area->Count == 0) {
+                KeQuerySystemTime(&area->FirstEventTime);
+            }
+
+            PEVENT_RECORD_HEADER record = (PEVENT_RECORD_HEADER)(area->Frame + area->Used);
+            record->length = recordLength;
+            record->reserved = 0;
+            RtlCopyMemory(record + 1, Event, EventLength);
+            RtlZeroMemory((PUCHAR)record + recordLength, alignedLength - recordLength);
+
+            area->Used += alignedLength;
+            area->Count++;
+
+            if (area->Count >= EVENT_BATCH_MAX_RECORDS && fullFrame == NULL) {
+                fullFrame = SealFrame(area, &fullLength);
+            }
+        }
+    }
+
+    //
+    //  Sent outside the lock so other threads on this CPU keep staging
+    //
+    if (fullFrame != NULL) {
+        SendFrame(fullFrame, fullLength);
+    }
+
+    return status;
+}
+
+VOID FlushEventBatches(
+    _In_ BOOLEAN Force
+)
+{
+    LARGE_INTEGER now;
+    KeQuerySystemTime(&now);
+
+    for (ULONG i = 0; i < g_StagingAreaCount; ++i) {
+        PEVENT_STAGING_AREA area = &g_StagingAreas[i];
+        PUCHAR frame = NULL;
+        ULONG length = 0;
+
+        {
+            Locker<FastMutex> locker(area->Lock);
+
+            if (area->Count > 0 && (Force ||
+                now.QuadPart - area->FirstEventTime.QuadPart >= 10 * 1000 * EVENT_BATCH_FLUSH_INTERVAL_MS)) {
+                frame = SealFrame(area, &length);
+            }
+        }
+
+        if (frame != NULL) {
+            SendFrame(frame, length);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Filter.h"
+
+//
+//  Per-CPU staging of audit-only events into batch frames (see
+//  EVENT_BATCH_HEADER). A frame is sent when it is full, holds
+//  EVENT_BATCH_MAX_RECORDS events, or its first event is older than
+//  EVENT_BATCH_FLUSH_INTERVAL_MS.
+//
+
+NTSTATUS InitializeEventBatching();
+
+//
+//  Stops the flush thread after it sent what is staged, call while the
+//  client port is still open
+//
+VOID StopEventBatching();
+
+//
+//  Frees the staging areas, call once no filter callback can run
+//
+VOID CleanupEventBatching();
+
+//
+//  Copies the event into the staging area of the current CPU. Fails if
+//  batching is unavailable or the event does not fit a frame, the caller
+//  then sends the event on its own.
+//
+NTSTATUS StageEvent(
+    _In_reads_bytes_(EventLength) PEVENT Event,
+    _In_ ULONG EventLength
+);
+
+VOID FlushEventBatches(
+    _In_ BOOLEAN Force
+);
@@ -0,0 +1,302 @@
+#include "EventRing.h"
+#include "FastMutex.h"
+
+typedef struct _EVENT_RING {
+    FastMutex Lock;                 // serializes writers and map/unmap
+    PEVENT_RING_HEADER Header;      // kernel view of the section
+    PUCHAR Data;
+    PMDL Mdl;                       // describes the section's own pages
+    ULONGLONG WriteIndex;           // ours, the header copy is only published to
+    ULONGLONG ReadIndex;            // last read_index seen
+
+    // set while mapped
+    PVOID UserBase;
+    PEPROCESS Owner;
+    PFILE_OBJECT OwnerFile;
+    PKEVENT Doorbell;
+    EX_RUNDOWN_REF Rundown;         // writers inside the ring
+} EVENT_RING, * PEVENT_RING;
+
+static EVENT_RING g_Ring;
+static BOOLEAN g_RingInitialized = FALSE;
+
+static ULONG AlignRecord(ULONG Length)
+{
+    return ALIGN_UP_BY(Length, EVENT_RECORD_ALIGNMENT);
+}
+
+//
+//  Kept apart from callers holding a Locker, __try does not mix with
+//  object unwinding
+//
+static PVOID MapIntoCurrentProcess(
+    _In_ PMDL Mdl
+)
+{
+    PVOID base = NULL;
+
+    __try {
+        base = MmMapLockedPagesSpecifyCache(Mdl, UserMode, MmCached, NULL, FALSE,
+            NormalPagePriority | MdlMappingNoExecute);
+    }
+    __except (EXCEPTION_EXECUTE_HANDLER) {
+        base = NULL;
+    }
+
+    return base;
+}
+
+static VOID FormatRing()
+{
+    RtlZeroMemory(g_Ring.Header, EVENT_RING_DATA_OFFSET);
+    g_Ring.Header->magic = EVENT_RING_MAGIC;
+    g_Ring.Header->version = EVENT_RING_VERSION;
+    g_Ring.Header->header_size = EVENT_RING_DATA_OFFSET;
+    g_Ring.Header->capacity = EVENT_RING_CAPACITY;
+
+    g_Ring.WriteIndex = 0;
+    g_Ring.ReadIndex = 0;
+}
+
+//
+//  Releases the user view, called with the lock held and no writer inside
+//
+static VOID ReleaseMapping()
+{
+    KAPC_STATE apcState;
+    BOOLEAN attached = FALSE;
+
+    //
+    //  The view belongs to the process that mapped it
+    //
+    if (PsGetCurrentProcess() != g_Ring.Owner) {
+        KeStackAttachProcess(g_Ring.Owner, &apcState);
+        attached = TRUE;
+    }
+
+    MmUnmapLockedPages(g_Ring.UserBase, g_Ring.Mdl);
+
+    if (attached) {
+        KeUnstackDetachProcess(&apcState);
+    }
+
+    ObDereferenceObject(g_Ring.Doorbell);
+    ObDereferenceObject(g_Ring.Owner);
+
+    g_Ring.UserBase = NULL;
+    g_Ring.Owner = NULL;
+    g_Ring.OwnerFile = NULL;
+    g_Ring.Doorbell = NULL;
+}
+
+NTSTATUS InitializeEventRing()
+{
+    PHYSICAL_ADDRESS lowAddress, highAddress, skipBytes;
+    lowAddress.QuadPart = 0;
+    highAddress.QuadPart = MAXLONGLONG;
+    skipBytes.QuadPart = 0;
+
+    //
+    //  Pages of its own rather than pool, only those may be mapped into the
+    //  service. They come zeroed, and all of them or none.
+    //
+    PMDL mdl = MmAllocatePagesForMdlEx(lowAddress, highAddress, skipBytes, EVENT_RING_SECTION_SIZE,
+        MmCached, MM_ALLOCATE_FULLY_REQUIRED);
+    if (mdl == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    PVOID section = MmGetSystemAddressForMdlSafe(mdl, NormalPagePriority | MdlMappingNoExecute);
+    if (section == NULL) {
+        MmFreePagesFromMdl(mdl);
+        ExFreePool(mdl);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    RtlZeroMemory(&g_Ring, sizeof(g_Ring));
+    g_Ring.Lock.Init();
+    g_Ring.Header = (PEVENT_RING_HEADER)section;
+    g_Ring.Data = (PUCHAR)section + EVENT_RING_DATA_OFFSET;
+    g_Ring.Mdl = mdl;
+
+    //
+    //  Run down until a service maps the ring, writers fail fast
+    //
+    ExInitializeRundownProtection(&g_Ring.Rundown);
+    ExWaitForRundownProtectionRelease(&g_Ring.Rundown);
+
+    g_RingInitialized = TRUE;
+
+    KdPrint(("event ring of %lu bytes ready\n", (ULONG)EVENT_RING_CAPACITY));
+    return STATUS_SUCCESS;
+}
+
+VOID CleanupEventRing()
+{
+    if (!g_RingInitialized) {
+        return;
+    }
+
+    ExWaitForRundownProtectionRelease(&g_Ring.Rundown);
+
+    {
+        Locker<FastMutex> locker(g_Ring.Lock);
+        if (g_Ring.UserBase != NULL) {
+            ReleaseMapping();
+        }
+    }
+
+    g_RingInitialized = FALSE;
+    MmUnmapLockedPages(g_Ring.Header, g_Ring.Mdl);
+    MmFreePagesFromMdl(g_Ring.Mdl);
+    ExFreePool(g_Ring.Mdl);
+}
+
+NTSTATUS MapEventRing(
+    _In_ HANDLE Doorbell,
+    _In_ PFILE_OBJECT FileObject,
+    _Out_ PEVENT_RING_MAP_RESPONSE Response
+)
+{
+    RtlZeroMemory(Response, sizeof(*Response));
+
+    if (!g_RingInitialized) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    PKEVENT doorbell = NULL;
+    NTSTATUS status = ObReferenceObjectByHandle(Doorbell, EVENT_MODIFY_STATE, *ExEventObjectType,
+        UserMode, (PVOID*)&doorbell, NULL);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+
+    Locker<FastMutex> locker(g_Ring.Lock);
+
+    if (g_Ring.UserBase != NULL) {
+        ObDereferenceObject(doorbell);
+        return STATUS_DEVICE_BUSY;
+    }
+
+    //
+    //  No writer is inside while the ring is run down, start from empty
+    //
+    FormatRing();
+
+    PVOID userBase = MapIntoCurrentProcess(g_Ring.Mdl);
+    if (userBase == NULL) {
+        ObDereferenceObject(doorbell);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    g_Ring.UserBase = userBase;
+    g_Ring.Owner = PsGetCurrentProcess();
+    ObReferenceObject(g_Ring.Owner);
+    g_Ring.OwnerFile = FileObject;
+    g_Ring.Doorbell = doorbell;
+
+    ExReInitializeRundownProtection(&g_Ring.Rundown);
+
+    Response->Base = (ULONGLONG)(ULONG_PTR)userBase;
+    Response->Size = EVENT_RING_SECTION_SIZE;
+
+    DbgPrint("!!! event ring mapped at 0x%p\n", userBase);
+    return STATUS_SUCCESS;
+}
+
+VOID UnmapEventRing(
+    _In_ PFILE_OBJECT FileObject
+)
+{
+    if (!g_RingInitialized || g_Ring.OwnerFile != FileObject) {
+        return;
+    }
+
+    //
+    //  Writers take the lock inside their rundown reference, wait for them
+    //  before taking it
+    //
+    ExWaitForRundownProtectionRelease(&g_Ring.Rundown);
+
+    Locker<FastMutex> locker(g_Ring.Lock);
+    if (g_Ring.UserBase != NULL && g_Ring.OwnerFile == FileObject) {
+        DbgPrint("!!! event ring unmapped, %lld events overflowed\n", g_Ring.Header->overflow_records);
+        ReleaseMapping();
+    }
+}
+
+NTSTATUS WriteRingEvent(
+    _In_reads_bytes_(EventLength) PEVENT Event,
+    _In_ ULONG EventLength
+)
+{
+    if (!g_RingInitialized || !ExAcquireRundownProtection(&g_Ring.Rundown)) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    PEVENT_RING_HEADER header = g_Ring.Header;
+    ULONG length = sizeof(EVENT_RING_RECORD) + EventLength;
+    ULONG padded = AlignRecord(length);
+    NTSTATUS status = STATUS_SUCCESS;
+    BOOLEAN ringDoorbell = FALSE;
+
+    {
+        Locker<FastMutex> locker(g_Ring.Lock);
+
+        ULONGLONG position = g_Ring.WriteIndex & (EVENT_RING_CAPACITY - 1);
+        ULONGLONG tailRoom = EVENT_RING_CAPACITY - position;
+        ULONGLONG needed = padded > tailRoom ? tailRoom + padded : padded;
+
+        //
+        //  Only look at the service's index when the space we last saw runs
+        //  out. A value behind or ahead of what we wrote leaves no space.
+        //
+        if (needed > EVENT_RING_CAPACITY - (g_Ring.WriteIndex - g_Ring.ReadIndex)) {
+            ULONGLONG readIndex = (ULONGLONG)ReadAcquire64(&header->read_index);
+            if (readIndex <= g_Ring.WriteIndex && g_Ring.WriteIndex - readIndex <= EVENT_RING_CAPACITY) {
+                g_Ring.ReadIndex = readIndex;
+            }
+        }
+
+        if (needed > EVENT_RING_CAPACITY - (g_Ring.WriteIndex - g_Ring.ReadIndex)) {
+            InterlockedIncrement64(&header->overflow_records);
+            InterlockedAdd64(&header->overflow_bytes, EventLength);
+            status = STATUS_BUFFER_OVERFLOW;
+        }
+        else {
+            if (padded > tailRoom) {
+                PEVENT_RING_RECORD wrap = (PEVENT_RING_RECORD)(g_Ring.Data + position);
+                wrap->length = (ULONG)tailRoom;
+                wrap->type = EVENT_RING_RECORD_WRAP;
+                g_Ring.WriteIndex += tailRoom;
+                position = 0;
+            }
+
+            PEVENT_RING_RECORD record = (PEVENT_RING_RECORD)(g_Ring.Data + position);
+            record->length = length;
+            record->type = EVENT_RING_RECORD_EVENT;
+            RtlCopyMemory(record + 1, Event, EventLength);
+            RtlZeroMemory((PUCHAR)record + length, padded - length);
+            g_Ring.WriteIndex += padded;
+
+            //
+            //  Publish with a full barrier, then look for a parked consumer
+            //
+            InterlockedExchange64(&header->write_index, (LONG64)g_Ring.WriteIndex);
+            if (InterlockedCompareExchange(&header->consumer_waiting, 0, 1) == 1) {
+                InterlockedIncrement64(&header->doorbells);
+                ringDoorbell = TRUE;
+            }
+        }
+    }
+
+    //
+    //  Signalled outside the lock so other writers keep going
+    //
+    if (ringDoorbell) {
+        KeSetEvent(g_Ring.Doorbell, IO_NO_INCREMENT, FALSE);
+    }
+
+    ExReleaseRundownProtection(&g_Ring.Rundown);
+    return status;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Filter.h"
+#include "DeviceIOCTL.h"
+
+//
+//  Shared event ring (see EVENT_RING_HEADER). The section is allocated once,
+//  mapped into the service on IOCTL_MAP_EVENT_RING and unmapped when the
+//  handle it was mapped through is cleaned up.
+//
+
+NTSTATUS InitializeEventRing();
+
+//
+//  Unmaps the ring if the service still has it and frees the section, call
+//  once no filter callback can run
+//
+VOID CleanupEventRing();
+
+NTSTATUS MapEventRing(
+    _In_ HANDLE Doorbell,
+    _In_ PFILE_OBJECT FileObject,
+    _Out_ PEVENT_RING_MAP_RESPONSE Response
+);
+
+VOID UnmapEventRing(
+    _In_ PFILE_OBJECT FileObject
+);
+
+//
+//  Copies the event into the ring. Fails if no service mapped it or the
+//  event does not fit the free space (counted as an overflow), the caller
+//  then sends the event over the port.
+//
+NTSTATUS WriteRingEvent(
+    _In_reads_bytes_(EventLength) PEVENT Event,
+    _In_ ULONG EventLength
+);
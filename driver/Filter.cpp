@@ -1,4 +1,6 @@
 #include "Filter.h"
+#include "EventBatch.h"
+#include "EventRing.h"
 #include "FilenameInformationGuard.h"
 
 constexpr auto EVENT_TAG = 'evnt';
@@ -103,7 +105,9 @@ FLT_PREOP_CALLBACK_STATUS FLTAPI PreOperationCreate(
             event->type = EventType_HostLog;
             event->operation = EventOperation_File;
             KeQuerySystemTime((LARGE_INTEGER*)&event->timestamp);
+            event->sequence = (ULONGLONG)InterlockedIncrement64(&g_ScannerData.EventSequence);
             event->blocked = false;
+            event->flags = 0;   // audit only, user-mode may acknowledge before processing
             event->data.File.ProcessId = (ULONG)(ULONG_PTR)PsGetCurrentProcessId();
             event->data.File.Operation = 0;
 
@@ -130,6 +134,16 @@ FLT_PREOP_CALLBACK_STATUS FLTAPI PreOperationCreate(
                 event->data.File.FilePathOffset = 0;
             }
 
+            //
+            // Audit-only events go to the shared ring when the service mapped
+            // it, otherwise out in batch frames; nothing waits on them
+            //
+            if (!(event->flags & EVENT_FLAG_VERDICT_REQUIRED) &&
+                (NT_SUCCESS(WriteRingEvent(event, eventLength)) ||
+                    NT_SUCCESS(StageEvent(event, eventLength)))) {
+                __leave;
+            }
+
             NTSTATUS status = FltSendMessage(g_ScannerData.Filter,
                 &g_ScannerData.ClientPort,
                 event,
@@ -228,6 +242,12 @@ Return Value
     //  the filter.
     //
 
+    //
+    //  Sequence numbers start over with every connection, before events
+    //  can be sent on it
+    //
+    InterlockedExchange64(&g_ScannerData.EventSequence, 0);
+
     g_ScannerData.UserProcess = PsGetCurrentProcess();
     g_ScannerData.ClientPort = ClientPort;
 
@@ -286,6 +306,8 @@ NTSTATUS FLTAPI InstanceFilterUnloadCallback(_In_ FLT_FILTER_UNLOAD_FLAGS Flags)
     // This is called before a filter is unloaded.
     // If NULL is specified for this routine, then the filter can never be unloaded.
     //
+    StopEventBatching();
+
     if (g_ScannerData.ClientPort) {
         FltCloseClientPort(g_ScannerData.Filter, &g_ScannerData.ClientPort);
     }
@@ -299,6 +321,9 @@ NTSTATUS FLTAPI InstanceFilterUnloadCallback(_In_ FLT_FILTER_UNLOAD_FLAGS Flags)
         FltUnregisterFilter(g_ScannerData.Filter);
     }
 
+    CleanupEventBatching();
+    CleanupEventRing();
+
     return STATUS_SUCCESS;
 }
 
@@ -382,6 +407,24 @@ NTSTATUS RegisterFilter(
         FltFreeSecurityDescriptor(sd);
 
         if (NT_SUCCESS(status)) {
+            //
+            // stage audit-only events in batch frames, without it every
+            // event is sent on its own
+            //
+            NTSTATUS batchStatus = InitializeEventBatching();
+            if (!NT_SUCCESS(batchStatus)) {
+                KdPrint(("event batching disabled (0x%08X)\n", batchStatus));
+            }
+
+            //
+            // shared ring the service may map, without it audit-only events
+            // go over the port
+            //
+            NTSTATUS ringStatus = InitializeEventRing();
+            if (!NT_SUCCESS(ringStatus)) {
+                KdPrint(("event ring disabled (0x%08X)\n", ringStatus));
+            }
+
             //
             // start minifilter driver
             //
@@ -391,6 +434,9 @@ NTSTATUS RegisterFilter(
                 return STATUS_SUCCESS;
             }
 
+            StopEventBatching();
+            CleanupEventBatching();
+            CleanupEventRing();
             FltCloseCommunicationPort(g_ScannerData.ServerPort);
         }
     }
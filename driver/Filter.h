@@ -90,6 +90,7 @@ typedef struct _SCANNER_DATA {
     PFLT_PORT ServerPort;
     PEPROCESS UserProcess;
     PFLT_PORT ClientPort;
+    volatile LONG64 EventSequence;  // last EVENT.sequence handed out on this connection
 
 } SCANNER_DATA, * PSCANNER_DATA;
 
@@ -144,21 +145,109 @@ typedef struct _NETWORK_EVENT {
     UCHAR address_family;
 } NETWORK_EVENT, * PNETWORK_EVENT;
 
+//
+//  EVENT flags, the byte after 'blocked' was padding so older
+//  user-mode builds read it as 0
+//
+#define EVENT_FLAG_VERDICT_REQUIRED 0x01    // reply only after the event was evaluated
+
 typedef struct _EVENT {
     ULONGLONG timestamp;
     FS_EVENT_TYPE type;
     FS_EVENT_OPERATION operation;
     BOOLEAN blocked;
+    UCHAR flags;
     union {
         FILE_EVENT File;
         PROCESS_EVENT Process;
         NETWORK_EVENT Network;
     } data;
+    ULONGLONG sequence;     // per connection, from 1: numbers that never arrive were lost
 } EVENT, * PEVENT;
 
 typedef struct _REPLY {
     BOOLEAN ack;
 } EVENT_REPLY, * PEVENT_REPLY;
 
+//
+//  Batch frames. Audit-only events are staged per CPU and sent together in
+//  one FltSendMessage without a reply buffer. A frame is an
+//  EVENT_BATCH_HEADER followed by 'count' records; each record is an
+//  EVENT_RECORD_HEADER and an EVENT with its strings (offsets relative to
+//  that EVENT) and starts on an EVENT_RECORD_ALIGNMENT boundary.
+//
+//  The magic sits where a single EVENT has its timestamp and has the sign
+//  bit set, which KeQuerySystemTime never returns, so user-mode can tell
+//  frames and single events apart.
+//
+#define EVENT_BATCH_MAGIC               0x8000000042544348ULL
+#define EVENT_BATCH_VERSION             1
+#define EVENT_RECORD_ALIGNMENT          8
+
+#define EVENT_BATCH_FRAME_SIZE          MAX_FILTER_EVENT_SIZE
+#define EVENT_BATCH_MAX_RECORDS         64
+#define EVENT_BATCH_FLUSH_INTERVAL_MS   2       // longest an event waits in a frame
+
+typedef struct _EVENT_BATCH_HEADER {
+    ULONGLONG magic;
+    USHORT version;
+    USHORT count;
+    ULONG length;           // header and records, in bytes
+} EVENT_BATCH_HEADER, * PEVENT_BATCH_HEADER;
+
+typedef struct _EVENT_RECORD_HEADER {
+    ULONG length;           // record header, EVENT and strings, before padding
+    ULONG reserved;
+} EVENT_RECORD_HEADER, * PEVENT_RECORD_HEADER;
+
+//
+//  Shared event ring. The service maps a non-paged section through
+//  IOCTL_MAP_EVENT_RING and audit-only events are written into it instead
+//  of being sent as messages. Indices count bytes since the ring was
+//  formatted; records start on an EVENT_RECORD_ALIGNMENT boundary and never
+//  straddle the end of the data area, an EVENT_RING_RECORD_WRAP pads it.
+//
+//  The service sets consumer_waiting before it sleeps on the doorbell, the
+//  writer that clears it sets the doorbell event. Everything in the section
+//  is writable from user-mode, the driver keeps its own indices and only
+//  reads read_index to find free space.
+//
+#define EVENT_RING_MAGIC                0x0031474E4952414BULL   // "KARING1"
+#define EVENT_RING_VERSION              1
+#define EVENT_RING_DATA_OFFSET          PAGE_SIZE
+#define EVENT_RING_CAPACITY             (1024 * 1024)           // power of two
+#define EVENT_RING_SECTION_SIZE         (EVENT_RING_DATA_OFFSET + EVENT_RING_CAPACITY)
+
+#define EVENT_RING_RECORD_EVENT         1
+#define EVENT_RING_RECORD_WRAP          2
+
+typedef struct _EVENT_RING_HEADER {
+    ULONGLONG magic;
+    ULONG version;
+    ULONG header_size;              // data area offset
+    ULONGLONG capacity;
+    UCHAR reserved0[40];
+
+    // written by the driver
+    volatile LONG64 write_index;
+    volatile LONG64 overflow_records;   // did not fit, sent over the port instead
+    volatile LONG64 overflow_bytes;
+    volatile LONG64 doorbells;
+    UCHAR reserved1[32];
+
+    // written by the service
+    volatile LONG64 read_index;
+    volatile LONG consumer_waiting;
+    ULONG reserved2;
+    UCHAR reserved3[48];
+} EVENT_RING_HEADER, * PEVENT_RING_HEADER;
+
+typedef struct _EVENT_RING_RECORD {
+    ULONG length;           // record header, EVENT and strings, before padding
+    ULONG type;             // EVENT_RING_RECORD_*
+} EVENT_RING_RECORD, * PEVENT_RING_RECORD;
+
+C_ASSERT(sizeof(EVENT_RING_HEADER) == 192);
+
 #pragma pack(pop)
 #endif // !__FILTER_H__
@@ -1,6 +1,7 @@
 #include "Filter.h"
 #include "ETW.h"
 #include "DeviceIOCTL.h"
+#include "EventRing.h"
 #include "Globals.h"
 
 Globals g_State;
@@ -9,7 +10,7 @@ BOOLEAN g_ProcessNotifyRegistered = FALSE, g_SymLinkCreated = FALSE;
 
 void OnProcessNotify(_Inout_ PEPROCESS Process, _In_ HANDLE ProcessId, _Inout_opt_ PPS_CREATE_NOTIFY_INFO CreateInfo);
 VOID LogProcessEvent(RuleAction action, PPROCESS_EVENT_DATA EventData);
-DRIVER_DISPATCH KarmorDeviceControl, KarmorCreateClose;
+DRIVER_DISPATCH KarmorDeviceControl, KarmorCreateClose, KarmorCleanup;
 
 void KarmorUnload(PDRIVER_OBJECT DriverObject) {
     if (g_ProcessNotifyRegistered)
@@ -70,6 +71,7 @@ DriverEntry(PDRIVER_OBJECT DriverObject, PUNICODE_STRING RegistryPath) {
 
     DriverObject->DriverUnload = KarmorUnload;
     DriverObject->MajorFunction[IRP_MJ_CREATE] = DriverObject->MajorFunction[IRP_MJ_CLOSE] = KarmorCreateClose;
+    DriverObject->MajorFunction[IRP_MJ_CLEANUP] = KarmorCleanup;
     DriverObject->MajorFunction[IRP_MJ_DEVICE_CONTROL] = KarmorDeviceControl;
 
     UNICODE_STRING devName = RTL_CONSTANT_STRING(L"\\Device\\Karmor");
@@ -224,6 +226,15 @@ NTSTATUS KarmorCreateClose(PDEVICE_OBJECT, PIRP Irp) {
     return CompleteIrp(Irp);
 }
 
+NTSTATUS KarmorCleanup(PDEVICE_OBJECT, PIRP Irp) {
+    //
+    // runs in the context of the process closing its last handle, the event
+    // ring view mapped through this handle goes with it
+    //
+    UnmapEventRing(IoGetCurrentIrpStackLocation(Irp)->FileObject);
+    return CompleteIrp(Irp);
+}
+
 NTSTATUS KarmorDeviceControl(PDEVICE_OBJECT DeviceObject, PIRP Irp) {
     UNREFERENCED_PARAMETER(DeviceObject);
 
@@ -286,6 +297,29 @@ NTSTATUS KarmorDeviceControl(PDEVICE_OBJECT DeviceObject, PIRP Irp) {
         break;
     }
 
+    case IOCTL_MAP_EVENT_RING: {
+        if (Irp->RequestorMode != UserMode) {
+            status = STATUS_INVALID_DEVICE_REQUEST;
+            break;
+        }
+
+        if (stack->Parameters.DeviceIoControl.InputBufferLength < sizeof(EVENT_RING_MAP_REQUEST) ||
+            stack->Parameters.DeviceIoControl.OutputBufferLength < sizeof(EVENT_RING_MAP_RESPONSE)) {
+            status = STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        PEVENT_RING_MAP_REQUEST request = (PEVENT_RING_MAP_REQUEST)Irp->AssociatedIrp.SystemBuffer;
+        EVENT_RING_MAP_RESPONSE response;
+
+        status = MapEventRing((HANDLE)(ULONG_PTR)request->Doorbell, stack->FileObject, &response);
+        if (NT_SUCCESS(status)) {
+            RtlCopyMemory(Irp->AssociatedIrp.SystemBuffer, &response, sizeof(response));
+            info = sizeof(response);
+        }
+        break;
+    }
+
     default:
         status = STATUS_INVALID_DEVICE_REQUEST;
         break;
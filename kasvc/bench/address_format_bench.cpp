@@ -0,0 +1,238 @@
+// Network address benchmark. NetworkEventData keeps addresses as
+// data::IpAddress (16 bytes and a family) and sinks format them through
+// data::AddressFormatCache; before, the parser ran inet_ntop twice per event
+// and stored two std::strings. This
+//  - checks the cache against inet_ntop for random IPv4 and IPv6 addresses,
+//    from several threads sharing slots
+//  - compares the parse-side cost and the size of both layouts
+//  - times sink formatting with and without the cache for working sets of
+//    1 to 64K distinct addresses at 1 to 4 threads
+//  - times a filter on remote addresses, binary against text keys
+
+#include "data/ip_address.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+using namespace kubearmor;
+
+namespace {
+
+    // NetworkEventData's address fields before this change
+    struct LegacyAddresses {
+        std::string local_address;
+        std::string remote_address;
+    };
+
+    struct Addresses {
+        data::IpAddress local_address;
+        data::IpAddress remote_address;
+    };
+
+    // What MessageParser::FormatIPAddress did per address
+    std::string LegacyFormat(const uint8_t* addr, bool v6) {
+        char buffer[INET6_ADDRSTRLEN] = { 0 };
+        if (!v6) {
+            struct in_addr addr4;
+            std::memcpy(&addr4, addr, sizeof(addr4));
+            inet_ntop(AF_INET, &addr4, buffer, sizeof(buffer));
+        }
+        else {
+            struct in6_addr addr6;
+            std::memcpy(&addr6, addr, sizeof(addr6));
+            inet_ntop(AF_INET6, &addr6, buffer, sizeof(buffer));
+        }
+        return std::string(buffer);
+    }
+
+    struct RawAddress {
+        uint8_t bytes[16];
+        bool v6;
+    };
+
+    // Connection-heavy host: a quarter IPv6, some with long zero runs
+    std::vector<RawAddress> MakeAddresses(size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::vector<RawAddress> addresses(count);
+        for (auto& a : addresses) {
+            std::memset(a.bytes, 0, sizeof(a.bytes));
+            a.v6 = rng() % 4 == 0;
+            size_t bytes = a.v6 ? 16 : 4;
+            for (size_t i = 0; i < bytes; ++i) {
+                a.bytes[i] = static_cast<uint8_t>(rng());
+            }
+            if (a.v6 && rng() % 2) {
+                std::memset(a.bytes + 4, 0, 8);
+            }
+        }
+        return addresses;
+    }
+
+    data::IpAddress ToIpAddress(const RawAddress& raw) {
+        return data::IpAddress::FromBytes(raw.bytes, raw.v6 ? data::AddressFamily::IPV6 : data::AddressFamily::IPV4);
+    }
+
+    bool Check(size_t count) {
+        auto raw = MakeAddresses(count, 1);
+        // Few slots, so the threads below collide on them all the time
+        data::AddressFormatCache cache(64);
+
+        std::atomic<size_t> failures{ 0 };
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t] {
+                for (size_t i = 0; i < raw.size(); ++i) {
+                    const auto& a = raw[(i * (t + 1)) % raw.size()];
+                    if (cache.Format(ToIpAddress(a)).view() != LegacyFormat(a.bytes, a.v6)) {
+                        failures++;
+                    }
+                }
+                });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        bool ok = failures == 0 && cache.Format(data::IpAddress()).view().empty();
+        std::printf("check          : %zu addresses x 4 threads, %zu mismatches -> %s\n",
+            count, failures.load(), ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    template<typename Work>
+    double NsPerItem(size_t items, Work work) {
+        auto start = std::chrono::steady_clock::now();
+        size_t sink = work();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (sink == 1) std::printf(" ");    // keep the work
+        return elapsed * 1e9 / items;
+    }
+
+    // Million formats per second over all threads
+    double FormatRate(const std::vector<data::IpAddress>& addresses, size_t threads, size_t rounds, bool cached,
+        data::AddressFormatCache& cache) {
+
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                size_t sink = 0;
+                for (size_t r = 0; r < rounds; ++r) {
+                    for (size_t i = t; i < addresses.size() + t; ++i) {
+                        const auto& a = addresses[i % addresses.size()];
+                        sink += cached ? cache.Format(a).view().size() :
+                            data::AddressFormatCache::FormatUncached(a).view().size();
+                    }
+                }
+                if (sink == 1) std::printf(" ");
+                });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(threads * rounds * addresses.size()) / elapsed / 1e6;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    std::printf("=== network addresses ===\n");
+    bool ok = Check(100000);
+
+    // 4096, the filter below indexes with & 4095
+    auto raw = MakeAddresses(4096, 2);
+
+    std::vector<LegacyAddresses> legacy(raw.size());
+    double legacy_ns = NsPerItem(events, [&] {
+        size_t sink = 0;
+        for (size_t i = 0; i < events; ++i) {
+            const auto& a = raw[i % raw.size()];
+            const auto& b = raw[(i + 1) % raw.size()];
+            auto& out = legacy[i % legacy.size()];
+            out.local_address = LegacyFormat(a.bytes, a.v6);
+            out.remote_address = LegacyFormat(b.bytes, b.v6);
+            sink += out.remote_address.size();
+        }
+        return sink;
+        });
+
+    std::vector<Addresses> binary(raw.size());
+    double binary_ns = NsPerItem(events, [&] {
+        size_t sink = 0;
+        for (size_t i = 0; i < events; ++i) {
+            const auto& a = raw[i % raw.size()];
+            const auto& b = raw[(i + 1) % raw.size()];
+            auto& out = binary[i % binary.size()];
+            out.local_address = ToIpAddress(a);
+            out.remote_address = ToIpAddress(b);
+            sink += out.remote_address.bytes[0];
+        }
+        return sink;
+        });
+
+    std::printf("\nparse side, per event (local + remote):\n");
+    std::printf("  %-10s %8s %10s\n", "layout", "sizeof", "ns");
+    std::printf("  %-10s %8zu %10.1f  (plus heap for IPv6 text)\n", "strings", sizeof(LegacyAddresses), legacy_ns);
+    std::printf("  %-10s %8zu %10.1f\n", "binary", sizeof(Addresses), binary_ns);
+
+    std::printf("\nsink formatting, million addresses/s:\n");
+    std::printf("  %-10s %-8s %12s %12s %10s\n", "distinct", "threads", "inet_ntop", "cache", "hit rate");
+    for (size_t distinct : { 1, 256, 4096, 65536 }) {
+        std::vector<data::IpAddress> addresses;
+        for (const auto& a : MakeAddresses(distinct, 3)) {
+            addresses.push_back(ToIpAddress(a));
+        }
+        size_t rounds = std::max<size_t>(1, 400000 / distinct);
+
+        for (size_t threads : { 1, 4 }) {
+            data::AddressFormatCache cache;
+            double direct = FormatRate(addresses, threads, rounds, false, cache);
+            double cached = FormatRate(addresses, threads, rounds, true, cache);
+            auto stats = cache.GetStatistics();
+            std::printf("  %-10zu %-8zu %12.2f %12.2f %9.1f%%\n", distinct, threads, direct, cached,
+                100.0 * stats.hits / std::max<uint64_t>(1, stats.hits + stats.misses));
+        }
+    }
+
+    // A filter on remote addresses: a set of 256 watched addresses looked up
+    // per event, keyed by the binary address or by its text
+    std::unordered_set<data::IpAddress, data::IpAddressHash> watched;
+    std::unordered_set<std::string> watched_text;
+    for (size_t i = 0; i < 256; ++i) {
+        watched.insert(binary[i * 16].remote_address);
+        watched_text.insert(legacy[i * 16].remote_address);
+    }
+    double lookup_binary = NsPerItem(events, [&] {
+        size_t matches = 0;
+        for (size_t i = 0; i < events; ++i) matches += watched.count(binary[i & 4095].remote_address);
+        return matches;
+        });
+    double lookup_text = NsPerItem(events, [&] {
+        size_t matches = 0;
+        for (size_t i = 0; i < events; ++i) matches += watched_text.count(legacy[i & 4095].remote_address);
+        return matches;
+        });
+    std::printf("\nremote address filter (256 watched), ns per event: binary %.1f, string %.1f\n",
+        lookup_binary, lookup_text);
+
+    return ok ? 0 : 1;
+}
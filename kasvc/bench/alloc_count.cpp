@@ -0,0 +1,187 @@
+// Steady-state allocation check: runs the synthetic-driver pipeline
+// (SyntheticFilterPort -> IOCPFilterPortCommunicator -> MonitoringService ->
+// a publisher that reads every string) with the global operator new
+// replaced by a counting one, and fails unless the events published after
+// the warm-up cost no heap allocation at all. Pools, arenas and caches fill
+// during the warm-up; what is counted is the per-event hot path. With
+// publish threads the events also pass through the publish queue.
+
+#include "app/monitoring_service.h"
+#include "comm/iocp_filter_port_communicator.h"
+#include "comm/synthetic_filter_port.h"
+#include "common/constants.h"
+#include "common/logger.h"
+#include "data/event_processor.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+
+using namespace kubearmor;
+
+namespace {
+
+    std::atomic<bool> g_counting{ false };
+    std::atomic<uint64_t> g_allocations{ 0 };
+    std::atomic<uint64_t> g_bytes{ 0 };
+
+    // Sizes of the first allocations counted, to tell where they come from
+    constexpr size_t SAMPLE_COUNT = 16;
+    std::atomic<size_t> g_samples[SAMPLE_COUNT];
+
+    void* CountedAllocate(size_t size) {
+        if (g_counting.load(std::memory_order_relaxed)) {
+            uint64_t n = g_allocations.fetch_add(1, std::memory_order_relaxed);
+            g_bytes.fetch_add(size, std::memory_order_relaxed);
+            if (n < SAMPLE_COUNT) {
+                g_samples[n].store(size, std::memory_order_relaxed);
+            }
+        }
+
+        void* p = std::malloc(size ? size : 1);
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+} // namespace
+
+void* operator new(size_t size) { return CountedAllocate(size); }
+void* operator new[](size_t size) { return CountedAllocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+    // Reads every string of every event, the way a subscriber that takes
+    // all events makes the gRPC publisher do
+    class ReadingPublisher : public app::IEventPublisher {
+    public:
+        void Publish(data::Event&& event) override {
+            size_t bytes = 0;
+            if (auto fe = event.GetFileData()) {
+                bytes += fe->process_path.str().size() + fe->file_path.str().size();
+            }
+            else if (auto pe = event.GetProcessData()) {
+                bytes += pe->process_path.str().size() + pe->command_line.str().size() +
+                    pe->parent_process_path.str().size();
+            }
+            else if (auto ne = event.GetNetworkData()) {
+                bytes += data::FormatAddress(ne->local_address).view().size() +
+                    data::FormatAddress(ne->remote_address).view().size();
+            }
+            string_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+            published_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void PublishBatch(std::vector<data::Event>&& events) override {
+            for (auto& event : events) {
+                Publish(std::move(event));
+            }
+            events.clear();
+        }
+
+        size_t GetSubscriberCount() const override { return 1; }
+
+        PublisherStatistics GetStatistics() const override {
+            return PublisherStatistics{ Published(), 0, 1, 0 };
+        }
+
+        uint64_t Published() const { return published_.load(); }
+        uint64_t StringBytes() const { return string_bytes_.load(); }
+
+    private:
+        std::atomic<uint64_t> published_{ 0 };
+        std::atomic<uint64_t> string_bytes_{ 0 };
+    };
+
+    bool WaitFor(const ReadingPublisher& publisher, uint64_t count, std::chrono::seconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (publisher.Published() < count) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t warmup = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 50000;
+    uint64_t measured = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+    uint64_t rate = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 100000;
+    size_t publish_threads = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 0;
+
+    common::Logger::GetInstance().SetLevel(common::LogLevel::WARN);
+
+    comm::SyntheticFilterPort::SyntheticConfig driver;
+    driver.total_events = warmup + measured + 10000;
+    driver.events_per_second = rate;
+    driver.producer_threads = 2;
+    driver.unicode_percent = 1;
+
+    comm::IOCPFilterPortCommunicator::IOCPConfig iocp;
+    iocp.worker_thread_count = 4;
+    iocp.concurrent_operations = 8;
+    iocp.buffer_size = constants::FILTER_MESSAGE_BUFFER_SIZE;
+    iocp.buffer_pool_size = 16;
+    iocp.overload_policy = common::OverloadPolicy::BLOCK;
+
+    auto receiver = std::make_shared<comm::IOCPFilterPortCommunicator>(
+        iocp, std::make_unique<comm::SyntheticFilterPort>(driver));
+    auto publisher = std::make_shared<ReadingPublisher>();
+    app::MonitoringService service(receiver, publisher, std::make_shared<data::EventProcessor>(), 4, {},
+        publish_threads);
+
+    auto started = service.Start();
+    if (!started) {
+        std::fprintf(stderr, "failed to start pipeline: %s\n", started.ErrorMessage().c_str());
+        return 1;
+    }
+
+    bool completed = WaitFor(*publisher, warmup, std::chrono::seconds(60));
+
+    uint64_t first = publisher->Published();
+    uint64_t string_bytes = publisher->StringBytes();
+    g_counting = true;
+    completed = completed && WaitFor(*publisher, first + measured, std::chrono::seconds(60));
+    g_counting = false;
+    uint64_t events = publisher->Published() - first;
+    string_bytes = publisher->StringBytes() - string_bytes;
+
+    auto metrics = receiver->GetPerformanceMetrics();
+    service.Stop();
+
+    uint64_t allocations = g_allocations.load();
+    bool ok = completed && allocations == 0;
+
+    std::printf("=== steady-state allocations ===\n");
+    std::printf("warm-up        : %llu events\n", static_cast<unsigned long long>(warmup));
+    std::printf("publish threads: %zu\n", publish_threads);
+    std::printf("measured       : %llu events, %llu UTF-8 string bytes read\n",
+        static_cast<unsigned long long>(events), static_cast<unsigned long long>(string_bytes));
+    std::printf("allocations    : %llu (%llu bytes), %.4f per event\n",
+        static_cast<unsigned long long>(allocations), static_cast<unsigned long long>(g_bytes.load()),
+        events ? static_cast<double>(allocations) / events : 0.0);
+    std::printf("buffers        : %llu heap fallbacks, %llu dropped\n",
+        static_cast<unsigned long long>(metrics.buffer_heap_allocations),
+        static_cast<unsigned long long>(metrics.dropped_messages));
+    if (allocations > 0) {
+        std::printf("first sizes    :");
+        for (size_t i = 0; i < SAMPLE_COUNT && i < allocations; ++i) {
+            std::printf(" %zu", g_samples[i].load());
+        }
+        std::printf("\n");
+    }
+    std::printf("result         : %s\n", !completed ? "TIMED OUT" : ok ? "ok" : "FAILED");
+
+    return ok ? 0 : 1;
+}
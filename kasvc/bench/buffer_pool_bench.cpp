@@ -0,0 +1,222 @@
+// Receive-buffer pool microbenchmark: the previous mutex + condition variable
+// pool (linear scan for a free context) against common::LockFreeIndexPool.
+// Every thread runs acquire -> touch -> release in a loop while one thread
+// polls the in-use count the way GetPerformanceMetrics() does.
+
+#include "common/latency_histogram.h"
+#include "common/lock_free_index_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kubearmor;
+
+namespace {
+
+    struct Context {
+        bool in_use = false;
+        size_t pool_index = 0;
+        uint64_t touches = 0;
+    };
+
+    // Copy of the pool IOCPFilterPortCommunicator used before the free list
+    class LegacyPool {
+    public:
+        explicit LegacyPool(size_t size) {
+            for (size_t i = 0; i < size; ++i) {
+                auto context = std::make_unique<Context>();
+                context->pool_index = i;
+                pool_.push_back(std::move(context));
+            }
+        }
+
+        Context* Acquire(std::chrono::milliseconds timeout) {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            if (!available_.wait_for(lock, timeout, [this] {
+                return std::any_of(pool_.begin(), pool_.end(),
+                    [](const auto& ctx) { return !ctx->in_use; });
+                })) {
+                return nullptr;
+            }
+
+            for (auto& context : pool_) {
+                if (!context->in_use) {
+                    context->in_use = true;
+                    return context.get();
+                }
+            }
+            return nullptr;
+        }
+
+        void Release(Context* context) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                context->in_use = false;
+            }
+            available_.notify_one();
+        }
+
+        size_t InUse() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return std::count_if(pool_.begin(), pool_.end(),
+                [](const auto& ctx) { return ctx->in_use; });
+        }
+
+    private:
+        std::vector<std::unique_ptr<Context>> pool_;
+        std::mutex mutex_;
+        std::condition_variable available_;
+    };
+
+    class FreeListPool {
+    public:
+        explicit FreeListPool(size_t size) {
+            for (size_t i = 0; i < size; ++i) {
+                auto context = std::make_unique<Context>();
+                context->pool_index = i;
+                pool_.push_back(std::move(context));
+            }
+            free_.Reset(size);
+        }
+
+        Context* Acquire(std::chrono::milliseconds timeout) {
+            size_t index = free_.Acquire(timeout);
+            return index == common::LockFreeIndexPool::NPOS ? nullptr : pool_[index].get();
+        }
+
+        void Release(Context* context) { free_.Release(context->pool_index); }
+
+        size_t InUse() { return free_.InUse(); }
+
+    private:
+        std::vector<std::unique_ptr<Context>> pool_;
+        common::LockFreeIndexPool free_;
+    };
+
+    struct RunResult {
+        double ops_per_second;
+        uint64_t failures;
+        uint64_t p50_ns;
+        uint64_t p99_ns;
+        uint64_t metrics_p50_ns;
+    };
+
+    template<typename Pool>
+    RunResult Run(size_t threads, size_t pool_size, std::chrono::milliseconds duration) {
+        Pool pool(pool_size);
+        common::LatencyHistogram acquire_latency;
+        common::LatencyHistogram metrics_latency;
+        std::atomic<bool> go{ false };
+        std::atomic<bool> stop{ false };
+        std::atomic<uint64_t> operations{ 0 };
+        std::atomic<uint64_t> failures{ 0 };
+
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                uint64_t local_ops = 0;
+                uint64_t local_failures = 0;
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+
+                while (!stop.load(std::memory_order_relaxed)) {
+                    auto begin = std::chrono::steady_clock::now();
+                    Context* context = pool.Acquire(std::chrono::milliseconds(100));
+                    auto end = std::chrono::steady_clock::now();
+
+                    if (!context) {
+                        local_failures++;
+                        continue;
+                    }
+
+                    // Sample so the clock reads do not dominate the loop
+                    if ((local_ops & 63) == 0) {
+                        acquire_latency.Record(static_cast<uint64_t>(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
+                    }
+
+                    context->touches++;
+                    pool.Release(context);
+                    local_ops++;
+                }
+
+                operations.fetch_add(local_ops, std::memory_order_relaxed);
+                failures.fetch_add(local_failures, std::memory_order_relaxed);
+            });
+        }
+
+        std::thread metrics([&] {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            volatile size_t sink = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto begin = std::chrono::steady_clock::now();
+                sink = pool.InUse();
+                auto end = std::chrono::steady_clock::now();
+                metrics_latency.Record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            (void)sink;
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        std::this_thread::sleep_for(duration);
+        stop.store(true, std::memory_order_relaxed);
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        metrics.join();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        return RunResult{
+            operations.load() / elapsed,
+            failures.load(),
+            acquire_latency.ValueAtPercentile(50),
+            acquire_latency.ValueAtPercentile(99),
+            metrics_latency.ValueAtPercentile(50)
+        };
+    }
+
+    void PrintRow(const char* name, size_t threads, size_t pool_size, const RunResult& result) {
+        std::printf("%-9s %7zu %6zu %12.2f %8llu %10llu %10llu %12llu\n",
+            name, threads, pool_size, result.ops_per_second / 1e6,
+            static_cast<unsigned long long>(result.failures),
+            static_cast<unsigned long long>(result.p50_ns),
+            static_cast<unsigned long long>(result.p99_ns),
+            static_cast<unsigned long long>(result.metrics_p50_ns));
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // usage: kasvc_pool_bench [duration_ms] [buffers_per_thread]
+    auto duration = std::chrono::milliseconds(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500);
+    size_t per_thread = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4;
+
+    std::printf("=== receive buffer pool: mutex scan vs lock-free free list ===\n");
+    std::printf("%-9s %7s %6s %12s %8s %10s %10s %12s\n",
+        "pool", "threads", "size", "Mops/s", "timeouts", "acq p50ns", "acq p99ns", "in-use p50ns");
+
+    for (size_t threads : { 1, 2, 4, 8, 16, 32, 64 }) {
+        // Same sizing rule as main.cpp: buffer_pool_size = 4 x worker threads
+        size_t pool_size = std::max<size_t>(1, threads * per_thread);
+        PrintRow("legacy", threads, pool_size, Run<LegacyPool>(threads, pool_size, duration));
+        PrintRow("freelist", threads, pool_size, Run<FreeListPool>(threads, pool_size, duration));
+    }
+
+    return 0;
+}
\ No newline at end of file
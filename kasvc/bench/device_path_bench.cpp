@@ -0,0 +1,265 @@
+// Device path translation benchmark. The driver reports paths as
+// \Device\HarddiskVolumeN\..., data::DevicePathTable turns them into C:\...
+// as they are converted to UTF-8. This
+//  - checks longest-prefix matching (volumes whose names prefix each other,
+//    whole components only, ASCII case, trailing backslashes, UNC), that
+//    unchanged mappings are not replaced, and that file paths, process paths
+//    and event codec round trips come out in DOS form while command lines
+//    are left alone
+//  - swaps the mapping while reader threads convert paths: every result has
+//    to be what one of the two mappings gives
+//  - times conversion with no mapping, with a machine's worth of volumes,
+//    and plain UTF-16 to UTF-8 for scale
+
+#include "common/buffer_pool.h"
+#include "common/unicode.h"
+#include "data/device_path_table.h"
+#include "data/event_codec.h"
+#include "data/event_types.h"
+#include "data/lazy_string.h"
+#include "data/path_table.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kubearmor;
+
+namespace {
+
+    std::u16string Utf16(const std::string& text) {
+        return std::u16string(text.begin(), text.end());
+    }
+
+    std::u16string Volume(int n) {
+        return Utf16("\\Device\\HarddiskVolume" + std::to_string(n));
+    }
+
+    // Volumes 1-12 on letters C: onwards, 1 and 10-12 sharing a prefix
+    std::vector<data::DevicePrefix> Machine(char first_letter) {
+        std::vector<data::DevicePrefix> prefixes;
+        for (int n = 1; n <= 12; ++n) {
+            prefixes.push_back({ Volume(n), Utf16(std::string(1, static_cast<char>(first_letter + n - 1)) + ":") });
+        }
+        prefixes.push_back({ u"\\Device\\Mup", u"\\" });
+        return prefixes;
+    }
+
+    struct Case {
+        const char* path;
+        const char* expected;
+    };
+
+    bool CheckTranslation() {
+        data::DevicePathTable table;
+        size_t failures = 0;
+
+        const Case unmapped[] = {
+            { "\\Device\\HarddiskVolume3\\Windows\\notepad.exe", "\\Device\\HarddiskVolume3\\Windows\\notepad.exe" },
+            { "", "" },
+        };
+        for (const auto& c : unmapped) {
+            if (table.ToUtf8(Utf16(c.path)) != c.expected) failures++;
+        }
+
+        auto prefixes = Machine('C');
+        prefixes.push_back({ Utf16("\\Device\\HarddiskVolume1\\"), u"Z:" });              // duplicate, dropped
+        prefixes.push_back({ Utf16("\\Device\\HarddiskVolume1\\mnt\\data\\"), u"M:" });   // nested, longer
+        if (!table.Update(prefixes) || table.Size() != 14 || table.Generation() != 1) failures++;
+        if (table.Update(prefixes) || table.Generation() != 1) failures++;
+
+        const Case mapped[] = {
+            { "\\Device\\HarddiskVolume1\\Windows\\System32\\svchost.exe", "C:\\Windows\\System32\\svchost.exe" },
+            { "\\Device\\HarddiskVolume10\\Users\\a.txt", "L:\\Users\\a.txt" },
+            { "\\Device\\HarddiskVolume12", "N:" },
+            { "\\Device\\HarddiskVolume1", "C:" },
+            { "\\device\\HARDDISKVOLUME2\\x", "D:\\x" },
+            { "\\Device\\HarddiskVolume100\\x", "\\Device\\HarddiskVolume100\\x" },
+            { "\\Device\\HarddiskVolume1x\\y", "\\Device\\HarddiskVolume1x\\y" },
+            { "\\Device\\HarddiskVolume1\\mnt\\data\\f", "M:\\f" },
+            { "\\Device\\HarddiskVolume1\\mnt\\database", "C:\\mnt\\database" },
+            { "\\Device\\Mup\\server\\share\\f.doc", "\\\\server\\share\\f.doc" },
+            { "\\Device\\Harddisk", "\\Device\\Harddisk" },
+            { "C:\\already\\dos", "C:\\already\\dos" },
+        };
+        for (const auto& c : mapped) {
+            std::string got = table.ToUtf8(Utf16(c.path));
+            if (got != c.expected) {
+                std::printf("  %s -> %s, expected %s\n", c.path, got.c_str(), c.expected);
+                failures++;
+            }
+        }
+
+        // Non-ASCII after the prefix
+        std::u16string accented = Volume(3) + u"\\caf\u00e9";
+        if (table.ToUtf8(accented) != "E:\\caf\xc3\xa9") failures++;
+
+        bool ok = failures == 0;
+        std::printf("check prefixes : %zu paths -> %s\n", std::size(unmapped) + std::size(mapped) + 1,
+            ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    // The strings events carry, through the shared table
+    bool CheckEvents(common::BufferPool& pool) {
+        auto& table = data::DevicePathTable::GetInstance();
+        table.Update(Machine('C'));
+        size_t failures = 0;
+
+        std::u16string file = Volume(1) + Utf16("\\Users\\a\\report.docx");
+        std::u16string command = Volume(1) + Utf16("\\tools\\run.exe -x");
+        std::u16string all = file + command;
+        size_t bytes = all.size() * sizeof(char16_t);
+        auto message = pool.Copy(reinterpret_cast<const uint8_t*>(all.data()), bytes, bytes);
+        const auto* text = reinterpret_cast<const char16_t*>(message.data());
+
+        auto path = data::LazyString::FromUtf16Path(text, file.size(), message);
+        auto line = data::LazyString::FromUtf16(text + file.size(), command.size(), message);
+        auto copied = path;
+        if (path.str() != "C:\\Users\\a\\report.docx" || copied.str() != path.str() ||
+            line.str() != "\\Device\\HarddiskVolume1\\tools\\run.exe -x") {
+            failures++;
+        }
+
+        data::PathTable paths;
+        if (paths.Intern(Volume(2) + Utf16("\\Windows\\explorer.exe")).str() != "D:\\Windows\\explorer.exe") {
+            failures++;
+        }
+
+        // Encoded as the device path the driver sent, decoded to DOS form
+        data::FileEventData fd;
+        fd.file_path = data::LazyString::FromUtf16Path(text, file.size(), message);
+        data::Event event;
+        event.operation_type = data::EventOperationType::FILE_EVENT;
+        event.data = std::move(fd);
+
+        std::vector<uint8_t> record(data::EncodedEventSize(event));
+        data::EncodeEvent(event, record.data(), record.size());
+        auto heap = data::DecodeEvent(record.data(), record.size());
+        auto buffer = pool.Copy(record.data(), record.size(), record.size());
+        auto owned = data::DecodeEvent(buffer.data(), record.size(), buffer);
+        if (!heap || !owned || heap.Value().GetFileData()->file_path.str() != "C:\\Users\\a\\report.docx" ||
+            owned.Value().GetFileData()->file_path.str() != "C:\\Users\\a\\report.docx") {
+            failures++;
+        }
+
+        table.Update({});
+
+        bool ok = failures == 0;
+        std::printf("check events   : file path, process path, command line, codec -> %s\n", ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    // Readers convert while the mapping flips between letters from C: and from P:
+    bool CheckSwaps(size_t readers, double seconds) {
+        data::DevicePathTable table;
+        auto first = Machine('C');
+        auto second = Machine('P');
+        table.Update(first);
+
+        std::u16string path = Volume(7) + Utf16("\\ProgramData\\log.txt");
+        const std::string either[] = { "I:\\ProgramData\\log.txt", "V:\\ProgramData\\log.txt" };
+
+        std::atomic<bool> stop{ false };
+        std::atomic<uint64_t> conversions{ 0 };
+        std::atomic<uint64_t> failures{ 0 };
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < readers; ++i) {
+            threads.emplace_back([&] {
+                uint64_t count = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    std::string utf8 = table.ToUtf8(path);
+                    if (utf8 != either[0] && utf8 != either[1]) {
+                        failures.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    count++;
+                }
+                conversions.fetch_add(count, std::memory_order_relaxed);
+                });
+        }
+
+        uint64_t swaps = 0;
+        auto end = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(seconds));
+        while (std::chrono::steady_clock::now() < end) {
+            table.Update(swaps % 2 ? first : second);
+            swaps++;
+            std::this_thread::yield();
+        }
+        stop = true;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        bool ok = failures.load() == 0 && table.Generation() == swaps + 1;
+        std::printf("check swaps    : %llu mappings, %llu conversions on %zu threads -> %s\n",
+            static_cast<unsigned long long>(swaps), static_cast<unsigned long long>(conversions.load()),
+            readers, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    template<typename Work>
+    double NsPerItem(size_t items, Work work) {
+        size_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < items; ++i) {
+            sink += work(i);
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (sink == 1) std::printf(" ");    // keep the work
+        return elapsed * 1e9 / items;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    double seconds = argc > 2 ? std::strtod(argv[2], nullptr) : 0.5;
+
+    auto pool = common::BufferPool::Create({ { 4096, 16 } });
+    if (!pool) {
+        std::fprintf(stderr, "unable to allocate the buffer pool\n");
+        return 1;
+    }
+
+    std::printf("=== device path translation ===\n");
+    bool ok = CheckTranslation();
+    ok = CheckEvents(*pool) && ok;
+    ok = CheckSwaps(2, seconds) && ok;
+
+    // Paths spread over the volumes, the last ones matching late
+    std::vector<std::u16string> paths;
+    for (int n = 1; n <= 12; ++n) {
+        paths.push_back(Volume(n) + Utf16("\\Users\\Administrator\\AppData\\Local\\Temp\\report_2024_05.docx"));
+    }
+
+    data::DevicePathTable empty;
+    data::DevicePathTable mapped;
+    mapped.Update(Machine('C'));
+
+    double plain = NsPerItem(iterations, [&](size_t i) {
+        const auto& path = paths[i % paths.size()];
+        return common::Utf16ToUtf8(path.data(), path.size()).size();
+        });
+    double no_mapping = NsPerItem(iterations, [&](size_t i) {
+        return empty.ToUtf8(paths[i % paths.size()]).size();
+        });
+    double lookup = NsPerItem(iterations, [&](size_t i) {
+        return mapped.Find(paths[i % paths.size()]).device_length;
+        });
+    double translated = NsPerItem(iterations, [&](size_t i) {
+        return mapped.ToUtf8(paths[i % paths.size()]).size();
+        });
+
+    std::printf("\n%zu-unit paths, 13 devices mapped:\n", paths[0].size());
+    std::printf("  %-28s %10s\n", "operation", "ns/path");
+    std::printf("  %-28s %10.1f\n", "Utf16ToUtf8", plain);
+    std::printf("  %-28s %10.1f\n", "ToUtf8, no mapping", no_mapping);
+    std::printf("  %-28s %10.1f\n", "Find", lookup);
+    std::printf("  %-28s %10.1f\n", "ToUtf8, translated", translated);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,324 @@
+// Event codec benchmark. data::EncodeEvent()/DecodeEvent() turn an event
+// into a fixed header and length-prefixed strings and back, for spooling
+// and hand-offs that should not go through protobuf or ToString(). This
+//  - round-trips file, process and network events (UTF-16 strings in a
+//    message buffer, UTF-8 strings, empty strings, both address families)
+//    and checks every field, and that re-encoding gives the same bytes
+//  - decodes every truncation, every header_size too small for the header
+//    and body, and a run of single-byte mutations of each record: each has
+//    to fail cleanly or decode to something re-encodable
+//  - times encode, decode (into the record's buffer and onto the heap) and
+//    the round trip for a typical file event, with ToString() for scale
+// Built with -DKASVC_LIBFUZZER the decode check is a libFuzzer target
+// (kasvc_codec_fuzz) and main() is left to libFuzzer.
+
+#include "common/buffer_pool.h"
+#include "common/timestamp.h"
+#include "data/event_codec.h"
+#include "data/event_types.h"
+#include "data/path_table.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace kubearmor;
+
+namespace {
+
+    // What decodes has to encode again, anything else has to fail cleanly.
+    // False for an event that decoded but does not re-encode.
+    bool DecodesCleanly(const uint8_t* data, size_t size, bool& rejected) {
+        auto decoded = data::DecodeEvent(data, size);
+        rejected = !decoded;
+        if (!decoded) {
+            return true;
+        }
+        std::vector<uint8_t> again(data::EncodedEventSize(decoded.Value()));
+        return data::EncodeEvent(decoded.Value(), again.data(), again.size()) == again.size();
+    }
+
+} // namespace
+
+// Records are read in place, the copy gives them the 4-byte alignment an
+// encoded record has
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::vector<uint32_t> aligned(size / sizeof(uint32_t) + 1);
+    std::memcpy(aligned.data(), data, size);
+    bool rejected = false;
+    if (!DecodesCleanly(reinterpret_cast<const uint8_t*>(aligned.data()), size, rejected)) {
+        std::abort();
+    }
+    return 0;
+}
+
+#ifndef KASVC_LIBFUZZER
+
+namespace {
+
+    std::u16string Utf16(const std::string& text) {
+        return std::u16string(text.begin(), text.end());
+    }
+
+    // Message buffer holding the UTF-16 strings the events point into, the
+    // way the parser leaves them
+    struct Strings {
+        common::BufferRef message;
+        std::vector<std::pair<size_t, size_t>> spans;
+
+        data::LazyString At(size_t i) const {
+            auto [offset, units] = spans[i];
+            return data::LazyString::FromUtf16(reinterpret_cast<const char16_t*>(message.data()) + offset, units,
+                message);
+        }
+    };
+
+    Strings MakeStrings(common::BufferPool& pool, const std::vector<std::string>& texts) {
+        std::u16string all;
+        Strings strings;
+        for (const auto& text : texts) {
+            strings.spans.emplace_back(all.size(), text.size());
+            all += Utf16(text);
+        }
+        size_t bytes = all.size() * sizeof(char16_t);
+        strings.message = pool.Copy(reinterpret_cast<const uint8_t*>(all.data()), bytes, bytes);
+        return strings;
+    }
+
+    data::Event FileEvent(const Strings& strings, size_t path, uint32_t pid) {
+        data::FileEventData fd;
+        fd.operation = data::FileOperation::F_WRITE;
+        fd.process_id = pid;
+        fd.process_path = data::PathTable::GetInstance().Intern(
+            Utf16("\\Device\\HarddiskVolume3\\Windows\\System32\\svchost.exe"));
+        fd.file_path = strings.At(path);
+
+        data::Event event;
+        event.type = data::EventType::MATCH_HOST_POLICY;
+        event.operation_type = data::EventOperationType::FILE_EVENT;
+        event.event_id = 0x1122334455667788ULL + pid;
+        event.sequence = 0x0102030405060708ULL;
+        event.blocked = true;
+        event.data = std::move(fd);
+        return event;
+    }
+
+    std::vector<data::Event> MakeEvents(const Strings& strings) {
+        std::vector<data::Event> events;
+        events.push_back(FileEvent(strings, 0, 4242));
+
+        data::Event empty_paths;
+        empty_paths.data = data::FileEventData{};
+        events.push_back(std::move(empty_paths));
+
+        for (int utf16 = 0; utf16 < 2; ++utf16) {
+            data::ProcessEventData pd;
+            pd.operation = data::ProcessOperation::P_CREATE;
+            pd.process_id = 100 + utf16;
+            pd.parent_process_id = 4;
+            pd.process_path = data::PathTable::GetInstance().Intern(
+                Utf16("\\Device\\HarddiskVolume3\\Windows\\System32\\cmd.exe"));
+            pd.command_line = utf16 ? strings.At(1) : data::LazyString("cmd.exe /c \"echo caf\xc3\xa9\"");
+            pd.parent_process_path = data::PathTable::GetInstance().Intern(
+                Utf16("\\Device\\HarddiskVolume3\\Windows\\explorer.exe"));
+
+            data::Event event;
+            event.operation_type = data::EventOperationType::PROCESS_EVENT;
+            event.event_id = 7 + utf16;
+            event.data = std::move(pd);
+            events.push_back(std::move(event));
+        }
+
+        for (auto family : { data::AddressFamily::IPV4, data::AddressFamily::IPV6 }) {
+            // One byte over, the remote address starts at raw + 1
+            uint8_t raw[17];
+            for (size_t i = 0; i < sizeof(raw); ++i) raw[i] = static_cast<uint8_t>(i * 17 + 1);
+
+            data::NetworkEventData nd;
+            nd.operation = data::NetworkOperation::TCP_CONNECT;
+            nd.protocol = 6;
+            nd.local_port = 50123;
+            nd.remote_port = 443;
+            nd.local_address = data::IpAddress::FromBytes(raw, family);
+            nd.remote_address = data::IpAddress::FromBytes(raw + 1, family);
+            nd.data_length = 1460;
+
+            data::Event event;
+            event.operation_type = data::EventOperationType::NETWORK_EVENT;
+            event.data = std::move(nd);
+            events.push_back(std::move(event));
+        }
+        return events;
+    }
+
+    int64_t Ticks(std::chrono::system_clock::time_point tp) {
+        return std::chrono::duration_cast<common::FileTimeTicks>(tp.time_since_epoch()).count();
+    }
+
+    bool Same(const data::Event& a, const data::Event& b) {
+        if (a.type != b.type || a.operation_type != b.operation_type || a.event_id != b.event_id ||
+            a.sequence != b.sequence || Ticks(a.timestamp) != Ticks(b.timestamp) || a.blocked != b.blocked ||
+            a.data.index() != b.data.index()) {
+            return false;
+        }
+        if (auto fa = a.GetFileData()) {
+            auto fb = b.GetFileData();
+            return fa->operation == fb->operation && fa->process_id == fb->process_id &&
+                fa->process_path.str() == fb->process_path.str() && fa->file_path == fb->file_path;
+        }
+        if (auto pa = a.GetProcessData()) {
+            auto pb = b.GetProcessData();
+            return pa->operation == pb->operation && pa->process_id == pb->process_id &&
+                pa->parent_process_id == pb->parent_process_id && pa->process_path.str() == pb->process_path.str() &&
+                pa->command_line == pb->command_line &&
+                pa->parent_process_path.str() == pb->parent_process_path.str();
+        }
+        auto na = a.GetNetworkData();
+        auto nb = b.GetNetworkData();
+        return na->operation == nb->operation && na->protocol == nb->protocol && na->local_port == nb->local_port &&
+            na->remote_port == nb->remote_port && na->local_address == nb->local_address &&
+            na->remote_address == nb->remote_address && na->data_length == nb->data_length;
+    }
+
+    // 4-byte aligned storage for records
+    std::vector<uint32_t> Encode(const data::Event& event) {
+        std::vector<uint32_t> record((data::EncodedEventSize(event) + 3) / 4);
+        data::EncodeEvent(event, reinterpret_cast<uint8_t*>(record.data()), record.size() * 4);
+        return record;
+    }
+
+    bool Check(common::BufferPool& pool, const std::vector<data::Event>& events, size_t mutations) {
+        size_t failures = 0;
+        size_t rejected = 0;
+        std::mt19937 rng(1);
+
+        for (const auto& event : events) {
+            auto record = Encode(event);
+            const auto* bytes = reinterpret_cast<const uint8_t*>(record.data());
+            size_t size = data::EncodedEventSize(event);
+
+            // into the heap, and into a buffer holding the record
+            auto heap = data::DecodeEvent(bytes, size);
+            auto buffer = pool.Copy(bytes, size, size);
+            auto owned = data::DecodeEvent(buffer.data(), size, buffer);
+            if (!heap || !owned || !Same(event, heap.Value()) || !Same(event, owned.Value()) ||
+                Encode(owned.Value()) != record || size % 4 != 0 ||
+                data::EncodeEvent(event, reinterpret_cast<uint8_t*>(record.data()), size - 1) != 0) {
+                failures++;
+                continue;
+            }
+
+            for (size_t cut = 0; cut < size; ++cut) {
+                if (data::DecodeEvent(bytes, cut)) {
+                    failures++;
+                }
+            }
+
+            // A header_size short of the header and body leaves no room for
+            // them, single-byte mutations seldom produce one
+            data::EncodedEventHeader header;
+            std::memcpy(&header, bytes, sizeof(header));
+            for (uint16_t header_size = 0; header_size < header.header_size; ++header_size) {
+                auto mutated = record;
+                std::memcpy(reinterpret_cast<uint8_t*>(mutated.data()) + offsetof(data::EncodedEventHeader, header_size),
+                    &header_size, sizeof(header_size));
+                if (data::DecodeEvent(reinterpret_cast<const uint8_t*>(mutated.data()), size)) {
+                    failures++;
+                }
+            }
+
+            for (size_t m = 0; m < mutations; ++m) {
+                auto mutated = record;
+                reinterpret_cast<uint8_t*>(mutated.data())[rng() % size] ^= static_cast<uint8_t>(1 + rng() % 255);
+                bool mutation_rejected = false;
+                if (!DecodesCleanly(reinterpret_cast<const uint8_t*>(mutated.data()), size, mutation_rejected)) {
+                    failures++;
+                }
+                rejected += mutation_rejected;
+            }
+        }
+
+        bool ok = failures == 0;
+        std::printf("check          : %zu events round-tripped, truncations and short header sizes rejected, "
+            "%zu of %zu mutations rejected -> %s\n", events.size(), rejected, events.size() * mutations, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    template<typename Work>
+    double NsPerItem(size_t items, Work work) {
+        size_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < items; ++i) {
+            sink += work(i);
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (sink == 1) std::printf(" ");    // keep the work
+        return elapsed * 1e9 / items;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t mutations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20000;
+
+    auto pool = common::BufferPool::Create({ { 4096, 64 } });
+    if (!pool) {
+        std::fprintf(stderr, "unable to allocate the buffer pool\n");
+        return 1;
+    }
+
+    auto strings = MakeStrings(*pool, {
+        "\\Device\\HarddiskVolume3\\Users\\Administrator\\AppData\\Local\\Temp\\report_2024_05.docx",
+        "powershell.exe -NoProfile -ExecutionPolicy Bypass -File C:\\scripts\\collect.ps1",
+        });
+    auto events = MakeEvents(strings);
+
+    std::printf("=== event codec ===\n");
+    bool ok = Check(*pool, events, mutations);
+
+    // A file event the way the parser leaves it: interned process path, file
+    // path still UTF-16 in its message
+    const data::Event& file = events[0];
+    size_t size = data::EncodedEventSize(file);
+    auto record = pool->Acquire(size);
+    record.SetSize(size);
+    uint8_t* out = record.data();
+
+    double encode = NsPerItem(iterations, [&](size_t) {
+        return data::EncodeEvent(file, out, size);
+        });
+    double decode_owned = NsPerItem(iterations, [&](size_t) {
+        auto decoded = data::DecodeEvent(out, size, record);
+        return decoded.Value().event_id & 1;
+        });
+    double decode_heap = NsPerItem(iterations / 4, [&](size_t) {
+        auto decoded = data::DecodeEvent(out, size);
+        return decoded.Value().event_id & 1;
+        });
+    double round_trip = NsPerItem(iterations, [&](size_t) {
+        data::EncodeEvent(file, out, size);
+        auto decoded = data::DecodeEvent(out, size, record);
+        return decoded.Value().event_id & 1;
+        });
+    double to_string = NsPerItem(iterations / 10, [&](size_t) {
+        return file.ToString().size();
+        });
+
+    std::printf("\nfile event, %zu byte record (%zu-unit path in the message, interned process path):\n",
+        size, strings.spans[0].second);
+    std::printf("  %-28s %10s\n", "operation", "ns/event");
+    std::printf("  %-28s %10.1f\n", "encode", encode);
+    std::printf("  %-28s %10.1f\n", "decode, strings in buffer", decode_owned);
+    std::printf("  %-28s %10.1f\n", "decode, strings to heap", decode_heap);
+    std::printf("  %-28s %10.1f\n", "round trip (buffer)", round_trip);
+    std::printf("  %-28s %10.1f\n", "Event::ToString()", to_string);
+
+    return ok ? 0 : 1;
+}
+
+#endif
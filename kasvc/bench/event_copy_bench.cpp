@@ -0,0 +1,190 @@
+// Event ownership benchmark. Walks file events through the hand-offs an
+// event makes between the parser and the publisher (parse result -> event
+// queue -> worker -> Enrich -> Publish) twice:
+//  - copying: the contract before events became move-only, where the parse
+//    result was copied out, TryPush(const T&) and Enrich(const Event&) each
+//    made another copy and the publisher read the last one
+//  - moving: Result::TakeValue(), TryPush(T&&), Enrich in place and
+//    Publish(Event&&)
+// Events are wrapped in a type that counts its copies and moves (a copy is
+// an Event::Clone(), reference counts and all), and every event has its
+// strings read the way a matching subscriber would.
+
+#include "common/buffer_pool.h"
+#include "common/result.h"
+#include "common/thread_safe_queue.h"
+#include "data/event_processor.h"
+#include "data/event_types.h"
+#include "data/path_table.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace kubearmor;
+
+static_assert(!std::is_copy_constructible_v<data::Event>, "events are moved through the pipeline");
+
+namespace {
+
+    uint64_t g_copies = 0;
+    uint64_t g_moves = 0;
+
+    struct Tracked {
+        data::Event event;
+
+        explicit Tracked(data::Event&& e) : event(std::move(e)) {}
+
+        Tracked(const Tracked& other) : event(other.event.Clone()) { g_copies++; }
+        Tracked(Tracked&& other) noexcept : event(std::move(other.event)) { g_moves++; }
+
+        Tracked& operator=(const Tracked& other) {
+            event = other.event.Clone();
+            g_copies++;
+            return *this;
+        }
+
+        Tracked& operator=(Tracked&& other) noexcept {
+            event = std::move(other.event);
+            g_moves++;
+            return *this;
+        }
+    };
+
+    // Kernel messages with one file event each, the strings stay in them
+    struct Workload {
+        std::vector<std::u16string> processes;
+        std::vector<common::BufferRef> messages;
+        std::vector<size_t> path_units;
+    };
+
+    Workload MakeWorkload(common::BufferPool& pool, size_t count) {
+        Workload workload;
+        for (size_t i = 0; i < 16; ++i) {
+            std::string image = "\\Device\\HarddiskVolume3\\Windows\\System32\\svc" + std::to_string(i) + ".exe";
+            workload.processes.emplace_back(image.begin(), image.end());
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            std::string file = "\\Device\\HarddiskVolume3\\Users\\Administrator\\AppData\\Local\\Temp\\file_" +
+                std::to_string(i) + ".tmp";
+            std::u16string path(file.begin(), file.end());
+
+            size_t bytes = path.size() * sizeof(char16_t);
+            workload.messages.push_back(pool.Copy(reinterpret_cast<const uint8_t*>(path.data()), bytes, bytes));
+            workload.path_units.push_back(path.size());
+        }
+        return workload;
+    }
+
+    // What MessageParser::Parse hands back for message i
+    common::Result<Tracked> Parse(const Workload& workload, data::PathCache& cache, size_t i) {
+        const common::BufferRef& message = workload.messages[i % workload.messages.size()];
+        uint32_t pid = static_cast<uint32_t>(i % workload.processes.size());
+
+        data::FileEventData fd;
+        fd.operation = data::FileOperation::F_READ;
+        fd.process_id = pid;
+        fd.process_path = cache.Intern(pid, workload.processes[pid]);
+        fd.file_path = data::LazyString::FromUtf16(reinterpret_cast<const char16_t*>(message.data()),
+            workload.path_units[i % workload.messages.size()], message);
+
+        data::Event event;
+        event.event_id = i;
+        event.data = std::move(fd);
+        event.raw_message = message;
+        return common::Result<Tracked>::Success(Tracked(std::move(event)));
+    }
+
+    size_t ReadStrings(const data::Event& event) {
+        auto fe = event.GetFileData();
+        return fe ? fe->process_path.str().size() + fe->file_path.str().size() : 0;
+    }
+
+    // The contract events were copied through
+    Tracked EnrichCopy(const Tracked& event) {
+        return event;
+    }
+
+    size_t PublishConst(const Tracked& event) {
+        return ReadStrings(event.event);
+    }
+
+    size_t PublishOwned(Tracked&& event) {
+        Tracked owned(std::move(event));
+        return ReadStrings(owned.event);
+    }
+
+    struct Measurement {
+        double copies;
+        double moves;
+        double ns;
+    };
+
+    template<typename Step>
+    Measurement Run(size_t events, Step step) {
+        g_copies = 0;
+        g_moves = 0;
+        size_t sink = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < events; ++i) {
+            sink += step(i);
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (sink == 1) std::printf(" ");    // keep the work
+        return Measurement{ static_cast<double>(g_copies) / events, static_cast<double>(g_moves) / events,
+            elapsed * 1e9 / events };
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t messages = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4096;
+
+    auto pool = common::BufferPool::Create({ { 512, messages } });
+    if (!pool) {
+        std::fprintf(stderr, "unable to allocate the buffer pool\n");
+        return 1;
+    }
+
+    auto workload = MakeWorkload(*pool, messages);
+    data::PathTable table;
+    data::PathCache cache(table);
+    data::EventProcessor processor;
+    common::ThreadSafeQueue<Tracked> queue;
+
+    Measurement copying = Run(events, [&](size_t i) {
+        auto parsed = Parse(workload, cache, i);
+        Tracked event = parsed.Value();
+        queue.TryPush(event, std::chrono::milliseconds(0));
+        auto received = queue.TryPop(std::chrono::milliseconds(0));
+        Tracked enriched = EnrichCopy(*received);
+        return PublishConst(enriched);
+        });
+
+    Measurement moving = Run(events, [&](size_t i) {
+        auto parsed = Parse(workload, cache, i);
+        queue.TryPush(parsed.TakeValue(), std::chrono::milliseconds(0));
+        auto received = queue.TryPop(std::chrono::milliseconds(0));
+        processor.Enrich(received->event);
+        return PublishOwned(std::move(*received));
+        });
+
+    bool ok = moving.copies == 0;
+
+    std::printf("=== event ownership, parser -> publisher ===\n");
+    std::printf("events         : %zu file events over %zu messages, strings read\n", events, messages);
+    std::printf("  %-10s %12s %12s %12s\n", "contract", "copies/ev", "moves/ev", "ns/ev");
+    std::printf("  %-10s %12.2f %12.2f %12.1f\n", "copying", copying.copies, copying.moves, copying.ns);
+    std::printf("  %-10s %12.2f %12.2f %12.1f\n", "moving", moving.copies, moving.moves, moving.ns);
+    std::printf("  (moves include building the parse result, the same in both)\n");
+    std::printf("result         : %s\n", ok ? "ok" : "FAILED");
+
+    return ok ? 0 : 1;
+}
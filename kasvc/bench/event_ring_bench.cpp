@@ -0,0 +1,457 @@
+// Shared-ring transport harness: a forked producer process plays the driver
+// and writes EVENT records into a memfd-backed ring, ringing an eventfd
+// doorbell; this process consumes them either straight off the ring or
+// through IOCPFilterPortCommunicator's ring thread. Every record carries a
+// sequence number in process_id, so loss, reordering and torn records are
+// reported as failures. Linux only (memfd_create, eventfd).
+
+#include "comm/event_ring.h"
+#include "comm/interfaces/i_event_ring_section.h"
+#include "comm/interfaces/i_filter_port.h"
+#include "comm/iocp_filter_port_communicator.h"
+#include "comm/kernel_event_view.h"
+#include "common/constants.h"
+#include "common/latency_histogram.h"
+#include "common/logger.h"
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kubearmor;
+
+namespace {
+
+    struct BenchOptions {
+        uint64_t events = 1000000;
+        uint64_t events_per_second = 0;     // 0 = unthrottled
+        size_t ring_kb = 1024;
+        uint32_t long_path_percent = 0;
+        bool block = false;                 // wait for space instead of overflowing
+        bool pipeline = true;
+        double timeout_seconds = 60.0;
+    };
+
+    void PrintUsage(const char* argv0) {
+        std::printf(
+            "usage: %s [options]\n"
+            "  --events N           events the producer writes (default 1000000)\n"
+            "  --rate N             events per second, 0 = unthrottled (default 0)\n"
+            "  --ring-kb N          ring data area in KiB (default 1024)\n"
+            "  --long-paths PCT     file paths of 4K-30K characters (default 0)\n"
+            "  --block 0|1          producer waits for space instead of overflowing (default 0)\n"
+            "  --pipeline 0|1       consume through IOCPFilterPortCommunicator (default 1)\n"
+            "  --timeout SEC        give up after SEC seconds (default 60)\n",
+            argv0);
+    }
+
+    bool ParseOptions(int argc, char** argv, BenchOptions& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                return false;
+            }
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+                return false;
+            }
+            const char* value = argv[++i];
+            auto number = [value] { return std::strtoull(value, nullptr, 10); };
+
+            if (arg == "--events") options.events = number();
+            else if (arg == "--rate") options.events_per_second = number();
+            else if (arg == "--ring-kb") options.ring_kb = number();
+            else if (arg == "--long-paths") options.long_path_percent = static_cast<uint32_t>(number());
+            else if (arg == "--block") options.block = number() != 0;
+            else if (arg == "--pipeline") options.pipeline = number() != 0;
+            else if (arg == "--timeout") options.timeout_seconds = std::strtod(value, nullptr);
+            else {
+                std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+                return false;
+            }
+        }
+
+        if (options.events == 0 || options.events > UINT32_MAX || options.ring_kb == 0) {
+            std::fprintf(stderr, "--events must be 1..2^32-1 and --ring-kb non-zero\n");
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t KernelTimeNow() {
+        auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+        auto ticks = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count() / 100;
+        return comm::UNIX_EPOCH_IN_KERNEL_TICKS + static_cast<uint64_t>(ticks);
+    }
+
+    // The section and doorbell as the service sees them after the mapping
+    // IOCTL, with an eventfd in place of the driver's KEVENT
+    class MemfdRingSection : public comm::IEventRingSection {
+    public:
+        MemfdRingSection(void* base, size_t size, int doorbell)
+            : base_(base), size_(size), doorbell_(doorbell) {
+        }
+
+        common::Result<void> Map() override { return common::Result<void>::Success(); }
+        void Unmap() override {}
+
+        void* base() const override { return base_; }
+        size_t size() const override { return size_; }
+
+        bool WaitDoorbell(std::chrono::milliseconds timeout) override {
+            pollfd fd{ doorbell_, POLLIN, 0 };
+            if (poll(&fd, 1, static_cast<int>(timeout.count())) <= 0) {
+                return false;
+            }
+            uint64_t count;
+            return read(doorbell_, &count, sizeof(count)) == sizeof(count);
+        }
+
+        void Wake() override {
+            uint64_t one = 1;
+            (void)!write(doorbell_, &one, sizeof(one));
+        }
+
+    private:
+        void* base_;
+        size_t size_;
+        int doorbell_;
+    };
+
+    // A message port that never delivers, every event comes through the ring
+    class IdleFilterPort : public comm::IFilterPort {
+    public:
+        common::Result<void> Connect(size_t) override {
+            std::lock_guard<std::mutex> lock(mutex_);
+            connected_ = true;
+            return common::Result<void>::Success();
+        }
+
+        void Disconnect() override {
+            std::lock_guard<std::mutex> lock(mutex_);
+            connected_ = false;
+            wakeup_.notify_all();
+        }
+
+        bool IsConnected() const override {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return connected_;
+        }
+
+        common::Result<void> Attach(comm::ReceiveRequest*) override { return common::Result<void>::Success(); }
+        void Detach(comm::ReceiveRequest*) override {}
+        bool SubmitReceive(comm::ReceiveRequest*) override { return true; }
+
+        comm::CompletionStatus GetCompletion(comm::Completion&, std::chrono::milliseconds timeout) override {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (wakeup_.wait_for(lock, timeout, [this] { return wakeups_ > 0 || !connected_; })) {
+                if (!connected_) return comm::CompletionStatus::CLOSED;
+                wakeups_--;
+                return comm::CompletionStatus::WAKEUP;
+            }
+            return comm::CompletionStatus::TIMEOUT;
+        }
+
+        void CancelReceives() override {}
+
+        void Wake() override {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wakeups_++;
+            wakeup_.notify_one();
+        }
+
+        bool SendReply(uint64_t, int32_t) override { return true; }
+
+    private:
+        mutable std::mutex mutex_;
+        std::condition_variable wakeup_;
+        size_t wakeups_ = 0;
+        bool connected_ = false;
+    };
+
+    // Builds the records the producer cycles through: file events with a
+    // short image path and a file path, some of them \\?\ long paths
+    std::vector<std::vector<uint8_t>> BuildRecords(uint32_t long_path_percent) {
+        std::vector<std::vector<uint8_t>> records;
+        const std::u16string image = u"\\Device\\HarddiskVolume3\\Windows\\System32\\svchost.exe";
+
+        for (uint32_t i = 0; i < 100; ++i) {
+            std::u16string file = u"\\Device\\HarddiskVolume3\\Windows\\System32\\ring_" +
+                std::u16string(1, static_cast<char16_t>(u'a' + i % 26)) + u".dll";
+            if (i < long_path_percent) {
+                file = u"\\\\?\\C:" + std::u16string(4096 + i * 256, u'x');
+            }
+
+            size_t size = sizeof(comm::KernelEvent) + (image.size() + file.size()) * sizeof(char16_t);
+            std::vector<uint8_t> record(size);
+            auto* event = reinterpret_cast<comm::KernelEvent*>(record.data());
+            event->event_type = comm::KernelEventType::HOST_LOG;
+            event->event_operation = comm::KernelEventOperation::FILE_EVENT;
+
+            uint32_t offset = sizeof(comm::KernelEvent);
+            event->data.file.process_path_offset = offset;
+            event->data.file.process_path_length = static_cast<uint32_t>(image.size() * sizeof(char16_t));
+            std::memcpy(record.data() + offset, image.data(), event->data.file.process_path_length);
+            offset += event->data.file.process_path_length;
+
+            event->data.file.file_path_offset = offset;
+            event->data.file.file_path_length = static_cast<uint32_t>(file.size() * sizeof(char16_t));
+            std::memcpy(record.data() + offset, file.data(), event->data.file.file_path_length);
+
+            records.push_back(std::move(record));
+        }
+        return records;
+    }
+
+    // Child process: writes every event once, one that does not fit is what
+    // the driver would send over the message port instead. With block the
+    // producer waits for the consumer, which measures what the ring carries.
+    int RunProducer(comm::EventRingWriter writer, int doorbell, const BenchOptions& options) {
+        auto records = BuildRecords(options.long_path_percent);
+        const auto interval = options.events_per_second ?
+            std::chrono::nanoseconds(1000000000ULL / options.events_per_second) :
+            std::chrono::nanoseconds(0);
+        auto next = std::chrono::steady_clock::now();
+
+        for (uint64_t sequence = 0; sequence < options.events; ++sequence) {
+            auto& record = records[sequence % records.size()];
+            auto* event = reinterpret_cast<comm::KernelEvent*>(record.data());
+            event->timestamp = KernelTimeNow();
+            event->data.file.process_id = static_cast<uint32_t>(sequence);
+
+            while (options.block && !writer.Fits(record.size())) {
+                std::this_thread::yield();
+            }
+
+            bool doorbell_needed = false;
+            writer.Write(record.data(), record.size(), doorbell_needed);
+            if (doorbell_needed) {
+                uint64_t one = 1;
+                (void)!write(doorbell, &one, sizeof(one));
+            }
+
+            if (interval.count() > 0) {
+                next += interval;
+                std::this_thread::sleep_until(next);
+            }
+        }
+        return 0;
+    }
+
+    // Sequence numbers must rise, gaps are only allowed for overflows
+    struct Validator {
+        uint64_t received = 0;
+        uint64_t next_sequence = 0;
+        uint64_t skipped = 0;
+        uint64_t errors = 0;
+        common::LatencyHistogram latency;
+
+        // Overflows after the last record read
+        void Finish(uint64_t total) {
+            skipped += total > next_sequence ? total - next_sequence : 0;
+        }
+
+        void Check(uint32_t sequence, std::chrono::system_clock::time_point timestamp) {
+            if (sequence < next_sequence) {
+                if (errors++ < 5) {
+                    std::fprintf(stderr, "sequence %u after %llu\n", sequence,
+                        static_cast<unsigned long long>(next_sequence));
+                }
+                return;
+            }
+            skipped += sequence - next_sequence;
+            next_sequence = sequence + 1;
+            received++;
+
+            auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now() - timestamp).count();
+            latency.Record(waited > 0 ? static_cast<uint64_t>(waited) : 0);
+        }
+    };
+
+    bool Done(const Validator& validator, const comm::EventRingReader& reader, uint64_t total) {
+        return validator.received + reader.overflow_records() >= total;
+    }
+
+    void ConsumeRaw(comm::EventRingReader reader, comm::IEventRingSection& section,
+        Validator& validator, uint64_t total, std::chrono::steady_clock::time_point deadline,
+        uint64_t& wakeups) {
+
+        while (!Done(validator, reader, total) && std::chrono::steady_clock::now() < deadline) {
+            comm::EventRecord record;
+            comm::EventRingStatus status;
+            while ((status = reader.Read(record)) == comm::EventRingStatus::RECORD) {
+                auto view = comm::KernelEventView::Create(record.data, record.size);
+                if (!view) {
+                    if (validator.errors++ < 5) {
+                        std::fprintf(stderr, "bad record: %s\n", view.ErrorMessage().c_str());
+                    }
+                    continue;
+                }
+                validator.Check(view.Value().file().process_id,
+                    comm::KernelTimeToSystemTime(view.Value().timestamp()));
+            }
+            reader.Release();
+
+            if (status == comm::EventRingStatus::CORRUPT) {
+                std::fprintf(stderr, "ring is corrupt\n");
+                validator.errors++;
+                return;
+            }
+
+            if (reader.PrepareToWait()) {
+                if (section.WaitDoorbell(std::chrono::milliseconds(100))) {
+                    wakeups++;
+                }
+                reader.FinishWait();
+            }
+        }
+    }
+
+    void ConsumePipeline(std::unique_ptr<comm::IEventRingSection> section, const comm::EventRingReader& reader,
+        Validator& validator, uint64_t total, std::chrono::steady_clock::time_point deadline,
+        uint64_t& wakeups) {
+
+        comm::IOCPFilterPortCommunicator::IOCPConfig config;
+        config.worker_thread_count = 1;
+        config.concurrent_operations = 1;
+        config.buffer_size = constants::FILTER_MESSAGE_BUFFER_SIZE;
+        config.buffer_pool_size = 2;
+        comm::IOCPFilterPortCommunicator receiver(config, std::make_unique<IdleFilterPort>(),
+            std::move(section));
+
+        auto connected = receiver.Connect();
+        if (!connected) {
+            std::fprintf(stderr, "failed to connect: %s\n", connected.ErrorMessage().c_str());
+            validator.errors++;
+            return;
+        }
+
+        while (!Done(validator, reader, total) && std::chrono::steady_clock::now() < deadline) {
+            auto event = receiver.ReceiveEvent(std::chrono::milliseconds(100));
+            if (!event) {
+                continue;
+            }
+
+            const auto* file = event->GetFileData();
+            if (!file || file->file_path.str().empty()) {
+                if (validator.errors++ < 5) {
+                    std::fprintf(stderr, "event without file data\n");
+                }
+                continue;
+            }
+            validator.Check(file->process_id, event->timestamp);
+        }
+
+        wakeups = receiver.GetPerformanceMetrics().ring_wakeups;
+        receiver.Disconnect();
+    }
+
+    double Micros(uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    common::Logger::GetInstance().SetLevel(common::LogLevel::WARN);
+
+    // The section the driver would allocate and map into the service
+    const size_t section_size = sizeof(comm::EventRingHeader) + options.ring_kb * 1024;
+    int section = memfd_create("kasvc-event-ring", MFD_CLOEXEC);
+    if (section < 0 || ftruncate(section, static_cast<off_t>(section_size)) != 0) {
+        std::perror("memfd_create");
+        return 1;
+    }
+
+    void* base = mmap(nullptr, section_size, PROT_READ | PROT_WRITE, MAP_SHARED, section, 0);
+    int doorbell = eventfd(0, EFD_CLOEXEC);
+    if (base == MAP_FAILED || doorbell < 0) {
+        std::perror("mmap/eventfd");
+        return 1;
+    }
+
+    auto writer = comm::EventRingWriter::Format(base, section_size);
+    auto reader = comm::EventRingReader::Attach(base, section_size);
+    if (!writer || !reader) {
+        std::fprintf(stderr, "failed to set up the ring: %s\n",
+            (!writer ? writer.ErrorMessage() : reader.ErrorMessage()).c_str());
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t producer = fork();
+    if (producer < 0) {
+        std::perror("fork");
+        return 1;
+    }
+    if (producer == 0) {
+        _exit(RunProducer(writer.Value(), doorbell, options));
+    }
+
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(options.timeout_seconds));
+    Validator validator;
+    uint64_t wakeups = 0;
+
+    if (options.pipeline) {
+        ConsumePipeline(std::make_unique<MemfdRingSection>(base, section_size, doorbell),
+            reader.Value(), validator, options.events, deadline, wakeups);
+    }
+    else {
+        MemfdRingSection ring_section(base, section_size, doorbell);
+        ConsumeRaw(reader.Value(), ring_section, validator, options.events, deadline, wakeups);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    int producer_status = 0;
+    waitpid(producer, &producer_status, 0);
+
+    validator.Finish(options.events);
+    const auto& ring = reader.Value();
+    uint64_t overflowed = ring.overflow_records();
+    double elapsed = std::chrono::duration<double>(end - start).count();
+    bool complete = validator.received + overflowed == options.events &&
+        validator.skipped == overflowed && validator.errors == 0;
+
+    std::printf("=== kasvc event ring harness ===\n");
+    std::printf("config         : %s, %s%s, %llu KiB ring, %u%% long paths\n",
+        options.pipeline ? "pipeline" : "raw reader",
+        options.events_per_second ?
+            (std::to_string(options.events_per_second) + " ev/s").c_str() : "unthrottled",
+        options.block ? " blocking" : "",
+        static_cast<unsigned long long>(ring.capacity() / 1024), options.long_path_percent);
+    std::printf("events written : %llu\n", static_cast<unsigned long long>(options.events));
+    std::printf("events read    : %llu\n", static_cast<unsigned long long>(validator.received));
+    std::printf("overflowed     : %llu (would go over the message port)\n",
+        static_cast<unsigned long long>(overflowed));
+    std::printf("doorbells      : %llu rung, %llu consumer wakeups (%.4f per event)\n",
+        static_cast<unsigned long long>(ring.doorbells()), static_cast<unsigned long long>(wakeups),
+        validator.received ? static_cast<double>(ring.doorbells()) / validator.received : 0.0);
+    std::printf("elapsed        : %.3f s\n", elapsed);
+    std::printf("throughput     : %.0f events/s\n", elapsed > 0 ? validator.received / elapsed : 0.0);
+    std::printf("write -> read us: p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+        Micros(validator.latency.ValueAtPercentile(50)), Micros(validator.latency.ValueAtPercentile(99)),
+        Micros(validator.latency.ValueAtPercentile(99.9)), Micros(validator.latency.Max()));
+    std::printf("result         : %s\n", complete ? "ok" : "FAILED (lost, reordered or corrupt records)");
+
+    munmap(base, section_size);
+    close(section);
+    close(doorbell);
+
+    return complete && WIFEXITED(producer_status) && WEXITSTATUS(producer_status) == 0 ? 0 : 1;
+}
@@ -0,0 +1,414 @@
+// End-to-end pipeline benchmark: SyntheticFilterPort -> IOCPFilterPortCommunicator
+// -> MonitoringService -> publisher. Runs anywhere the portable core builds.
+
+#include "app/monitoring_service.h"
+#include "comm/iocp_filter_port_communicator.h"
+#include "comm/synthetic_filter_port.h"
+#include "common/constants.h"
+#include "common/latency_histogram.h"
+#include "common/logger.h"
+#include "data/event_processor.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace kubearmor;
+
+namespace {
+
+    // Stand-in for the gRPC publisher: records how long each event took from
+    // the (synthetic) kernel timestamp to the point it would be written out.
+    // read_percent of the events have their strings read, the way a
+    // subscriber whose filter matches would. publish_delay stands in for a
+    // slow subscriber so the receive queue overloads.
+    class LatencyPublisher : public app::IEventPublisher {
+    public:
+        LatencyPublisher(uint32_t read_percent, std::chrono::microseconds publish_delay)
+            : read_percent_(read_percent), publish_delay_(publish_delay) {}
+
+        void Publish(data::Event&& event) override {
+            if (publish_delay_.count() > 0) {
+                std::this_thread::sleep_for(publish_delay_);
+            }
+
+            if (sequence_.fetch_add(1, std::memory_order_relaxed) % 100 < read_percent_) {
+                ReadStrings(event);
+            }
+
+            auto now = std::chrono::system_clock::now();
+            auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                now - event.timestamp).count();
+            latency_.Record(latency > 0 ? static_cast<uint64_t>(latency) : 0);
+
+            if (event.IsAlert()) alerts_++;
+            else logs_++;
+
+            last_publish_ns_.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                std::memory_order_relaxed);
+        }
+
+        void PublishBatch(std::vector<data::Event>&& events) override {
+            for (auto& event : events) {
+                Publish(std::move(event));
+            }
+            events.clear();
+        }
+
+        size_t GetSubscriberCount() const override { return 1; }
+
+        PublisherStatistics GetStatistics() const override {
+            return PublisherStatistics{ Published(), 0, 1, 0 };
+        }
+
+        uint64_t Published() const { return alerts_.load() + logs_.load(); }
+        uint64_t Alerts() const { return alerts_.load(); }
+        uint64_t StringBytes() const { return string_bytes_.load(); }
+        const common::LatencyHistogram& Latency() const { return latency_; }
+
+        std::chrono::steady_clock::time_point LastPublish() const {
+            return std::chrono::steady_clock::time_point(
+                std::chrono::steady_clock::duration(last_publish_ns_.load(std::memory_order_relaxed)));
+        }
+
+    private:
+        void ReadStrings(const data::Event& event) {
+            size_t bytes = 0;
+            if (auto fe = event.GetFileData()) {
+                bytes += fe->process_path.str().size() + fe->file_path.str().size();
+            }
+            else if (auto pe = event.GetProcessData()) {
+                bytes += pe->process_path.str().size() + pe->command_line.str().size() +
+                    pe->parent_process_path.str().size();
+            }
+            else if (auto ne = event.GetNetworkData()) {
+                bytes += data::FormatAddress(ne->local_address).view().size() +
+                    data::FormatAddress(ne->remote_address).view().size();
+            }
+            string_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        uint32_t read_percent_;
+        std::chrono::microseconds publish_delay_;
+        std::atomic<uint64_t> sequence_{ 0 };
+        std::atomic<uint64_t> string_bytes_{ 0 };
+        common::LatencyHistogram latency_;
+        std::atomic<uint64_t> alerts_{ 0 };
+        std::atomic<uint64_t> logs_{ 0 };
+        std::atomic<int64_t> last_publish_ns_{ 0 };
+    };
+
+    comm::IOCPFilterPortCommunicator::IOCPConfig DefaultIocpConfig() {
+        comm::IOCPFilterPortCommunicator::IOCPConfig iocp;
+        iocp.worker_thread_count = 4;
+        iocp.concurrent_operations = 8;
+        iocp.buffer_size = constants::FILTER_MESSAGE_BUFFER_SIZE;
+        iocp.buffer_pool_size = 16;
+        return iocp;
+    }
+
+    struct BenchOptions {
+        comm::SyntheticFilterPort::SyntheticConfig driver;
+        comm::IOCPFilterPortCommunicator::IOCPConfig iocp = DefaultIocpConfig();
+        size_t service_threads = 4;
+        bool sharded = false;
+        size_t publish_threads = 0;
+        size_t publish_queue = constants::PUBLISH_QUEUE_SIZE;
+        uint32_t read_percent = 100;
+        uint64_t publish_delay_us = 0;
+        double timeout_seconds = 60.0;
+        std::string log_level = "WARN";
+    };
+
+    void PrintUsage(const char* argv0) {
+        std::printf(
+            "usage: %s [options]\n"
+            "  --events N           events to emit (default 200000)\n"
+            "  --rate N             events per second, 0 = unthrottled (default 0)\n"
+            "  --producers N        synthetic kernel threads (default 2)\n"
+            "  --mix F:P:N          file:process:network weights (default 8:1:1)\n"
+            "  --alerts PCT         MATCH_HOST_POLICY share (default 5)\n"
+            "  --unicode PCT        paths with non-ASCII characters (default 1)\n"
+            "  --long-paths PCT     file paths of 4K-30K characters (default 0)\n"
+            "  --iocp-threads N     IOCP worker threads (default 4)\n"
+            "  --concurrent-ops N   receives kept posted (default 8)\n"
+            "  --buffers N          receive buffer pool size (default 16)\n"
+            "  --buffer-size N      receive buffer bytes (default 65552)\n"
+            "  --completion-batch N completions drained per wakeup (default 16)\n"
+            "  --early-reply 0|1    acknowledge audit-only events before processing (default 1)\n"
+            "  --batch N            audit-only events per batch frame, 0 = one message each (default 0)\n"
+            "  --batch-flush-us N   longest an event waits in a batch frame (default 2000)\n"
+            "  --service-threads N  MonitoringService workers (default 4)\n"
+            "  --read-strings PCT   events whose strings the publisher reads (default 100)\n"
+            "  --publish-delay-us N slow publisher, sleep N us per event (default 0)\n"
+            "  --overload-policy P  drop_newest|drop_oldest|shed_logs|block (default shed_logs)\n"
+            "  --overload-deadline-ms N  longest a full queue stalls a receive (default 10)\n"
+            "  --consumer-wait W    latency|balanced|cpu, how idle workers wait (default balanced)\n"
+            "  --pipeline P         shared|sharded, sharded = a queue lane per worker (default shared)\n"
+            "  --publish-threads N  publish workers behind their own queue, 0 = publish inline (default 0)\n"
+            "  --publish-queue N    events the publish queue holds (default 4096)\n"
+            "  --timeout SEC        give up after SEC seconds (default 60)\n"
+            "  --log-level LEVEL    service log level (default WARN)\n",
+            argv0);
+    }
+
+    bool ParseOptions(int argc, char** argv, BenchOptions& options) {
+        options.driver.total_events = 200000;
+        options.driver.producer_threads = 2;
+
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                return false;
+            }
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+                return false;
+            }
+            const char* value = argv[++i];
+            auto number = [value] { return std::strtoull(value, nullptr, 10); };
+
+            if (arg == "--events") options.driver.total_events = number();
+            else if (arg == "--rate") options.driver.events_per_second = number();
+            else if (arg == "--producers") options.driver.producer_threads = number();
+            else if (arg == "--alerts") options.driver.alert_percent = static_cast<uint32_t>(number());
+            else if (arg == "--unicode") options.driver.unicode_percent = static_cast<uint32_t>(number());
+            else if (arg == "--long-paths") options.driver.long_path_percent = static_cast<uint32_t>(number());
+            else if (arg == "--iocp-threads") options.iocp.worker_thread_count = number();
+            else if (arg == "--concurrent-ops") options.iocp.concurrent_operations = number();
+            else if (arg == "--buffers") options.iocp.buffer_pool_size = number();
+            else if (arg == "--buffer-size") options.iocp.buffer_size = number();
+            else if (arg == "--completion-batch") options.iocp.completion_batch_size = number();
+            else if (arg == "--early-reply") options.iocp.early_reply = number() != 0;
+            else if (arg == "--batch") options.driver.batch_size = number();
+            else if (arg == "--batch-flush-us") options.driver.batch_flush_us = number();
+            else if (arg == "--service-threads") options.service_threads = number();
+            else if (arg == "--publish-threads") options.publish_threads = number();
+            else if (arg == "--publish-queue") options.publish_queue = number();
+            else if (arg == "--read-strings") options.read_percent = static_cast<uint32_t>(number());
+            else if (arg == "--publish-delay-us") options.publish_delay_us = number();
+            else if (arg == "--overload-deadline-ms") options.iocp.overload_deadline = std::chrono::milliseconds(number());
+            else if (arg == "--overload-policy") {
+                auto policy = common::ParseOverloadPolicy(value);
+                if (!policy) {
+                    std::fprintf(stderr, "invalid --overload-policy %s\n", value);
+                    return false;
+                }
+                options.iocp.overload_policy = *policy;
+            }
+            else if (arg == "--consumer-wait") {
+                auto strategy = common::ParseWaitStrategy(value);
+                if (!strategy) {
+                    std::fprintf(stderr, "invalid --consumer-wait %s\n", value);
+                    return false;
+                }
+                options.iocp.consumer_wait = *strategy;
+            }
+            else if (arg == "--pipeline") {
+                std::string pipeline = value;
+                if (pipeline != "shared" && pipeline != "sharded") {
+                    std::fprintf(stderr, "invalid --pipeline %s\n", value);
+                    return false;
+                }
+                options.sharded = pipeline == "sharded";
+            }
+            else if (arg == "--timeout") options.timeout_seconds = std::strtod(value, nullptr);
+            else if (arg == "--log-level") options.log_level = value;
+            else if (arg == "--mix") {
+                unsigned f = 0, p = 0, n = 0;
+                if (std::sscanf(value, "%u:%u:%u", &f, &p, &n) != 3) {
+                    std::fprintf(stderr, "invalid --mix %s\n", value);
+                    return false;
+                }
+                options.driver.file_weight = f;
+                options.driver.process_weight = p;
+                options.driver.network_weight = n;
+            }
+            else {
+                std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+                return false;
+            }
+        }
+
+        if (options.driver.total_events == 0) {
+            std::fprintf(stderr, "--events must be greater than zero\n");
+            return false;
+        }
+        options.iocp.event_lanes = options.sharded ? options.service_threads : 0;
+        return true;
+    }
+
+    common::LogLevel ParseLogLevel(const std::string& level) {
+        if (level == "TRACE") return common::LogLevel::TRACE;
+        if (level == "DEBUG") return common::LogLevel::DEBUG;
+        if (level == "INFO") return common::LogLevel::INFO;
+        if (level == "ERR") return common::LogLevel::ERR;
+        if (level == "FATAL") return common::LogLevel::FATAL;
+        return common::LogLevel::WARN;
+    }
+
+    double Micros(uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    common::Logger::GetInstance().SetLevel(ParseLogLevel(options.log_level));
+
+    auto port = std::make_unique<comm::SyntheticFilterPort>(options.driver);
+    comm::SyntheticFilterPort* driver = port.get();
+
+    auto receiver = std::make_shared<comm::IOCPFilterPortCommunicator>(
+        options.iocp, std::move(port));
+    auto publisher = std::make_shared<LatencyPublisher>(
+        options.read_percent, std::chrono::microseconds(options.publish_delay_us));
+    auto processor = std::make_shared<data::EventProcessor>();
+
+    app::MonitoringService service(receiver, publisher, processor, options.service_threads, {},
+        options.publish_threads, options.publish_queue);
+
+    auto start = std::chrono::steady_clock::now();
+    auto started = service.Start();
+    if (!started) {
+        std::fprintf(stderr, "failed to start pipeline: %s\n", started.ErrorMessage().c_str());
+        return 1;
+    }
+
+    // Wait until every emitted event is published, or the pipeline goes quiet
+    // after the driver is done (events were dropped), or we time out
+    const uint64_t total = options.driver.total_events;
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(options.timeout_seconds));
+    uint64_t last_seen = 0;
+    auto last_progress = std::chrono::steady_clock::now();
+
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        uint64_t published = publisher->Published();
+        if (published >= total) break;
+
+        auto now = std::chrono::steady_clock::now();
+        if (published != last_seen) {
+            last_seen = published;
+            last_progress = now;
+        }
+        else if (driver->Finished() && now - last_progress > std::chrono::seconds(1)) {
+            break;
+        }
+    }
+
+    auto metrics = receiver->GetPerformanceMetrics();
+    auto driver_stats = driver->GetStatistics();
+    service.Stop();
+    auto stages = service.GetStageMetrics();
+    auto ledger = service.GetLossLedger();
+    auto service_stats = service.GetStatistics();
+
+    uint64_t published = publisher->Published();
+    auto end = published > 0 ? publisher->LastPublish() : std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(end - start).count();
+    const auto& latency = publisher->Latency();
+    const auto& reply = driver->ReplyLatency();
+
+    std::printf("=== kasvc pipeline benchmark ===\n");
+    std::printf("config         : %zu producers, %s, mix %u:%u:%u, %u%% alerts\n",
+        options.driver.producer_threads,
+        options.driver.events_per_second ?
+            (std::to_string(options.driver.events_per_second) + " ev/s").c_str() : "unthrottled",
+        options.driver.file_weight, options.driver.process_weight, options.driver.network_weight,
+        options.driver.alert_percent);
+    std::printf("service        : %zu IOCP threads, %zu concurrent ops, %zu x %zu B buffers, batch %zu, %zu workers\n",
+        options.iocp.worker_thread_count, options.iocp.concurrent_operations,
+        options.iocp.buffer_pool_size, options.iocp.buffer_size,
+        options.iocp.completion_batch_size, options.service_threads);
+    std::printf("overload       : %s, deadline %lld ms, publish delay %llu us\n",
+        common::OverloadPolicyName(options.iocp.overload_policy),
+        static_cast<long long>(options.iocp.overload_deadline.count()),
+        static_cast<unsigned long long>(options.publish_delay_us));
+    std::printf("consumer wait  : %s\n", common::WaitStrategyName(options.iocp.consumer_wait));
+    std::printf("pipeline       : %s, %zu queue lanes, %zu publish threads\n", options.sharded ? "sharded" : "shared",
+        receiver->GetLaneCount(), options.publish_threads);
+    std::printf("events sent    : %llu\n", static_cast<unsigned long long>(driver_stats.events_sent));
+    std::printf("events received: %llu\n", static_cast<unsigned long long>(metrics.total_messages_received));
+    std::printf("events published: %llu (%llu alerts)\n",
+        static_cast<unsigned long long>(published),
+        static_cast<unsigned long long>(publisher->Alerts()));
+    std::printf("lost           : %llu\n",
+        static_cast<unsigned long long>(driver_stats.events_sent - std::min(driver_stats.events_sent, published)));
+    std::printf("queue drops    : %llu (%llu alerts, %llu logs)\n",
+        static_cast<unsigned long long>(metrics.dropped_messages),
+        static_cast<unsigned long long>(metrics.dropped_alerts),
+        static_cast<unsigned long long>(metrics.dropped_logs));
+    uint64_t messages = metrics.total_messages_received - metrics.batched_events + metrics.batch_frames;
+    std::printf("completions    : %.2f per wakeup (%llu wakeups)\n",
+        metrics.completion_batches ?
+            static_cast<double>(messages) / metrics.completion_batches : 0.0,
+        static_cast<unsigned long long>(metrics.completion_batches));
+    std::printf("batch frames   : %llu sent, %llu received, %.1f events per frame\n",
+        static_cast<unsigned long long>(driver_stats.batches_sent),
+        static_cast<unsigned long long>(metrics.batch_frames),
+        metrics.batch_frames ?
+            static_cast<double>(metrics.batched_events) / metrics.batch_frames : 0.0);
+    std::printf("buffers        : %llu large messages handed off, %llu heap fallbacks\n",
+        static_cast<unsigned long long>(metrics.buffer_handoffs),
+        static_cast<unsigned long long>(metrics.buffer_heap_allocations));
+    std::printf("strings read   : %u%% of events, %llu UTF-8 bytes\n",
+        options.read_percent, static_cast<unsigned long long>(publisher->StringBytes()));
+    std::printf("receive stalls : %llu, oversized: %llu\n",
+        static_cast<unsigned long long>(driver_stats.receive_stalls),
+        static_cast<unsigned long long>(driver_stats.oversized_events));
+    std::printf("elapsed        : %.3f s\n", elapsed);
+    std::printf("throughput     : %.0f events/s\n", elapsed > 0 ? published / elapsed : 0.0);
+    std::printf("end-to-end us  : p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f  mean %.1f\n",
+        Micros(latency.ValueAtPercentile(50)), Micros(latency.ValueAtPercentile(90)),
+        Micros(latency.ValueAtPercentile(99)), Micros(latency.ValueAtPercentile(99.9)),
+        Micros(latency.Max()), Micros(latency.Mean()));
+    std::printf("driver wait us : p50 %.1f  p99 %.1f  max %.1f  (send -> reply, %llu replies)\n",
+        Micros(reply.ValueAtPercentile(50)), Micros(reply.ValueAtPercentile(99)),
+        Micros(reply.Max()), static_cast<unsigned long long>(driver_stats.replies_received));
+    std::printf("service replies: %llu (%llu early, %llu failed), timestamp -> reply us p50 %llu  p99 %llu  max %llu\n",
+        static_cast<unsigned long long>(metrics.replies_sent),
+        static_cast<unsigned long long>(metrics.early_replies),
+        static_cast<unsigned long long>(metrics.reply_failures),
+        static_cast<unsigned long long>(metrics.reply_latency_p50_us),
+        static_cast<unsigned long long>(metrics.reply_latency_p99_us),
+        static_cast<unsigned long long>(metrics.reply_latency_max_us));
+    std::printf("queue wait us  : p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f  (offered -> taken by a worker)\n",
+        Micros(metrics.queue_wait_p50_ns), Micros(metrics.queue_wait_p99_ns),
+        Micros(metrics.queue_wait_p999_ns), Micros(metrics.queue_wait_max_ns));
+    std::printf("ordering       : %llu violations, %llu events untracked (per process, by driver sequence)\n",
+        static_cast<unsigned long long>(service_stats.ordering_violations),
+        static_cast<unsigned long long>(service_stats.ordering_untracked));
+    std::printf("stages         : %-8s %8s %15s %10s %12s %12s %12s\n",
+        "stage", "threads", "queue", "events", "svc p50 ns", "svc p99 ns", "svc max ns");
+    for (const auto& stage : stages) {
+        std::string queue = stage.queue_capacity ?
+            std::to_string(stage.queue_depth) + "/" + std::to_string(stage.queue_capacity) : "-";
+        std::printf("                 %-8s %8zu %15s %10llu %12llu %12llu %12llu\n", stage.stage,
+            stage.workers, queue.c_str(),
+            static_cast<unsigned long long>(stage.events),
+            static_cast<unsigned long long>(stage.service_p50_ns),
+            static_cast<unsigned long long>(stage.service_p99_ns),
+            static_cast<unsigned long long>(stage.service_max_ns));
+    }
+    std::printf("loss ledger    : %-12s %10s %10s %10s %10s %12s\n",
+        "stage", "received", "forwarded", "dropped", "pending", "unaccounted");
+    for (const auto& stage : ledger) {
+        std::printf("                 %-12s %10llu %10llu %10llu %10llu %12lld\n", stage.stage,
+            static_cast<unsigned long long>(stage.received),
+            static_cast<unsigned long long>(stage.forwarded),
+            static_cast<unsigned long long>(stage.dropped),
+            static_cast<unsigned long long>(stage.pending),
+            static_cast<long long>(stage.Unaccounted()));
+    }
+
+    return published > 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,327 @@
+// Kernel message decoder check and benchmark. KernelEventView::Create()
+// resolves an EVENT's strings with the decoder KernelEventLayout generates
+// per operation; this compares it with the hand-written checks it replaced:
+//  - check: valid file, process and network records, then the same records
+//    mutated (flipped bytes, boundary offsets and lengths, truncation,
+//    unknown operations) must be accepted or rejected exactly as the
+//    reference does, with the same string spans, and every accepted record
+//    must parse and read back through MessageParser
+//  - timing: ns per record for the reference, the generated decoder, the
+//    whole KernelEventView::Create() and a full MessageParser::Parse, per
+//    operation
+// Built with -DKASVC_LIBFUZZER the same check is a libFuzzer target
+// (kasvc_decode_fuzz) and main() is left to libFuzzer.
+
+#include "comm/kernel_event_view.h"
+#include "comm/kernel_message.h"
+#include "comm/message_parser.h"
+#include "common/buffer_pool.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace kubearmor;
+
+namespace {
+
+    // Copy of the per-operation checks KernelEventView::Create() used before
+    // the layout-driven decoder; strings in KernelStringField order
+    bool ReferenceStrings(const uint8_t* event, size_t size, std::u16string_view* strings) {
+        if (size < sizeof(comm::KernelEvent)) {
+            return false;
+        }
+
+        auto set = [&](comm::KernelStringField field, uint32_t offset, uint32_t length) {
+            if (length == 0) {
+                return true;
+            }
+            if (offset % sizeof(char16_t) != 0 || length % sizeof(char16_t) != 0) {
+                return false;
+            }
+            uint64_t begin = offset;
+            uint64_t end = begin + length;
+            if (begin < sizeof(comm::KernelEvent) || end > size) {
+                return false;
+            }
+            strings[field] = std::u16string_view(
+                reinterpret_cast<const char16_t*>(event + begin), length / sizeof(char16_t));
+            return true;
+        };
+
+        const auto* e = reinterpret_cast<const comm::KernelEvent*>(event);
+        switch (e->event_operation) {
+        case comm::KernelEventOperation::FILE_EVENT:
+            return set(comm::PROCESS_PATH, e->data.file.process_path_offset, e->data.file.process_path_length) &&
+                set(comm::FILE_PATH, e->data.file.file_path_offset, e->data.file.file_path_length);
+        case comm::KernelEventOperation::PROCESS_EVENT:
+            return set(comm::PROCESS_PATH, e->data.process.process_path_offset, e->data.process.process_path_length) &&
+                set(comm::COMMAND_LINE, e->data.process.command_line_offset, e->data.process.command_line_length) &&
+                set(comm::PARENT_PROCESS_PATH,
+                    e->data.process.parent_process_path_offset, e->data.process.parent_process_path_length);
+        case comm::KernelEventOperation::NETWORK_EVENT:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    size_t ReadStrings(const data::Event& event) {
+        if (auto fe = event.GetFileData()) {
+            return fe->process_path.str().size() + fe->file_path.str().size();
+        }
+        if (auto pe = event.GetProcessData()) {
+            return pe->process_path.str().size() + pe->command_line.str().size() +
+                pe->parent_process_path.str().size();
+        }
+        if (auto ne = event.GetNetworkData()) {
+            return data::FormatAddress(ne->local_address).view().size() +
+                data::FormatAddress(ne->remote_address).view().size();
+        }
+        return 0;
+    }
+
+    // The view and the reference agree on one record, which parses if valid
+    bool CheckRecord(const uint8_t* record, size_t size) {
+        std::u16string_view expected[comm::KERNEL_STRING_FIELD_COUNT];
+        bool valid = ReferenceStrings(record, size, expected);
+
+        auto view = comm::KernelEventView::Create(record, size);
+        if (view.IsSuccess() != valid) {
+            return false;
+        }
+        if (!valid) {
+            return true;
+        }
+
+        const auto& v = view.Value();
+        std::u16string_view actual[] = { v.process_path(), v.file_path(), v.command_line(), v.parent_process_path() };
+        for (size_t i = 0; i < comm::KERNEL_STRING_FIELD_COUNT; ++i) {
+            if (actual[i].data() != expected[i].data() || actual[i].size() != expected[i].size()) {
+                return false;
+            }
+        }
+
+        // Without an owner every string is converted up front
+        auto event = comm::MessageParser::Parse(v, common::BufferRef());
+        if (!event) {
+            return false;
+        }
+        ReadStrings(event.Value());
+        return true;
+    }
+
+    // Records are read in place, the copy gives them the alignment a receive
+    // buffer has
+    bool CheckBytes(const uint8_t* data, size_t size) {
+        std::vector<uint64_t> aligned(size / sizeof(uint64_t) + 1);
+        std::memcpy(aligned.data(), data, size);
+        return CheckRecord(reinterpret_cast<const uint8_t*>(aligned.data()), size);
+    }
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (!CheckBytes(data, size)) {
+        std::abort();
+    }
+    return 0;
+}
+
+#ifndef KASVC_LIBFUZZER
+
+namespace {
+
+    const comm::KernelEventOperation OPERATIONS[] = {
+        comm::KernelEventOperation::FILE_EVENT,
+        comm::KernelEventOperation::PROCESS_EVENT,
+        comm::KernelEventOperation::NETWORK_EVENT
+    };
+
+    const char* OperationName(comm::KernelEventOperation operation) {
+        switch (operation) {
+        case comm::KernelEventOperation::FILE_EVENT: return "file";
+        case comm::KernelEventOperation::PROCESS_EVENT: return "process";
+        case comm::KernelEventOperation::NETWORK_EVENT: return "network";
+        }
+        return "?";
+    }
+
+    // A record laid out the way the driver writes one
+    std::vector<uint8_t> MakeRecord(std::mt19937& rng, comm::KernelEventOperation operation) {
+        std::vector<uint8_t> record(sizeof(comm::KernelEvent));
+        auto string = [&](uint32_t& offset, uint32_t& length, const std::string& ascii) {
+            std::u16string text(ascii.begin(), ascii.end());
+            if (rng() % 16 == 0) {
+                text += static_cast<char16_t>(0x4E2D);
+            }
+            offset = static_cast<uint32_t>(record.size());
+            length = static_cast<uint32_t>(text.size() * sizeof(char16_t));
+            record.resize(record.size() + length);
+            std::memcpy(record.data() + offset, text.data(), length);
+        };
+
+        comm::KernelEvent event{};
+        event.timestamp = comm::UNIX_EPOCH_IN_KERNEL_TICKS + rng();
+        event.event_type = rng() % 10 ? comm::KernelEventType::HOST_LOG : comm::KernelEventType::MATCH_HOST_POLICY;
+        event.event_operation = operation;
+
+        std::string image = "\\Device\\HarddiskVolume3\\Windows\\System32\\svc" + std::to_string(rng() % 64) + ".exe";
+        switch (operation) {
+        case comm::KernelEventOperation::FILE_EVENT:
+            event.data.file.process_id = 1000 + rng() % 64;
+            string(event.data.file.process_path_offset, event.data.file.process_path_length, image);
+            string(event.data.file.file_path_offset, event.data.file.file_path_length,
+                "\\Device\\HarddiskVolume3\\Users\\Public\\file_" + std::to_string(rng()) + ".dat");
+            break;
+        case comm::KernelEventOperation::PROCESS_EVENT:
+            event.data.process.process_id = 1000 + rng() % 64;
+            event.data.process.parent_process_id = 1000 + rng() % 64;
+            string(event.data.process.process_path_offset, event.data.process.process_path_length, image);
+            string(event.data.process.command_line_offset, event.data.process.command_line_length,
+                image + " -k netsvcs -p -s Schedule");
+            string(event.data.process.parent_process_path_offset, event.data.process.parent_process_path_length,
+                "\\Device\\HarddiskVolume3\\Windows\\System32\\services.exe");
+            break;
+        case comm::KernelEventOperation::NETWORK_EVENT:
+            event.data.network.operation = rng() % 6;
+            event.data.network.protocol = 6;
+            event.data.network.address_family = static_cast<uint8_t>(rng() % 4 ?
+                comm::KernelAddressFamily::INET : comm::KernelAddressFamily::INET6);
+            for (auto& b : event.data.network.remote_address) b = static_cast<uint8_t>(rng());
+            break;
+        }
+
+        std::memcpy(record.data(), &event, sizeof(event));
+        return record;
+    }
+
+    // One structure-aware change: a flipped byte, an offset or length set
+    // to a boundary value, an unknown operation or a truncation
+    void Mutate(std::mt19937& rng, std::vector<uint8_t>& record) {
+        switch (rng() % 4) {
+        case 0:
+            record[rng() % record.size()] ^= static_cast<uint8_t>(1u << (rng() % 8));
+            break;
+        case 1: {
+            uint32_t size = static_cast<uint32_t>(record.size());
+            const uint32_t values[] = { 0, 1, 2, sizeof(comm::KernelEvent) - 2, sizeof(comm::KernelEvent),
+                size - 2, size - 1, size, size + 2, 0x7FFFFFFF, 0xFFFFFFFE, 0xFFFFFFFF };
+            // the offset/length words of every body are in the union
+            size_t field = offsetof(comm::KernelEvent, data) + sizeof(uint32_t) * (rng() % 9);
+            uint32_t value = values[rng() % (sizeof(values) / sizeof(values[0]))];
+            std::memcpy(record.data() + field, &value, sizeof(value));
+            break;
+        }
+        case 2: {
+            uint32_t operation = rng() % 6;
+            std::memcpy(record.data() + offsetof(comm::KernelEvent, event_operation), &operation, sizeof(operation));
+            break;
+        }
+        default:
+            record.resize(rng() % (record.size() + 1));
+            if (record.empty()) record.push_back(0);
+            break;
+        }
+    }
+
+    bool Check(size_t iterations, uint32_t seed) {
+        std::mt19937 rng(seed);
+        size_t accepted = 0;
+        size_t failures = 0;
+
+        for (size_t n = 0; n < iterations; ++n) {
+            auto record = MakeRecord(rng, OPERATIONS[n % 3]);
+            for (size_t mutations = n % 4; mutations > 0; --mutations) {
+                Mutate(rng, record);
+            }
+
+            std::vector<uint64_t> aligned(record.size() / sizeof(uint64_t) + 1);
+            std::memcpy(aligned.data(), record.data(), record.size());
+            std::u16string_view ignored[comm::KERNEL_STRING_FIELD_COUNT];
+            accepted += ReferenceStrings(reinterpret_cast<const uint8_t*>(aligned.data()), record.size(), ignored);
+
+            if (!CheckBytes(record.data(), record.size()) && failures++ < 5) {
+                std::printf("  mismatch, %zu byte record:", record.size());
+                for (size_t i = 0; i < record.size() && i < 96; ++i) std::printf(" %02X", record[i]);
+                std::printf("\n");
+            }
+        }
+
+        std::printf("check          : %zu records (%zu accepted), %zu mismatches -> %s\n",
+            iterations, accepted, failures, failures ? "FAILED" : "ok");
+        return failures == 0;
+    }
+
+    template<typename Decode>
+    double Measure(const std::vector<common::BufferRef>& records, double seconds, Decode decode) {
+        size_t sink = 0;
+        size_t rounds = 0;
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + std::chrono::duration<double>(seconds);
+        do {
+            for (const auto& record : records) {
+                sink += decode(record);
+            }
+            rounds++;
+        } while (std::chrono::steady_clock::now() < end);
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (sink == 1) std::printf(" ");    // keep the work
+        return elapsed * 1e9 / (static_cast<double>(rounds) * records.size());
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    double seconds = argc > 2 ? std::strtod(argv[2], nullptr) : 0.5;
+
+    std::printf("=== kernel message decoder ===\n");
+    bool ok = Check(iterations, 12345);
+
+    auto pool = common::BufferPool::Create({ { 1024, 4096 } });
+    if (!pool) {
+        std::fprintf(stderr, "unable to allocate the buffer pool\n");
+        return 1;
+    }
+
+    std::printf("\nns per record:\n");
+    std::printf("  %-10s %12s %12s %12s %12s\n", "operation", "reference", "decoder", "view", "parse");
+    std::mt19937 rng(7);
+    for (auto operation : OPERATIONS) {
+        std::vector<common::BufferRef> records;
+        for (size_t i = 0; i < 1024; ++i) {
+            auto record = MakeRecord(rng, operation);
+            records.push_back(pool->Copy(record.data(), record.size(), record.size()));
+        }
+
+        double reference = Measure(records, seconds, [](const common::BufferRef& r) {
+            std::u16string_view strings[comm::KERNEL_STRING_FIELD_COUNT];
+            return static_cast<size_t>(ReferenceStrings(r.data(), r.size(), strings)) + strings[0].size();
+            });
+        double decoder = Measure(records, seconds, [](const common::BufferRef& r) {
+            std::u16string_view strings[comm::KERNEL_STRING_FIELD_COUNT];
+            const auto& event = *reinterpret_cast<const comm::KernelEvent*>(r.data());
+            return static_cast<size_t>(comm::DecodeKernelStrings(event, r.size(), strings)) + strings[0].size();
+            });
+        double view = Measure(records, seconds, [](const common::BufferRef& r) {
+            auto v = comm::KernelEventView::Create(r.data(), r.size());
+            return v ? v.Value().process_path().size() : 0;
+            });
+        double parse = Measure(records, seconds, [](const common::BufferRef& r) {
+            auto e = comm::MessageParser::Parse(comm::EventRecord{ r.data(), r.size() }, r);
+            return e ? static_cast<size_t>(e.Value().operation_type) : 0;
+            });
+
+        std::printf("  %-10s %12.1f %12.1f %12.1f %12.1f\n", OperationName(operation), reference, decoder, view, parse);
+    }
+
+    return ok ? 0 : 1;
+}
+
+#endif
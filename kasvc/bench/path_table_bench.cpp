@@ -0,0 +1,397 @@
+// Process path interning benchmark. Compares data::Event, whose process
+// paths are data::PathTable handles, with the layout it replaced (every path
+// a LazyString span converted per event):
+//  - memory: sizeof(Event) and the heap each held event costs before and
+//    after a publisher has read its strings, counted by replacing the
+//    global operator new/delete
+//  - throughput: parse + publish of file events at 1 to 8 threads, with the
+//    publisher reading every event's strings or none of them
+//  - the table itself: Intern() of an already known path under contention
+
+#include "common/buffer_pool.h"
+#include "data/event_types.h"
+#include "data/lazy_string.h"
+#include "data/path_table.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace kubearmor;
+
+namespace {
+
+    // Heap accounting for the memory section, off while timing
+    std::atomic<bool> g_counting{ false };
+    std::atomic<int64_t> g_live_bytes{ 0 };
+    std::atomic<uint64_t> g_allocations{ 0 };
+
+    constexpr size_t ALLOCATION_HEADER = alignof(std::max_align_t);
+
+    void* CountedAllocate(size_t size) {
+        void* block = std::malloc(size + ALLOCATION_HEADER);
+        if (!block) {
+            throw std::bad_alloc();
+        }
+
+        // The header records what to subtract on delete, 0 if uncounted
+        bool counting = g_counting.load(std::memory_order_relaxed);
+        *static_cast<size_t*>(block) = counting ? size : 0;
+        if (counting) {
+            g_live_bytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+            g_allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+        return static_cast<char*>(block) + ALLOCATION_HEADER;
+    }
+
+    void CountedFree(void* p) {
+        if (!p) {
+            return;
+        }
+        char* block = static_cast<char*>(p) - ALLOCATION_HEADER;
+        size_t size = *reinterpret_cast<size_t*>(block);
+        if (size) {
+            g_live_bytes.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+        }
+        std::free(block);
+    }
+
+} // namespace
+
+void* operator new(size_t size) { return CountedAllocate(size); }
+void* operator new[](size_t size) { return CountedAllocate(size); }
+void operator delete(void* p) noexcept { CountedFree(p); }
+void operator delete[](void* p) noexcept { CountedFree(p); }
+void operator delete(void* p, size_t) noexcept { CountedFree(p); }
+void operator delete[](void* p, size_t) noexcept { CountedFree(p); }
+
+namespace {
+
+    // data::Event as it was before process paths were interned
+    namespace legacy {
+
+        struct FileEventData {
+            data::FileOperation operation = data::FileOperation::F_CREATE;
+            uint32_t process_id = 0;
+            data::LazyString process_path;
+            data::LazyString file_path;
+        };
+
+        struct ProcessEventData {
+            data::ProcessOperation operation = data::ProcessOperation::P_CREATE;
+            uint32_t process_id = 0;
+            uint32_t parent_process_id = 0;
+            data::LazyString process_path;
+            data::LazyString command_line;
+            data::LazyString parent_process_path;
+        };
+
+        struct Event {
+            data::EventType type = data::EventType::HOST_LOG;
+            data::EventOperationType operation_type = data::EventOperationType::FILE_EVENT;
+            uint64_t event_id = 0;
+            std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::now();
+            bool blocked = false;
+            std::variant<FileEventData, ProcessEventData, data::NetworkEventData> data;
+            common::BufferRef raw_message;
+        };
+
+    } // namespace legacy
+
+    // What the parser sees: UTF-16 process images, most events coming from a
+    // handful of busy ones, and file paths that rarely repeat
+    struct Workload {
+        std::vector<std::u16string> processes;
+        std::vector<std::u16string> files;
+        std::vector<std::pair<uint32_t, uint32_t>> events;      // process, file
+    };
+
+    std::u16string ToUtf16(const std::string& ascii) {
+        return std::u16string(ascii.begin(), ascii.end());
+    }
+
+    Workload MakeWorkload(size_t events, size_t process_count, size_t file_count) {
+        static const char* DIRECTORIES[] = {
+            "\\Device\\HarddiskVolume3\\Windows\\System32\\",
+            "\\Device\\HarddiskVolume3\\Program Files\\Microsoft Office\\root\\Office16\\",
+            "\\Device\\HarddiskVolume3\\Program Files (x86)\\Google\\Chrome\\Application\\",
+            "\\Device\\HarddiskVolume3\\Users\\Administrator\\AppData\\Local\\Temp\\"
+        };
+
+        std::mt19937 rng(42);
+        Workload workload;
+        for (size_t i = 0; i < process_count; ++i) {
+            workload.processes.push_back(ToUtf16(DIRECTORIES[i % 4] + std::string("process_") +
+                std::to_string(i) + ".exe"));
+        }
+        for (size_t i = 0; i < file_count; ++i) {
+            workload.files.push_back(ToUtf16(DIRECTORIES[rng() % 4] + std::string("data_") +
+                std::to_string(rng()) + ".dat"));
+        }
+
+        // 80% of events from the first eighth of the processes
+        size_t busy = std::max<size_t>(1, process_count / 8);
+        for (size_t i = 0; i < events; ++i) {
+            uint32_t process = static_cast<uint32_t>(rng() % 100 < 80 ? rng() % busy : rng() % process_count);
+            workload.events.emplace_back(process, static_cast<uint32_t>(rng() % file_count));
+        }
+        return workload;
+    }
+
+    data::LazyString Span(const std::u16string& s) {
+        return data::LazyString::FromUtf16(s.data(), s.size(), common::BufferRef());
+    }
+
+    using EventIndex = std::pair<uint32_t, uint32_t>;
+
+    legacy::Event ParseLegacy(const Workload& workload, const EventIndex& e) {
+        legacy::FileEventData fd;
+        fd.process_id = e.first;
+        fd.process_path = Span(workload.processes[e.first]);
+        fd.file_path = Span(workload.files[e.second]);
+
+        legacy::Event event;
+        event.data = std::move(fd);
+        return event;
+    }
+
+    // What MessageParser does, cache is null to go to the table every time
+    data::Event ParseInterned(data::PathTable& table, data::PathCache* cache, const Workload& workload,
+        const EventIndex& e) {
+        data::FileEventData fd;
+        fd.process_id = e.first;
+        fd.process_path = cache ? cache->Intern(e.first, workload.processes[e.first]) :
+            table.Intern(workload.processes[e.first]);
+        fd.file_path = Span(workload.files[e.second]);
+
+        data::Event event;
+        event.data = std::move(fd);
+        return event;
+    }
+
+    template<typename Event>
+    size_t ReadStrings(const Event& event) {
+        const auto& fd = std::get<0>(event.data);
+        return fd.process_path.str().size() + fd.file_path.str().size();
+    }
+
+    struct Footprint {
+        double unread;      // heap bytes per held event
+        double read;
+        uint64_t allocations;
+    };
+
+    // Holds every workload event, like a full event queue, and counts the
+    // heap it takes before and after the strings are read
+    template<typename Parse>
+    Footprint MeasureFootprint(const Workload& workload, Parse parse) {
+        using Event = decltype(parse(workload.events[0]));
+        std::vector<Event> held;
+        held.reserve(workload.events.size());
+
+        g_live_bytes = 0;
+        g_allocations = 0;
+        g_counting = true;
+
+        for (const auto& e : workload.events) {
+            held.push_back(parse(e));
+        }
+        int64_t unread = g_live_bytes.load();
+
+        size_t sink = 0;
+        for (const auto& event : held) {
+            sink += ReadStrings(event);
+        }
+        int64_t read = g_live_bytes.load();
+        uint64_t allocations = g_allocations.load();
+
+        g_counting = false;
+        if (sink == 1) std::printf(" ");
+
+        double n = static_cast<double>(held.size());
+        return Footprint{ unread / n, read / n, allocations };
+    }
+
+    // Events per second over threads, each parsing its share of the
+    // workload into a ring of in-flight events and reading read_percent
+    // of them the way the publisher does. make_event gets the thread's
+    // PathCache over table.
+    template<typename MakeEvent>
+    double MeasureThroughput(const Workload& workload, data::PathTable& table, size_t threads,
+        uint32_t read_percent, double seconds, MakeEvent make_event) {
+        using Event = decltype(make_event(std::declval<data::PathCache&>(), workload.events[0]));
+        constexpr size_t IN_FLIGHT = 1024;
+
+        std::atomic<bool> start{ false };
+        std::atomic<uint64_t> processed{ 0 };
+        std::vector<std::thread> workers;
+
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                data::PathCache cache(table);
+                std::vector<Event> ring(IN_FLIGHT);
+                size_t sink = 0;
+                uint64_t count = 0;
+                size_t i = t * workload.events.size() / threads;
+
+                while (!start.load()) std::this_thread::yield();
+                auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+                do {
+                    for (size_t n = 0; n < 256; ++n, ++count) {
+                        Event& slot = ring[count % IN_FLIGHT];
+                        slot = make_event(cache, workload.events[i]);
+                        if (++i == workload.events.size()) i = 0;
+                        if (count % 100 < read_percent) {
+                            sink += ReadStrings(slot);
+                        }
+                    }
+                } while (std::chrono::steady_clock::now() < end);
+
+                processed += count;
+                if (sink == 1) std::printf(" ");
+                });
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        start = true;
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return processed.load() / elapsed;
+    }
+
+    // Intern() + release of known paths, million calls per second over
+    // all threads, through a PathCache or straight to the table
+    double MeasureIntern(data::PathTable& table, const Workload& workload, size_t threads, bool cached,
+        double seconds) {
+        std::atomic<bool> start{ false };
+        std::atomic<uint64_t> calls{ 0 };
+        std::vector<std::thread> workers;
+
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                data::PathCache cache(table);
+                uint64_t count = 0;
+                size_t i = t * workload.events.size() / threads;
+                while (!start.load()) std::this_thread::yield();
+                auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+                do {
+                    for (size_t n = 0; n < 256; ++n, ++count) {
+                        uint32_t process = workload.events[i].first;
+                        data::PathRef path = cached ? cache.Intern(process, workload.processes[process]) :
+                            table.Intern(workload.processes[process]);
+                        if (++i == workload.events.size()) i = 0;
+                    }
+                } while (std::chrono::steady_clock::now() < end);
+                calls += count;
+                });
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        start = true;
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return calls.load() / elapsed / 1e6;
+    }
+
+    // Distinct paths are all interned once and equal paths share an entry
+    bool CheckTable(const Workload& workload) {
+        data::PathTable table(64);
+        std::vector<data::PathRef> refs;
+        for (const auto& process : workload.processes) {
+            refs.push_back(table.Intern(process));
+        }
+
+        bool ok = true;
+        for (size_t i = 0; i < workload.processes.size(); ++i) {
+            auto again = table.Intern(workload.processes[i]);
+            std::string expected(workload.processes[i].begin(), workload.processes[i].end());
+            ok = ok && again == refs[i] && again.id() == refs[i].id() && again.str() == expected;
+        }
+
+        // Idle entries go once the table is over its limit, held ones stay
+        auto held = refs.front();
+        refs.clear();
+        for (const auto& file : workload.files) {
+            table.Intern(file);
+        }
+        auto stats = table.GetStatistics();
+        ok = ok && stats.evictions > 0 && table.Intern(workload.processes.front()) == held &&
+            stats.referenced == 1;
+
+        std::printf("check table    : %zu paths, %llu inserts, %llu evicted, %zu referenced -> %s\n",
+            stats.paths, static_cast<unsigned long long>(stats.inserts),
+            static_cast<unsigned long long>(stats.evictions), stats.referenced, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    double seconds = argc > 2 ? std::strtod(argv[2], nullptr) : 0.5;
+
+    auto workload = MakeWorkload(events, 96, 20000);
+
+    std::printf("=== process path interning ===\n");
+    std::printf("workload       : %zu file events, %zu process images, %zu file paths\n",
+        workload.events.size(), workload.processes.size(), workload.files.size());
+
+    bool ok = CheckTable(workload);
+
+    std::printf("\nmemory, %zu events held:\n", workload.events.size());
+    std::printf("  %-16s %8s %14s %14s %12s\n", "layout", "sizeof", "heap unread", "heap read", "allocations");
+
+    Footprint before = MeasureFootprint(workload, [&](const auto& e) { return ParseLegacy(workload, e); });
+    std::printf("  %-16s %8zu %12.1f B %12.1f B %12llu\n", "lazy strings", sizeof(legacy::Event),
+        before.unread, before.read, static_cast<unsigned long long>(before.allocations));
+
+    Footprint after{};
+    {
+        data::PathTable table;
+        data::PathCache cache(table);
+        after = MeasureFootprint(workload, [&](const auto& e) { return ParseInterned(table, &cache, workload, e); });
+        std::printf("  %-16s %8zu %12.1f B %12.1f B %12llu\n", "interned paths", sizeof(data::Event),
+            after.unread, after.read, static_cast<unsigned long long>(after.allocations));
+        auto stats = table.GetStatistics();
+        std::printf("  (the table holds %zu paths in %zu bytes)\n", stats.paths, stats.bytes);
+    }
+
+    std::printf("\nthroughput, million events/s:\n");
+    std::printf("  %-8s %-5s %14s %14s %14s\n", "threads", "read", "lazy strings", "table", "table+cache");
+    for (uint32_t read_percent : { 100u, 0u }) {
+        for (size_t threads : { 1, 2, 4, 8 }) {
+            data::PathTable table;
+            double legacy_rate = MeasureThroughput(workload, table, threads, read_percent, seconds,
+                [&](data::PathCache&, const EventIndex& e) { return ParseLegacy(workload, e); });
+            double table_rate = MeasureThroughput(workload, table, threads, read_percent, seconds,
+                [&](data::PathCache&, const EventIndex& e) { return ParseInterned(table, nullptr, workload, e); });
+            double cached_rate = MeasureThroughput(workload, table, threads, read_percent, seconds,
+                [&](data::PathCache& cache, const EventIndex& e) { return ParseInterned(table, &cache, workload, e); });
+
+            std::printf("  %-8zu %3u%% %14.2f %14.2f %14.2f\n", threads, read_percent,
+                legacy_rate / 1e6, table_rate / 1e6, cached_rate / 1e6);
+        }
+    }
+
+    std::printf("\nIntern() of a known path, million calls/s:\n");
+    std::printf("  %-8s %14s %14s\n", "threads", "table", "table+cache");
+    for (size_t threads : { 1, 2, 4, 8 }) {
+        data::PathTable table;
+        double direct = MeasureIntern(table, workload, threads, false, seconds);
+        double cached = MeasureIntern(table, workload, threads, true, seconds);
+        std::printf("  %-8zu %14.2f %14.2f\n", threads, direct, cached);
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,252 @@
+// Placement planner harness: prints the plan common::PlanPlacement() makes
+// for this machine (or a synthetic NODES:CORES:SMT shape), and on this
+// machine starts threads pinned the way the service pins them to check
+// they only ever run where the plan put them. --sweep prints the plans for
+// a few common server shapes.
+
+#include "common/buffer_pool.h"
+#include "common/cpu_topology.h"
+#include "common/placement_planner.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+using namespace kubearmor;
+
+namespace {
+
+    struct Options {
+        common::PlacementRequest request;
+        uint32_t nodes = 0;             // 0 = detect
+        uint32_t cores_per_node = 0;
+        uint32_t threads_per_core = 0;
+        bool verify = true;
+        bool sweep = false;
+    };
+
+    void PrintUsage(const char* argv0) {
+        std::printf(
+            "usage: %s [options]\n"
+            "  --topology N:C:T     plan for N nodes x C cores x T threads instead of this machine\n"
+            "  --cpus LIST          allowed CPUs, e.g. 0-15,32-47 (default all)\n"
+            "  --budget N           CPUs to use, 0 = one per physical core on the node (default 0)\n"
+            "  --node N             preferred NUMA node, -1 = largest (default -1)\n"
+            "  --iocp-cpus LIST     explicit receive side CPUs\n"
+            "  --worker-cpus LIST   explicit monitoring worker CPUs\n"
+            "  --iocp-threads N     explicit IOCP thread count\n"
+            "  --worker-threads N   explicit worker thread count\n"
+            "  --verify 0|1         run pinned threads and check where they ran (default 1)\n"
+            "  --sweep              print plans for common server shapes\n",
+            argv0);
+    }
+
+    bool ParseList(const char* value, std::vector<uint32_t>& cpus) {
+        auto parsed = common::ParseCpuList(value);
+        if (!parsed) {
+            std::fprintf(stderr, "%s\n", parsed.ErrorMessage().c_str());
+            return false;
+        }
+        cpus = parsed.Value();
+        return true;
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                PrintUsage(argv[0]);
+                return false;
+            }
+            if (arg == "--sweep") {
+                options.sweep = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+                return false;
+            }
+
+            const char* value = argv[++i];
+            auto number = [value] { return std::strtoull(value, nullptr, 10); };
+
+            if (arg == "--budget") options.request.cpu_budget = number();
+            else if (arg == "--node") options.request.numa_node = std::atoi(value);
+            else if (arg == "--iocp-threads") options.request.iocp_threads = number();
+            else if (arg == "--worker-threads") options.request.worker_threads = number();
+            else if (arg == "--verify") options.verify = number() != 0;
+            else if (arg == "--cpus") { if (!ParseList(value, options.request.allowed_cpus)) return false; }
+            else if (arg == "--iocp-cpus") { if (!ParseList(value, options.request.iocp_cpus)) return false; }
+            else if (arg == "--worker-cpus") { if (!ParseList(value, options.request.worker_cpus)) return false; }
+            else if (arg == "--topology") {
+                if (std::sscanf(value, "%u:%u:%u", &options.nodes, &options.cores_per_node,
+                    &options.threads_per_core) != 3 || options.nodes == 0 ||
+                    options.cores_per_node == 0 || options.threads_per_core == 0) {
+                    std::fprintf(stderr, "invalid --topology %s\n", value);
+                    return false;
+                }
+            }
+            else {
+                std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void PrintTopology(const common::CpuTopology& topology) {
+        for (uint32_t node : topology.Nodes()) {
+            std::vector<uint32_t> cpus;
+            std::vector<uint32_t> cores;
+            for (const auto& cpu : topology.cpus) {
+                if (cpu.node == node) {
+                    cpus.push_back(cpu.id);
+                    cores.push_back(cpu.core);
+                }
+            }
+            std::sort(cores.begin(), cores.end());
+            size_t core_count = std::unique(cores.begin(), cores.end()) - cores.begin();
+            std::printf("node %-3u       : %zu CPUs on %zu cores [%s]\n",
+                node, cpus.size(), core_count, common::FormatCpuList(cpus).c_str());
+        }
+    }
+
+    int CurrentCpu() {
+#ifdef _WIN32
+        PROCESSOR_NUMBER number;
+        GetCurrentProcessorNumberEx(&number);
+        return number.Group * 64 + number.Number;
+#elif defined(__linux__)
+        return sched_getcpu();
+#else
+        return -1;
+#endif
+    }
+
+    // Starts the plan's threads pinned the way the service pins them and
+    // records every CPU each one was seen on
+    bool Verify(const common::PlacementPlan& plan) {
+        struct Role {
+            const char* name;
+            const std::vector<uint32_t>& cpus;
+            size_t threads;
+        };
+
+        bool ok = true;
+        for (const Role& role : { Role{ "iocp", plan.iocp_cpus, plan.iocp_threads },
+            Role{ "worker", plan.worker_cpus, plan.worker_threads } }) {
+
+            std::vector<std::vector<uint32_t>> allowed(role.threads);
+            std::vector<std::vector<uint32_t>> seen(role.threads);
+            std::atomic<size_t> pin_failures{ 0 };
+            std::vector<std::thread> threads;
+
+            for (size_t i = 0; i < role.threads; ++i) {
+                allowed[i] = common::CpusForThread(role.cpus, role.threads, i);
+                threads.emplace_back([&, i] {
+                    if (!common::PinCurrentThread(allowed[i])) {
+                        pin_failures++;
+                        return;
+                    }
+
+                    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+                    while (std::chrono::steady_clock::now() < end) {
+                        int cpu = CurrentCpu();
+                        if (cpu >= 0 && std::find(seen[i].begin(), seen[i].end(), cpu) == seen[i].end()) {
+                            seen[i].push_back(static_cast<uint32_t>(cpu));
+                        }
+                        std::this_thread::yield();
+                    }
+                    });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            size_t strays = 0;
+            std::vector<uint32_t> used;
+            for (size_t i = 0; i < role.threads; ++i) {
+                for (uint32_t cpu : seen[i]) {
+                    used.push_back(cpu);
+                    if (std::find(allowed[i].begin(), allowed[i].end(), cpu) == allowed[i].end()) {
+                        strays++;
+                    }
+                }
+            }
+            std::sort(used.begin(), used.end());
+            used.erase(std::unique(used.begin(), used.end()), used.end());
+
+            bool role_ok = pin_failures == 0 && strays == 0;
+            ok = ok && role_ok;
+            std::printf("verify %-7s : %zu threads ran on [%s], %zu pin failures, %zu off-plan -> %s\n",
+                role.name, role.threads, common::FormatCpuList(used).c_str(),
+                pin_failures.load(), strays, role_ok ? "ok" : "FAILED");
+        }
+
+        auto pool = common::BufferPool::Create({ { 2048, 1024 }, { 65552, 64 } }, plan.numa_node);
+        bool pool_ok = pool && pool->Acquire(2048) && pool->Acquire(65552);
+        ok = ok && pool_ok;
+        std::printf("verify slabs   : %s on node %d\n", pool_ok ? "ok" : "FAILED", plan.numa_node);
+        return ok;
+    }
+
+    void Sweep(const common::PlacementRequest& request) {
+        const uint32_t shapes[][3] = { { 1, 4, 2 }, { 1, 16, 2 }, { 2, 16, 2 }, { 2, 32, 2 }, { 4, 16, 2 } };
+        for (const auto& shape : shapes) {
+            auto topology = common::CpuTopology::Synthetic(shape[0], shape[1], shape[2]);
+            for (size_t budget : { size_t{ 0 }, size_t{ 8 }, size_t{ 16 } }) {
+                common::PlacementRequest sized = request;
+                sized.cpu_budget = budget;
+                auto plan = common::PlanPlacement(topology, sized);
+                std::printf("%u:%u:%u budget %-3zu: %s\n", shape[0], shape[1], shape[2], budget,
+                    plan ? common::DescribePlan(plan.Value()).c_str() : plan.ErrorMessage().c_str());
+            }
+        }
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    if (options.sweep) {
+        Sweep(options.request);
+        return 0;
+    }
+
+    bool synthetic = options.nodes > 0;
+    auto topology = synthetic ?
+        common::CpuTopology::Synthetic(options.nodes, options.cores_per_node, options.threads_per_core) :
+        common::CpuTopology::Detect();
+
+    std::printf("=== kasvc placement plan ===\n");
+    std::printf("topology       : %s, %zu CPUs on %zu nodes\n", synthetic ? "synthetic" : "detected",
+        topology.cpus.size(), topology.Nodes().size());
+    PrintTopology(topology);
+
+    auto plan = common::PlanPlacement(topology, options.request);
+    if (!plan) {
+        std::fprintf(stderr, "placement failed: %s\n", plan.ErrorMessage().c_str());
+        return 1;
+    }
+    std::printf("plan           : %s\n", common::DescribePlan(plan.Value()).c_str());
+
+    if (synthetic || !options.verify) {
+        return 0;
+    }
+    return Verify(plan.Value()) ? 0 : 1;
+}
@@ -0,0 +1,494 @@
+// Event queue benchmark. Compares common::ThreadSafeQueue (a deque behind
+// one mutex and two condition variables) with common::MpmcRing (a
+// preallocated lock-free ring that only parks threads that have to wait),
+// both with the interface the communicator's event queue uses:
+//  - checks both under every overload policy with a full queue, PopBatch()
+//    on both, and the ring under concurrent producers and consumers: every
+//    item arrives once, and each consumer sees each producer's items in
+//    order
+//  - times producers pushing and consumers popping 64-byte items through
+//    a 10000 item queue at 1 to 4 producers and consumers, one item at a
+//    time, so every item goes through the contended head and tail, and
+//    with consumers taking up to 64 at a time with PopBatch() as the
+//    monitoring workers do
+//  - checks common::OrderTracker, then runs keyed items (a process's
+//    events) from 2 producers through one ring shared by every consumer
+//    and through a ring per consumer picked by key, as the sharded
+//    pipeline does, and reports throughput and how many items came out
+//    behind a later one of their key; lanes must have none
+//  - feeds the ring one item at a time with idle gaps between, under each
+//    WaitStrategy, and reports how long items waited to be taken (the
+//    wake-up of an idle consumer) from the ring's queue-wait histogram
+
+#include "common/constants.h"
+#include "common/event_sequence.h"
+#include "common/latency_histogram.h"
+#include "common/mpmc_ring.h"
+#include "common/overload_policy.h"
+#include "common/thread_safe_queue.h"
+#include "common/wait_strategy.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kubearmor;
+
+namespace {
+
+    struct Item {
+        uint32_t producer;
+        uint32_t flags;             // bit 0: sheddable
+        uint64_t sequence;
+        char payload[48];
+    };
+
+    static_assert(sizeof(Item) == 64, "one cache line per item");
+
+    Item MakeItem(uint32_t producer, uint64_t sequence, bool sheddable = false) {
+        Item item{};
+        item.producer = producer;
+        item.flags = sheddable ? 1 : 0;
+        item.sequence = sequence;
+        return item;
+    }
+
+    bool Sheddable(const Item& item) { return item.flags & 1; }
+
+    // Fills a 4 item queue with the given items, then pushes incoming under
+    // policy; returns what was queued, what was dropped and what is left
+    template<typename Queue>
+    std::string RunPolicy(common::OverloadPolicy policy, std::vector<bool> queued_logs, std::vector<bool> incoming_logs) {
+        Queue queue(4);
+        uint64_t sequence = 0;
+        std::vector<Item> items;
+        for (bool log : queued_logs) items.push_back(MakeItem(0, sequence++, log));
+        queue.PushBatch(items, common::OverloadPolicy::DROP_NEWEST, std::chrono::milliseconds(0), Sheddable,
+            [](const Item&) {});
+
+        items.clear();
+        for (bool log : incoming_logs) items.push_back(MakeItem(0, sequence++, log));
+        std::string result;
+        size_t pushed = queue.PushBatch(items, policy, std::chrono::milliseconds(1), Sheddable,
+            [&](const Item& item) { result += "-" + std::to_string(item.sequence); });
+
+        result += " queued " + std::to_string(pushed) + ", left";
+        while (auto item = queue.TryPop(std::chrono::milliseconds(0))) {
+            result += " " + std::to_string(item->sequence);
+        }
+        return result;
+    }
+
+    bool CheckPolicies() {
+        struct Case {
+            common::OverloadPolicy policy;
+            std::vector<bool> queued;
+            std::vector<bool> incoming;
+        };
+        // Logs are true; the shed cases keep a log at the head, where the
+        // ring can evict it (ThreadSafeQueue looks further)
+        const Case cases[] = {
+            { common::OverloadPolicy::DROP_NEWEST, { true, false, true, false }, { false, true } },
+            { common::OverloadPolicy::DROP_OLDEST, { false, true, false, true }, { false, false } },
+            { common::OverloadPolicy::SHED_LOGS, { true, true, false, false }, { true, false, false } },
+            { common::OverloadPolicy::SHED_LOGS, { false, false, false }, { false, false } },
+            { common::OverloadPolicy::BLOCK, { true, true, true, true }, { false } },
+        };
+
+        size_t failures = 0;
+        for (const auto& c : cases) {
+            std::string expected = RunPolicy<common::ThreadSafeQueue<Item>>(c.policy, c.queued, c.incoming);
+            std::string ring = RunPolicy<common::MpmcRing<Item>>(c.policy, c.queued, c.incoming);
+            if (ring != expected) {
+                std::printf("  %s: ring%s, queue%s\n", common::OverloadPolicyName(c.policy), ring.c_str(),
+                    expected.c_str());
+                failures++;
+            }
+        }
+
+        bool ok = failures == 0;
+        std::printf("check policies : %zu full-queue cases, ring matches ThreadSafeQueue -> %s\n",
+            std::size(cases), ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    // Takes what is there up to the limit, appending; times out when empty
+    // and hands out what is left after Close()
+    template<typename Queue>
+    bool CheckPopBatch() {
+        Queue queue(8);
+        for (uint64_t i = 0; i < 6; ++i) {
+            queue.Push(MakeItem(0, i));
+        }
+
+        std::vector<Item> items;
+        items.push_back(MakeItem(0, 99));
+        bool ok = queue.PopBatch(items, 4, std::chrono::milliseconds(0)) == 4 && items.size() == 5 &&
+            items[0].sequence == 99 && items[1].sequence == 0 && items[4].sequence == 3;
+        items.clear();
+        ok = ok && queue.PopBatch(items, 0, std::chrono::milliseconds(0)) == 0;
+        ok = ok && queue.PopBatch(items, 64, std::chrono::milliseconds(0)) == 2 && items.back().sequence == 5;
+
+        auto start = std::chrono::steady_clock::now();
+        ok = ok && queue.PopBatch(items, 64, std::chrono::milliseconds(5)) == 0 &&
+            std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(5);
+
+        // A consumer waiting for the first item is handed a later push
+        items.clear();
+        std::thread producer([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            queue.Push(MakeItem(0, 6));
+            });
+        ok = ok && queue.PopBatch(items, 64, std::chrono::seconds(5)) == 1 && items[0].sequence == 6;
+        producer.join();
+
+        queue.Push(MakeItem(0, 7));
+        queue.Close();
+        items.clear();
+        ok = ok && queue.PopBatch(items, 64, std::chrono::seconds(5)) == 1 &&
+            queue.PopBatch(items, 64, std::chrono::seconds(5)) == 0;
+        return ok;
+    }
+
+    // Consumers pop until the queue is closed and drained
+    template<typename Queue>
+    double Run(size_t producers, size_t consumers, size_t batch, uint64_t per_producer, bool check,
+        size_t& failures) {
+        Queue queue(10000);
+        std::atomic<uint64_t> received{ 0 };
+        std::atomic<uint64_t> sum{ 0 };
+        std::atomic<uint64_t> disorders{ 0 };
+
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t c = 0; c < consumers; ++c) {
+            threads.emplace_back([&, producers] {
+                std::vector<uint64_t> next(producers, 0);
+                uint64_t count = 0;
+                uint64_t total = 0;
+                uint64_t out_of_order = 0;
+                auto take = [&](const Item& item) {
+                    if (check) {
+                        if (item.sequence < next[item.producer]) out_of_order++;
+                        next[item.producer] = item.sequence + 1;
+                        total += item.sequence;
+                    }
+                    count++;
+                };
+
+                if (batch > 1) {
+                    std::vector<Item> items;
+                    items.reserve(batch);
+                    while (!queue.IsClosed() || !queue.Empty()) {
+                        queue.PopBatch(items, batch, std::chrono::milliseconds(10));
+                        for (const auto& item : items) take(item);
+                        items.clear();
+                    }
+                }
+                else {
+                    while (auto item = queue.Pop()) take(*item);
+                }
+                received += count;
+                sum += total;
+                disorders += out_of_order;
+                });
+        }
+
+        std::vector<std::thread> senders;
+        for (size_t p = 0; p < producers; ++p) {
+            senders.emplace_back([&, p] {
+                for (uint64_t i = 0; i < per_producer; ++i) {
+                    queue.Push(MakeItem(static_cast<uint32_t>(p), i));
+                }
+                });
+        }
+        for (auto& sender : senders) {
+            sender.join();
+        }
+        queue.Close();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t total = producers * per_producer;
+        if (received.load() != total || disorders.load() != 0 ||
+            (check && sum.load() != producers * (per_producer * (per_producer - 1) / 2))) {
+            failures++;
+        }
+        return total / elapsed / 1e6;
+    }
+
+    bool CheckConcurrent(uint64_t per_producer) {
+        size_t failures = 0;
+        size_t runs = 0;
+        for (size_t producers : { 1, 3 }) {
+            for (size_t consumers : { 1, 3 }) {
+                for (size_t batch : { 1, 64 }) {
+                    Run<common::MpmcRing<Item>>(producers, consumers, batch, per_producer, true, failures);
+                    runs++;
+                }
+            }
+        }
+
+        // A ring smaller than the burst, so producers and consumers park
+        {
+            common::MpmcRing<Item> small(3);
+            std::atomic<uint64_t> received{ 0 };
+            std::thread consumer([&] {
+                while (auto item = small.Pop()) received++;
+                });
+            for (uint64_t i = 0; i < per_producer; ++i) {
+                small.Push(MakeItem(0, i));
+                if (i % 4096 == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            small.Close();
+            consumer.join();
+            if (received.load() != per_producer || small.Size() != 0) failures++;
+            runs++;
+        }
+
+        bool ok = failures == 0;
+        std::printf("check threads  : %zu runs of %llu items per producer, each delivered once, in order -> %s\n",
+            runs, static_cast<unsigned long long>(per_producer), ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    bool CheckOrderTracker() {
+        common::OrderTracker tracker;
+        bool ok = tracker.Record(4, 1) && tracker.Record(4, 3) && tracker.Record(8, 2);
+        ok = ok && !tracker.Record(4, 2) && tracker.Record(4, 0) && tracker.Record(4, 4);
+        ok = ok && tracker.Violations() == 1 && tracker.Untracked() == 0;
+
+        // More processes than slots, the rest go untracked
+        for (uint32_t pid = 0; pid < common::OrderTracker::SLOTS + 100; ++pid) {
+            tracker.Record(pid * 4, 1);
+        }
+        ok = ok && tracker.Untracked() >= 100;
+
+        // Far enough along, the processes above are gone and their slots
+        // are reused; a process's numbering starting over is no violation
+        const uint64_t later = constants::ORDER_TRACKER_STALE_EVENTS + 2;
+        uint64_t untracked = tracker.Untracked();
+        for (uint32_t pid = 0; pid < 1000; ++pid) {
+            tracker.Record(1000000 + pid * 4, later);
+        }
+        ok = ok && tracker.Untracked() == untracked && tracker.Evictions() == 1000;
+        uint64_t violations = tracker.Violations();
+        ok = ok && tracker.Record(1000000, later + constants::ORDER_TRACKER_STALE_EVENTS + 1) &&
+            tracker.Record(1000000, 1) && tracker.Record(1000000, 2) && tracker.Violations() == violations;
+
+        tracker.Reset();
+        ok = ok && tracker.Record(4, 1) && tracker.Violations() == 0 && tracker.Untracked() == 0;
+
+        std::printf("check ordering : OrderTracker violations, unsequenced, table full, stale slots, Reset() -> %s\n",
+            ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    struct KeyedRun {
+        double rate;
+        uint64_t violations;
+        bool complete;
+    };
+
+    size_t LaneOf(uint32_t key, size_t lanes) {
+        return static_cast<size_t>(((uint64_t(key) * 0x9E3779B97F4A7C15ull) >> 32) % lanes);
+    }
+
+    // Items of keys keys, each key owned by one producer that numbers its
+    // items from 1; consumers take up to 64 at a time and record every
+    // item's key and number. lanes = false: one ring any consumer takes
+    // from, true: a ring per consumer, picked by key.
+    KeyedRun RunKeyed(bool lanes, size_t consumers, uint32_t keys, uint64_t per_producer) {
+        const size_t producers = 2;
+        size_t rings_count = lanes ? consumers : 1;
+        std::vector<std::unique_ptr<common::MpmcRing<Item>>> rings;
+        for (size_t i = 0; i < rings_count; ++i) {
+            rings.push_back(std::make_unique<common::MpmcRing<Item>>((10000 + rings_count - 1) / rings_count));
+        }
+        common::OrderTracker order;
+        std::atomic<uint64_t> received{ 0 };
+
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t c = 0; c < consumers; ++c) {
+            threads.emplace_back([&, c] {
+                auto& ring = *rings[lanes ? c : 0];
+                std::vector<Item> items;
+                items.reserve(64);
+                uint64_t count = 0;
+                while (!ring.IsClosed() || !ring.Empty()) {
+                    ring.PopBatch(items, 64, std::chrono::milliseconds(10));
+                    for (const auto& item : items) {
+                        order.Record(item.producer, item.sequence);
+                    }
+                    count += items.size();
+                    items.clear();
+                }
+                received += count;
+                });
+        }
+
+        std::vector<std::thread> senders;
+        for (size_t p = 0; p < producers; ++p) {
+            senders.emplace_back([&, p] {
+                for (uint64_t i = 0; i < per_producer; ++i) {
+                    // Keys p, p + producers, ... belong to this producer
+                    uint32_t key = static_cast<uint32_t>(p + (i % (keys / producers)) * producers);
+                    rings[lanes ? LaneOf(key, rings_count) : 0]->Push(
+                        MakeItem(key, i + 1));
+                }
+                });
+        }
+        for (auto& sender : senders) {
+            sender.join();
+        }
+        for (auto& ring : rings) {
+            ring->Close();
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t total = producers * per_producer;
+        return KeyedRun{ total / elapsed / 1e6, order.Violations(), received.load() == total };
+    }
+
+    struct IdleWaits {
+        uint64_t items;
+        uint64_t p50_ns;
+        uint64_t p99_ns;
+        uint64_t max_ns;
+        double consumer_cpu;    // share of the run the consumer was on a CPU, < 0 if unknown
+    };
+
+    double ThreadCpuSeconds() {
+#if defined(__linux__)
+        timespec cpu{};
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu) == 0) {
+            return cpu.tv_sec + cpu.tv_nsec / 1e9;
+        }
+#endif
+        return -1;
+    }
+
+    // One consumer waiting in PopBatch() as a monitoring worker does, one
+    // item arriving every gap
+    IdleWaits RunIdle(common::WaitStrategy strategy, size_t items, std::chrono::microseconds gap) {
+        common::LatencyHistogram waits;
+        common::MpmcRing<Item> ring(1024, strategy, &waits);
+
+        double cpu = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::thread consumer([&] {
+            double begin = ThreadCpuSeconds();
+            std::vector<Item> batch;
+            batch.reserve(64);
+            while (ring.PopBatch(batch, 64, std::chrono::milliseconds(100)) || !ring.IsClosed()) {
+                batch.clear();
+            }
+            double end = ThreadCpuSeconds();
+            cpu = begin < 0 || end < 0 ? -1 : end - begin;
+            });
+
+        for (size_t i = 0; i < items; ++i) {
+            std::this_thread::sleep_for(gap);
+            ring.Push(MakeItem(0, i));
+        }
+        ring.Close();
+        consumer.join();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        return IdleWaits{ waits.Count(), waits.ValueAtPercentile(50), waits.ValueAtPercentile(99), waits.Max(),
+            cpu < 0 ? -1 : cpu / elapsed };
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t per_producer = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    size_t max_threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+
+    std::printf("=== event queue: ThreadSafeQueue vs MpmcRing ===\n");
+    std::printf("cpus           : %u\n", std::thread::hardware_concurrency());
+    bool ok = CheckPolicies();
+    bool batches = CheckPopBatch<common::ThreadSafeQueue<Item>>() && CheckPopBatch<common::MpmcRing<Item>>();
+    std::printf("check PopBatch : limits, appending, timeout, Close() -> %s\n", batches ? "ok" : "FAILED");
+    ok = batches && ok;
+    ok = CheckConcurrent(per_producer / 4) && ok;
+    ok = CheckOrderTracker() && ok;
+
+    std::printf("\n%llu 64-byte items per producer, million items/s:\n",
+        static_cast<unsigned long long>(per_producer));
+    std::printf("  %-21s %38s %38s\n", "", "Pop()", "PopBatch(64)");
+    std::printf("  %-10s %-10s %16s %12s %8s %16s %12s %8s\n", "producers", "consumers", "ThreadSafeQueue",
+        "MpmcRing", "ratio", "ThreadSafeQueue", "MpmcRing", "ratio");
+    size_t failures = 0;
+    for (size_t producers = 1; producers <= max_threads; producers *= 2) {
+        for (size_t consumers = 1; consumers <= max_threads; consumers *= 2) {
+            double rates[4];
+            for (size_t batch : { 1, 64 }) {
+                double* rate = rates + (batch > 1 ? 2 : 0);
+                rate[0] = Run<common::ThreadSafeQueue<Item>>(producers, consumers, batch, per_producer, false,
+                    failures);
+                rate[1] = Run<common::MpmcRing<Item>>(producers, consumers, batch, per_producer, false, failures);
+            }
+            std::printf("  %-10zu %-10zu %16.2f %12.2f %7.2fx %16.2f %12.2f %7.2fx\n", producers, consumers,
+                rates[0], rates[1], rates[1] / rates[0], rates[2], rates[3], rates[3] / rates[2]);
+        }
+    }
+    if (failures) {
+        std::printf("lost items in %zu timed runs\n", failures);
+        ok = false;
+    }
+
+    // A consumer per lane keeps each key in order; a shared ring reorders
+    // a key whenever two consumers hold its items at once
+    const uint32_t keys = 256;
+    std::printf("\n%u keys from 2 producers, %llu items each, consumers taking PopBatch(64):\n", keys,
+        static_cast<unsigned long long>(per_producer));
+    std::printf("  %-10s %12s %12s %12s %12s\n", "consumers", "shared M/s", "violations", "lanes M/s",
+        "violations");
+    for (size_t consumers = 1; consumers <= max_threads; consumers *= 2) {
+        auto shared = RunKeyed(false, consumers, keys, per_producer);
+        auto sharded = RunKeyed(true, consumers, keys, per_producer);
+        if (!shared.complete || !sharded.complete || sharded.violations != 0 ||
+            (consumers == 1 && shared.violations != 0)) {
+            ok = false;
+        }
+        std::printf("  %-10zu %12.2f %12llu %12.2f %12llu\n", consumers,
+            shared.rate, static_cast<unsigned long long>(shared.violations),
+            sharded.rate, static_cast<unsigned long long>(sharded.violations));
+    }
+
+    // Spinning is skipped on a single CPU, the strategies only differ with more
+    const size_t idle_items = 2000;
+    const auto gap = std::chrono::microseconds(500);
+    std::printf("\none item every %lld us to an idle consumer, queue wait us:\n",
+        static_cast<long long>(gap.count()));
+    std::printf("  %-10s %10s %10s %10s %14s\n", "strategy", "p50", "p99", "max", "consumer cpu");
+    for (auto strategy : { common::WaitStrategy::LATENCY, common::WaitStrategy::BALANCED,
+        common::WaitStrategy::CPU }) {
+        auto waits = RunIdle(strategy, idle_items, gap);
+        if (waits.items != idle_items) {
+            ok = false;
+        }
+        char cpu[16] = "-";
+        if (waits.consumer_cpu >= 0) {
+            std::snprintf(cpu, sizeof(cpu), "%.1f%%", waits.consumer_cpu * 100);
+        }
+        std::printf("  %-10s %10.1f %10.1f %10.1f %14s\n", common::WaitStrategyName(strategy),
+            waits.p50_ns / 1000.0, waits.p99_ns / 1000.0, waits.max_ns / 1000.0, cpu);
+    }
+
+    return ok ? 0 : 1;
+}
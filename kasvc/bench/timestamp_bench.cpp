@@ -0,0 +1,189 @@
+// Timestamp benchmark. The feeder publisher formats every alert and log's
+// UpdatedTime through common::FormatTimestamp; before, it went through
+// gmtime() (not thread-safe), put_time and an ostringstream. This
+//  - checks FormatTimestamp against gmtime_r/strftime for random times and
+//    calendar edges (leap days, century years, month and year boundaries)
+//  - checks FileTimeToSystemTime against the old microsecond conversion and
+//    that it keeps the 100 ns ticks
+//  - times both formatters for events within the same second and for
+//    events spread over many seconds, at 1 and 4 threads
+
+#include "common/timestamp.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kubearmor;
+
+namespace {
+
+    using Clock = std::chrono::system_clock;
+
+    // What FeederEventPublisher::ToFormattedTime did per event. gmtime()
+    // shares one buffer between threads, so here it runs under a lock.
+    std::string LegacyFormat(Clock::time_point tp) {
+        static std::mutex gmtime_lock;
+        auto time = Clock::to_time_t(tp);
+        std::ostringstream oss;
+        std::lock_guard<std::mutex> lock(gmtime_lock);
+        oss << std::put_time(std::gmtime(&time), "%Y-%m-%dT%H:%M:%SZ");
+        return oss.str();
+    }
+
+    // The reference: the C library's calendar and microseconds by hand
+    std::string ReferenceFormat(int64_t unix_seconds, int64_t micros, bool with_micros) {
+        std::time_t time = static_cast<std::time_t>(unix_seconds);
+        std::tm tm{};
+#ifdef _WIN32
+        gmtime_s(&tm, &time);
+#else
+        gmtime_r(&time, &tm);
+#endif
+        char buffer[64];
+        size_t size = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm);
+        if (with_micros) {
+            size += std::snprintf(buffer + size, sizeof(buffer) - size, ".%06lld", static_cast<long long>(micros));
+        }
+        buffer[size++] = 'Z';
+        return std::string(buffer, size);
+    }
+
+    // What comm::KernelTimeToSystemTime did before: microseconds only
+    Clock::time_point LegacyFileTime(uint64_t filetime) {
+        uint64_t unix_ticks = filetime > common::UNIX_EPOCH_IN_FILETIME_TICKS ?
+            filetime - common::UNIX_EPOCH_IN_FILETIME_TICKS : 0;
+        return Clock::time_point(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::microseconds(unix_ticks / 10)));
+    }
+
+    Clock::time_point FromUnix(int64_t seconds, int64_t micros) {
+        return Clock::time_point(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::seconds(seconds) + std::chrono::microseconds(micros)));
+    }
+
+    bool Check(size_t count) {
+        std::vector<int64_t> seconds = {
+            0, 59, 60, 86399, 86400,
+            951782399, 951782400, 951868799, 951868800,    // 2000-02-28/29, 2000-03-01
+            978307199, 978307200,                          // 2000-12-31, 2001-01-01
+            1709164800, 1709251199, 1709251200,            // 2024-02-29, 2024-03-01
+            2147483647, 2147483648,                        // 2038
+            4107542399, 4107542400, 4107628800,            // 2100-02-28, 2100-03-01 (no leap day)
+            7258118399, 7258118400,                        // 2199-12-31, 2200-01-01
+        };
+        // system_clock may count nanoseconds, which ends in 2262
+        int64_t last_second = std::chrono::duration_cast<std::chrono::seconds>(Clock::duration::max()).count() - 1;
+        std::mt19937_64 rng(1);
+        while (seconds.size() < count) {
+            seconds.push_back(static_cast<int64_t>(rng() % static_cast<uint64_t>(last_second)));
+        }
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < seconds.size(); ++i) {
+            int64_t micros = static_cast<int64_t>(rng() % 1000000);
+            auto tp = FromUnix(seconds[i], micros);
+            // Same second twice in a row, then a new one, to go through the cache
+            for (int repeat = 0; repeat < 2; ++repeat) {
+                if (common::FormatTimestamp(tp).view() != ReferenceFormat(seconds[i], micros, true) ||
+                    common::FormatTimestamp(tp, common::TimestampPrecision::SECONDS).view() !=
+                    ReferenceFormat(seconds[i], 0, false) ||
+                    common::ToUnixSeconds(tp) != seconds[i]) {
+                    mismatches++;
+                }
+            }
+        }
+
+        // FILETIMEs now: the old conversion truncated to microseconds
+        size_t filetime_mismatches = 0;
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t filetime = common::UNIX_EPOCH_IN_FILETIME_TICKS + rng() % (4000000000ULL * 10000000ULL);
+            auto tp = common::FileTimeToSystemTime(filetime);
+            auto ticks = std::chrono::duration_cast<common::FileTimeTicks>(tp.time_since_epoch()).count();
+            bool exact = Clock::period::den < 10000000 ||
+                static_cast<uint64_t>(ticks) == filetime - common::UNIX_EPOCH_IN_FILETIME_TICKS;
+            if (std::chrono::floor<std::chrono::microseconds>(tp) != LegacyFileTime(filetime) || !exact) {
+                filetime_mismatches++;
+            }
+        }
+        bool edges = common::FileTimeToSystemTime(0) == Clock::time_point() &&
+            common::FileTimeToSystemTime(UINT64_MAX) >= common::FileTimeToSystemTime(UINT64_MAX / 2);
+
+        bool ok = mismatches == 0 && filetime_mismatches == 0 && edges;
+        std::printf("check          : %zu times, %zu format / %zu FILETIME mismatches -> %s\n",
+            seconds.size(), mismatches, filetime_mismatches, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    // Million timestamps per second over all threads, each thread formatting
+    // per_thread times taken from times (offset per thread)
+    template<typename Format>
+    double FormatRate(const std::vector<Clock::time_point>& times, size_t threads, size_t per_thread,
+        Format format) {
+
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                size_t sink = 0;
+                for (size_t i = 0; i < per_thread; ++i) {
+                    sink += format(times[(i + t * 7919) % times.size()]);
+                }
+                if (sink == 1) std::printf(" ");    // keep the work
+                });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(threads * per_thread) / elapsed / 1e6;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t check_times = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+
+    std::printf("=== timestamps ===\n");
+    bool ok = Check(check_times);
+
+    // An event stream: 100K events/s for a while (successive events mostly
+    // share a second) and the same number of times scattered over a year
+    std::mt19937_64 rng(2);
+    auto base = Clock::now();
+    std::vector<Clock::time_point> stream(65536);
+    for (size_t i = 0; i < stream.size(); ++i) {
+        stream[i] = base + std::chrono::microseconds(i * 10 + rng() % 10);
+    }
+    std::vector<Clock::time_point> scattered(65536);
+    for (auto& tp : scattered) {
+        tp = base - std::chrono::microseconds(rng() % (365ULL * 86400 * 1000000));
+    }
+
+    auto legacy = [](Clock::time_point tp) { return LegacyFormat(tp).size(); };
+    auto formatted = [](Clock::time_point tp) { return common::FormatTimestamp(tp).size(); };
+
+    std::printf("\nformatting, million timestamps/s:\n");
+    std::printf("  %-10s %-8s %14s %14s\n", "times", "threads", "put_time", "FormatTimestamp");
+    for (auto* times : { &stream, &scattered }) {
+        for (size_t threads : { 1, 4 }) {
+            size_t per_thread = std::max<size_t>(1, events / threads);
+            double old_rate = FormatRate(*times, threads, per_thread / 4, legacy);
+            double new_rate = FormatRate(*times, threads, per_thread, formatted);
+            std::printf("  %-10s %-8zu %14.2f %14.2f\n", times == &stream ? "stream" : "scattered",
+                threads, old_rate, new_rate);
+        }
+    }
+
+    return ok ? 0 : 1;
+}
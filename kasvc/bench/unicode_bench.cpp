@@ -0,0 +1,243 @@
+// UTF-16 -> UTF-8 transcoder benchmark. First checks every kernel
+// common::Utf16ToUtf8 can run on against a reference (the previous
+// code-point-at-a-time converter) on random strings full of surrogate edge
+// cases, then times them on path-like data next to a plain memcpy of the
+// same bytes.
+
+#include "common/unicode.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace kubearmor;
+
+namespace {
+
+    // Copy of the converter common/unicode.cpp used before the block kernels
+    std::string ReferenceUtf16ToUtf8(const char16_t* src, size_t length) {
+        auto next = [&](size_t& i) -> char32_t {
+            char16_t c = src[i++];
+            if (c >= 0xD800 && c <= 0xDBFF) {
+                if (i < length && src[i] >= 0xDC00 && src[i] <= 0xDFFF) {
+                    char16_t low = src[i++];
+                    return 0x10000 + ((static_cast<char32_t>(c) - 0xD800) << 10) +
+                        (static_cast<char32_t>(low) - 0xDC00);
+                }
+                return 0xFFFD;
+            }
+            return c >= 0xDC00 && c <= 0xDFFF ? 0xFFFD : c;
+        };
+
+        size_t total = 0;
+        for (size_t i = 0; i < length;) {
+            char32_t cp = next(i);
+            total += cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+        }
+
+        std::string result(total, '\0');
+        char* out = result.empty() ? nullptr : &result[0];
+        for (size_t i = 0; i < length;) {
+            char32_t cp = next(i);
+            if (cp < 0x80) {
+                *out++ = static_cast<char>(cp);
+            }
+            else if (cp < 0x800) {
+                *out++ = static_cast<char>(0xC0 | (cp >> 6));
+                *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else if (cp < 0x10000) {
+                *out++ = static_cast<char>(0xE0 | (cp >> 12));
+                *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else {
+                *out++ = static_cast<char>(0xF0 | (cp >> 18));
+                *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+            }
+        }
+        return result;
+    }
+
+    // Code units that exercise every encoder branch and surrogate case
+    char16_t RandomUnit(std::mt19937& rng, uint32_t non_ascii_percent) {
+        static const char16_t SPECIAL[] = {
+            0x0000, 0x007F, 0x0080, 0x07FF, 0x0800, 0xD7FF, 0xD800, 0xDBFF,
+            0xDC00, 0xDFFF, 0xE000, 0xFFFD, 0xFFFF, 0x00E9, 0x4E2D
+        };
+
+        if (rng() % 100 >= non_ascii_percent) {
+            return static_cast<char16_t>(0x20 + rng() % 0x5F);
+        }
+        if (rng() % 2) {
+            return SPECIAL[rng() % (sizeof(SPECIAL) / sizeof(SPECIAL[0]))];
+        }
+        return static_cast<char16_t>(rng() % 0x10000);
+    }
+
+    std::u16string RandomString(std::mt19937& rng, size_t length, uint32_t non_ascii_percent) {
+        std::u16string s;
+        while (s.size() < length) {
+            // Proper pairs too, placed at every offset against the block ends
+            if (rng() % 100 < non_ascii_percent / 2 + 1 && s.size() + 2 <= length) {
+                s += static_cast<char16_t>(0xD800 + rng() % 0x400);
+                s += static_cast<char16_t>(0xDC00 + rng() % 0x400);
+            }
+            else {
+                s += RandomUnit(rng, non_ascii_percent);
+            }
+        }
+        return s;
+    }
+
+    std::vector<common::TranscodeKernel> AvailableKernels() {
+        std::vector<common::TranscodeKernel> kernels;
+        auto active = common::ActiveTranscodeKernel();
+        for (auto kernel : { common::TranscodeKernel::SCALAR, common::TranscodeKernel::SSE2,
+            common::TranscodeKernel::AVX2 }) {
+            if (common::SelectTranscodeKernel(kernel)) {
+                kernels.push_back(kernel);
+            }
+        }
+        common::SelectTranscodeKernel(active);
+        return kernels;
+    }
+
+    bool CheckKernel(common::TranscodeKernel kernel, size_t iterations) {
+        common::SelectTranscodeKernel(kernel);
+        std::mt19937 rng(12345);
+
+        size_t failures = 0;
+        for (size_t n = 0; n < iterations; ++n) {
+            size_t length = rng() % 80;
+            uint32_t non_ascii = std::vector<uint32_t>{ 0, 1, 10, 50, 100 }[n % 5];
+            auto input = RandomString(rng, length, non_ascii);
+
+            auto expected = ReferenceUtf16ToUtf8(input.data(), input.size());
+            auto actual = common::Utf16ToUtf8(input.data(), input.size());
+            size_t counted = common::Utf8Length(input.data(), input.size());
+
+            if (actual != expected || counted != expected.size()) {
+                if (failures++ < 5) {
+                    std::printf("  mismatch, length %zu:", input.size());
+                    for (char16_t c : input) std::printf(" %04X", static_cast<unsigned>(c));
+                    std::printf("\n");
+                }
+            }
+        }
+
+        std::printf("check %-7s : %zu strings, %zu mismatches -> %s\n",
+            common::TranscodeKernelName(kernel), iterations, failures, failures ? "FAILED" : "ok");
+        return failures == 0;
+    }
+
+    struct Dataset {
+        const char* name;
+        std::vector<std::u16string> strings;
+        size_t units = 0;
+    };
+
+    // Windows paths, non_ascii_percent of them with one non-ASCII component
+    Dataset MakePaths(const char* name, size_t count, uint32_t non_ascii_percent, uint32_t non_ascii_unit_percent) {
+        static const char* DIRECTORIES[] = {
+            "\\Device\\HarddiskVolume3\\Windows\\System32\\",
+            "\\Device\\HarddiskVolume3\\Program Files\\Common Files\\microsoft shared\\",
+            "\\Device\\HarddiskVolume3\\Users\\Administrator\\AppData\\Local\\Temp\\",
+            "\\Device\\HarddiskVolume3\\ProgramData\\Microsoft\\Windows Defender\\Scans\\"
+        };
+
+        std::mt19937 rng(7);
+        Dataset dataset{ name, {}, 0 };
+        for (size_t i = 0; i < count; ++i) {
+            std::string ascii = DIRECTORIES[rng() % 4] + std::string("file_") + std::to_string(rng()) + ".dll";
+            std::u16string path(ascii.begin(), ascii.end());
+
+            if (rng() % 100 < non_ascii_percent) {
+                path += RandomString(rng, 12, non_ascii_unit_percent);
+            }
+            dataset.units += path.size();
+            dataset.strings.push_back(std::move(path));
+        }
+        return dataset;
+    }
+
+    template<typename Convert>
+    double Measure(const Dataset& dataset, double seconds, Convert convert) {
+        size_t sink = 0;
+        size_t rounds = 0;
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + std::chrono::duration<double>(seconds);
+        do {
+            for (const auto& s : dataset.strings) {
+                sink += convert(s);
+            }
+            rounds++;
+        } while (std::chrono::steady_clock::now() < end);
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (sink == 1) std::printf(" ");    // keep the work
+        return elapsed * 1e9 / (static_cast<double>(rounds) * dataset.strings.size());
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? std::strtod(argv[1], nullptr) : 0.5;
+    size_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+
+    auto kernels = AvailableKernels();
+    auto best = common::ActiveTranscodeKernel();
+
+    std::printf("=== UTF-16 -> UTF-8 transcoder ===\n");
+    std::printf("default kernel : %s\n", common::TranscodeKernelName(best));
+
+    bool ok = true;
+    for (auto kernel : kernels) {
+        ok = CheckKernel(kernel, iterations) && ok;
+    }
+
+    std::vector<Dataset> datasets;
+    datasets.push_back(MakePaths("paths, ascii", 4096, 0, 0));
+    datasets.push_back(MakePaths("paths, 1% unicode", 4096, 1, 50));
+    datasets.push_back(MakePaths("paths, 50% unicode", 4096, 50, 50));
+    datasets.push_back(MakePaths("paths, all cjk", 4096, 100, 100));
+
+    for (const auto& dataset : datasets) {
+        double avg_units = static_cast<double>(dataset.units) / dataset.strings.size();
+        std::printf("\n%s (%.0f code units per string), ns per string:\n", dataset.name, avg_units);
+
+        std::vector<char> scratch(64 * 1024);
+        double memcpy_ns = Measure(dataset, seconds, [&](const std::u16string& s) {
+            std::memcpy(scratch.data(), s.data(), std::min(scratch.size(), s.size() * sizeof(char16_t)));
+            return static_cast<size_t>(scratch[0]);
+            });
+        // What every conversion pays for its std::string before any transcoding
+        double string_ns = Measure(dataset, seconds, [](const std::u16string& s) {
+            return std::string(s.size(), '\0').size();
+            });
+        double reference_ns = Measure(dataset, seconds, [](const std::u16string& s) {
+            return ReferenceUtf16ToUtf8(s.data(), s.size()).size();
+            });
+        std::printf("  %-10s %8.1f\n", "memcpy", memcpy_ns);
+        std::printf("  %-10s %8.1f  (allocation and zero fill of the result)\n", "string", string_ns);
+        std::printf("  %-10s %8.1f\n", "reference", reference_ns);
+
+        for (auto kernel : kernels) {
+            common::SelectTranscodeKernel(kernel);
+            double ns = Measure(dataset, seconds, [](const std::u16string& s) {
+                return common::Utf16ToUtf8(s.data(), s.size()).size();
+                });
+            std::printf("  %-10s %8.1f  (%.1fx reference, %.2f GB/s of UTF-16)\n",
+                common::TranscodeKernelName(kernel), ns, reference_ns / ns, 2 * avg_units / ns);
+        }
+    }
+
+    common::SelectTranscodeKernel(best);
+    return ok ? 0 : 1;
+}
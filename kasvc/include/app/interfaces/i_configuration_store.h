@@ -1,6 +1,8 @@
 #pragma once
 
+#include "common/overload_policy.h"
 #include "common/result.h"
+#include "common/wait_strategy.h"
 #include <string>
 #include <vector>
 #include <functional>
@@ -17,8 +19,28 @@ namespace kubearmor::app {
         uint16_t grpc_port;
 
         size_t event_queue_size;
-        size_t worker_threads;
-        size_t service_worker_threads;
+        common::OverloadPolicy overload_policy;
+        size_t overload_deadline_ms;
+        common::WaitStrategy consumer_wait;
+        bool sharded_pipeline;          // a queue lane per worker, events kept in order per process
+        size_t worker_threads;          // 0 = "auto", sized by the placement plan
+        size_t completion_batch_size;
+        bool early_reply;
+        bool event_ring;
+        size_t receive_buffer_size;
+        size_t buffers_per_size_class;
+        size_t service_worker_threads;  // 0 = "auto", sized by the placement plan
+        size_t publish_threads;         // 0 = the service workers publish what they enrich
+        size_t publish_queue_size;
+
+        // Placement, see common::PlacementRequest
+        std::vector<uint32_t> placement_cpus;
+        size_t cpu_budget;
+        int numa_node;
+        std::vector<uint32_t> iocp_cpus;
+        std::vector<uint32_t> worker_cpus;
+        bool pin_threads;
+
         std::string log_file;
         std::string log_level;
     };
@@ -9,8 +9,12 @@ namespace kubearmor::app {
     public:
         virtual ~IEventPublisher() = default;
 
-        virtual void Publish(const data::Event& event) = 0;
-        virtual void PublishBatch(const std::vector<data::Event>& events) = 0;
+        // Events are handed over: by the time the call returns they are
+        // written out and released, and with them the kernel messages
+        // they point into. PublishBatch leaves the vector empty, its
+        // capacity kept for the caller's next batch.
+        virtual void Publish(data::Event&& event) = 0;
+        virtual void PublishBatch(std::vector<data::Event>&& events) = 0;
         virtual size_t GetSubscriberCount() const = 0;
 
         struct PublisherStatistics {
@@ -4,6 +4,7 @@
 #include "data/event_types.h"
 #include <chrono>
 #include <optional>
+#include <vector>
 
 namespace kubearmor::app {
 
@@ -16,16 +17,70 @@ namespace kubearmor::app {
         virtual void Disconnect() = 0;
         virtual bool IsConnected() const = 0;
 
+        // Events are queued on one or more lanes, each process's events
+        // always on the same one; a single consumer per lane gets them in
+        // the order they were queued
+        virtual size_t GetLaneCount() const = 0;
+
+        // From any lane
         virtual std::optional<data::Event> ReceiveEvent(
             std::chrono::milliseconds timeout) = 0;
 
+        // Waits up to timeout for an event on lane, then appends it and any
+        // others ready, up to max_events in all. Returns how many were appended.
+        virtual size_t ReceiveEvents(size_t lane, std::vector<data::Event>& events, size_t max_events,
+            std::chrono::milliseconds timeout) = 0;
+
         struct PerformanceMetrics {
-            uint64_t total_messages_received;
+            uint64_t total_messages_received;  // events, batch frames count each record
             uint64_t messages_per_second;
             uint64_t average_latency_us;
             uint64_t buffers_in_use;
             uint64_t buffers_available;
-            uint64_t dropped_messages;
+            uint64_t dropped_messages;    // event queue overload, both classes below
+            uint64_t dropped_alerts;      // MATCH_HOST_POLICY
+            uint64_t dropped_logs;
+            uint64_t completion_batches;  // wakeups that returned messages
+            uint64_t batch_frames;        // messages carrying several events
+            uint64_t batched_events;      // events received in batch frames
+            uint64_t ring_events;         // read from the driver's shared ring
+            uint64_t ring_wakeups;        // doorbells that woke the ring consumer
+            uint64_t ring_overflows;      // did not fit the ring, sent over the port instead
+            uint64_t buffer_handoffs;     // large messages passed on in their receive buffer
+            uint64_t buffer_heap_allocations;  // slab classes were exhausted
+
+            // Driver acknowledgements
+            uint64_t replies_sent;
+            uint64_t early_replies;       // sent before the event was processed
+            uint64_t reply_failures;
+            uint64_t reply_latency_p50_us;
+            uint64_t reply_latency_p99_us;
+            uint64_t reply_latency_max_us;
+
+            // Loss ledger inputs, see MonitoringService::GetLossLedger()
+            uint64_t parse_failures;      // records dropped, never queued
+            uint64_t events_queued;       // offered to the event queue, dropped ones included
+            uint64_t events_dequeued;     // handed out by ReceiveEvent() and ReceiveEvents()
+            uint64_t queue_depth;         // all lanes
+            uint64_t driver_sequence_span;     // driver sequence numbers from lowest to highest seen
+            uint64_t driver_events_received;   // events that carried one
+            uint64_t driver_events_missing;    // numbers in the span that have not arrived
+            uint64_t unsequenced_events;       // events without one
+
+            // Event queue, offered -> handed out
+            uint64_t queue_wait_p50_ns;
+            uint64_t queue_wait_p99_ns;
+            uint64_t queue_wait_p999_ns;
+            uint64_t queue_wait_max_ns;
+
+            // Receive and decode stage: the threads draining the driver, and
+            // the time from a batch's completion to its events being offered
+            // to the event queue, per event
+            uint64_t receive_threads;
+            uint64_t queue_capacity;      // all lanes
+            uint64_t decode_p50_ns;
+            uint64_t decode_p99_ns;
+            uint64_t decode_max_ns;
         };
 
         virtual PerformanceMetrics GetPerformanceMetrics() const = 0;
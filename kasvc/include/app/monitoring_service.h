@@ -3,6 +3,10 @@
 #include "app/interfaces/i_event_publisher.h"
 #include "app/interfaces/i_event_receiver.h"
 #include "data/event_processor.h"
+#include "common/constants.h"
+#include "common/event_sequence.h"
+#include "common/latency_histogram.h"
+#include "common/mpmc_ring.h"
 #include "common/result.h"
 #include <memory>
 #include <thread>
@@ -11,6 +15,13 @@
 
 namespace kubearmor::app {
 
+    // Takes events off the receiver and hands them to the publisher in
+    // stages: worker_threads_count workers enrich what they receive, then
+    // publish it (matching each subscriber's filter, encoding and fanning
+    // out) themselves or, with publish_threads, queue it for publish
+    // workers of its own behind a bounded queue of publish_queue_size.
+    // A full publish queue holds the enrich workers back, and with them the
+    // event queue, where the overload policy decides what goes.
     class MonitoringService {
     public:
         struct MonitoringStatus {
@@ -25,7 +36,10 @@ namespace kubearmor::app {
             std::shared_ptr<IEventReceiver> event_receiver,
             std::shared_ptr<IEventPublisher> publisher,
             std::shared_ptr<data::EventProcessor> processor,
-            size_t worker_threads_count);
+            size_t worker_threads_count,
+            std::vector<uint32_t> worker_cpus = {},
+            size_t publish_threads = 0,
+            size_t publish_queue_size = constants::PUBLISH_QUEUE_SIZE);
 
         ~MonitoringService();
 
@@ -40,28 +54,72 @@ namespace kubearmor::app {
             uint64_t events_processed;
             uint64_t events_published;
             uint64_t processing_errors;
+            // events handed to the publisher ahead of an earlier one of the
+            // same process, and events of processes too many to track
+            uint64_t ordering_violations;
+            uint64_t ordering_untracked;
             std::chrono::steady_clock::time_point start_time;
         };
 
         Statistics GetStatistics() const;
         void ResetStatistics();
 
+        // Where events went, stage by stage from the driver's sequence
+        // numbers to the hand-off to the publisher. A stage's Unaccounted()
+        // events were lost without being counted as dropped; for the driver
+        // stage those are the sequence numbers that never arrived.
+        std::vector<common::StageLedger> GetLossLedger() const;
+
+        // A pipeline stage: the threads that run it, the bounded queue it
+        // takes events from, and its service time per event, measured over
+        // each batch it handles. Where the queue stays full and the service
+        // time is high, the stage needs more threads.
+        struct StageMetrics {
+            const char* stage;
+            size_t workers;             // 0: runs on the previous stage's threads
+            uint64_t queue_depth;
+            uint64_t queue_capacity;    // 0: no queue in front of it
+            uint64_t events;            // taken in
+            uint64_t service_p50_ns;
+            uint64_t service_p99_ns;
+            uint64_t service_max_ns;
+        };
+
+        // receive (the receiver's threads, parsing included), enrich, publish
+        std::vector<StageMetrics> GetStageMetrics() const;
+
     private:
-        void EventLoopThread();
-        void ProcessEvent(const data::Event& event);
+        void EventLoopThread(size_t lane);
+        void PublishLoopThread();
+
+        // Enriches the batch in place, dropping events that fail
+        void EnrichBatch(std::vector<data::Event>& batch);
+        void PublishBatch(std::vector<data::Event>& batch);
 
         std::shared_ptr<IEventReceiver> event_receiver_;
         std::shared_ptr<IEventPublisher> publisher_;
         std::shared_ptr<data::EventProcessor> processor_;
         size_t worker_threads_count_;
+        std::vector<uint32_t> worker_cpus_;     // empty = unpinned
+        size_t publish_threads_count_;
+        size_t publish_queue_size_;
+
+        // Enriched events waiting for a publish worker, null without them
+        std::unique_ptr<common::MpmcRing<data::Event>> publish_queue_;
 
         std::atomic<bool> running_;
         std::vector<std::thread> worker_threads_;
+        std::vector<std::thread> publish_threads_;
 
         std::atomic<uint64_t> events_received_{ 0 };
         std::atomic<uint64_t> events_processed_{ 0 };
         std::atomic<uint64_t> events_published_{ 0 };
-        std::atomic<uint64_t> processing_errors_{ 0 };
+        std::atomic<uint64_t> events_enriched_{ 0 };
+        std::atomic<uint64_t> enrich_errors_{ 0 };
+        std::atomic<uint64_t> publish_errors_{ 0 };
+        common::LatencyHistogram enrich_ns_;
+        common::LatencyHistogram publish_ns_;
+        common::OrderTracker order_;
         std::chrono::steady_clock::time_point start_time_;
     };
 
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "comm/kernel_message.h"
+#include "common/result.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace kubearmor::comm {
+
+    // Builds a batch frame (KernelBatchHeader and its records) in a caller
+    // provided buffer, the way the driver stages audit-only events. It does
+    // not allocate or throw, so it runs unchanged against any buffer.
+    class EventBatchWriter {
+    public:
+        EventBatchWriter(uint8_t* frame, size_t capacity);
+
+        // Frame bytes a record takes for an EVENT of event_size bytes
+        static size_t RecordSize(size_t event_size);
+
+        bool Fits(size_t event_size) const;
+
+        // Copies an EVENT and its strings, offsets relative to the EVENT;
+        // false if the frame has no room for it
+        bool Append(const uint8_t* event, size_t event_size);
+
+        // Writes the frame header, returns the frame size
+        size_t Finish();
+
+        void Reset();
+
+        uint16_t count() const { return count_; }
+        size_t size() const { return size_; }
+        bool empty() const { return count_ == 0; }
+
+    private:
+        uint8_t* frame_;
+        size_t capacity_;
+        size_t size_;
+        uint16_t count_;
+    };
+
+    // One EVENT and its strings
+    struct EventRecord {
+        const uint8_t* data;
+        size_t size;
+    };
+
+    // Iterates the EVENT records of a message payload (the bytes after
+    // FILTER_MESSAGE_HEADER). A batch frame yields each of its records, any
+    // other payload is a single-event message and yields itself, so frames
+    // and single events can share a port. Create() validates the frame
+    // header and every record header once.
+    class EventBatchReader {
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = EventRecord;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const EventRecord*;
+            using reference = const EventRecord&;
+
+            reference operator*() const { return record_; }
+            pointer operator->() const { return &record_; }
+
+            Iterator& operator++();
+            Iterator operator++(int) {
+                Iterator previous = *this;
+                ++(*this);
+                return previous;
+            }
+
+            bool operator==(const Iterator& other) const { return remaining_ == other.remaining_; }
+            bool operator!=(const Iterator& other) const { return remaining_ != other.remaining_; }
+
+        private:
+            friend class EventBatchReader;
+
+            Iterator(const uint8_t* position, size_t remaining, bool framed, EventRecord record);
+            void Load();
+
+            const uint8_t* position_;
+            size_t remaining_;
+            bool framed_;
+            EventRecord record_;
+        };
+
+        static bool IsBatch(const uint8_t* payload, size_t size);
+
+        static common::Result<EventBatchReader> Create(const uint8_t* payload, size_t size);
+
+        bool framed() const { return framed_; }
+        size_t count() const { return count_; }
+
+        Iterator begin() const;
+        Iterator end() const;
+
+    private:
+        EventBatchReader(const uint8_t* payload, size_t size, size_t count, bool framed)
+            : payload_(payload), size_(size), count_(count), framed_(framed) {
+        }
+
+        const uint8_t* payload_;
+        size_t size_;
+        size_t count_;
+        bool framed_;
+    };
+
+} // namespace kubearmor::comm
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "comm/event_batch.h"
+#include "common/result.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace kubearmor::comm {
+
+    // Shared-section ring the driver writes audit-only EVENT records into
+    // (EVENT_RING_HEADER in driver/Filter.h). One producer, serialized by the
+    // driver, and one consumer. Indices count bytes since the ring was
+    // formatted and are masked by the power-of-two capacity; records are
+    // EVENT_RECORD_ALIGNMENT aligned and never straddle the end of the data
+    // area, a WRAP record pads the rest of it instead.
+    //
+    // Doorbell: a consumer that finds the ring empty sets consumer_waiting and
+    // checks again before it sleeps, the producer clears it after publishing
+    // and only then signals, so the kernel sets an event only when the ring
+    // goes non-empty under a parked consumer.
+    constexpr uint64_t EVENT_RING_MAGIC = 0x0031474E4952414BULL;   // "KARING1"
+    constexpr uint32_t EVENT_RING_VERSION = 1;
+
+    enum class EventRingRecordType : uint32_t {
+        EVENT = 1,
+        WRAP = 2    // skip to the start of the data area
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+        std::atomic<uint32_t>::is_always_lock_free,
+        "ring indices are shared with another address space");
+
+    struct EventRingHeader {
+        // Written once by the producer when the ring is formatted
+        uint64_t magic;
+        uint32_t version;
+        uint32_t header_size;       // data area starts here
+        uint64_t capacity;          // data area bytes, a power of two
+        uint8_t reserved0[40];
+
+        // Producer cache line
+        std::atomic<uint64_t> write_index;
+        std::atomic<uint64_t> overflow_records;  // did not fit, sent over the message port
+        std::atomic<uint64_t> overflow_bytes;
+        std::atomic<uint64_t> doorbells;
+        uint8_t reserved1[32];
+
+        // Consumer cache line
+        std::atomic<uint64_t> read_index;
+        std::atomic<uint32_t> consumer_waiting;
+        uint32_t reserved2;
+        uint8_t reserved3[48];
+    };
+
+    struct EventRingRecordHeader {
+        uint32_t length;            // record header and EVENT with its strings, before padding
+        uint32_t type;              // EventRingRecordType
+    };
+
+    static_assert(sizeof(EventRingHeader) == 192, "EventRingHeader must match EVENT_RING_HEADER");
+    static_assert(offsetof(EventRingHeader, write_index) == 64, "producer line offset");
+    static_assert(offsetof(EventRingHeader, read_index) == 128, "consumer line offset");
+    static_assert(sizeof(EventRingRecordHeader) == 8, "EventRingRecordHeader must match EVENT_RING_RECORD");
+
+    // Producer side, what the driver does under its ring lock. Used by the
+    // harnesses that stand in for the driver.
+    class EventRingWriter {
+    public:
+        // Formats a ring over region, the data area is the largest power of
+        // two that fits after the header
+        static common::Result<EventRingWriter> Format(void* region, size_t size);
+
+        // Whether an EVENT of event_size bytes fits the free space now
+        bool Fits(size_t event_size);
+
+        // Copies an EVENT and its strings into the ring. False if it does
+        // not fit the free space, which is counted as an overflow. doorbell
+        // is set when the consumer is parked and has to be signalled.
+        bool Write(const uint8_t* event, size_t event_size, bool& doorbell);
+
+        uint64_t overflow_records() const { return header_->overflow_records.load(std::memory_order_relaxed); }
+
+    private:
+        explicit EventRingWriter(EventRingHeader* header);
+
+        // Ring bytes a record takes at the current position, wrap padding included
+        uint64_t Needed(size_t event_size) const;
+
+        EventRingHeader* header_;
+        uint8_t* data_;
+        uint64_t mask_;
+        uint64_t write_index_;      // our copy, the shared one is only published to
+        uint64_t read_index_;       // last read_index seen, refreshed when space runs out
+    };
+
+    enum class EventRingStatus {
+        RECORD,     // record holds the next EVENT
+        EMPTY,
+        CORRUPT     // a record header is out of bounds, the ring cannot be trusted
+    };
+
+    // Consumer side. Records stay in the ring until Release(), so a caller
+    // copies what it keeps and releases a whole drain at once.
+    class EventRingReader {
+    public:
+        // Validates a ring the producer formatted over region
+        static common::Result<EventRingReader> Attach(void* region, size_t size);
+
+        EventRingStatus Read(EventRecord& record);
+
+        // Returns the space of every record read so far to the producer
+        void Release();
+
+        // Call before sleeping on the doorbell, false if records arrived in
+        // the meantime and the caller should read instead
+        bool PrepareToWait();
+        void FinishWait();
+
+        uint64_t overflow_records() const { return header_->overflow_records.load(std::memory_order_relaxed); }
+        uint64_t doorbells() const { return header_->doorbells.load(std::memory_order_relaxed); }
+        uint64_t capacity() const { return mask_ + 1; }
+
+    private:
+        explicit EventRingReader(EventRingHeader* header);
+
+        EventRingHeader* header_;
+        const uint8_t* data_;
+        uint64_t mask_;
+        uint64_t read_index_;       // next record, published by Release()
+        uint64_t write_index_;      // last write_index seen
+    };
+
+} // namespace kubearmor::comm
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "common/result.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace kubearmor::comm {
+
+    // The memory an EventRingReader runs over and the doorbell that wakes it.
+    // On Windows the driver maps its ring section into the service and
+    // signals an event, the harnesses back it with a memfd and an eventfd.
+    class IEventRingSection {
+    public:
+        virtual ~IEventRingSection() = default;
+
+        virtual common::Result<void> Map() = 0;
+        virtual void Unmap() = 0;
+
+        virtual void* base() const = 0;
+        virtual size_t size() const = 0;
+
+        // Sleep until the producer rings or timeout, true if it rang
+        virtual bool WaitDoorbell(std::chrono::milliseconds timeout) = 0;
+
+        // Unblock WaitDoorbell, used on shutdown
+        virtual void Wake() = 0;
+    };
+
+} // namespace kubearmor::comm
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "common/result.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace kubearmor::comm {
+
+    // A posted receive: the transport fills message_buffer with exactly one
+    // kernel message (FILTER_MESSAGE_HEADER followed by the EVENT record).
+    struct ReceiveRequest {
+        uint8_t* message_buffer = nullptr;
+        size_t buffer_size = 0;
+        // transport-owned per-request state, i.e. the OVERLAPPED on Windows
+        void* port_context = nullptr;
+    };
+
+    struct Completion {
+        ReceiveRequest* request = nullptr;
+        size_t bytes_transferred = 0;
+        uint32_t error = 0; // 0 on success, platform error code otherwise
+    };
+
+    enum class CompletionStatus {
+        COMPLETED,  // completion holds a finished (or failed) receive
+        TIMEOUT,    // nothing completed within the timeout
+        WAKEUP,     // woken up by Wake(), no request attached
+        CLOSED      // the port has been torn down
+    };
+
+    // Completion-port style transport between the driver and the service.
+    // The real implementation wraps FilterGetMessage/IOCP, the synthetic one
+    // stands in for the driver so the pipeline can be exercised anywhere.
+    class IFilterPort {
+    public:
+        virtual ~IFilterPort() = default;
+
+        // Connection management
+        virtual common::Result<void> Connect(size_t concurrency) = 0;
+        virtual void Disconnect() = 0;
+        virtual bool IsConnected() const = 0;
+
+        // Per-request transport state, called once per pooled request
+        virtual common::Result<void> Attach(ReceiveRequest* request) = 0;
+        virtual void Detach(ReceiveRequest* request) = 0;
+
+        // Post a buffer for the next kernel message
+        virtual bool SubmitReceive(ReceiveRequest* request) = 0;
+
+        // Dequeue one completion, blocks for up to timeout
+        virtual CompletionStatus GetCompletion(Completion& completion,
+            std::chrono::milliseconds timeout) = 0;
+
+        // Dequeue up to max_count completions in one wait (the
+        // GetQueuedCompletionStatusEx model). Blocks for up to timeout for the
+        // first one and only drains what is already queued after that. Returns
+        // COMPLETED with count >= 1, or the status of the first wait with
+        // count == 0. Wakeups are never mixed into a returned batch.
+        virtual CompletionStatus GetCompletions(Completion* completions,
+            size_t max_count, size_t& count, std::chrono::milliseconds timeout) {
+
+            count = 0;
+            CompletionStatus status = GetCompletion(completions[0], timeout);
+            if (status != CompletionStatus::COMPLETED) {
+                return status;
+            }
+            count = 1;
+
+            // Fallback for transports without a native batch dequeue
+            while (count < max_count) {
+                Completion next;
+                CompletionStatus more = GetCompletion(next, std::chrono::milliseconds(0));
+                if (more == CompletionStatus::WAKEUP) {
+                    Wake();  // hand it on, another thread is waiting for it
+                    break;
+                }
+                if (more != CompletionStatus::COMPLETED) {
+                    break;
+                }
+                completions[count++] = next;
+            }
+            return CompletionStatus::COMPLETED;
+        }
+
+        // Cancel all outstanding receives, they complete with an error
+        virtual void CancelReceives() = 0;
+
+        // Wake one thread blocked in GetCompletion
+        virtual void Wake() = 0;
+
+        // Acknowledge a message that expects a reply
+        virtual bool SendReply(uint64_t message_id, int32_t status) = 0;
+    };
+
+} // namespace kubearmor::comm
\ No newline at end of file
@@ -1,10 +1,19 @@
 #pragma once
 
 #include "app/interfaces/i_event_receiver.h"  // Changed!
+#include "comm/event_ring.h"
+#include "comm/interfaces/i_event_ring_section.h"
+#include "comm/interfaces/i_filter_port.h"
 #include "comm/kernel_message.h"
-#include "common/thread_safe_queue.h"
-#include <Windows.h>
-#include <fltUser.h>
+#include "common/buffer_pool.h"
+#include "common/constants.h"
+#include "common/event_sequence.h"
+#include "common/latency_histogram.h"
+#include "common/lock_free_index_pool.h"
+#include "common/logger.h"
+#include "common/mpmc_ring.h"
+#include "common/overload_policy.h"
+#include "common/wait_strategy.h"
 #include <vector>
 #include <thread>
 #include <atomic>
@@ -12,17 +21,44 @@
 
 namespace kubearmor::comm {
 
+    // Completion-port receive loop on top of an IFilterPort: keeps a pool of
+    // receive buffers posted, parses completed messages, queues the events and
+    // replies to the driver. With a ring section, audit-only events the driver
+    // writes into the shared ring are drained by one more thread that sleeps
+    // on the doorbell when the ring is empty.
     class IOCPFilterPortCommunicator : public app::IEventReceiver {
     public:
         struct IOCPConfig {
-            std::wstring port_name;
             size_t worker_thread_count;
             size_t concurrent_operations;
             size_t buffer_size;
             size_t buffer_pool_size;
+            // completions drained per wakeup, 1 = one GetQueuedCompletionStatus per message
+            size_t completion_batch_size = constants::DEFAULT_COMPLETION_BATCH;
+            // acknowledge audit-only messages before parsing and queueing them
+            bool early_reply = true;
+            // slab buffers per MESSAGE_SIZE_CLASSES entry for handed-off messages
+            size_t buffers_per_size_class = constants::MESSAGE_BUFFERS_PER_CLASS;
+            // what a full event queue does with new events, and how long the
+            // policies that wait may stall a receive thread
+            common::OverloadPolicy overload_policy = common::OverloadPolicy::SHED_LOGS;
+            std::chrono::milliseconds overload_deadline = constants::DEFAULT_OVERLOAD_DEADLINE;
+            // how consumers waiting on an empty event queue wait
+            common::WaitStrategy consumer_wait = common::WaitStrategy::BALANCED;
+            // event queue lanes, events hashed to them by process: 0 or 1 is
+            // a single queue any consumer takes from, N keeps each process's
+            // events in order for one consumer per lane. MAX_EVENT_QUEUE_SIZE
+            // is split between the lanes.
+            size_t event_lanes = 0;
+            // CPUs the IOCP workers and the ring thread run on, empty = unpinned
+            std::vector<uint32_t> cpus;
+            // NUMA node the buffer slabs are allocated on, -1 = no preference
+            int numa_node = -1;
         };
 
-        explicit IOCPFilterPortCommunicator(const IOCPConfig& config);
+        IOCPFilterPortCommunicator(const IOCPConfig& config,
+            std::unique_ptr<IFilterPort> port,
+            std::unique_ptr<IEventRingSection> ring_section = nullptr);
         ~IOCPFilterPortCommunicator() override;
 
         // IEventReceiver implementation
@@ -30,19 +66,20 @@ namespace kubearmor::comm {
         void Disconnect() override;
         bool IsConnected() const override;
 
+        size_t GetLaneCount() const override { return lanes_.size(); }
         std::optional<data::Event> ReceiveEvent(
             std::chrono::milliseconds timeout) override;
+        size_t ReceiveEvents(size_t lane, std::vector<data::Event>& events, size_t max_events,
+            std::chrono::milliseconds timeout) override;
 
         PerformanceMetrics GetPerformanceMetrics() const override;
 
     private:
         // IOCP context structure
-        struct IOContext {
-            OVERLAPPED overlapped;
-            uint8_t* message_buffer;
-            size_t buffer_size;
+        struct IOContext : ReceiveRequest {
             IOCPFilterPortCommunicator* communicator;
-            bool in_use;
+            common::BufferRef buffer;   // backs message_buffer
+            size_t pool_index;
             std::chrono::steady_clock::time_point submit_time;
         };
 
@@ -50,35 +87,95 @@ namespace kubearmor::comm {
         IOContext* AllocateContext(std::chrono::milliseconds timeout = std::chrono::milliseconds(100));
         void FreeContext(IOContext* context);
         bool SubmitReceive(IOContext* context);
+        void ReleaseContextPool();
 
         // IOCP worker threads
         void IOCPWorkerThread();
+        void PinThread(const std::vector<uint32_t>& cpus, const char* role);
+
+        // Event processing: parse, queue and acknowledge a drained batch
+        struct PendingReply {
+            uint64_t message_id;
+            uint64_t kernel_time;   // 0 if the message was truncated
+        };
+
+        void ProcessCompletions(const Completion* completions, size_t count,
+            std::vector<data::Event>& events, std::vector<PendingReply>& replies);
 
-        // Event processing
-        void ProcessCompletedIO(IOContext* context, DWORD bytes_transferred);
+        // Shared ring consumer, runs until Disconnect() or a corrupt ring
+        void EventRingThread(EventRingReader reader);
 
-        // Reply sending
-        bool SendReply(const FILTER_MESSAGE_HEADER* msg_header, HRESULT status);
+        // Queues under config_.overload_policy and accounts for what it drops
+        void QueueEvents(std::vector<data::Event>& events);
+
+        // Lane of a process's events; network events, which carry no
+        // process, stay in order per port pair
+        size_t LaneOf(const data::Event& event) const;
+
+        // Moves a received message into a buffer the event can own
+        common::BufferRef CaptureMessage(IOContext* context, size_t bytes_transferred);
+
+        // Reply sending, batch frames are sent without a reply buffer
+        bool NeedsReply(const Completion& completion) const;
+        bool RepliesEarly(const Completion& completion) const;
+        bool SendReply(uint64_t message_id, uint64_t kernel_time, int32_t status, bool early);
 
         IOCPConfig config_;
-        HANDLE filter_port_;
-        HANDLE iocp_handle_;
+        std::unique_ptr<IFilterPort> port_;
 
         std::atomic<bool> running_;
         std::vector<std::thread> worker_threads_;
 
-        // Buffer pool
+        // Buffer pool: context_pool_ owns the contexts, free_contexts_ hands
+        // out their indices
         std::vector<std::unique_ptr<IOContext>> context_pool_;
-        std::mutex context_pool_mutex_;
-        std::condition_variable context_available_;
-
-        // Event queue for dispatch
-        common::ThreadSafeQueue<data::Event> event_queue_;
+        common::LockFreeIndexPool free_contexts_;
+
+        // Slabs for receive buffers and for messages handed to the pipeline,
+        // events still holding handed-off buffers keep the slabs alive
+        std::shared_ptr<common::BufferPool> buffer_pool_;
+        std::atomic<uint64_t> buffer_handoffs_{ 0 };
+
+        // Driver event ring, optional
+        std::unique_ptr<IEventRingSection> ring_section_;
+        std::thread ring_thread_;
+
+        // Event queue lanes for dispatch, and how long events wait in them
+        // (offered to the queue -> taken by a consumer)
+        common::LatencyHistogram queue_wait_ns_;
+        std::vector<std::unique_ptr<common::MpmcRing<data::Event>>> lanes_;
+        std::atomic<size_t> next_lane_{ 0 };    // ReceiveEvent() round robin
+        size_t queue_capacity_{ 0 };
+
+        // Completion -> offered to the lanes, per event of a batch
+        common::LatencyHistogram decode_ns_;
+
+        // Loss accounting: driver sequence numbers as they arrive, records
+        // that did not parse, and events in and out of the lanes
+        common::SequenceTracker driver_sequence_;
+        std::atomic<uint64_t> parse_failures_{ 0 };
+        std::atomic<uint64_t> events_queued_{ 0 };
+        std::atomic<uint64_t> events_dequeued_{ 0 };
 
         // Performance
         std::atomic<uint64_t> total_messages_{ 0 };
         std::atomic<uint64_t> total_latency_us_{ 0 };
         std::atomic<uint64_t> dropped_messages_{ 0 };
+        std::atomic<uint64_t> dropped_alerts_{ 0 };
+        std::atomic<uint64_t> dropped_logs_{ 0 };
+        common::LogThrottle drop_log_throttle_{ std::chrono::seconds(5) };
+        std::atomic<uint64_t> completion_batches_{ 0 };
+        std::atomic<uint64_t> batch_frames_{ 0 };
+        std::atomic<uint64_t> batched_events_{ 0 };
+        std::atomic<uint64_t> ring_events_{ 0 };
+        std::atomic<uint64_t> ring_wakeups_{ 0 };
+        std::atomic<uint64_t> ring_overflows_{ 0 };
+
+        // Driver acknowledgements, latency is kernel timestamp -> reply sent
+        std::atomic<uint64_t> replies_sent_{ 0 };
+        std::atomic<uint64_t> early_replies_{ 0 };
+        std::atomic<uint64_t> reply_failures_{ 0 };
+        common::LatencyHistogram reply_latency_us_;
         std::chrono::steady_clock::time_point last_stats_time_;
         uint64_t last_message_count_{ 0 };
     };
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "comm/kernel_message.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+namespace kubearmor::comm {
+
+    // Strings an EVENT record can carry, the slots KernelEventView keeps
+    enum KernelStringField : uint8_t {
+        PROCESS_PATH,
+        FILE_PATH,
+        COMMAND_LINE,
+        PARENT_PROCESS_PATH,
+        KERNEL_STRING_FIELD_COUNT
+    };
+
+    // Where one string's offset and byte length sit in an operation's body
+    template<typename Body>
+    struct KernelStringLayout {
+        KernelStringField field;
+        uint32_t Body::* offset;
+        uint32_t Body::* length;
+    };
+
+    // Field layout of each operation's EVENT body, declared once here and
+    // nowhere else: Body is the union member, Select() picks it out and
+    // STRINGS lists the strings that follow the EVENT. A new operation (or a
+    // new string) is a specialization, the decoder below is generated from it.
+    template<KernelEventOperation Operation>
+    struct KernelEventLayout;
+
+    template<>
+    struct KernelEventLayout<KernelEventOperation::FILE_EVENT> {
+        using Body = KernelFileEvent;
+        static const Body& Select(const KernelEvent& event) { return event.data.file; }
+
+        static constexpr std::array<KernelStringLayout<Body>, 2> STRINGS{ {
+            { PROCESS_PATH, &Body::process_path_offset, &Body::process_path_length },
+            { FILE_PATH, &Body::file_path_offset, &Body::file_path_length },
+        } };
+    };
+
+    template<>
+    struct KernelEventLayout<KernelEventOperation::PROCESS_EVENT> {
+        using Body = KernelProcessEvent;
+        static const Body& Select(const KernelEvent& event) { return event.data.process; }
+
+        static constexpr std::array<KernelStringLayout<Body>, 3> STRINGS{ {
+            { PROCESS_PATH, &Body::process_path_offset, &Body::process_path_length },
+            { COMMAND_LINE, &Body::command_line_offset, &Body::command_line_length },
+            { PARENT_PROCESS_PATH, &Body::parent_process_path_offset, &Body::parent_process_path_length },
+        } };
+    };
+
+    template<>
+    struct KernelEventLayout<KernelEventOperation::NETWORK_EVENT> {
+        using Body = KernelNetworkEvent;
+        static const Body& Select(const KernelEvent& event) { return event.data.network; }
+
+        static constexpr std::array<KernelStringLayout<Body>, 0> STRINGS{};
+    };
+
+    namespace layout_detail {
+
+        // Every string is checked before any is stored, with the checks
+        // folded into one mask: an empty string is valid wherever it points,
+        // anything else has to be whole code units between the end of the
+        // EVENT and the end of the record
+        inline bool StringInvalid(uint32_t offset, uint32_t length, size_t size) {
+            uint64_t end = static_cast<uint64_t>(offset) + length;    // cannot wrap
+            bool misaligned = ((offset | length) & (sizeof(char16_t) - 1)) != 0;
+            return (length != 0) & (misaligned | (offset < sizeof(KernelEvent)) | (end > size));
+        }
+
+        // An empty string's offset is not looked at, it may point anywhere
+        inline std::u16string_view StringAt(const KernelEvent& event, uint32_t offset, uint32_t length) {
+            const auto* base = reinterpret_cast<const uint8_t*>(&event);
+            return std::u16string_view(length ? reinterpret_cast<const char16_t*>(base + offset) : nullptr,
+                length / sizeof(char16_t));
+        }
+
+        // Layouts without strings (NETWORK) expand to nothing
+        template<typename Layout, size_t... I>
+        bool DecodeStrings(const KernelEvent& event, [[maybe_unused]] size_t size,
+            [[maybe_unused]] std::u16string_view* strings, std::index_sequence<I...>) {
+
+            const auto& body = Layout::Select(event);
+            bool invalid = false;
+            ((invalid |= StringInvalid(body.*Layout::STRINGS[I].offset, body.*Layout::STRINGS[I].length, size)), ...);
+            if (invalid) {
+                return false;
+            }
+
+            ((strings[Layout::STRINGS[I].field] = StringAt(event, body.*Layout::STRINGS[I].offset,
+                body.*Layout::STRINGS[I].length)), ...);
+            return true;
+        }
+
+    } // namespace layout_detail
+
+    // Resolves an operation's strings against a record of size bytes into
+    // strings (indexed by KernelStringField), false if any is out of bounds.
+    // The event's alignment has been checked by the caller.
+    template<KernelEventOperation Operation>
+    bool DecodeKernelStrings(const KernelEvent& event, size_t size, std::u16string_view* strings) {
+        using Layout = KernelEventLayout<Operation>;
+        return layout_detail::DecodeStrings<Layout>(event, size, strings,
+            std::make_index_sequence<Layout::STRINGS.size()>());
+    }
+
+    enum class KernelDecodeStatus {
+        OK,
+        UNKNOWN_OPERATION,
+        OUT_OF_BOUNDS
+    };
+
+    // Picks the decoder for the event's operation; the decoders are inlined
+    // into the dispatch rather than called through a table
+    inline KernelDecodeStatus DecodeKernelStrings(const KernelEvent& event, size_t size,
+        std::u16string_view* strings) {
+
+        bool valid;
+        switch (event.event_operation) {
+        case KernelEventOperation::FILE_EVENT:
+            valid = DecodeKernelStrings<KernelEventOperation::FILE_EVENT>(event, size, strings);
+            break;
+        case KernelEventOperation::PROCESS_EVENT:
+            valid = DecodeKernelStrings<KernelEventOperation::PROCESS_EVENT>(event, size, strings);
+            break;
+        case KernelEventOperation::NETWORK_EVENT:
+            valid = DecodeKernelStrings<KernelEventOperation::NETWORK_EVENT>(event, size, strings);
+            break;
+        default:
+            return KernelDecodeStatus::UNKNOWN_OPERATION;
+        }
+        return valid ? KernelDecodeStatus::OK : KernelDecodeStatus::OUT_OF_BOUNDS;
+    }
+
+} // namespace kubearmor::comm
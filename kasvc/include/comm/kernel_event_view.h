@@ -0,0 +1,52 @@
+#pragma once
+
+#include "comm/kernel_event_layout.h"
+#include "comm/kernel_message.h"
+#include "common/result.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace kubearmor::comm {
+
+    // Read-only view over one EVENT record and its strings, either the body
+    // of a single-event message or a record of a batch frame. Create() checks
+    // every string the event carries against the record size once, with the
+    // decoder KernelEventLayout generates for the operation, after which the
+    // UTF-16 spans can be read without further bounds checks. The view does
+    // not own the buffer.
+    class KernelEventView {
+    public:
+        static common::Result<KernelEventView> Create(const uint8_t* event, size_t size);
+
+        const KernelEvent* event() const { return event_; }
+        size_t size() const { return size_; }
+
+        uint64_t timestamp() const { return event_->timestamp; }
+        uint64_t sequence() const { return event_->sequence; }
+        KernelEventType event_type() const { return event_->event_type; }
+        KernelEventOperation event_operation() const { return event_->event_operation; }
+        bool blocked() const { return event_->blocked; }
+        bool verdict_required() const { return event_->verdict_required(); }
+
+        const KernelFileEvent& file() const { return event_->data.file; }
+        const KernelProcessEvent& process() const { return event_->data.process; }
+        const KernelNetworkEvent& network() const { return event_->data.network; }
+
+        // UTF-16 strings, empty when the event does not carry them
+        std::u16string_view process_path() const { return strings_[PROCESS_PATH]; }
+        std::u16string_view file_path() const { return strings_[FILE_PATH]; }
+        std::u16string_view command_line() const { return strings_[COMMAND_LINE]; }
+        std::u16string_view parent_process_path() const { return strings_[PARENT_PROCESS_PATH]; }
+
+    private:
+        KernelEventView(const KernelEvent* event, size_t size)
+            : event_(event), size_(size) {
+        }
+
+        const KernelEvent* event_;
+        size_t size_;
+        std::u16string_view strings_[KERNEL_STRING_FIELD_COUNT];
+    };
+
+} // namespace kubearmor::comm
\ No newline at end of file
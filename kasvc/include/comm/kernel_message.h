@@ -1,8 +1,27 @@
 #pragma once
 
-#include <Windows.h>
+#include "common/timestamp.h"
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+
+#ifdef _WIN32
+#include <Windows.h>
 #include <fltUser.h>
+#else
+// Off Windows we mirror the filter manager headers from fltUserStructures.h
+// so the wire layout (and everything that parses it) can be built and
+// benchmarked without the SDK.
+typedef struct _FILTER_MESSAGE_HEADER {
+    uint32_t ReplyLength;
+    uint64_t MessageId;
+} FILTER_MESSAGE_HEADER, * PFILTER_MESSAGE_HEADER;
+
+typedef struct _FILTER_REPLY_HEADER {
+    int32_t Status;
+    uint64_t MessageId;
+} FILTER_REPLY_HEADER, * PFILTER_REPLY_HEADER;
+#endif
 
 namespace kubearmor::comm {
 
@@ -17,6 +36,34 @@ namespace kubearmor::comm {
         NETWORK_EVENT = 3
     };
 
+    // EVENT.flags (EVENT_FLAG_* in driver/Filter.h)
+    enum class KernelEventFlags : uint8_t {
+        NONE = 0x00,
+        // the kernel thread waits for an evaluated verdict, everything else
+        // is audit-only and can be acknowledged as soon as it is received
+        VERDICT_REQUIRED = 0x01
+    };
+
+    // KeQuerySystemTime: 100 ns ticks since 1601-01-01 (UTC), a FILETIME
+    constexpr uint64_t UNIX_EPOCH_IN_KERNEL_TICKS = common::UNIX_EPOCH_IN_FILETIME_TICKS;
+
+    inline std::chrono::system_clock::time_point KernelTimeToSystemTime(uint64_t kernel_time) {
+        return common::FileTimeToSystemTime(kernel_time);
+    }
+
+    // EVENT_BATCH_MAGIC: sits where a single event has its timestamp and has
+    // the sign bit set, which KeQuerySystemTime never returns
+    constexpr uint64_t EVENT_BATCH_MAGIC = 0x8000000042544348ULL;
+    constexpr uint16_t EVENT_BATCH_VERSION = 1;
+    constexpr size_t EVENT_RECORD_ALIGNMENT = 8;
+
+    // address_family values as the kernel reports them (Windows AF_*),
+    // these differ from the host values on non-Windows platforms
+    enum class KernelAddressFamily : uint8_t {
+        INET = 2,
+        INET6 = 23
+    };
+
 #pragma pack(push, 8)
 
     struct KernelFileEvent {
@@ -51,44 +98,81 @@ namespace kubearmor::comm {
         uint8_t address_family;
     };
 
-    struct KernelMessage {
-        FILTER_MESSAGE_HEADER header;
-
+    // EVENT in driver/Filter.h, string offsets are relative to its start
+    struct KernelEvent {
         uint64_t timestamp;
         KernelEventType event_type;
         KernelEventOperation event_operation;
         bool blocked;
+        uint8_t flags;
         union {
             KernelFileEvent file;
             KernelProcessEvent process;
             KernelNetworkEvent network;
         } data;
+        // per connection, from 1: numbers that never arrive were lost
+        uint64_t sequence;
 
+        bool verdict_required() const {
+            return (flags & static_cast<uint8_t>(KernelEventFlags::VERDICT_REQUIRED)) != 0;
+        }
+    };
 
-        const wchar_t* get_string_at_offset(size_t offset, size_t buffer_size) const {
-            const uint8_t* buffer_start = reinterpret_cast<const uint8_t*>(this);
-            // this should be offset by kernel header, as kenel event struct doesn't have
-            // header defined and offsets are calculated relative to event
-            const uint8_t* string_area_start = buffer_start + sizeof(FILTER_MESSAGE_HEADER);
-            const uint8_t* target = string_area_start + offset;
+    // Message carrying a single event, as FilterGetMessage returns it
+    struct KernelMessage {
+        FILTER_MESSAGE_HEADER header;
+        KernelEvent event;
+    };
 
-            if (target >= buffer_start + buffer_size) {
-                return nullptr;
-            }
+    // EVENT_BATCH_HEADER in driver/Filter.h. A batch frame is this header
+    // followed by record_count records, each a KernelRecordHeader and an
+    // EVENT with its strings, starting on an EVENT_RECORD_ALIGNMENT boundary.
+    struct KernelBatchHeader {
+        uint64_t magic;
+        uint16_t version;
+        uint16_t record_count;
+        uint32_t length;        // header and records, in bytes
+    };
 
-            return reinterpret_cast<const wchar_t*>(target);
-        }
+    // EVENT_RECORD_HEADER in driver/Filter.h
+    struct KernelRecordHeader {
+        uint32_t length;        // record header, EVENT and strings, before padding
+        uint32_t reserved;
     };
 
 #pragma pack(pop)
 
-    // compile-time size checks 
+    // compile-time size checks
     // we need this to match the user and kernel structs for compatibility
     static_assert(sizeof(KernelFileEvent) == 24,
         "KernelFileEvent size mismatch!");
+    static_assert(sizeof(KernelProcessEvent) == 36,
+        "KernelProcessEvent size mismatch!");
+    static_assert(sizeof(KernelNetworkEvent) == 52,
+        "KernelNetworkEvent size mismatch!");
+    static_assert(sizeof(FILTER_MESSAGE_HEADER) == 16,
+        "FILTER_MESSAGE_HEADER size mismatch!");
+    // EVENT in driver/Filter.h is 80 bytes, string offsets start right after it
+    static_assert(sizeof(KernelEvent) == 80,
+        "KernelEvent does not match the driver EVENT layout!");
+    static_assert(offsetof(KernelEvent, flags) == 17,
+        "KernelEvent flags must sit in the padding after blocked!");
+    static_assert(offsetof(KernelEvent, sequence) == 72,
+        "KernelEvent sequence must follow the event data!");
+    static_assert(offsetof(KernelMessage, event) == sizeof(FILTER_MESSAGE_HEADER),
+        "KernelMessage event must follow the message header!");
+    static_assert(sizeof(KernelBatchHeader) == 16,
+        "KernelBatchHeader size mismatch!");
+    static_assert(sizeof(KernelRecordHeader) == EVENT_RECORD_ALIGNMENT,
+        "KernelRecordHeader size mismatch!");
+    static_assert(sizeof(char16_t) == 2, "char16_t must be UTF-16 code unit sized");
+#ifdef _WIN32
     static_assert(sizeof(uint32_t) == sizeof(ULONG),
         "uint32_t != ULONG size!");
     static_assert(sizeof(uint64_t) == sizeof(ULONGLONG),
         "uint64_t != ULONGLONG size!");
+    static_assert(sizeof(char16_t) == sizeof(WCHAR),
+        "char16_t != WCHAR size!");
+#endif
 
 } // namespace kubearmor::comm
\ No newline at end of file
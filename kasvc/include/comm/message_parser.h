@@ -1,21 +1,47 @@
 #pragma once
 
+#include "comm/event_batch.h"
+#include "comm/kernel_event_view.h"
 #include "comm/kernel_message.h"
 #include "data/event_types.h"
+#include "common/buffer_pool.h"
+#include "common/event_sequence.h"
 #include "common/result.h"
+#include <string_view>
 
 namespace kubearmor::comm {
 
     class MessageParser {
     public:
+        // EVENT records of a received message (FILTER_MESSAGE_HEADER
+        // included): every record of a batch frame, or the message's event
+        static common::Result<EventBatchReader> Records(const uint8_t* message, size_t size);
+
+        // Validates a record and parses it with strings pointing into owner
+        static common::Result<data::Event> Parse(const EventRecord& record, const common::BufferRef& owner);
+
+        // Strings in the event point into owner's buffer, which must hold the
+        // message the view was created over, and are converted when read.
+        // Process paths are interned in data::PathTable::GetInstance(), event
+        // ids come from EventIds() and the driver's sequence number is kept.
+        static common::Result<data::Event> Parse(const KernelEventView& view, const common::BufferRef& owner);
+
+        // Single-event message, converts every string up front for callers
+        // that do not own the buffer
         static common::Result<data::Event> Parse(const KernelMessage* kernel_msg, size_t buffer_size);
 
+        // Generator every parsed event draws its id from, never destroyed
+        static common::EventIdGenerator& EventIds();
+
     private:
-        static data::FileEventData ParseFileEvent(const KernelMessage* km, size_t buffer_size);
-        static data::ProcessEventData ParseProcessEvent(const KernelMessage* km, size_t buffer_size);
-        static data::NetworkEventData ParseNetworkEvent(const KernelMessage* km, size_t buffer_size);
-        static std::string WStringToString(const wchar_t* wstr, size_t length);
-        static std::string FormatIPAddress(const uint8_t* addr, uint8_t family);
+        static data::FileEventData ParseFileEvent(const KernelEventView& view, const common::BufferRef& owner);
+        static data::ProcessEventData ParseProcessEvent(const KernelEventView& view, const common::BufferRef& owner);
+        static data::NetworkEventData ParseNetworkEvent(const KernelEventView& view);
+        // Calling thread's cache in front of data::PathTable::GetInstance()
+        static data::PathCache& ProcessPaths();
+        static data::LazyString MakeString(std::u16string_view value, const common::BufferRef& owner);
+        static data::LazyString MakePath(std::u16string_view value, const common::BufferRef& owner);
+        static data::AddressFamily ToAddressFamily(uint8_t family);
     };
 
-} // namespace kubearmor::comm
\ No newline at end of file
+} // namespace kubearmor::comm
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "comm/interfaces/i_filter_port.h"
+#include "common/latency_histogram.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory_resource>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace kubearmor::comm {
+
+    // In-process stand-in for the minifilter. Producer threads play the part
+    // of kernel threads calling FltSendMessage: each takes a posted receive,
+    // writes a byte-exact FILTER_MESSAGE_HEADER + EVENT record into it and
+    // completes it, at a configurable rate and event mix. With batching on,
+    // each producer stages audit-only events in a batch frame the way the
+    // driver's per-CPU staging areas do.
+    class SyntheticFilterPort : public IFilterPort {
+    public:
+        struct SyntheticConfig {
+            uint64_t events_per_second = 0;  // 0 = as fast as receives are posted
+            uint64_t total_events = 0;       // 0 = until disconnected
+            size_t producer_threads = 1;
+
+            // Relative weights of the emitted operations
+            uint32_t file_weight = 8;
+            uint32_t process_weight = 1;
+            uint32_t network_weight = 1;
+
+            uint32_t alert_percent = 5;      // MATCH_HOST_POLICY share
+            uint32_t unicode_percent = 1;    // paths with non-ASCII characters
+            uint32_t long_path_percent = 0;  // \\?\ style paths of 4K-30K characters
+
+            // Audit-only events per batch frame, 0 or 1 sends every event on its own
+            size_t batch_size = 0;
+            uint64_t batch_flush_us = 2000;  // longest an event waits in a frame
+
+            size_t process_count = 64;       // distinct image paths / pids
+            size_t file_count = 4096;        // distinct file paths
+            uint64_t seed = 0x6b6177696eULL;
+        };
+
+        struct Statistics {
+            uint64_t events_sent;
+            uint64_t replies_received;
+            uint64_t receive_stalls;    // an event was ready but no receive was posted
+            uint64_t oversized_events;  // event did not fit the posted buffer
+            uint64_t batches_sent;
+        };
+
+        explicit SyntheticFilterPort(const SyntheticConfig& config);
+        ~SyntheticFilterPort() override;
+
+        // IFilterPort implementation
+        common::Result<void> Connect(size_t concurrency) override;
+        void Disconnect() override;
+        bool IsConnected() const override;
+
+        common::Result<void> Attach(ReceiveRequest* request) override;
+        void Detach(ReceiveRequest* request) override;
+
+        bool SubmitReceive(ReceiveRequest* request) override;
+        CompletionStatus GetCompletion(Completion& completion,
+            std::chrono::milliseconds timeout) override;
+        CompletionStatus GetCompletions(Completion* completions, size_t max_count,
+            size_t& count, std::chrono::milliseconds timeout) override;
+        void CancelReceives() override;
+        void Wake() override;
+
+        bool SendReply(uint64_t message_id, int32_t status) override;
+
+        Statistics GetStatistics() const;
+
+        // Time a "kernel thread" waited between send and reply, in ns
+        const common::LatencyHistogram& ReplyLatency() const { return reply_latency_; }
+
+        // All total_events have been handed to the service
+        bool Finished() const;
+
+    private:
+        struct Rng {
+            uint64_t state;
+            uint64_t Next();
+            uint32_t Below(uint32_t bound) { return static_cast<uint32_t>(Next() % bound); }
+        };
+
+        void BuildCorpus();
+        void ProducerThread(size_t index);
+        ReceiveRequest* TakeReceive();
+        void Complete(const Completion& completion);
+
+        // Writes an EVENT and its strings, returns its size or 0 if it does
+        // not fit. Either way the event used up a sequence number, as in the
+        // driver, where events that cannot be sent leave a gap.
+        size_t EncodeEvent(Rng& rng, uint8_t* event, size_t capacity);
+
+        // Deliver one message to a posted receive, false once stopping
+        bool SendMessage(uint64_t message_id, bool reply_expected,
+            const uint8_t* payload, size_t payload_size, uint64_t events);
+
+        static uint64_t KernelTimeNow();
+
+        SyntheticConfig config_;
+
+        // Pre-generated UTF-16 strings so producers only copy bytes
+        std::vector<std::u16string> process_paths_;
+        std::vector<std::u16string> file_paths_;
+        std::vector<std::u16string> command_lines_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable receive_posted_;
+        std::condition_variable completion_ready_;
+        // Blocks recycled like ThreadSafeQueue's; only touched under mutex_
+        std::pmr::unsynchronized_pool_resource blocks_;
+        std::pmr::deque<ReceiveRequest*> pending_receives_{ &blocks_ };
+        std::pmr::deque<Completion> completions_{ &blocks_ };
+        bool connected_;
+
+        std::atomic<bool> stopping_;
+        std::vector<std::thread> producers_;
+
+        std::atomic<uint64_t> next_message_id_{ 1 };
+        std::atomic<uint64_t> last_sequence_{ 0 };  // EVENT.sequence, per connection
+        std::atomic<uint64_t> events_sent_{ 0 };
+        std::atomic<uint64_t> replies_received_{ 0 };
+        std::atomic<uint64_t> receive_stalls_{ 0 };
+        std::atomic<uint64_t> oversized_events_{ 0 };
+        std::atomic<uint64_t> batches_sent_{ 0 };
+
+        // send time per in-flight message id, indexed by id & SEND_TIME_MASK
+        static constexpr size_t SEND_TIME_SLOTS = 1 << 16;
+        static constexpr size_t SEND_TIME_MASK = SEND_TIME_SLOTS - 1;
+        std::unique_ptr<std::atomic<int64_t>[]> send_times_;
+        common::LatencyHistogram reply_latency_;
+    };
+
+} // namespace kubearmor::comm
\ No newline at end of file
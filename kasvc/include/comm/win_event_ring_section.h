@@ -0,0 +1,50 @@
+#pragma once
+
+#include "comm/interfaces/i_event_ring_section.h"
+#include <Windows.h>
+#include <winioctl.h>
+#include <string>
+
+namespace kubearmor::comm {
+
+    // Mirrors driver/DeviceIOCTL.h
+    constexpr DWORD KARMOR_DEVICE_TYPE = 0x8022;
+    constexpr DWORD IOCTL_MAP_EVENT_RING =
+        CTL_CODE(KARMOR_DEVICE_TYPE, 0x802, METHOD_BUFFERED, FILE_READ_DATA | FILE_WRITE_DATA);
+
+#pragma pack(push, 8)
+    struct EventRingMapRequest {
+        uint64_t doorbell;      // event handle the driver signals
+    };
+
+    struct EventRingMapResponse {
+        uint64_t base;          // section address in this process
+        uint64_t size;
+    };
+#pragma pack(pop)
+
+    // The driver's ring section, mapped into this process through the
+    // control device. Closing the device handle unmaps it again.
+    class WinEventRingSection : public IEventRingSection {
+    public:
+        explicit WinEventRingSection(const std::wstring& device_path);
+        ~WinEventRingSection() override;
+
+        common::Result<void> Map() override;
+        void Unmap() override;
+
+        void* base() const override { return base_; }
+        size_t size() const override { return size_; }
+
+        bool WaitDoorbell(std::chrono::milliseconds timeout) override;
+        void Wake() override;
+
+    private:
+        std::wstring device_path_;
+        HANDLE device_;
+        HANDLE doorbell_;
+        void* base_;
+        size_t size_;
+    };
+
+} // namespace kubearmor::comm
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "comm/interfaces/i_filter_port.h"
+#include <Windows.h>
+#include <fltUser.h>
+#include <string>
+
+namespace kubearmor::comm {
+
+    // IFilterPort over the minifilter communication port and an IOCP
+    class WinFilterPort : public IFilterPort {
+    public:
+        explicit WinFilterPort(const std::wstring& port_name);
+        ~WinFilterPort() override;
+
+        common::Result<void> Connect(size_t concurrency) override;
+        void Disconnect() override;
+        bool IsConnected() const override;
+
+        common::Result<void> Attach(ReceiveRequest* request) override;
+        void Detach(ReceiveRequest* request) override;
+
+        bool SubmitReceive(ReceiveRequest* request) override;
+        CompletionStatus GetCompletion(Completion& completion,
+            std::chrono::milliseconds timeout) override;
+        CompletionStatus GetCompletions(Completion* completions, size_t max_count,
+            size_t& count, std::chrono::milliseconds timeout) override;
+        void CancelReceives() override;
+        void Wake() override;
+
+        bool SendReply(uint64_t message_id, int32_t status) override;
+
+    private:
+        // Per-request OVERLAPPED, CONTAINING_RECORD maps a completion back
+        struct PendingIo {
+            OVERLAPPED overlapped;
+            ReceiveRequest* request;
+        };
+
+        std::wstring port_name_;
+        HANDLE filter_port_;
+        HANDLE iocp_handle_;
+    };
+
+} // namespace kubearmor::comm
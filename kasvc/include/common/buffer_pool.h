@@ -0,0 +1,219 @@
+#pragma once
+
+#include "common/constants.h"
+#include "common/lock_free_index_pool.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace kubearmor::common {
+
+    class BufferPool;
+    struct PooledBuffer;
+
+    // pmr resource over the part of a pooled buffer past its payload. What
+    // is derived from a message (the UTF-8 form of its strings) is bump
+    // allocated there and goes back to the pool with the buffer, so there
+    // is nothing to free per allocation. Safe to allocate from several
+    // threads, the events sharing a message are published concurrently.
+    // Requests that no longer fit go to the heap and are counted.
+    class BufferArena final : public std::pmr::memory_resource {
+    public:
+        // Starts the arena over at byte begin of buffer's payload
+        void Reset(PooledBuffer* buffer, size_t begin) {
+            buffer_ = buffer;
+            next_.store(begin, std::memory_order_relaxed);
+        }
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        PooledBuffer* buffer_ = nullptr;
+        std::atomic<size_t> next_{ 0 };
+    };
+
+    // Header in front of every pooled buffer, the payload follows it at
+    // POOLED_BUFFER_DATA_OFFSET so it keeps MESSAGE_BUFFER_ALIGNMENT
+    struct PooledBuffer {
+        std::atomic<uint32_t> refs;
+        uint32_t size_class;    // BufferPool::HEAP_CLASS for fallback allocations
+        uint32_t index;         // slot within the size class
+        uint32_t length;        // bytes of payload in use
+        size_t capacity;
+        BufferPool* pool;
+        BufferArena arena;      // capacity past length
+
+        uint8_t* data();
+        const uint8_t* data() const;
+    };
+
+    constexpr size_t POOLED_BUFFER_DATA_OFFSET =
+        (sizeof(PooledBuffer) + constants::MESSAGE_BUFFER_ALIGNMENT - 1) /
+        constants::MESSAGE_BUFFER_ALIGNMENT * constants::MESSAGE_BUFFER_ALIGNMENT;
+
+    inline uint8_t* PooledBuffer::data() {
+        return reinterpret_cast<uint8_t*>(this) + POOLED_BUFFER_DATA_OFFSET;
+    }
+
+    inline const uint8_t* PooledBuffer::data() const {
+        return reinterpret_cast<const uint8_t*>(this) + POOLED_BUFFER_DATA_OFFSET;
+    }
+
+    // Reference-counted handle to a pooled buffer. Copies share the buffer,
+    // it goes back to its size class when the last handle is released.
+    class BufferRef {
+    public:
+        BufferRef() = default;
+        explicit BufferRef(PooledBuffer* buffer) : buffer_(buffer) {}
+
+        BufferRef(const BufferRef& other) : buffer_(other.buffer_) {
+            if (buffer_) buffer_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        BufferRef(BufferRef&& other) noexcept : buffer_(other.buffer_) {
+            other.buffer_ = nullptr;
+        }
+
+        BufferRef& operator=(const BufferRef& other) {
+            if (this != &other) {
+                BufferRef copy(other);
+                Swap(copy);
+            }
+            return *this;
+        }
+
+        BufferRef& operator=(BufferRef&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                buffer_ = other.buffer_;
+                other.buffer_ = nullptr;
+            }
+            return *this;
+        }
+
+        ~BufferRef() { Reset(); }
+
+        // Moved-from and empty handles are reset far more often than full
+        // ones, so only those leave the header
+        void Reset() {
+            if (buffer_) {
+                Unref();
+            }
+        }
+
+        void Swap(BufferRef& other) noexcept { std::swap(buffer_, other.buffer_); }
+
+        explicit operator bool() const { return buffer_ != nullptr; }
+
+        uint8_t* data() { return buffer_ ? buffer_->data() : nullptr; }
+        const uint8_t* data() const { return buffer_ ? buffer_->data() : nullptr; }
+        size_t size() const { return buffer_ ? buffer_->length : 0; }
+        size_t capacity() const { return buffer_ ? buffer_->capacity : 0; }
+
+        // Also starts the arena over right after the payload, so only call
+        // it before anything has been allocated from the arena
+        void SetSize(size_t length) {
+            if (buffer_) {
+                buffer_->length = static_cast<uint32_t>(length);
+                buffer_->arena.Reset(buffer_, length);
+            }
+        }
+
+        // Arena over the capacity past size(), null for an empty handle.
+        // Whatever is allocated from it must go before the last handle does.
+        std::pmr::memory_resource* arena() const { return buffer_ ? &buffer_->arena : nullptr; }
+
+    private:
+        void Unref();
+
+        PooledBuffer* buffer_ = nullptr;
+    };
+
+    // Slab allocator for message buffers in a few fixed size classes. Each
+    // class is one contiguous allocation with a lock-free free list; a
+    // request goes to the smallest class that fits, then to larger classes,
+    // then to the heap. The pool stays alive until the owner has dropped it
+    // and every outstanding buffer has been released.
+    class BufferPool {
+    public:
+        struct SizeClass {
+            size_t buffer_size;
+            size_t buffer_count;
+        };
+
+        struct Statistics {
+            struct ClassStatistics {
+                size_t buffer_size;
+                size_t capacity;
+                size_t in_use;
+            };
+            std::vector<ClassStatistics> classes;
+            uint64_t heap_allocations;  // requests no size class could serve
+            uint64_t heap_in_use;
+            uint64_t arena_overflows;   // arena allocations that went to the heap
+        };
+
+        static constexpr uint32_t HEAP_CLASS = UINT32_MAX;
+
+        // Classes are sorted by buffer_size; returns nullptr if the slabs
+        // cannot be allocated. Slabs prefer numa_node, -1 for no preference.
+        static std::shared_ptr<BufferPool> Create(std::vector<SizeClass> classes, int numa_node = -1);
+
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator=(const BufferPool&) = delete;
+
+        // Buffer with at least size bytes of capacity, empty only if the
+        // heap fallback fails as well
+        BufferRef Acquire(size_t size);
+
+        // Copies size bytes into a right-sized buffer, with at least reserve
+        // bytes to spare for its arena
+        BufferRef Copy(const uint8_t* data, size_t size, size_t reserve = 0);
+
+        size_t LargestClassSize() const;
+        Statistics GetStatistics() const;
+
+    private:
+        struct Slab {
+            size_t buffer_size;
+            size_t stride;
+            size_t count;
+            uint8_t* memory;
+            size_t bytes;
+            std::unique_ptr<LockFreeIndexPool> free;
+        };
+
+        BufferPool(std::vector<SizeClass> classes, int numa_node);
+        ~BufferPool();
+
+        bool Initialize();
+        PooledBuffer* SlotAt(const Slab& slab, size_t index) const;
+        PooledBuffer* AllocateFromHeap(size_t size);
+
+        void Release(PooledBuffer* buffer);
+        void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
+        void Unref();
+
+        friend class BufferRef;
+        friend class BufferArena;
+
+        std::vector<SizeClass> classes_;
+        int numa_node_;
+        std::vector<Slab> slabs_;
+
+        // one for the owner plus one per outstanding buffer
+        std::atomic<size_t> refs_{ 1 };
+        std::atomic<uint64_t> heap_allocations_{ 0 };
+        std::atomic<uint64_t> heap_in_use_{ 0 };
+        std::atomic<uint64_t> arena_overflows_{ 0 };
+    };
+
+} // namespace kubearmor::common
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <chrono>
 
 namespace kubearmor::constants {
@@ -8,10 +9,74 @@ namespace kubearmor::constants {
 	// Queue sizes
 	constexpr size_t MAX_EVENT_QUEUE_SIZE = 10000;
 
+	// Longest a receive thread waits on a full event queue before dropping
+	constexpr std::chrono::milliseconds DEFAULT_OVERLOAD_DEADLINE{ 10 };
+
 	// Thread counts
 	constexpr size_t FILTER_PORT_WORKER_THREADS = 4;
 
+	// Largest EVENT record the driver sends (MAX_FILTER_EVENT_SIZE in driver/Filter.h)
+	constexpr size_t MAX_FILTER_EVENT_SIZE = 64 * 1024;
+
 	// Buffer sizes
-	constexpr size_t FILTER_MESSAGE_BUFFER_SIZE = 4096;
+	// Receive buffers fit any message: FILTER_MESSAGE_HEADER + the largest EVENT
+	constexpr size_t FILTER_MESSAGE_BUFFER_SIZE = 16 + MAX_FILTER_EVENT_SIZE;
+
+	// Slab size classes received messages are handed to the pipeline in,
+	// anything larger keeps its receive buffer
+	constexpr size_t MESSAGE_SIZE_CLASSES[] = { 1024, 2048, 8192 };
+	constexpr size_t MESSAGE_BUFFERS_PER_CLASS = 2048;
+
+	// Room left past a copied message for its buffer arena (the UTF-8 form
+	// of the strings read from it): size / divisor, enough for ASCII strings.
+	// A message needs 1.5x its size in a class, which is why the smallest
+	// class is 1024 rather than 512: 512 only took messages up to 341 B,
+	// less than a file event with two 70-character paths (about 380 B),
+	// and those would all have landed in 2048.
+	constexpr size_t MESSAGE_ARENA_DIVISOR = 2;
+
+	// Receive buffers are handed to FilterGetMessage, keep them at
+	// MEMORY_ALLOCATION_ALIGNMENT (16 on x64)
+	constexpr size_t MESSAGE_BUFFER_ALIGNMENT = 16;
+
+	// Completions an IOCP worker drains per wakeup
+	constexpr size_t DEFAULT_COMPLETION_BATCH = 16;
+	constexpr size_t MAX_COMPLETION_BATCH = 64;
+
+	// Events a monitoring worker takes off the event queue and publishes at once
+	constexpr size_t MONITORING_BATCH_SIZE = 64;
+
+	// Events enriched but not yet taken by a publish worker, when publishing
+	// has workers of its own
+	constexpr size_t PUBLISH_QUEUE_SIZE = 4096;
+
+	// Process path interning: lock shards of the table and how many paths
+	// no event refers to any more it keeps before trimming them
+	constexpr size_t PATH_TABLE_SHARDS = 64;
+	constexpr size_t MAX_IDLE_INTERNED_PATHS = 16384;
+
+	// Per-thread cache in front of the path table, slots keyed by process id
+	constexpr size_t PATH_CACHE_SLOTS = 256;
+
+	// Network addresses formatted for sinks, recently used ones are kept
+	constexpr size_t ADDRESS_FORMAT_CACHE_SLOTS = 4096;
+
+	// Event ids are drawn from 2^bits counters, one cache line each
+	constexpr size_t EVENT_ID_SHARD_BITS = 6;
+
+	// Processes whose events are checked for publishing order (a power of
+	// two), and how far a process's slot may be from its home slot
+	constexpr size_t ORDER_TRACKER_SLOTS = 16384;
+	constexpr size_t ORDER_TRACKER_PROBES = 32;
+	// Driver events a process may go without one of its own before its slot
+	// is given to another process; a process's sequence that far behind its
+	// slot means the driver started numbering over
+	constexpr uint64_t ORDER_TRACKER_STALE_EVENTS = 1048576;
+
+	// Drive letters are read again this long after a volume arrives or
+	// goes away (the letter is assigned after the arrival), and at least
+	// every refresh interval for changes nothing announces
+	constexpr std::chrono::milliseconds VOLUME_SETTLE_DELAY{ 500 };
+	constexpr std::chrono::seconds VOLUME_REFRESH_INTERVAL{ 60 };
 
 } // namespace kubearmor::constants
\ No newline at end of file
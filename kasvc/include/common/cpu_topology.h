@@ -0,0 +1,53 @@
+#pragma once
+
+#include "common/result.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kubearmor::common {
+
+    // Logical processors the process may run on, with the NUMA node and
+    // physical core each belongs to. CPU ids are the ones affinity masks and
+    // config.json core lists use: on Windows group * 64 + the bit in the
+    // group, on Linux the kernel's cpu number.
+    struct CpuTopology {
+        struct Cpu {
+            uint32_t id;
+            uint32_t node;
+            uint32_t core;      // SMT siblings share it
+        };
+
+        std::vector<Cpu> cpus;  // sorted by id
+
+        // What this machine has, restricted to the process affinity. Falls
+        // back to hardware_concurrency() CPUs on one node if the OS does not
+        // tell us more.
+        static CpuTopology Detect();
+
+        // nodes x cores_per_node x threads_per_core, numbered the way
+        // Windows and Linux number them: siblings are cores_per_node * nodes
+        // apart. For planning on machines we are not running on.
+        static CpuTopology Synthetic(uint32_t nodes, uint32_t cores_per_node, uint32_t threads_per_core);
+
+        std::vector<uint32_t> Nodes() const;
+        size_t CpuCount(uint32_t node) const;
+        const Cpu* Find(uint32_t id) const;
+    };
+
+    // "0-3,8,10-11" -> { 0, 1, 2, 3, 8, 10, 11 }, sorted and without
+    // duplicates. An empty string is an empty list.
+    Result<std::vector<uint32_t>> ParseCpuList(const std::string& list);
+    std::string FormatCpuList(const std::vector<uint32_t>& cpus);
+
+    // Restricts the calling thread to cpus. On Windows every CPU has to be in
+    // the same processor group, the first CPU's group wins.
+    Result<void> PinCurrentThread(const std::vector<uint32_t>& cpus);
+
+    // Page-aligned memory preferring a NUMA node, node < 0 for no preference.
+    // The preference is best effort, allocation only fails if memory does.
+    void* AllocateNodeMemory(size_t size, int node);
+    void FreeNodeMemory(void* memory, size_t size);
+
+} // namespace kubearmor::common
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "common/constants.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+namespace kubearmor::common {
+
+    // Event ids handed out without one shared counter: a thread draws from
+    // one of EVENT_ID_SHARDS cache-line sized counters and the shard is the
+    // low bits of the id. Ids are unique for the life of the generator,
+    // never 0, and increase across the ids any one thread draws.
+    class EventIdGenerator {
+    public:
+        static constexpr size_t SHARD_BITS = constants::EVENT_ID_SHARD_BITS;
+        static constexpr size_t SHARDS = size_t(1) << SHARD_BITS;
+
+        uint64_t Next() {
+            size_t shard = ThreadShard();
+            uint64_t count = shards_[shard].next.fetch_add(1, std::memory_order_relaxed) + 1;
+            return (count << SHARD_BITS) | shard;
+        }
+
+        // Shard of an id Next() returned
+        static size_t ShardOf(uint64_t id) { return static_cast<size_t>(id & (SHARDS - 1)); }
+
+    private:
+        struct alignas(64) Shard {
+            std::atomic<uint64_t> next{ 0 };
+        };
+
+        // Threads take shards round robin the first time they draw an id
+        static size_t ThreadShard();
+
+        Shard shards_[SHARDS];
+    };
+
+    // What arrived of one connection's driver sequence numbers. The driver
+    // stamps every event it creates with the next number starting at 1, so
+    // of the span between the lowest and highest number seen, whatever did
+    // not arrive was lost on the way (a failed send, a dropped frame).
+    // Events may be recorded from several threads and in any order; until
+    // the stream drains, events still in flight count as missing too.
+    class SequenceTracker {
+    public:
+        // Sequence numbers of a batch of events, added up before taking the
+        // tracker's shared counters
+        struct Batch {
+            uint64_t lowest = std::numeric_limits<uint64_t>::max();
+            uint64_t highest = 0;
+            uint64_t count = 0;
+            uint64_t unsequenced = 0;   // 0: parse failures, drivers without sequences
+
+            void Add(uint64_t sequence) {
+                if (sequence == 0) {
+                    unsequenced++;
+                    return;
+                }
+                lowest = sequence < lowest ? sequence : lowest;
+                highest = sequence > highest ? sequence : highest;
+                count++;
+            }
+        };
+
+        struct Snapshot {
+            uint64_t lowest;            // 0 before any sequenced event
+            uint64_t highest;
+            uint64_t received;          // sequenced events
+            uint64_t unsequenced;
+
+            uint64_t Span() const { return received ? highest - lowest + 1 : 0; }
+            uint64_t Missing() const { return Span() > received ? Span() - received : 0; }
+        };
+
+        SequenceTracker() { Reset(); }
+
+        void Record(const Batch& batch) {
+            if (batch.unsequenced) {
+                unsequenced_.fetch_add(batch.unsequenced, std::memory_order_relaxed);
+            }
+            if (batch.count == 0) {
+                return;
+            }
+
+            uint64_t current = lowest_.load(std::memory_order_relaxed);
+            while (batch.lowest < current &&
+                !lowest_.compare_exchange_weak(current, batch.lowest, std::memory_order_relaxed)) {
+            }
+            current = highest_.load(std::memory_order_relaxed);
+            while (batch.highest > current &&
+                !highest_.compare_exchange_weak(current, batch.highest, std::memory_order_relaxed)) {
+            }
+            received_.fetch_add(batch.count, std::memory_order_relaxed);
+        }
+
+        void Record(uint64_t sequence) {
+            Batch batch;
+            batch.Add(sequence);
+            Record(batch);
+        }
+
+        // A new connection starts the driver's numbering over
+        void Reset() {
+            lowest_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+            highest_.store(0, std::memory_order_relaxed);
+            received_.store(0, std::memory_order_relaxed);
+            unsequenced_.store(0, std::memory_order_relaxed);
+        }
+
+        Snapshot GetSnapshot() const {
+            uint64_t received = received_.load(std::memory_order_relaxed);
+            return Snapshot{
+                received ? lowest_.load(std::memory_order_relaxed) : 0,
+                highest_.load(std::memory_order_relaxed),
+                received,
+                unsequenced_.load(std::memory_order_relaxed)
+            };
+        }
+
+    private:
+        std::atomic<uint64_t> lowest_;
+        std::atomic<uint64_t> highest_;
+        std::atomic<uint64_t> received_;
+        std::atomic<uint64_t> unsequenced_;
+    };
+
+    // Whether each process's events come out in the driver's order: an
+    // event recorded after one of the same process with a higher sequence
+    // number is a violation. Processes get a slot in a fixed table on their
+    // first event. Age is counted in driver sequence numbers, so no clock
+    // is read: a slot whose process has had no event within
+    // ORDER_TRACKER_STALE_EVENTS of the one being recorded is reused, which
+    // keeps exited processes from filling the table. Events of processes
+    // that find no free or stale slot within ORDER_TRACKER_PROBES of their
+    // own are counted as untracked. Record() is lock-free: a load of the
+    // process's slot and, for an event in order, a compare-exchange on it;
+    // a process that is reused at the moment it records again may be
+    // misjudged once.
+    class OrderTracker {
+    public:
+        static constexpr size_t SLOTS = constants::ORDER_TRACKER_SLOTS;
+
+        OrderTracker();
+
+        // False for a violation; unsequenced events (0) are not checked
+        bool Record(uint32_t process_id, uint64_t sequence);
+
+        uint64_t Violations() const { return violations_.load(std::memory_order_relaxed); }
+        uint64_t Untracked() const { return untracked_.load(std::memory_order_relaxed); }
+        uint64_t Evictions() const { return evictions_.load(std::memory_order_relaxed); }
+
+        // Forgets every process; events recorded meanwhile may be kept or not
+        void Reset();
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> key{ 0 };        // process id + 1, 0 = free
+            std::atomic<uint64_t> highest{ 0 };
+        };
+
+        static bool Stale(uint64_t highest, uint64_t sequence) {
+            uint64_t distance = highest > sequence ? highest - sequence : sequence - highest;
+            return distance > constants::ORDER_TRACKER_STALE_EVENTS;
+        }
+
+        std::unique_ptr<Slot[]> slots_;
+        std::atomic<uint64_t> violations_{ 0 };
+        std::atomic<uint64_t> untracked_{ 0 };
+        std::atomic<uint64_t> evictions_{ 0 };
+    };
+
+    // One stage's account of the events that passed through it: what it
+    // received either went on, was dropped and counted, or is still held.
+    // Anything else disappeared without a trace. The counters are read one
+    // after the other, so under load a stage can be a few events off in
+    // either direction; once the pipeline drains every stage has to balance.
+    struct StageLedger {
+        const char* stage;
+        uint64_t received;
+        uint64_t forwarded;
+        uint64_t dropped;
+        uint64_t pending;
+
+        int64_t Unaccounted() const {
+            return static_cast<int64_t>(received - forwarded - dropped - pending);
+        }
+    };
+
+} // namespace kubearmor::common
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace kubearmor::common {
+
+    // Lock-free log-linear histogram (HdrHistogram style): each power of two
+    // is split into 16 linear sub-buckets, so any recorded value is reported
+    // within ~6% of its true value. Record() is a single relaxed increment.
+    class LatencyHistogram {
+    public:
+        static constexpr size_t SUB_BUCKET_BITS = 4;
+        static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+        static constexpr size_t BUCKET_COUNT = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+        LatencyHistogram() { Reset(); }
+
+        void Record(uint64_t value) {
+            buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(value, std::memory_order_relaxed);
+
+            uint64_t current = max_.load(std::memory_order_relaxed);
+            while (value > current &&
+                !max_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+            }
+        }
+
+        uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+        uint64_t Max() const { return max_.load(std::memory_order_relaxed); }
+
+        uint64_t Mean() const {
+            uint64_t count = Count();
+            return count > 0 ? sum_.load(std::memory_order_relaxed) / count : 0;
+        }
+
+        // Upper bound of the bucket holding the given percentile (0-100)
+        uint64_t ValueAtPercentile(double percentile) const {
+            uint64_t count = Count();
+            if (count == 0) return 0;
+
+            uint64_t target = static_cast<uint64_t>(percentile / 100.0 * count + 0.5);
+            if (target == 0) target = 1;
+            if (target > count) target = count;
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+                seen += buckets_[i].load(std::memory_order_relaxed);
+                if (seen >= target) {
+                    uint64_t bound = BucketUpperBound(i);
+                    uint64_t max = Max();
+                    return bound < max ? bound : max;
+                }
+            }
+            return Max();
+        }
+
+        void Reset() {
+            for (auto& bucket : buckets_) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            count_.store(0, std::memory_order_relaxed);
+            sum_.store(0, std::memory_order_relaxed);
+            max_.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        static size_t HighestBit(uint64_t value) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return index;
+#else
+            return 63 - static_cast<size_t>(__builtin_clzll(value));
+#endif
+        }
+
+        static size_t BucketIndex(uint64_t value) {
+            if (value < SUB_BUCKETS) {
+                return static_cast<size_t>(value);
+            }
+            size_t magnitude = HighestBit(value) - SUB_BUCKET_BITS;
+            size_t sub_bucket = static_cast<size_t>(value >> magnitude) - SUB_BUCKETS;
+            return SUB_BUCKETS + magnitude * SUB_BUCKETS + sub_bucket;
+        }
+
+        static uint64_t BucketUpperBound(size_t index) {
+            if (index < SUB_BUCKETS) {
+                return index;
+            }
+            size_t magnitude = (index - SUB_BUCKETS) / SUB_BUCKETS;
+            size_t sub_bucket = (index - SUB_BUCKETS) % SUB_BUCKETS;
+            return ((static_cast<uint64_t>(SUB_BUCKETS + sub_bucket) + 1) << magnitude) - 1;
+        }
+
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_;
+        std::atomic<uint64_t> count_;
+        std::atomic<uint64_t> sum_;
+        std::atomic<uint64_t> max_;
+    };
+
+} // namespace kubearmor::common
\ No newline at end of file
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace kubearmor::common {
+
+    // Small dense id per thread, used to pick a per-thread cache shard
+    inline size_t ThisThreadSlot() {
+        static std::atomic<size_t> next_slot{ 0 };
+        thread_local size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+
+    // Free list of the indices [0, capacity) of a caller-owned object array.
+    //
+    // Acquire/Release are O(1) and lock-free: a per-thread cache shard is
+    // tried first (try-lock, never waited on), then a global Treiber stack
+    // whose head carries an ABA tag. A thread only parks on a condition
+    // variable when the whole pool is exhausted and it asked to wait.
+    // InUse()/Available() are a single atomic load.
+    class LockFreeIndexPool {
+    public:
+        static constexpr size_t NPOS = static_cast<size_t>(-1);
+        static constexpr size_t MAX_CACHE_PER_SHARD = 16;
+
+        explicit LockFreeIndexPool(size_t cache_per_shard = 8, size_t shard_count = 0)
+            : shard_count_(shard_count ? shard_count :
+                std::max<size_t>(1, std::min<size_t>(64, 2 * std::thread::hardware_concurrency())))
+            , requested_cache_(std::min(cache_per_shard, MAX_CACHE_PER_SHARD))
+            , shards_(new Shard[shard_count_]) {
+        }
+
+        LockFreeIndexPool(const LockFreeIndexPool&) = delete;
+        LockFreeIndexPool& operator=(const LockFreeIndexPool&) = delete;
+
+        // Makes every index free and reopens the pool. Not thread-safe, call
+        // before any Acquire/Release (i.e. while setting up the owner).
+        void Reset(size_t capacity) {
+            capacity_ = capacity;
+            next_.reset(new std::atomic<uint32_t>[capacity]);
+
+            // Leave most of a small pool in the shared stack, caches only pay
+            // off when there is enough to go around
+            cache_limit_ = std::min(requested_cache_, capacity / (2 * shard_count_));
+
+            for (size_t i = 0; i < shard_count_; ++i) {
+                shards_[i].count = 0;
+                shards_[i].busy.store(false, std::memory_order_relaxed);
+            }
+
+            uint32_t head = 0;
+            for (size_t i = capacity; i-- > 0;) {
+                next_[i].store(head, std::memory_order_relaxed);
+                head = static_cast<uint32_t>(i + 1);
+            }
+            head_.store(head, std::memory_order_relaxed);
+            in_use_.store(0, std::memory_order_relaxed);
+            closed_.store(false, std::memory_order_release);
+        }
+
+        size_t TryAcquire() {
+            if (closed_.load(std::memory_order_acquire)) {
+                return NPOS;
+            }
+
+            size_t index = PopCache();
+            if (index == NPOS) index = PopShared();
+            if (index == NPOS) index = StealFromCaches();
+
+            if (index != NPOS) {
+                in_use_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return index;
+        }
+
+        template<typename Rep, typename Period>
+        size_t Acquire(std::chrono::duration<Rep, Period> timeout) {
+            size_t index = TryAcquire();
+            if (index != NPOS || closed_.load(std::memory_order_acquire)) {
+                return index;
+            }
+
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+
+            std::unique_lock<std::mutex> lock(wait_mutex_);
+            while ((index = TryAcquire()) == NPOS &&
+                !closed_.load(std::memory_order_acquire)) {
+                if (available_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                    index = TryAcquire();
+                    break;
+                }
+            }
+
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+            return index;
+        }
+
+        void Release(size_t index) {
+            in_use_.fetch_sub(1, std::memory_order_relaxed);
+
+            if (!PushCache(index)) {
+                PushShared(index);
+            }
+
+            if (waiters_.load(std::memory_order_seq_cst) > 0) {
+                std::lock_guard<std::mutex> lock(wait_mutex_);
+                available_.notify_one();
+            }
+        }
+
+        // Wakes every waiter, Acquire/TryAcquire fail until the next Reset
+        void Close() {
+            closed_.store(true, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            available_.notify_all();
+        }
+
+        size_t Capacity() const { return capacity_; }
+        size_t InUse() const { return in_use_.load(std::memory_order_relaxed); }
+        size_t Available() const {
+            size_t in_use = InUse();
+            return in_use < capacity_ ? capacity_ - in_use : 0;
+        }
+
+    private:
+        struct alignas(64) Shard {
+            std::atomic<bool> busy{ false };
+            uint32_t count = 0;
+            uint32_t items[MAX_CACHE_PER_SHARD];
+        };
+
+        static constexpr uint64_t INDEX_MASK = 0xFFFFFFFFULL;
+
+        Shard& MyShard() { return shards_[ThisThreadSlot() % shard_count_]; }
+
+        static bool TryLock(Shard& shard) {
+            return !shard.busy.load(std::memory_order_relaxed) &&
+                !shard.busy.exchange(true, std::memory_order_acquire);
+        }
+
+        static void Unlock(Shard& shard) {
+            shard.busy.store(false, std::memory_order_release);
+        }
+
+        size_t PopCache() {
+            if (cache_limit_ == 0) return NPOS;
+
+            Shard& shard = MyShard();
+            if (!TryLock(shard)) return NPOS;
+
+            size_t index = NPOS;
+            if (shard.count > 0) {
+                index = shard.items[--shard.count];
+            }
+            Unlock(shard);
+            return index;
+        }
+
+        bool PushCache(size_t index) {
+            if (cache_limit_ == 0) return false;
+
+            Shard& shard = MyShard();
+            if (!TryLock(shard)) return false;
+
+            bool cached = false;
+            if (shard.count < cache_limit_) {
+                shard.items[shard.count++] = static_cast<uint32_t>(index);
+                cached = true;
+            }
+            Unlock(shard);
+            return cached;
+        }
+
+        // Only reached when the shared stack is empty: scan the other shards
+        size_t StealFromCaches() {
+            if (cache_limit_ == 0) return NPOS;
+
+            for (size_t i = 0; i < shard_count_; ++i) {
+                Shard& shard = shards_[i];
+                if (!TryLock(shard)) continue;
+
+                size_t index = NPOS;
+                if (shard.count > 0) {
+                    index = shard.items[--shard.count];
+                }
+                Unlock(shard);
+
+                if (index != NPOS) return index;
+            }
+            return NPOS;
+        }
+
+        // head_ = (ABA tag << 32) | (index + 1), 0 in the low half means empty
+        size_t PopShared() {
+            uint64_t head = head_.load(std::memory_order_acquire);
+            while (true) {
+                uint32_t top = static_cast<uint32_t>(head & INDEX_MASK);
+                if (top == 0) {
+                    return NPOS;
+                }
+
+                uint32_t next = next_[top - 1].load(std::memory_order_relaxed);
+                uint64_t replacement = (((head >> 32) + 1) << 32) | next;
+
+                if (head_.compare_exchange_weak(head, replacement,
+                    std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    return top - 1;
+                }
+            }
+        }
+
+        void PushShared(size_t index) {
+            uint64_t head = head_.load(std::memory_order_relaxed);
+            uint64_t replacement;
+            do {
+                next_[index].store(static_cast<uint32_t>(head & INDEX_MASK), std::memory_order_relaxed);
+                replacement = (((head >> 32) + 1) << 32) | static_cast<uint32_t>(index + 1);
+            } while (!head_.compare_exchange_weak(head, replacement,
+                std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        const size_t shard_count_;
+        const size_t requested_cache_;
+        size_t cache_limit_ = 0;
+        size_t capacity_ = 0;
+
+        std::unique_ptr<Shard[]> shards_;
+        std::unique_ptr<std::atomic<uint32_t>[]> next_;
+        alignas(64) std::atomic<uint64_t> head_{ 0 };
+        alignas(64) std::atomic<size_t> in_use_{ 0 };
+        std::atomic<bool> closed_{ true };
+
+        std::atomic<size_t> waiters_{ 0 };
+        std::mutex wait_mutex_;
+        std::condition_variable available_;
+    };
+
+} // namespace kubearmor::common
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <mutex>
 #include <fstream>
@@ -96,6 +97,32 @@ namespace kubearmor::common {
         bool console_enabled_;
     };
 
+    // Lets a hot-path warning through at most once per interval. The caller
+    // reports how many were suppressed since the last one it logged.
+    class LogThrottle {
+    public:
+        explicit LogThrottle(std::chrono::milliseconds interval) : interval_(interval) {}
+
+        bool Allow(uint64_t& suppressed) {
+            int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+            int64_t next = next_allowed_.load(std::memory_order_relaxed);
+            if (now < next || !next_allowed_.compare_exchange_strong(next,
+                now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval_).count(),
+                std::memory_order_relaxed)) {
+                suppressed_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+
+    private:
+        std::chrono::milliseconds interval_;
+        std::atomic<int64_t> next_allowed_{ 0 };
+        std::atomic<uint64_t> suppressed_{ 0 };
+    };
+
 #define LOG_TRACE(msg) \
     kubearmor::common::Logger::GetInstance().Log(\
         kubearmor::common::LogLevel::TRACE, msg, __FILE__, __LINE__)
@@ -0,0 +1,542 @@
+#pragma once
+
+#include "common/latency_histogram.h"
+#include "common/overload_policy.h"
+#include "common/wait_strategy.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace kubearmor::common {
+
+    // Bounded multi-producer multi-consumer queue with ThreadSafeQueue's
+    // interface. Items live in max_size slots allocated up front; producers
+    // and consumers claim slots with one compare-exchange on the tail or
+    // head and hand them over through a per-slot sequence number (Vyukov's
+    // bounded MPMC queue), so nothing is locked or allocated while items
+    // move. Only a thread that has to wait, for an item or for room, spins
+    // briefly and then parks on a condition variable; the other side only
+    // takes its mutex when someone is parked there.
+    //
+    // Items come out in the order their slots were claimed. Under SHED_LOGS
+    // only the oldest item can be evicted, and only if it was queued by
+    // PushBatch() and found sheddable then.
+    //
+    // How long waiting threads spin before parking follows the WaitStrategy
+    // (never on a single CPU, where the other side cannot run meanwhile).
+    // With a queue_wait_ns histogram, every item taken records the
+    // nanoseconds from being offered to the ring to being taken; batches
+    // share one clock read on each side.
+    template<typename T>
+    class MpmcRing {
+    public:
+        explicit MpmcRing(size_t max_size = 10000, WaitStrategy wait = WaitStrategy::BALANCED,
+            LatencyHistogram* queue_wait_ns = nullptr)
+            : capacity_(max_size ? max_size : 1)
+            , mask_(capacity_ & (capacity_ - 1) ? 0 : capacity_ - 1)
+            , spin_(std::thread::hardware_concurrency() > 1 ? SpinTime(wait) : std::chrono::nanoseconds(0))
+            , queue_wait_(queue_wait_ns)
+            , slots_(new Slot[capacity_]) {
+            for (size_t i = 0; i < capacity_; ++i) {
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~MpmcRing() {
+            Close();
+            Clear();
+        }
+
+        MpmcRing(const MpmcRing&) = delete;
+        MpmcRing& operator=(const MpmcRing&) = delete;
+
+        // Push item (blocks if full)
+        bool Push(const T& item) {
+            return PushUntil(item, std::chrono::steady_clock::time_point::max());
+        }
+
+        bool Push(T&& item) {
+            return PushUntil(std::move(item), std::chrono::steady_clock::time_point::max());
+        }
+
+        // Try push with timeout
+        template<typename Rep, typename Period>
+        bool TryPush(const T& item, std::chrono::duration<Rep, Period> timeout) {
+            if (!closed_.load(std::memory_order_acquire) && TryEnqueue(item, false, Stamp())) {
+                Wake(not_empty_, 1);
+                return true;
+            }
+            return PushUntil(item, Deadline(timeout));
+        }
+
+        // Try push with timeout, item is only moved from if it was queued
+        template<typename Rep, typename Period>
+        bool TryPush(T&& item, std::chrono::duration<Rep, Period> timeout) {
+            if (!closed_.load(std::memory_order_acquire) && TryEnqueue(std::move(item), false, Stamp())) {
+                Wake(not_empty_, 1);
+                return true;
+            }
+            return PushUntil(std::move(item), Deadline(timeout));
+        }
+
+        // Try push a batch with timeout, consumers are woken once per wait.
+        // Returns how many were queued (a prefix).
+        template<typename Rep, typename Period>
+        size_t TryPushBatch(std::vector<T>& items, std::chrono::duration<Rep, Period> timeout) {
+            auto deadline = Deadline(timeout);
+            int64_t offered = Stamp();
+
+            size_t pushed = 0;
+            size_t woken = 0;
+            while (pushed < items.size() && !closed_.load(std::memory_order_acquire)) {
+                if (TryEnqueue(std::move(items[pushed]), false, offered)) {
+                    pushed++;
+                    continue;
+                }
+
+                Wake(not_empty_, pushed - woken);
+                woken = pushed;
+                if (!WaitUntil(not_full_, deadline, [this] { return !Full(); })) {
+                    break;
+                }
+            }
+            Wake(not_empty_, pushed - woken);
+            return pushed;
+        }
+
+        // Queue a batch under an overload policy, items are moved in. Only
+        // BLOCK, and SHED_LOGS for items that are not sheddable, wait for room,
+        // for up to timeout. on_drop(item) is called by this thread for every
+        // item dropped, incoming or evicted, before it is destroyed. Returns
+        // how many of the incoming items were queued.
+        template<typename Rep, typename Period, typename Sheddable, typename OnDrop>
+        size_t PushBatch(std::vector<T>& items, OverloadPolicy policy,
+            std::chrono::duration<Rep, Period> timeout, Sheddable sheddable, OnDrop on_drop) {
+
+            auto deadline = Deadline(timeout);
+            int64_t offered = Stamp();
+
+            size_t pushed = 0;
+            size_t woken = 0;
+            for (T& item : items) {
+                // Remembered with the item, a later SHED_LOGS batch may evict it
+                bool log = sheddable(item);
+                bool shed = policy == OverloadPolicy::SHED_LOGS && log;
+                bool queued = false;
+                while (!closed_.load(std::memory_order_acquire)) {
+                    if (TryEnqueue(std::move(item), log, offered)) {
+                        queued = true;
+                        break;
+                    }
+
+                    // Consumers that could make room should not sleep through it
+                    Wake(not_empty_, pushed - woken);
+                    woken = pushed;
+                    if (!MakeRoom(policy, shed, deadline, on_drop)) {
+                        break;
+                    }
+                }
+
+                if (queued) {
+                    pushed++;
+                }
+                else {
+                    on_drop(item);
+                }
+            }
+            Wake(not_empty_, pushed - woken);
+            return pushed;
+        }
+
+        // Pop item (blocks if empty)
+        std::optional<T> Pop() {
+            return PopUntil(std::chrono::steady_clock::time_point::max());
+        }
+
+        // Try pop with timeout
+        template<typename Rep, typename Period>
+        std::optional<T> TryPop(std::chrono::duration<Rep, Period> timeout) {
+            // The clock is only read when there is nothing to take
+            int64_t queued = 0;
+            if (auto item = TryDequeue(false, &queued)) {
+                int64_t now = 0;
+                RecordWait(queued, now);
+                Wake(not_full_, 1);
+                return item;
+            }
+            return PopUntil(Deadline(timeout));
+        }
+
+        // Try pop a batch with timeout: waits for the first item, then takes
+        // up to max_items that are ready onto the end of items, waking
+        // producers once. Returns how many were appended.
+        template<typename Rep, typename Period>
+        size_t PopBatch(std::vector<T>& items, size_t max_items, std::chrono::duration<Rep, Period> timeout) {
+            if (max_items == 0) {
+                return 0;
+            }
+            if (size_t popped = TakeReady(items, max_items)) {
+                return popped;
+            }
+
+            auto first = PopUntil(Deadline(timeout));
+            if (!first) {
+                return 0;
+            }
+            items.push_back(std::move(*first));
+            return 1 + TakeReady(items, max_items - 1);
+        }
+
+        bool Empty() const {
+            return Size() == 0;
+        }
+
+        // Exact when no push or pop is under way
+        size_t Size() const {
+            size_t head = head_.load(std::memory_order_acquire);
+            size_t tail = tail_.load(std::memory_order_acquire);
+            return tail > head ? std::min(tail - head, capacity_) : 0;
+        }
+
+        size_t Capacity() const { return capacity_; }
+
+        void Close() {
+            closed_.store(true, std::memory_order_seq_cst);
+            WakeAll(not_empty_);
+            WakeAll(not_full_);
+        }
+
+        bool IsClosed() const {
+            return closed_.load(std::memory_order_acquire);
+        }
+
+        void Clear() {
+            while (TryDequeue()) {
+            }
+            WakeAll(not_full_);
+        }
+
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence;
+            std::atomic<bool> sheddable{ false };
+            int64_t queued_ns = 0;      // steady clock, 0 when not recorded
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            T* item() { return std::launder(reinterpret_cast<T*>(storage)); }
+        };
+
+        // Threads parked waiting for one side of the ring
+        struct Parking {
+            std::atomic<size_t> waiters{ 0 };   // announced, asleep or about to be
+            std::mutex mutex;
+            std::condition_variable cv;
+            size_t sleeping = 0;                // in cv, under mutex
+            size_t notified = 0;                // of those, woken but not yet running
+        };
+
+        template<typename Rep, typename Period>
+        static std::chrono::steady_clock::time_point Deadline(std::chrono::duration<Rep, Period> timeout) {
+            auto now = std::chrono::steady_clock::now();
+            if (timeout >= std::chrono::duration_cast<std::chrono::duration<Rep, Period>>(
+                std::chrono::steady_clock::time_point::max() - now)) {
+                return std::chrono::steady_clock::time_point::max();
+            }
+            return now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+        }
+
+        Slot& SlotAt(size_t position) const {
+            return slots_[mask_ ? position & mask_ : position % capacity_];
+        }
+
+        static void Pause() {
+#if defined(_M_X64) || defined(__x86_64__)
+            _mm_pause();
+#else
+            std::this_thread::yield();
+#endif
+        }
+
+        static int64_t NowNs() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // Time items offered now are stamped with, when waits are recorded
+        int64_t Stamp() const {
+            return queue_wait_ ? NowNs() : 0;
+        }
+
+        // Records the wait of an item taken now, reading the clock on first use
+        void RecordWait(int64_t queued_ns, int64_t& now_ns) {
+            if (!queue_wait_ || queued_ns == 0) {
+                return;
+            }
+            if (now_ns == 0) {
+                now_ns = NowNs();
+            }
+            queue_wait_->Record(now_ns > queued_ns ? static_cast<uint64_t>(now_ns - queued_ns) : 0);
+        }
+
+        template<typename U>
+        bool TryEnqueue(U&& item, bool sheddable, int64_t queued_ns) {
+            size_t position = tail_.load(std::memory_order_relaxed);
+            Slot* slot;
+            while (true) {
+                slot = &SlotAt(position);
+                size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                auto lag = static_cast<std::intptr_t>(sequence - position);
+                if (lag == 0) {
+                    if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                else if (lag < 0) {
+                    return false;   // full, or the slot's consumer has not finished with it
+                }
+                else {
+                    position = tail_.load(std::memory_order_relaxed);
+                }
+            }
+
+            new (slot->storage) T(std::forward<U>(item));
+            slot->sheddable.store(sheddable, std::memory_order_relaxed);
+            slot->queued_ns = queued_ns;
+            slot->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Takes the oldest item, only if it is sheddable when only_sheddable
+        std::optional<T> TryDequeue(bool only_sheddable = false, int64_t* queued_ns = nullptr) {
+            size_t position = head_.load(std::memory_order_relaxed);
+            Slot* slot;
+            while (true) {
+                slot = &SlotAt(position);
+                size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                auto lag = static_cast<std::intptr_t>(sequence - (position + 1));
+                if (lag == 0) {
+                    if (only_sheddable && !slot->sheddable.load(std::memory_order_relaxed)) {
+                        return std::nullopt;
+                    }
+                    if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                else if (lag < 0) {
+                    return std::nullopt;    // empty, or the slot's producer has not finished with it
+                }
+                else {
+                    position = head_.load(std::memory_order_relaxed);
+                }
+            }
+
+            std::optional<T> item(std::move(*slot->item()));
+            slot->item()->~T();
+            if (queued_ns) {
+                *queued_ns = slot->queued_ns;
+            }
+            slot->sequence.store(position + capacity_, std::memory_order_release);
+            return item;
+        }
+
+        size_t TakeReady(std::vector<T>& items, size_t max_items) {
+            size_t popped = 0;
+            int64_t now = 0;
+            while (popped < max_items) {
+                int64_t queued = 0;
+                auto item = TryDequeue(false, &queued);
+                if (!item) {
+                    break;
+                }
+                RecordWait(queued, now);
+                items.push_back(std::move(*item));
+                popped++;
+            }
+            Wake(not_full_, popped);
+            return popped;
+        }
+
+        bool Full() const {
+            return Size() >= capacity_;
+        }
+
+        // Called with the ring full, true once it is worth trying again
+        template<typename OnDrop>
+        bool MakeRoom(OverloadPolicy policy, bool sheddable,
+            std::chrono::steady_clock::time_point deadline, OnDrop& on_drop) {
+
+            switch (policy) {
+            case OverloadPolicy::DROP_NEWEST:
+                return false;
+
+            case OverloadPolicy::DROP_OLDEST:
+                if (auto victim = TryDequeue()) {
+                    on_drop(*victim);
+                    Wake(not_full_, 1);
+                }
+                return true;
+
+            case OverloadPolicy::SHED_LOGS:
+                if (sheddable) {
+                    return false;
+                }
+                if (auto victim = TryDequeue(true)) {
+                    on_drop(*victim);
+                    Wake(not_full_, 1);
+                    return true;
+                }
+                break;
+
+            case OverloadPolicy::BLOCK:
+                break;
+            }
+
+            // Everything queued has to stay, wait for a consumer
+            return WaitUntil(not_full_, deadline, [this] { return !Full(); });
+        }
+
+        template<typename U>
+        bool PushUntil(U&& item, std::chrono::steady_clock::time_point deadline) {
+            int64_t offered = Stamp();
+            while (!closed_.load(std::memory_order_acquire)) {
+                if (TryEnqueue(std::forward<U>(item), false, offered)) {
+                    Wake(not_empty_, 1);
+                    return true;
+                }
+                if (!WaitUntil(not_full_, deadline, [this] { return !Full(); })) {
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        std::optional<T> PopUntil(std::chrono::steady_clock::time_point deadline) {
+            while (true) {
+                // Items pushed before Close() are still handed out
+                bool closed = closed_.load(std::memory_order_acquire);
+                int64_t queued = 0;
+                if (auto item = TryDequeue(false, &queued)) {
+                    int64_t now = 0;
+                    RecordWait(queued, now);
+                    Wake(not_full_, 1);
+                    return item;
+                }
+                if (closed || !WaitUntil(not_empty_, deadline, [this] { return !Empty(); })) {
+                    return std::nullopt;
+                }
+            }
+        }
+
+        // Spins, then parks until ready(), Close() or the deadline. False
+        // on timeout; the caller tries again otherwise.
+        template<typename Ready>
+        bool WaitUntil(Parking& parking, std::chrono::steady_clock::time_point deadline, Ready ready) {
+            constexpr auto FOREVER = std::chrono::steady_clock::time_point::max();
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) {
+                return false;
+            }
+
+            if (spin_.count() > 0) {
+                auto spin_end = deadline - now > spin_ ? now + spin_ : deadline;
+                for (unsigned i = 1; ; ++i) {
+                    if (ready() || closed_.load(std::memory_order_acquire)) {
+                        return true;
+                    }
+                    Pause();
+                    if (i % 16 == 0 && std::chrono::steady_clock::now() >= spin_end) {
+                        break;
+                    }
+                }
+            }
+
+            // Announce the wait before the last look, Wake() reads waiters
+            // after making its change visible, so one of the two sees the other
+            parking.waiters.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            bool woken = true;
+            {
+                std::unique_lock<std::mutex> lock(parking.mutex);
+                while (!ready() && !closed_.load(std::memory_order_acquire)) {
+                    if (!woken) {
+                        break;
+                    }
+                    parking.sleeping++;
+                    if (deadline == FOREVER) {
+                        parking.cv.wait(lock);
+                    }
+                    else {
+                        woken = parking.cv.wait_until(lock, deadline) == std::cv_status::no_timeout;
+                    }
+                    parking.sleeping--;
+                    if (parking.notified > 0) {
+                        parking.notified--;
+                    }
+                }
+                woken = woken || ready() || closed_.load(std::memory_order_acquire);
+            }
+            parking.waiters.fetch_sub(1, std::memory_order_relaxed);
+            return woken;
+        }
+
+        void Wake(Parking& parking, size_t count) {
+            if (count == 0) {
+                return;
+            }
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (parking.waiters.load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+
+            // Under the mutex a waiter is either still to look or asleep.
+            // Sleepers already woken are not woken again, the change that
+            // woke them keeps coming while they wait to be scheduled.
+            std::lock_guard<std::mutex> lock(parking.mutex);
+            size_t idle = parking.sleeping - parking.notified;
+            if (idle == 0) {
+                return;
+            }
+            if (count == 1) {
+                parking.notified++;
+                parking.cv.notify_one();
+            }
+            else {
+                parking.notified = parking.sleeping;
+                parking.cv.notify_all();
+            }
+        }
+
+        void WakeAll(Parking& parking) {
+            { std::lock_guard<std::mutex> lock(parking.mutex); }
+            parking.cv.notify_all();
+        }
+
+        const size_t capacity_;
+        const size_t mask_;             // capacity_ - 1 for powers of two, 0 otherwise
+        const std::chrono::nanoseconds spin_;   // before parking, 0 on one CPU
+        LatencyHistogram* const queue_wait_;    // optional
+        std::unique_ptr<Slot[]> slots_;
+
+        alignas(64) std::atomic<size_t> tail_{ 0 };
+        alignas(64) std::atomic<size_t> head_{ 0 };
+        alignas(64) std::atomic<bool> closed_{ false };
+        Parking not_empty_;
+        Parking not_full_;
+    };
+
+} // namespace kubearmor::common
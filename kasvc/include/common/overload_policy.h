@@ -0,0 +1,36 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+namespace kubearmor::common {
+
+    // What a bounded queue does with items that arrive while it is full
+    enum class OverloadPolicy {
+        DROP_NEWEST,    // reject the incoming item
+        DROP_OLDEST,    // evict the oldest queued item to make room
+        SHED_LOGS,      // reject or evict sheddable items, wait up to the deadline for the rest
+        BLOCK           // wait up to the deadline, then reject
+    };
+
+    inline const char* OverloadPolicyName(OverloadPolicy policy) {
+        switch (policy) {
+        case OverloadPolicy::DROP_NEWEST: return "drop_newest";
+        case OverloadPolicy::DROP_OLDEST: return "drop_oldest";
+        case OverloadPolicy::SHED_LOGS: return "shed_logs";
+        case OverloadPolicy::BLOCK: return "block";
+        default: return "unknown";
+        }
+    }
+
+    inline std::optional<OverloadPolicy> ParseOverloadPolicy(std::string_view name) {
+        for (OverloadPolicy policy : { OverloadPolicy::DROP_NEWEST, OverloadPolicy::DROP_OLDEST,
+            OverloadPolicy::SHED_LOGS, OverloadPolicy::BLOCK }) {
+            if (name == OverloadPolicyName(policy)) {
+                return policy;
+            }
+        }
+        return std::nullopt;
+    }
+
+} // namespace kubearmor::common
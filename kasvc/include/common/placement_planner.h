@@ -0,0 +1,47 @@
+#pragma once
+
+#include "common/cpu_topology.h"
+#include "common/result.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kubearmor::common {
+
+    // What config.json's placement section asks for. Explicit CPU lists and
+    // thread counts win, everything left at its default is derived.
+    struct PlacementRequest {
+        std::vector<uint32_t> allowed_cpus;     // empty = every CPU the process may use
+        size_t cpu_budget = 0;                  // 0 = one CPU per physical core on the chosen node
+        int numa_node = -1;                     // -1 = the node with the most allowed CPUs
+        std::vector<uint32_t> iocp_cpus;        // receive side: IOCP workers and the ring thread
+        std::vector<uint32_t> worker_cpus;      // MonitoringService workers
+        size_t iocp_threads = 0;                // 0 = one per IOCP CPU
+        size_t worker_threads = 0;              // 0 = one per worker CPU
+    };
+
+    struct PlacementPlan {
+        int numa_node;                          // receive buffer slabs live here, -1 = single node
+        std::vector<uint32_t> iocp_cpus;
+        std::vector<uint32_t> worker_cpus;
+        size_t iocp_threads;
+        size_t worker_threads;
+        size_t concurrent_operations;           // receives kept posted
+        size_t buffer_pool_size;                // receive buffers
+    };
+
+    // Turns a request into concrete CPUs, thread counts and pool sizes.
+    // CPUs on the chosen node go first, one hardware thread per physical
+    // core before any SMT sibling; the receive side gets a quarter of the
+    // budget (at least one CPU) and the workers the rest. Pure, so it can be
+    // run against CpuTopology::Synthetic() shapes.
+    Result<PlacementPlan> PlanPlacement(const CpuTopology& topology, const PlacementRequest& request);
+
+    // CPUs thread index of thread_count runs on: its own CPU while there are
+    // enough, the whole list otherwise
+    std::vector<uint32_t> CpusForThread(const std::vector<uint32_t>& cpus, size_t thread_count, size_t index);
+
+    std::string DescribePlan(const PlacementPlan& plan);
+
+} // namespace kubearmor::common
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <utility>
 #include <variant>
 #include <stdexcept>
 
@@ -39,6 +40,14 @@ namespace kubearmor::common {
             return std::get<T>(data_);
         }
 
+        // Moves the value out, the result is left holding a moved-from T
+        T TakeValue() {
+            if (IsError()) {
+                throw std::runtime_error("Attempted to take value from error result: " + ErrorMessage());
+            }
+            return std::move(std::get<T>(data_));
+        }
+
         const std::string& ErrorMessage() const {
             if (IsSuccess()) {
                 throw std::runtime_error("Attempted to get error from success result");
@@ -1,10 +1,13 @@
 #pragma once
 
-#include <queue>
+#include "common/overload_policy.h"
+#include <algorithm>
+#include <deque>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
 #include <optional>
+#include <vector>
 
 namespace kubearmor::common {
 
@@ -29,7 +32,7 @@ namespace kubearmor::common {
 
             if (closed_) return false;
 
-            queue_.push(item);
+            queue_.push_back(item);
             cv_not_empty_.notify_one();
             return true;
         }
@@ -43,7 +46,7 @@ namespace kubearmor::common {
 
             if (closed_) return false;
 
-            queue_.push(std::move(item));
+            queue_.push_back(std::move(item));
             cv_not_empty_.notify_one();
             return true;
         }
@@ -61,11 +64,99 @@ namespace kubearmor::common {
 
             if (closed_) return false;
 
-            queue_.push(item);
+            queue_.push_back(item);
             cv_not_empty_.notify_one();
             return true;
         }
 
+        // Try push with timeout, item is only moved from if it was queued
+        template<typename Rep, typename Period>
+        bool TryPush(T&& item, std::chrono::duration<Rep, Period> timeout) {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            if (!cv_not_full_.wait_for(lock, timeout, [this] {
+                return queue_.size() < max_size_ || closed_;
+                })) {
+                return false;
+            }
+
+            if (closed_) return false;
+
+            queue_.push_back(std::move(item));
+            cv_not_empty_.notify_one();
+            return true;
+        }
+
+        // Try push a batch with timeout, items are moved in with one lock
+        // acquisition per wait. Returns how many were queued (a prefix).
+        template<typename Rep, typename Period>
+        size_t TryPushBatch(std::vector<T>& items, std::chrono::duration<Rep, Period> timeout) {
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            size_t pushed = 0;
+            while (pushed < items.size()) {
+                if (!cv_not_full_.wait_until(lock, deadline, [this] {
+                    return queue_.size() < max_size_ || closed_;
+                    })) {
+                    break;
+                }
+
+                if (closed_) break;
+
+                size_t first = pushed;
+                while (pushed < items.size() && queue_.size() < max_size_) {
+                    queue_.push_back(std::move(items[pushed++]));
+                }
+
+                if (pushed - first == 1) {
+                    cv_not_empty_.notify_one();
+                }
+                else {
+                    cv_not_empty_.notify_all();
+                }
+            }
+            return pushed;
+        }
+
+        // Queue a batch under an overload policy, items are moved in. Only
+        // BLOCK, and SHED_LOGS for items that are not sheddable, wait for room,
+        // for up to timeout. on_drop(item) is called under the lock for every
+        // item dropped, incoming or evicted, before it is destroyed. Returns
+        // how many of the incoming items were queued.
+        template<typename Rep, typename Period, typename Sheddable, typename OnDrop>
+        size_t PushBatch(std::vector<T>& items, OverloadPolicy policy,
+            std::chrono::duration<Rep, Period> timeout, Sheddable sheddable, OnDrop on_drop) {
+
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            size_t pushed = 0;
+            size_t first_waiter = queue_.size();
+            for (T& item : items) {
+                if (closed_) {
+                    on_drop(item);
+                    continue;
+                }
+
+                if (queue_.size() >= max_size_ && !MakeRoom(lock, item, policy, deadline, sheddable, on_drop)) {
+                    on_drop(item);
+                    continue;
+                }
+
+                queue_.push_back(std::move(item));
+                pushed++;
+            }
+
+            if (queue_.size() > first_waiter + 1) {
+                cv_not_empty_.notify_all();
+            }
+            else if (pushed > 0) {
+                cv_not_empty_.notify_one();
+            }
+            return pushed;
+        }
+
         // Pop item (blocks if empty)
         std::optional<T> Pop() {
             std::unique_lock<std::mutex> lock(mutex_);
@@ -79,7 +170,7 @@ namespace kubearmor::common {
             }
 
             T item = std::move(queue_.front());
-            queue_.pop();
+            queue_.pop_front();
             cv_not_full_.notify_one();
             return item;
         }
@@ -100,11 +191,40 @@ namespace kubearmor::common {
             }
 
             T item = std::move(queue_.front());
-            queue_.pop();
+            queue_.pop_front();
             cv_not_full_.notify_one();
             return item;
         }
 
+        // Try pop a batch with timeout: waits for the first item, then moves
+        // up to max_items onto the end of items with one lock acquisition.
+        // Returns how many were appended.
+        template<typename Rep, typename Period>
+        size_t PopBatch(std::vector<T>& items, size_t max_items, std::chrono::duration<Rep, Period> timeout) {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            if (!cv_not_empty_.wait_for(lock, timeout, [this] {
+                return !queue_.empty() || closed_;
+                })) {
+                return 0; // Timeout
+            }
+
+            size_t popped = 0;
+            while (popped < max_items && !queue_.empty()) {
+                items.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+                popped++;
+            }
+
+            if (popped == 1) {
+                cv_not_full_.notify_one();
+            }
+            else if (popped > 1) {
+                cv_not_full_.notify_all();
+            }
+            return popped;
+        }
+
         bool Empty() const {
             std::lock_guard<std::mutex> lock(mutex_);
             return queue_.empty();
@@ -129,16 +249,55 @@ namespace kubearmor::common {
 
         void Clear() {
             std::lock_guard<std::mutex> lock(mutex_);
-            std::queue<T> empty;
+            std::deque<T> empty;
             std::swap(queue_, empty);
             cv_not_full_.notify_all();
         }
 
     private:
+        // Called with the queue full, true once there is room for item
+        template<typename Sheddable, typename OnDrop>
+        bool MakeRoom(std::unique_lock<std::mutex>& lock, const T& item, OverloadPolicy policy,
+            std::chrono::steady_clock::time_point deadline, Sheddable& sheddable, OnDrop& on_drop) {
+
+            switch (policy) {
+            case OverloadPolicy::DROP_NEWEST:
+                return false;
+
+            case OverloadPolicy::DROP_OLDEST:
+                on_drop(queue_.front());
+                queue_.pop_front();
+                return true;
+
+            case OverloadPolicy::SHED_LOGS: {
+                if (sheddable(item)) {
+                    return false;
+                }
+
+                // Oldest sheddable item goes first, they are usually near the front
+                auto victim = std::find_if(queue_.begin(), queue_.end(), sheddable);
+                if (victim != queue_.end()) {
+                    on_drop(*victim);
+                    queue_.erase(victim);
+                    return true;
+                }
+                break;
+            }
+
+            case OverloadPolicy::BLOCK:
+                break;
+            }
+
+            // Everything queued has to stay, wait for a consumer
+            return cv_not_full_.wait_until(lock, deadline, [this] {
+                return queue_.size() < max_size_ || closed_;
+                }) && !closed_;
+        }
+
         mutable std::mutex mutex_;
         std::condition_variable cv_not_empty_;
         std::condition_variable cv_not_full_;
-        std::queue<T> queue_;
+        std::deque<T> queue_;
         size_t max_size_;
         bool closed_;
     };
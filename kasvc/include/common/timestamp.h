@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ratio>
+#include <string>
+#include <string_view>
+
+namespace kubearmor::common {
+
+    // FILETIME / KeQuerySystemTime: 100 ns ticks since 1601-01-01 (UTC)
+    using FileTimeTicks = std::chrono::duration<int64_t, std::ratio<1, 10000000>>;
+    constexpr uint64_t UNIX_EPOCH_IN_FILETIME_TICKS = 116444736000000000ULL;
+
+    // Keeps the full 100 ns resolution where the clock has it. Times before
+    // 1970 map to the Unix epoch and times past what system_clock can hold
+    // to its maximum; the driver sends neither.
+    std::chrono::system_clock::time_point FileTimeToSystemTime(uint64_t filetime);
+
+    enum class TimestampPrecision {
+        SECONDS,        // 2024-05-01T12:00:00Z
+        MICROSECONDS    // 2024-05-01T12:00:00.123456Z
+    };
+
+    // RFC 3339 UTC text of a time point, held inline
+    class FormattedTime {
+    public:
+        static constexpr size_t CAPACITY = 32;
+
+        const char* data() const { return text_; }
+        size_t size() const { return size_; }
+        std::string_view view() const { return std::string_view(text_, size_); }
+        operator std::string_view() const { return view(); }
+        std::string str() const { return std::string(text_, size_); }
+
+    private:
+        friend FormattedTime FormatTimestamp(std::chrono::system_clock::time_point, TimestampPrecision);
+
+        char text_[CAPACITY];
+        uint8_t size_ = 0;
+    };
+
+    // Thread-safe replacement for put_time(gmtime()): the date and time of
+    // day are worked out without the C library, and each thread keeps the
+    // "YYYY-MM-DDTHH:MM:SS" of the last second it formatted, so events in
+    // the same second only write their sub-second digits
+    FormattedTime FormatTimestamp(std::chrono::system_clock::time_point time,
+        TimestampPrecision precision = TimestampPrecision::MICROSECONDS);
+
+    // Whole seconds since the Unix epoch, rounded towards the past
+    int64_t ToUnixSeconds(std::chrono::system_clock::time_point time);
+
+} // namespace kubearmor::common
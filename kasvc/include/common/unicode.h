@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+
+namespace kubearmor::common {
+
+    // Converts UTF-16 (as written by the driver) to UTF-8. Unpaired surrogates
+    // are replaced with U+FFFD, matching WideCharToMultiByte(CP_UTF8, 0, ...).
+    // All-ASCII input, most paths, is narrowed in one vectorized pass.
+    std::string Utf16ToUtf8(const char16_t* src, size_t length);
+
+    // Same conversion into out, which must have room for Utf8Length()
+    // bytes. Returns the number of bytes written.
+    size_t Utf16ToUtf8(const char16_t* src, size_t length, char* out);
+
+    // Same conversion appended to out. Non-ASCII input grows out twice,
+    // callers that need one exact allocation use Utf8Length() first.
+    void AppendUtf8(const char16_t* src, size_t length, std::string& out);
+    void AppendUtf8(const char16_t* src, size_t length, std::pmr::string& out);
+
+    // Number of UTF-8 bytes Utf16ToUtf8 would produce for the same input
+    size_t Utf8Length(const char16_t* src, size_t length);
+
+    // Block kernels the transcoder can run on. The best one the CPU supports
+    // is picked on first use; benchmarks select others to compare them.
+    enum class TranscodeKernel {
+        SCALAR,     // 4 code units at a time in a 64-bit word
+        SSE2,       // 8 code units, x64 baseline
+        AVX2        // 16 code units
+    };
+
+    TranscodeKernel ActiveTranscodeKernel();
+    const char* TranscodeKernelName(TranscodeKernel kernel);
+
+    // False, and nothing changes, if this build or CPU lacks the kernel
+    bool SelectTranscodeKernel(TranscodeKernel kernel);
+
+} // namespace kubearmor::common
@@ -0,0 +1,173 @@
+#pragma once
+
+// Building blocks of the UTF-16 -> UTF-8 transcoder in common/unicode.h,
+// shared by unicode.cpp and unicode_avx2.cpp. Everything here has internal
+// linkage on purpose: unicode_avx2.cpp is compiled with AVX2 enabled, and a
+// shared inline definition could otherwise be merged into the baseline
+// translation unit and run on a CPU without AVX2.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace kubearmor::common {
+
+    namespace {
+
+        constexpr char32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+        inline bool IsHighSurrogate(char16_t c) { return c >= 0xD800 && c <= 0xDBFF; }
+        inline bool IsLowSurrogate(char16_t c) { return c >= 0xDC00 && c <= 0xDFFF; }
+
+        // Decodes one code point starting at src[i] and advances i
+        inline char32_t NextCodePoint(const char16_t* src, size_t length, size_t& i) {
+            char16_t c = src[i++];
+
+            if (IsHighSurrogate(c)) {
+                if (i < length && IsLowSurrogate(src[i])) {
+                    char16_t low = src[i++];
+                    return 0x10000 + ((static_cast<char32_t>(c) - 0xD800) << 10) +
+                        (static_cast<char32_t>(low) - 0xDC00);
+                }
+                return REPLACEMENT_CHARACTER;
+            }
+
+            if (IsLowSurrogate(c)) {
+                return REPLACEMENT_CHARACTER;
+            }
+
+            return c;
+        }
+
+        inline size_t EncodedLength(char32_t cp) {
+            if (cp < 0x80) return 1;
+            if (cp < 0x800) return 2;
+            if (cp < 0x10000) return 3;
+            return 4;
+        }
+
+        inline char* EncodeCodePoint(char32_t cp, char* out) {
+            if (cp < 0x80) {
+                *out++ = static_cast<char>(cp);
+            }
+            else if (cp < 0x800) {
+                *out++ = static_cast<char>(0xC0 | (cp >> 6));
+                *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else if (cp < 0x10000) {
+                *out++ = static_cast<char>(0xE0 | (cp >> 12));
+                *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else {
+                *out++ = static_cast<char>(0xF0 | (cp >> 18));
+                *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            return out;
+        }
+
+        // Population count without relying on the POPCNT instruction
+        inline size_t CountBits(uint32_t mask) {
+            mask = mask - ((mask >> 1) & 0x55555555);
+            mask = (mask & 0x33333333) + ((mask >> 2) & 0x33333333);
+            mask = (mask + (mask >> 4)) & 0x0F0F0F0F;
+            return (mask * 0x01010101) >> 24;
+        }
+
+        // The drivers below walk the input in blocks of Kernel::WIDTH code
+        // units. A Kernel provides, for one block at p:
+        //   AllAscii(p)        every unit < 0x80
+        //   Narrow(p, out)     writes the block as WIDTH ASCII bytes
+        //   HasSurrogate(p)    some unit is in D800-DFFF
+        //   Utf8Bytes(p)       encoded size of a block without surrogates
+        // Blocks that fail the fast check are done one code point at a time,
+        // which is also where surrogate pairs straddling a block end go.
+
+        template<typename Kernel>
+        size_t Utf8LengthBlocks(const char16_t* src, size_t length) {
+            size_t total = 0;
+            size_t i = 0;
+            while (i + Kernel::WIDTH <= length) {
+                if (!Kernel::HasSurrogate(src + i)) {
+                    total += Kernel::Utf8Bytes(src + i);
+                    i += Kernel::WIDTH;
+                    continue;
+                }
+
+                size_t block_end = i + Kernel::WIDTH;
+                while (i < block_end) {
+                    total += EncodedLength(NextCodePoint(src, length, i));
+                }
+            }
+
+            while (i < length) {
+                total += EncodedLength(NextCodePoint(src, length, i));
+            }
+            return total;
+        }
+
+        // Copies the leading ASCII units, returns how many
+        template<typename Kernel>
+        size_t NarrowAsciiBlocks(const char16_t* src, size_t length, char* out) {
+            size_t i = 0;
+            while (i + Kernel::WIDTH <= length && Kernel::AllAscii(src + i)) {
+                Kernel::Narrow(src + i, out + i);
+                i += Kernel::WIDTH;
+            }
+
+            // A short tail is done as the last full block, overlapping
+            // units already written with the same bytes
+            if (i < length && length >= Kernel::WIDTH && i + Kernel::WIDTH > length &&
+                Kernel::AllAscii(src + length - Kernel::WIDTH)) {
+                Kernel::Narrow(src + length - Kernel::WIDTH, out + length - Kernel::WIDTH);
+                return length;
+            }
+
+            while (i < length && src[i] < 0x80) {
+                out[i] = static_cast<char>(src[i]);
+                i++;
+            }
+            return i;
+        }
+
+        // out must have room for Utf8LengthBlocks() bytes, returns the end
+        template<typename Kernel>
+        char* EncodeBlocks(const char16_t* src, size_t length, char* out) {
+            size_t i = 0;
+            while (i + Kernel::WIDTH <= length) {
+                if (Kernel::AllAscii(src + i)) {
+                    Kernel::Narrow(src + i, out);
+                    out += Kernel::WIDTH;
+                    i += Kernel::WIDTH;
+                    continue;
+                }
+
+                size_t block_end = i + Kernel::WIDTH;
+                while (i < block_end) {
+                    out = EncodeCodePoint(NextCodePoint(src, length, i), out);
+                }
+            }
+
+            while (i < length) {
+                out = EncodeCodePoint(NextCodePoint(src, length, i), out);
+            }
+            return out;
+        }
+
+    } // namespace
+
+    // One implementation of the block drivers, see SelectTranscodeKernel()
+    struct TranscodeFunctions {
+        size_t(*utf8_length)(const char16_t* src, size_t length);
+        size_t(*narrow_ascii)(const char16_t* src, size_t length, char* out);
+        char* (*encode)(const char16_t* src, size_t length, char* out);
+    };
+
+    // Defined in unicode_avx2.cpp, nullptr where it is not built. Call
+    // only after checking the CPU supports AVX2.
+    const TranscodeFunctions* Avx2TranscodeFunctions();
+
+} // namespace kubearmor::common
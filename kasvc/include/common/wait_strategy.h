@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string_view>
+
+namespace kubearmor::common {
+
+    // How a thread waiting on an empty (or full) queue waits: how long it
+    // spins, watching for the other side, before parking on a condition
+    // variable. Spinning hides the wake-up of a parked thread at the cost
+    // of a busy CPU while the queue is idle.
+    enum class WaitStrategy {
+        LATENCY,    // spin for a while, for deployments with cores to spare
+        BALANCED,   // spin briefly, enough for a producer in mid-batch
+        CPU         // park at once
+    };
+
+    inline const char* WaitStrategyName(WaitStrategy strategy) {
+        switch (strategy) {
+        case WaitStrategy::LATENCY: return "latency";
+        case WaitStrategy::BALANCED: return "balanced";
+        case WaitStrategy::CPU: return "cpu";
+        default: return "unknown";
+        }
+    }
+
+    inline std::optional<WaitStrategy> ParseWaitStrategy(std::string_view name) {
+        for (WaitStrategy strategy : { WaitStrategy::LATENCY, WaitStrategy::BALANCED, WaitStrategy::CPU }) {
+            if (name == WaitStrategyName(strategy)) {
+                return strategy;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Longest a waiting thread spins before parking
+    inline std::chrono::nanoseconds SpinTime(WaitStrategy strategy) {
+        switch (strategy) {
+        case WaitStrategy::LATENCY: return std::chrono::microseconds(100);
+        case WaitStrategy::BALANCED: return std::chrono::microseconds(2);
+        default: return std::chrono::nanoseconds(0);
+        }
+    }
+
+} // namespace kubearmor::common
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kubearmor::data {
+
+    // An NT device the kernel names paths by and the DOS form it stands for:
+    // \Device\HarddiskVolume3 -> C:, \Device\Mup -> \ (UNC paths)
+    struct DevicePrefix {
+        std::u16string device;
+        std::u16string dos;
+    };
+
+    // Turns the device paths the driver reports (\Device\HarddiskVolume3\...)
+    // into DOS paths (C:\...) as paths are converted to UTF-8. The mapping is
+    // replaced as a whole when volumes come and go; readers look up the
+    // longest device prefix of a path in the current mapping without taking
+    // a lock. Replaced mappings stay allocated until the table is destroyed
+    // because readers may still be using them, so updates should be rare.
+    class DevicePathTable {
+    public:
+        struct Match {
+            size_t device_length;       // UTF-16 units of the path the device covers, 0 for no match
+            std::u16string_view dos;    // what replaces them
+        };
+
+        // Table LazyString and PathRef translate with, never destroyed
+        static DevicePathTable& GetInstance();
+
+        DevicePathTable();
+        ~DevicePathTable();
+
+        DevicePathTable(const DevicePathTable&) = delete;
+        DevicePathTable& operator=(const DevicePathTable&) = delete;
+
+        // Replaces the mapping, false if it is the one in place already.
+        // Devices match whole path components, ignoring ASCII case and a
+        // trailing backslash; of duplicate devices the first is kept. The
+        // DOS form is used as given.
+        bool Update(std::vector<DevicePrefix> prefixes);
+
+        Match Find(std::u16string_view path) const;
+
+        // UTF-8 form of path with its device replaced, as is if none matches
+        std::string ToUtf8(std::u16string_view path) const;
+        void ToUtf8(std::u16string_view path, std::pmr::string& out) const;
+
+        // Mappings Update() put in place, and devices in the current one
+        uint64_t Generation() const;
+        size_t Size() const;
+
+    private:
+        struct Mapping {
+            std::vector<DevicePrefix> prefixes;     // longest device first
+            uint64_t generation = 0;
+        };
+
+        std::atomic<const Mapping*> current_;
+        std::mutex update_mutex_;
+        std::vector<std::unique_ptr<Mapping>> mappings_;   // current and replaced ones
+    };
+
+} // namespace kubearmor::data
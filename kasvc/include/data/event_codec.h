@@ -0,0 +1,93 @@
+#pragma once
+
+#include "common/buffer_pool.h"
+#include "common/result.h"
+#include "data/event_types.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace kubearmor::data {
+
+    // Binary form of a data::Event for spooling to disk and handing events
+    // between threads or processes without protobuf or ToString(). A record
+    // is an EncodedEventHeader, the fixed body of its operation and then the
+    // operation's strings. All fields are little-endian (every target this
+    // builds for), and the record is a multiple of 4 bytes.
+    //
+    // Each string is a uint32_t prefix, its byte length shifted left by one
+    // with the low bit set for UTF-16 and clear for UTF-8, then the bytes,
+    // padded to a multiple of 4. Strings are written in whichever form the
+    // event holds them, so encoding never transcodes.
+    constexpr uint32_t EVENT_CODEC_MAGIC = 0x5645414B;     // "KAEV"
+
+    // Bumped for changes older decoders cannot read. Fields added to the end
+    // of a body only grow header_size, which decoders skip to.
+    constexpr uint16_t EVENT_CODEC_VERSION = 1;
+
+    enum EventCodecFlags : uint8_t {
+        EVENT_CODEC_BLOCKED = 0x01
+    };
+
+#pragma pack(push, 4)
+
+    struct EncodedEventHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t header_size;       // header and body, where the strings start
+        uint32_t length;            // whole record, strings and padding included
+        uint8_t type;               // EventType
+        uint8_t operation_type;     // EventOperationType
+        uint8_t operation;          // File/Process/NetworkOperation
+        uint8_t flags;              // EventCodecFlags
+        uint64_t event_id;
+        uint64_t sequence;          // driver sequence number, 0 if none
+        int64_t timestamp;          // 100 ns ticks since the Unix epoch
+    };
+
+    // Strings: process_path, file_path
+    struct EncodedFileBody {
+        uint32_t process_id;
+        uint32_t reserved;
+    };
+
+    // Strings: process_path, command_line, parent_process_path
+    struct EncodedProcessBody {
+        uint32_t process_id;
+        uint32_t parent_process_id;
+    };
+
+    // No strings
+    struct EncodedNetworkBody {
+        uint32_t protocol;
+        uint32_t data_length;
+        uint16_t local_port;
+        uint16_t remote_port;
+        uint8_t local_family;       // AddressFamily
+        uint8_t remote_family;
+        uint16_t reserved;
+        uint8_t local_address[16];
+        uint8_t remote_address[16];
+    };
+
+#pragma pack(pop)
+
+    static_assert(sizeof(EncodedEventHeader) == 40, "encoded layout is part of the format");
+    static_assert(sizeof(EncodedFileBody) == 8, "encoded layout is part of the format");
+    static_assert(sizeof(EncodedProcessBody) == 8, "encoded layout is part of the format");
+    static_assert(sizeof(EncodedNetworkBody) == 48, "encoded layout is part of the format");
+
+    // Bytes EncodeEvent() writes for event
+    size_t EncodedEventSize(const Event& event);
+
+    // Writes event to out, returns the record size or 0 if it does not fit
+    // in capacity bytes. Does not allocate.
+    size_t EncodeEvent(const Event& event, uint8_t* out, size_t capacity);
+
+    // Rebuilds an event from the record at data, which must be 2-byte
+    // aligned. Paths are interned in PathTable::GetInstance(). With an owner
+    // (the buffer data lies in) the other strings stay where they are, UTF-16
+    // as unconverted LazyStrings and UTF-8 copied into the owner's arena;
+    // without one they are copied to the heap. raw_message is left empty.
+    common::Result<Event> DecodeEvent(const uint8_t* data, size_t size, common::BufferRef owner = {});
+
+} // namespace kubearmor::data
@@ -11,11 +11,13 @@ namespace kubearmor::data {
     public:
         using FilterPredicate = std::function<bool(const Event&)>;
 
+        // Keeps the events predicate accepts, the rest are released
         std::vector<Event> Filter(
-            const std::vector<Event>& events,
+            std::vector<Event> events,
             FilterPredicate predicate) const;
 
-        Event Enrich(const Event& event) const;
+        // Adds what kernel space does not know to the event, in place
+        void Enrich(Event& event) const;
 
         struct AggregatedStats {
             size_t total_events;
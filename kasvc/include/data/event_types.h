@@ -1,7 +1,13 @@
 #pragma once
 
+#include "common/buffer_pool.h"
+#include "data/ip_address.h"
+#include "data/lazy_string.h"
+#include "data/path_table.h"
+#include <cstdint>
 #include <string>
 #include <chrono>
+#include <optional>
 #include <variant>
 
 namespace kubearmor::data {
@@ -44,10 +50,10 @@ namespace kubearmor::data {
     struct FileEventData {
         FileOperation operation;
         uint32_t process_id;
-        std::string process_path;
-        std::string file_path;
+        PathRef process_path;       // interned, see PathTable
+        LazyString file_path;
 
-        FileEventData() : operation(FileOperation::F_CREATE) {
+        FileEventData() : operation(FileOperation::F_CREATE), process_id(0) {
         }
         std::string ToString() const;
     };
@@ -56,11 +62,11 @@ namespace kubearmor::data {
         ProcessOperation operation;
         uint32_t process_id;
         uint32_t parent_process_id;
-        std::string process_path;
-        std::string command_line;
-        std::string parent_process_path;
+        PathRef process_path;
+        LazyString command_line;
+        PathRef parent_process_path;
 
-        ProcessEventData() : operation(ProcessOperation::P_CREATE) {
+        ProcessEventData() : operation(ProcessOperation::P_CREATE), process_id(0), parent_process_id(0) {
         }
         std::string ToString() const;
     };
@@ -70,8 +76,8 @@ namespace kubearmor::data {
         uint32_t protocol;
         uint16_t local_port;
         uint16_t remote_port;
-        std::string local_address;
-        std::string remote_address;
+        IpAddress local_address;        // formatted by sinks, see FormatAddress()
+        IpAddress remote_address;
         uint32_t data_length;
 
         NetworkEventData() : operation(NetworkOperation::TCP_CONNECT), protocol(0),
@@ -83,22 +89,48 @@ namespace kubearmor::data {
     struct Event {
         EventType type;
         EventOperationType operation_type;
-        uint64_t event_id;
+        uint64_t event_id;          // unique in this service, see EventIdGenerator
+        uint64_t sequence;          // the driver's per-connection number, 0 if none
         std::chrono::system_clock::time_point timestamp;
         bool blocked;
 
         std::variant<FileEventData, ProcessEventData, NetworkEventData> data;
 
-        Event() : operation_type(EventOperationType::FILE_EVENT), event_id(0),
-            timestamp(std::chrono::system_clock::now()),blocked(false), data(FileEventData{}) {
+        // Kernel message the event was parsed from, owned by the event and
+        // returned to its slab when the last copy of the event goes away
+        common::BufferRef raw_message;
+
+        Event() : type(EventType::HOST_LOG), operation_type(EventOperationType::FILE_EVENT), event_id(0),
+            sequence(0), timestamp(std::chrono::system_clock::now()),blocked(false), data(FileEventData{}) {
+        }
+
+        // For decoders that already have the time, reading the clock is not free
+        explicit Event(std::chrono::system_clock::time_point time) : type(EventType::HOST_LOG),
+            operation_type(EventOperationType::FILE_EVENT), event_id(0), sequence(0), timestamp(time), blocked(false),
+            data(FileEventData{}) {
         }
 
+        // Events are moved from the parser to the publisher, never copied on
+        // the way; Clone() is there for the rare consumer that keeps one
+        Event(Event&&) = default;
+        Event& operator=(Event&&) = default;
+        Event& operator=(const Event&) = delete;
+
+        Event Clone() const { return Event(*this); }
+
         bool IsFileEvent() const { return operation_type == EventOperationType::FILE_EVENT; }
         bool IsProcessEvent() const { return operation_type == EventOperationType::PROCESS_EVENT; }
         bool IsNetworkEvent() const { return operation_type == EventOperationType::NETWORK_EVENT; }
 
         bool IsAlert() const { return type == EventType::MATCH_HOST_POLICY; }
 
+        // Process the event belongs to, network events carry none
+        std::optional<uint32_t> ProcessId() const {
+            if (const auto* file = GetFileData()) return file->process_id;
+            if (const auto* process = GetProcessData()) return process->process_id;
+            return std::nullopt;
+        }
+
         const FileEventData* GetFileData() const {
             return std::get_if<FileEventData>(&data);
         }
@@ -111,6 +143,9 @@ namespace kubearmor::data {
 
         std::string ToString() const;
         bool IsHighSeverity() const;
+
+    private:
+        Event(const Event&) = default;
     };
 
 } // namespace kubearmor::data
\ No newline at end of file
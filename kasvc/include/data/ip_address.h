@@ -0,0 +1,133 @@
+#pragma once
+
+#include "common/constants.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace kubearmor::data {
+
+    // Host-independent, unlike AF_INET6 which differs between platforms
+    enum class AddressFamily : uint8_t {
+        NONE = 0,
+        IPV4 = 4,
+        IPV6 = 6
+    };
+
+    // Network address as the driver reports it: 16 bytes in network order
+    // (IPv4 in the first four, the rest zero) and the family. Compared and
+    // hashed as two 64-bit words, never as text.
+    struct IpAddress {
+        uint8_t bytes[16] = {};
+        AddressFamily family = AddressFamily::NONE;
+
+        static IpAddress FromBytes(const uint8_t* raw, AddressFamily family) {
+            IpAddress address;
+            address.family = family;
+            if (family == AddressFamily::IPV4) {
+                std::memcpy(address.bytes, raw, 4);
+            }
+            else if (family == AddressFamily::IPV6) {
+                std::memcpy(address.bytes, raw, 16);
+            }
+            return address;
+        }
+
+        bool empty() const { return family == AddressFamily::NONE; }
+
+        uint64_t high() const { uint64_t word; std::memcpy(&word, bytes, 8); return word; }
+        uint64_t low() const { uint64_t word; std::memcpy(&word, bytes + 8, 8); return word; }
+
+        size_t Hash() const {
+            uint64_t h = (high() ^ (low() * 0x9E3779B97F4A7C15ULL)) + static_cast<uint64_t>(family);
+            h ^= h >> 29;
+            h *= 0xBF58476D1CE4E5B9ULL;
+            return static_cast<size_t>(h ^ (h >> 32));
+        }
+
+        friend bool operator==(const IpAddress& a, const IpAddress& b) {
+            return a.family == b.family && a.high() == b.high() && a.low() == b.low();
+        }
+        friend bool operator!=(const IpAddress& a, const IpAddress& b) { return !(a == b); }
+    };
+
+    struct IpAddressHash {
+        size_t operator()(const IpAddress& address) const { return address.Hash(); }
+    };
+
+    // Text of an address, held inline: formatting one does not allocate
+    class FormattedAddress {
+    public:
+        // INET6_ADDRSTRLEN
+        static constexpr size_t CAPACITY = 46;
+
+        std::string_view view() const { return std::string_view(text_, size_); }
+        operator std::string_view() const { return view(); }
+        std::string str() const { return std::string(text_, size_); }
+
+    private:
+        friend class AddressFormatCache;
+
+        char text_[CAPACITY] = {};
+        uint8_t size_ = 0;
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const FormattedAddress& value) {
+        return os << value.view();
+    }
+
+    // Recently formatted addresses, for sinks that turn events into text.
+    // Direct-mapped: an address hashes to one of ADDRESS_FORMAT_CACHE_SLOTS
+    // slots, each behind its own try-lock. A thread that finds the slot busy
+    // formats the address itself rather than wait, so the cache never
+    // blocks and never hands out a half-written entry.
+    class AddressFormatCache {
+    public:
+        struct Statistics {
+            uint64_t hits;
+            uint64_t misses;
+        };
+
+        // Cache FormatAddress() goes through, never destroyed
+        static AddressFormatCache& GetInstance();
+
+        explicit AddressFormatCache(size_t slots = constants::ADDRESS_FORMAT_CACHE_SLOTS);
+
+        AddressFormatCache(const AddressFormatCache&) = delete;
+        AddressFormatCache& operator=(const AddressFormatCache&) = delete;
+
+        FormattedAddress Format(const IpAddress& address);
+
+        Statistics GetStatistics() const;
+
+        // inet_ntop, without the cache; empty for AddressFamily::NONE
+        static FormattedAddress FormatUncached(const IpAddress& address);
+
+    private:
+        struct alignas(64) Slot {
+            std::atomic<bool> busy{ false };
+            bool used = false;
+            IpAddress address;
+            FormattedAddress text;
+        };
+
+        size_t mask_;
+        std::unique_ptr<Slot[]> slots_;
+        std::atomic<uint64_t> hits_{ 0 };
+        std::atomic<uint64_t> misses_{ 0 };
+    };
+
+    inline FormattedAddress FormatAddress(const IpAddress& address) {
+        return AddressFormatCache::GetInstance().Format(address);
+    }
+
+    inline std::ostream& operator<<(std::ostream& os, const IpAddress& value) {
+        return os << FormatAddress(value);
+    }
+
+} // namespace kubearmor::data
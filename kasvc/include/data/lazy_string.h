@@ -0,0 +1,126 @@
+#pragma once
+
+#include "common/buffer_pool.h"
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace kubearmor::data {
+
+    // Event string field that is either plain UTF-8 or a validated UTF-16 span
+    // into a kernel message buffer. The UTF-16 form is converted on first
+    // read and cached in the buffer's arena (common::BufferArena), so fields
+    // nobody reads are never transcoded and the ones that are read do not
+    // touch the heap. Like std::string, a single instance must not be read
+    // from several threads while it is still unconverted. Device paths are
+    // converted to their DOS form (DevicePathTable::GetInstance()).
+    class LazyString {
+    public:
+        LazyString() = default;
+
+        // Already converted value (parsers without a buffer to point into)
+        LazyString(const std::string& value)
+            : utf8_(std::in_place, value.data(), value.size()), converted_(true) {
+        }
+
+        LazyString(const char* value)
+            : utf8_(std::in_place, value), converted_(true) {
+        }
+
+        // Span into owner's buffer, which the string keeps alive
+        static LazyString FromUtf16(const char16_t* data, size_t length, common::BufferRef owner) {
+            LazyString s;
+            s.owner_ = std::move(owner);
+            s.utf16_ = std::u16string_view(data, length);
+            s.converted_ = length == 0;
+            return s;
+        }
+
+        // Same for a \Device\... path, read as C:\...
+        static LazyString FromUtf16Path(const char16_t* data, size_t length, common::BufferRef owner) {
+            LazyString s = FromUtf16(data, length, std::move(owner));
+            s.device_path_ = true;
+            return s;
+        }
+
+        // Already converted value copied into owner's arena, the heap without one
+        static LazyString FromUtf8(std::string_view value, common::BufferRef owner) {
+            LazyString s;
+            std::pmr::memory_resource* resource = owner ? owner.arena() : std::pmr::get_default_resource();
+            s.owner_ = std::move(owner);
+            s.utf8_.emplace(value.data(), value.size(), resource);
+            return s;
+        }
+
+        // Copies keep the converted value in the arena it was allocated from,
+        // the copy holds the buffer as well
+        LazyString(const LazyString& other)
+            : owner_(other.owner_), utf16_(other.utf16_), converted_(other.converted_),
+            device_path_(other.device_path_) {
+            if (other.utf8_) {
+                utf8_.emplace(*other.utf8_, other.utf8_->get_allocator());
+            }
+        }
+
+        LazyString(LazyString&& other) noexcept = default;
+
+        LazyString& operator=(const LazyString& other) {
+            if (this != &other) {
+                *this = LazyString(other);
+            }
+            return *this;
+        }
+
+        LazyString& operator=(LazyString&& other) noexcept {
+            if (this != &other) {
+                // The old value may live in the arena of the buffer let go of here
+                utf8_.reset();
+                owner_ = std::move(other.owner_);
+                utf16_ = other.utf16_;
+                converted_ = other.converted_;
+                device_path_ = other.device_path_;
+                if (other.utf8_) {
+                    utf8_.emplace(std::move(*other.utf8_));
+                }
+            }
+            return *this;
+        }
+
+        // UTF-8 value, converted on first use
+        std::string_view str() const {
+            if (!converted_) {
+                Convert();
+            }
+            return utf8_ ? std::string_view(*utf8_) : std::string_view();
+        }
+
+        operator std::string_view() const { return str(); }
+
+        bool empty() const { return converted_ ? !utf8_ || utf8_->empty() : utf16_.empty(); }
+        bool IsConverted() const { return converted_; }
+
+        // Raw UTF-16 the value was captured as, empty for UTF-8 constructed values
+        std::u16string_view utf16() const { return utf16_; }
+
+    private:
+        void Convert() const;
+
+        // Declared first so the value is destroyed while its arena is still held
+        common::BufferRef owner_;
+        std::u16string_view utf16_;
+        mutable std::optional<std::pmr::string> utf8_;
+        mutable bool converted_ = true;
+        bool device_path_ = false;
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const LazyString& value) {
+        return os << value.str();
+    }
+
+    inline bool operator==(const LazyString& a, const LazyString& b) { return a.str() == b.str(); }
+    inline bool operator!=(const LazyString& a, const LazyString& b) { return !(a == b); }
+
+} // namespace kubearmor::data
\ No newline at end of file
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "common/constants.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace kubearmor::data {
+
+    // char_traits<char16_t>::compare is a loop, paths are compared a lot
+    inline bool SameText(std::u16string_view a, std::u16string_view b) {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(char16_t)) == 0;
+    }
+
+    // One distinct path in a PathTable. The UTF-16 text is the key and never
+    // changes; the UTF-8 form is produced once, by the first reader.
+    struct InternedPath {
+        std::atomic<uint32_t> refs{ 0 };
+        uint32_t id = 0;
+        size_t hash = 0;
+        std::u16string utf16;
+
+        mutable std::once_flag converted;
+        mutable std::string utf8;
+    };
+
+    // Reference-counted handle to an interned path, one pointer wide. Copies
+    // share the entry; the table may drop an entry once no handle refers to
+    // it. Handles to the same text from the same table compare equal.
+    class PathRef {
+    public:
+        PathRef() = default;
+        explicit PathRef(InternedPath* path) : path_(path) {}
+
+        PathRef(const PathRef& other) : path_(other.path_) {
+            if (path_) path_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        PathRef(PathRef&& other) noexcept : path_(other.path_) {
+            other.path_ = nullptr;
+        }
+
+        PathRef& operator=(const PathRef& other) {
+            if (this != &other) {
+                PathRef copy(other);
+                Swap(copy);
+            }
+            return *this;
+        }
+
+        PathRef& operator=(PathRef&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                path_ = other.path_;
+                other.path_ = nullptr;
+            }
+            return *this;
+        }
+
+        ~PathRef() { Reset(); }
+
+        void Reset() {
+            if (path_) {
+                path_->refs.fetch_sub(1, std::memory_order_release);
+                path_ = nullptr;
+            }
+        }
+
+        void Swap(PathRef& other) noexcept { std::swap(path_, other.path_); }
+
+        // UTF-8 value in DOS form (DevicePathTable::GetInstance()), converted
+        // the first time any handle to the path reads it
+        const std::string& str() const;
+
+        // Adapter for code written against the former std::string fields
+        operator const std::string&() const { return str(); }
+
+        bool empty() const { return path_ == nullptr; }
+
+        // Compact identity of the path, unique among the paths the table
+        // currently holds and reused after an entry is dropped; 0 for the
+        // empty path
+        uint32_t id() const { return path_ ? path_->id : 0; }
+
+        std::u16string_view utf16() const {
+            return path_ ? std::u16string_view(path_->utf16) : std::u16string_view();
+        }
+
+        friend bool operator==(const PathRef& a, const PathRef& b) { return a.path_ == b.path_; }
+        friend bool operator!=(const PathRef& a, const PathRef& b) { return a.path_ != b.path_; }
+
+    private:
+        InternedPath* path_ = nullptr;
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const PathRef& value) {
+        return os << value.str();
+    }
+
+    // Concurrent intern table for paths that repeat across events (process
+    // images above all). Lookups of a path that is already in the table take
+    // a shared lock on one of PATH_TABLE_SHARDS shards; inserts take it
+    // exclusively. Entries nobody refers to stay cached until a shard holds
+    // more than its share of idle_limit, then the idle ones are dropped.
+    // A table must outlive every handle it gave out.
+    class PathTable {
+    public:
+        struct Statistics {
+            size_t paths;           // entries held, referenced or idle
+            size_t referenced;      // entries some handle refers to
+            size_t bytes;           // entries and their UTF-16 keys
+            uint64_t inserts;
+            uint64_t evictions;
+        };
+
+        // Table MessageParser interns into, never destroyed
+        static PathTable& GetInstance();
+
+        explicit PathTable(size_t idle_limit = constants::MAX_IDLE_INTERNED_PATHS);
+        ~PathTable();
+
+        PathTable(const PathTable&) = delete;
+        PathTable& operator=(const PathTable&) = delete;
+
+        // Handle to the entry for path, empty for an empty path
+        PathRef Intern(std::u16string_view path);
+
+        Statistics GetStatistics() const;
+
+    private:
+        struct Key {
+            std::u16string_view text;
+            size_t hash;
+
+            bool operator==(const Key& other) const { return SameText(text, other.text); }
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key& key) const { return key.hash; }
+        };
+
+        struct alignas(64) Shard {
+            mutable std::shared_mutex mutex;
+            std::unordered_map<Key, InternedPath*, KeyHash> paths;
+            size_t trim_at = 0;
+            uint32_t next_id = 1;
+            std::vector<uint32_t> free_ids;     // ids of evicted entries, reused first
+            uint64_t inserts = 0;
+            uint64_t evictions = 0;
+        };
+
+        static PathRef Acquire(InternedPath* path);
+        void Trim(Shard& shard);
+
+        size_t shard_idle_limit_;
+        std::unique_ptr<Shard[]> shards_;
+    };
+
+    // One thread's front for a PathTable. Remembers the last path seen per
+    // key (the parser uses the process id, whose image does not change) so
+    // a repeat costs a compare instead of a hash and a shard lock. Every
+    // remembered path stays referenced, and so in the table, until its slot
+    // is reused or the cache goes away.
+    class PathCache {
+    public:
+        explicit PathCache(PathTable& table) : table_(table) {}
+
+        PathCache(const PathCache&) = delete;
+        PathCache& operator=(const PathCache&) = delete;
+
+        PathRef Intern(uint32_t key, std::u16string_view path) {
+            if (path.empty()) {
+                return PathRef();
+            }
+
+            Slot& slot = slots_[((key * 2654435761u) >> 16) % constants::PATH_CACHE_SLOTS];
+            if (slot.key != key || !SameText(slot.path.utf16(), path)) {
+                slot.key = key;
+                slot.path = table_.Intern(path);
+            }
+            return slot.path;
+        }
+
+    private:
+        struct Slot {
+            uint32_t key = 0;
+            PathRef path;
+        };
+
+        PathTable& table_;
+        std::array<Slot, constants::PATH_CACHE_SLOTS> slots_;
+    };
+
+} // namespace kubearmor::data
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "common/result.h"
+#include "data/device_path_table.h"
+#include <Windows.h>
+#include <cfgmgr32.h>
+#include <atomic>
+#include <thread>
+
+namespace kubearmor::data {
+
+    // Keeps a DevicePathTable in step with the volumes on drive letters: it
+    // is filled on Start(), again shortly after a volume arrives or goes
+    // away, and every VOLUME_REFRESH_INTERVAL for changes that come without
+    // a notification (letters reassigned in Disk Management). \Device\Mup
+    // always maps to \, so network files read as \\server\share\...
+    // Volumes mounted only on folders keep their device paths.
+    class WinVolumeWatcher {
+    public:
+        explicit WinVolumeWatcher(DevicePathTable& table);
+        ~WinVolumeWatcher();
+
+        WinVolumeWatcher(const WinVolumeWatcher&) = delete;
+        WinVolumeWatcher& operator=(const WinVolumeWatcher&) = delete;
+
+        common::Result<void> Start();
+        void Stop();
+
+        // Reads the device behind every drive letter into the table
+        common::Result<void> Refresh();
+
+    private:
+        static DWORD CALLBACK OnVolumeChange(HCMNOTIFICATION notification, PVOID context,
+            CM_NOTIFY_ACTION action, PCM_NOTIFY_EVENT_DATA data, DWORD size);
+
+        void WatchThread();
+
+        DevicePathTable& table_;
+        HCMNOTIFICATION notification_;
+        HANDLE changed_;
+        std::atomic<bool> running_;
+        std::thread thread_;
+    };
+
+} // namespace kubearmor::data
@@ -1,13 +1,17 @@
 #pragma once
 
 #include "app/interfaces/i_event_publisher.h"
+#include "common/timestamp.h"
 #include "data/event_types.h"
 #include "kubearmor.grpc.pb.h"  // From submodule
 #include <grpcpp/grpcpp.h>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <atomic>
 #include <set>
+#include <vector>
 
 namespace kubearmor::rpc {
 
@@ -26,8 +30,8 @@ namespace kubearmor::rpc {
             const std::string& host_name);
         ~FeederEventPublisher() override = default;
 
-        void Publish(const data::Event& event) override;
-        void PublishBatch(const std::vector<data::Event>& events) override;
+        void Publish(data::Event&& event) override;
+        void PublishBatch(std::vector<data::Event>&& events) override;
         size_t GetSubscriberCount() const override;
         PublisherStatistics GetStatistics() const override;
 
@@ -60,6 +64,19 @@ namespace kubearmor::rpc {
             std::mutex write_mutex;
         };
 
+        // Subscribers are copied out under the list's lock and written to
+        // outside it, so a slow stream does not hold up subscribe and
+        // unsubscribe. Unsubscribe deactivates a subscriber under its
+        // write_mutex, writers check active again under it.
+        using AlertSubscriberList = std::vector<std::shared_ptr<AlertSubscriber>>;
+        using LogSubscriberList = std::vector<std::shared_ptr<LogSubscriber>>;
+
+        void SnapshotAlertSubscribers(AlertSubscriberList& subscribers) const;
+        void SnapshotLogSubscribers(LogSubscriberList& subscribers) const;
+
+        void PublishAlert(const data::Event& event, const AlertSubscriberList& subscribers);
+        void PublishLog(const data::Event& event, const LogSubscriberList& subscribers);
+
         feeder::Alert ConvertToAlert(const data::Event& event);
         feeder::Log ConvertToLog(const data::Event& event);
 
@@ -67,17 +84,19 @@ namespace kubearmor::rpc {
             const StreamFilter& filter);
 
         int64_t ToUnixTimestamp(std::chrono::system_clock::time_point tp);
-        std::string ToFormattedTime(std::chrono::system_clock::time_point tp);
+        common::FormattedTime ToFormattedTime(std::chrono::system_clock::time_point tp);
+        // Addresses are formatted here, at the sink, through the format cache
+        std::string FormatNetworkResource(const data::NetworkEventData& network);
 
         std::string cluster_name_;
         std::string host_name_;
 
         mutable std::shared_mutex alert_subscribers_mutex_;
-        std::map<AlertStreamId, std::unique_ptr<AlertSubscriber>> alert_subscribers_;
+        std::map<AlertStreamId, std::shared_ptr<AlertSubscriber>> alert_subscribers_;
         std::atomic<AlertStreamId> next_alert_id_{ 1 };
 
         mutable std::shared_mutex log_subscribers_mutex_;
-        std::map<LogStreamId, std::unique_ptr<LogSubscriber>> log_subscribers_;
+        std::map<LogStreamId, std::shared_ptr<LogSubscriber>> log_subscribers_;
         std::atomic<LogStreamId> next_log_id_{ 1 };
 
         std::atomic<uint64_t> alerts_published_{ 0 };
@@ -1,18 +1,46 @@
 #include "app/monitoring_service.h"
+#include "common/constants.h"
 #include "common/logger.h"
+#include "common/placement_planner.h"
 
 namespace kubearmor::app {
 
+    namespace {
+
+        void PinWorker(const std::vector<uint32_t>& cpus, const char* role) {
+            if (cpus.empty()) {
+                return;
+            }
+            auto pinned = common::PinCurrentThread(cpus);
+            if (!pinned) {
+                LOG_WARN(std::string("Unable to pin ") + role + ": " + pinned.ErrorMessage());
+            }
+        }
+
+        uint64_t PerEventNs(std::chrono::steady_clock::time_point start, size_t events) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            return static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / events;
+        }
+
+    } // namespace
+
     MonitoringService::MonitoringService(
         std::shared_ptr<IEventReceiver> event_receiver,
         std::shared_ptr<IEventPublisher> publisher,
         std::shared_ptr<data::EventProcessor> processor,
-        size_t worker_threads_count)
+        size_t worker_threads_count,
+        std::vector<uint32_t> worker_cpus,
+        size_t publish_threads,
+        size_t publish_queue_size)
         : event_receiver_(std::move(event_receiver))
         , publisher_(std::move(publisher))
         , processor_(std::move(processor))
-        , running_(false)
-        , worker_threads_count_(worker_threads_count){
+        , worker_threads_count_(worker_threads_count)
+        , worker_cpus_(std::move(worker_cpus))
+        , publish_threads_count_(publish_threads)
+        , publish_queue_size_(publish_queue_size)
+        , running_(false) {
     }
 
     MonitoringService::~MonitoringService() {
@@ -24,6 +52,21 @@ namespace kubearmor::app {
             return common::Result<void>::Error("Service already running");
         }
 
+        // With lanes, each worker drains one and no lane may be left without
+        size_t lanes = event_receiver_->GetLaneCount();
+        if (lanes > 1 && lanes != worker_threads_count_) {
+            return common::Result<void>::Error("Event receiver has " + std::to_string(lanes) +
+                " lanes for " + std::to_string(worker_threads_count_) + " worker threads");
+        }
+        // and one publish worker keeps the order the lanes gave
+        if (lanes > 1 && publish_threads_count_ > 1) {
+            return common::Result<void>::Error("Event receiver lanes keep each process in order, " +
+                std::to_string(publish_threads_count_) + " publish threads would not");
+        }
+        if (publish_threads_count_ > 0 && publish_queue_size_ == 0) {
+            return common::Result<void>::Error("Publish threads need a publish queue");
+        }
+
         LOG_INFO("Starting monitoring service");
 
         // Connect to event_receiver
@@ -36,13 +79,33 @@ namespace kubearmor::app {
         running_ = true;
         start_time_ = std::chrono::steady_clock::now();
 
+        // Publish workers first, so enrich workers have somewhere to queue.
+        // Both pools share the worker CPUs.
+        size_t threads = worker_threads_count_ + publish_threads_count_;
+        if (publish_threads_count_ > 0) {
+            publish_queue_ = std::make_unique<common::MpmcRing<data::Event>>(publish_queue_size_);
+        }
+        for (size_t i = 0; i < publish_threads_count_; ++i) {
+            auto cpus = common::CpusForThread(worker_cpus_, threads, worker_threads_count_ + i);
+            publish_threads_.emplace_back([this, cpus] {
+                PinWorker(cpus, "publish worker");
+                PublishLoopThread();
+                });
+        }
+
         // Start worker threads
         for (size_t i = 0; i < worker_threads_count_; ++i) {
-            worker_threads_.emplace_back([this] { EventLoopThread(); });
+            auto cpus = common::CpusForThread(worker_cpus_, threads, i);
+            size_t lane = lanes > 1 ? i : 0;
+            worker_threads_.emplace_back([this, cpus, lane] {
+                PinWorker(cpus, "monitoring worker");
+                EventLoopThread(lane);
+                });
         }
 
         LOG_INFO("Monitoring service started with " +
-            std::to_string(worker_threads_count_) + " worker threads");
+            std::to_string(worker_threads_count_) + " worker threads, " +
+            std::to_string(publish_threads_count_) + " publish threads");
 
         return common::Result<void>::Success();
     }
@@ -64,6 +127,17 @@ namespace kubearmor::app {
         }
         worker_threads_.clear();
 
+        // Publish workers drain what the enrich workers queued, then stop
+        if (publish_queue_) {
+            publish_queue_->Close();
+        }
+        for (auto& thread : publish_threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        publish_threads_.clear();
+
         // Disconnect
         event_receiver_->Disconnect();
 
@@ -72,42 +146,115 @@ namespace kubearmor::app {
         return common::Result<void>::Success();
     }
 
-    void MonitoringService::EventLoopThread() {
+    void MonitoringService::EventLoopThread(size_t lane) {
         LOG_DEBUG("Event loop thread started");
 
+        // Reused for every batch, emptied once published or queued
+        std::vector<data::Event> batch;
+        batch.reserve(constants::MONITORING_BATCH_SIZE);
+
+        // The receiver spins and parks as its wait strategy says, the
+        // timeout only bounds how long Stop() waits for this thread
         while (running_.load()) {
-            LOG_DEBUG("EventLoopThread()");
-            auto event_opt = event_receiver_->ReceiveEvent(std::chrono::milliseconds(100));
+            size_t received = event_receiver_->ReceiveEvents(lane, batch, constants::MONITORING_BATCH_SIZE,
+                std::chrono::milliseconds(100));
 
-            if (!event_opt) {
-                LOG_DEBUG("EventLoopThread() !event_opt");
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (received == 0) {
                 continue;
             }
 
-            events_received_++;
+            events_received_ += received;
+            EnrichBatch(batch);
+
+            if (!batch.empty()) {
+                if (publish_queue_) {
+                    // Waits for room: a full publish queue backs up into the
+                    // event queue, where the overload policy applies. Only
+                    // Stop() drops events here, and it closes the queue last.
+                    publish_queue_->PushBatch(batch, common::OverloadPolicy::BLOCK,
+                        std::chrono::steady_clock::duration::max(),
+                        [](const data::Event&) { return false; },
+                        [this](const data::Event&) { publish_errors_++; });
+                }
+                else {
+                    PublishBatch(batch);
+                }
+            }
+            batch.clear();
+        }
 
+        LOG_DEBUG("Event loop thread stopped");
+    }
+
+    void MonitoringService::PublishLoopThread() {
+        LOG_DEBUG("Publish thread started");
+
+        std::vector<data::Event> batch;
+        batch.reserve(constants::MONITORING_BATCH_SIZE);
+
+        // Runs until Stop() closes the queue and it is drained
+        while (publish_queue_->PopBatch(batch, constants::MONITORING_BATCH_SIZE,
+            std::chrono::milliseconds(100)) || !publish_queue_->IsClosed()) {
+
+            if (!batch.empty()) {
+                PublishBatch(batch);
+                batch.clear();
+            }
+        }
+
+        LOG_DEBUG("Publish thread stopped");
+    }
+
+    void MonitoringService::EnrichBatch(std::vector<data::Event>& batch) {
+        auto start = std::chrono::steady_clock::now();
+        size_t received = batch.size();
+
+        // Enrich events with additional information, dropping any that fail
+        size_t kept = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
             try {
-                ProcessEvent(*event_opt);
+                processor_->Enrich(batch[i]);
             }
             catch (const std::exception& e) {
                 LOG_ERR(std::string("Error processing event: ") + e.what());
-                processing_errors_++;
+                enrich_errors_++;
+                continue;
+            }
+
+            if (kept != i) {
+                batch[kept] = std::move(batch[i]);
             }
+            kept++;
         }
+        batch.erase(batch.begin() + kept, batch.end());
 
-        LOG_DEBUG("Event loop thread stopped");
+        events_enriched_ += kept;
+        enrich_ns_.Record(PerEventNs(start, received));
     }
 
-    void MonitoringService::ProcessEvent(const data::Event& event) {
-        // Enrich event with additional information
-        auto enriched = processor_->Enrich(event);
+    void MonitoringService::PublishBatch(std::vector<data::Event>& batch) {
+        auto start = std::chrono::steady_clock::now();
+        size_t count = batch.size();
 
-        // Publish to subscribers
-        publisher_->Publish(enriched);
+        for (const auto& event : batch) {
+            if (auto process_id = event.ProcessId()) {
+                order_.Record(*process_id, event.sequence);
+            }
+        }
 
-        events_processed_++;
-        events_published_++;
+        // Publish to subscribers, the publisher owns the events from here
+        try {
+            publisher_->PublishBatch(std::move(batch));
+        }
+        catch (const std::exception& e) {
+            LOG_ERR(std::string("Error publishing events: ") + e.what());
+            publish_errors_ += count;
+            return;
+        }
+
+        events_processed_ += count;
+        events_published_ += count;
+        publish_ns_.Record(PerEventNs(start, count));
     }
 
     MonitoringService::MonitoringStatus MonitoringService::GetStatus() const {
@@ -125,16 +272,51 @@ namespace kubearmor::app {
             events_received_.load(),
             events_processed_.load(),
             events_published_.load(),
-            processing_errors_.load(),
+            enrich_errors_.load() + publish_errors_.load(),
+            order_.Violations(),
+            order_.Untracked(),
             start_time_
         };
     }
 
+    std::vector<common::StageLedger> MonitoringService::GetLossLedger() const {
+        auto metrics = event_receiver_->GetPerformanceMetrics();
+        uint64_t records = metrics.driver_events_received + metrics.unsequenced_events;
+
+        // Every record the driver sends is queued as one event, or dropped
+        // by the parser when it does not parse; nothing is queued for it
+        return {
+            { "driver", metrics.driver_sequence_span, metrics.driver_events_received, 0, 0 },
+            { "parser", records, metrics.events_queued, metrics.parse_failures, 0 },
+            { "event_queue", metrics.events_queued, metrics.events_dequeued, metrics.dropped_messages,
+                metrics.queue_depth },
+            { "enrich", events_received_.load(), events_enriched_.load(), enrich_errors_.load(), 0 },
+            { "publish", events_enriched_.load(), events_published_.load(), publish_errors_.load(),
+                publish_queue_ ? publish_queue_->Size() : 0 }
+        };
+    }
+
+    std::vector<MonitoringService::StageMetrics> MonitoringService::GetStageMetrics() const {
+        auto metrics = event_receiver_->GetPerformanceMetrics();
+        return {
+            { "receive", metrics.receive_threads, 0, 0, metrics.total_messages_received,
+                metrics.decode_p50_ns, metrics.decode_p99_ns, metrics.decode_max_ns },
+            { "enrich", worker_threads_count_, metrics.queue_depth, metrics.queue_capacity, events_received_.load(),
+                enrich_ns_.ValueAtPercentile(50), enrich_ns_.ValueAtPercentile(99), enrich_ns_.Max() },
+            { "publish", publish_threads_count_, publish_queue_ ? publish_queue_->Size() : 0,
+                publish_queue_ ? publish_queue_->Capacity() : 0, events_enriched_.load(),
+                publish_ns_.ValueAtPercentile(50), publish_ns_.ValueAtPercentile(99), publish_ns_.Max() }
+        };
+    }
+
     void MonitoringService::ResetStatistics() {
         events_received_ = 0;
         events_processed_ = 0;
         events_published_ = 0;
-        processing_errors_ = 0;
+        events_enriched_ = 0;
+        enrich_errors_ = 0;
+        publish_errors_ = 0;
+        order_.Reset();
         start_time_ = std::chrono::steady_clock::now();
     }
 
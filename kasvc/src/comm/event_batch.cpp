@@ -0,0 +1,159 @@
+#include "comm/event_batch.h"
+#include <cstring>
+
+namespace kubearmor::comm {
+
+    namespace {
+
+        constexpr size_t AlignRecord(size_t size) {
+            return (size + EVENT_RECORD_ALIGNMENT - 1) / EVENT_RECORD_ALIGNMENT * EVENT_RECORD_ALIGNMENT;
+        }
+
+    } // namespace
+
+    EventBatchWriter::EventBatchWriter(uint8_t* frame, size_t capacity)
+        : frame_(frame), capacity_(capacity), size_(sizeof(KernelBatchHeader)), count_(0) {
+    }
+
+    size_t EventBatchWriter::RecordSize(size_t event_size) {
+        return AlignRecord(sizeof(KernelRecordHeader) + event_size);
+    }
+
+    bool EventBatchWriter::Fits(size_t event_size) const {
+        return count_ < UINT16_MAX && event_size >= sizeof(KernelEvent) &&
+            size_ + RecordSize(event_size) <= capacity_;
+    }
+
+    bool EventBatchWriter::Append(const uint8_t* event, size_t event_size) {
+        if (!Fits(event_size)) {
+            return false;
+        }
+
+        KernelRecordHeader record{};
+        record.length = static_cast<uint32_t>(sizeof(KernelRecordHeader) + event_size);
+
+        uint8_t* position = frame_ + size_;
+        std::memcpy(position, &record, sizeof(record));
+        std::memcpy(position + sizeof(record), event, event_size);
+
+        // zero the padding so frames are byte-for-byte reproducible
+        size_t padded = RecordSize(event_size);
+        std::memset(position + record.length, 0, padded - record.length);
+
+        size_ += padded;
+        count_++;
+        return true;
+    }
+
+    size_t EventBatchWriter::Finish() {
+        KernelBatchHeader header{};
+        header.magic = EVENT_BATCH_MAGIC;
+        header.version = EVENT_BATCH_VERSION;
+        header.record_count = count_;
+        header.length = static_cast<uint32_t>(size_);
+        std::memcpy(frame_, &header, sizeof(header));
+        return size_;
+    }
+
+    void EventBatchWriter::Reset() {
+        size_ = sizeof(KernelBatchHeader);
+        count_ = 0;
+    }
+
+    EventBatchReader::Iterator::Iterator(const uint8_t* position, size_t remaining,
+        bool framed, EventRecord record)
+        : position_(position), remaining_(remaining), framed_(framed), record_(record) {
+        Load();
+    }
+
+    void EventBatchReader::Iterator::Load() {
+        if (!framed_ || remaining_ == 0) {
+            return;
+        }
+
+        const auto* record = reinterpret_cast<const KernelRecordHeader*>(position_);
+        record_ = EventRecord{ position_ + sizeof(KernelRecordHeader),
+            record->length - sizeof(KernelRecordHeader) };
+    }
+
+    EventBatchReader::Iterator& EventBatchReader::Iterator::operator++() {
+        if (framed_) {
+            position_ += AlignRecord(record_.size + sizeof(KernelRecordHeader));
+        }
+        remaining_--;
+        Load();
+        return *this;
+    }
+
+    bool EventBatchReader::IsBatch(const uint8_t* payload, size_t size) {
+        if (!payload || size < sizeof(uint64_t)) {
+            return false;
+        }
+
+        uint64_t magic;
+        std::memcpy(&magic, payload, sizeof(magic));
+        return magic == EVENT_BATCH_MAGIC;
+    }
+
+    common::Result<EventBatchReader> EventBatchReader::Create(const uint8_t* payload, size_t size) {
+        if (!payload) {
+            return common::Result<EventBatchReader>::Error("Null kernel message");
+        }
+
+        if (!IsBatch(payload, size)) {
+            return common::Result<EventBatchReader>::Success(EventBatchReader(payload, size, 1, false));
+        }
+
+        // Records are read in place
+        if (reinterpret_cast<uintptr_t>(payload) % alignof(KernelEvent) != 0) {
+            return common::Result<EventBatchReader>::Error("Misaligned batch frame");
+        }
+
+        if (size < sizeof(KernelBatchHeader)) {
+            return common::Result<EventBatchReader>::Error("Truncated batch frame");
+        }
+
+        const auto* header = reinterpret_cast<const KernelBatchHeader*>(payload);
+        if (header->version != EVENT_BATCH_VERSION) {
+            return common::Result<EventBatchReader>::Error(
+                "Unsupported batch frame version " + std::to_string(header->version));
+        }
+
+        if (header->length < sizeof(KernelBatchHeader) || header->length > size) {
+            return common::Result<EventBatchReader>::Error(
+                "Batch frame length " + std::to_string(header->length) +
+                " does not match the " + std::to_string(size) + " bytes received");
+        }
+
+        size_t offset = sizeof(KernelBatchHeader);
+        for (uint16_t i = 0; i < header->record_count; ++i) {
+            if (offset + sizeof(KernelRecordHeader) > header->length) {
+                return common::Result<EventBatchReader>::Error("Batch frame record count exceeds its length");
+            }
+
+            const auto* record = reinterpret_cast<const KernelRecordHeader*>(payload + offset);
+            if (record->length < sizeof(KernelRecordHeader) + sizeof(KernelEvent) ||
+                record->length > header->length - offset) {
+                return common::Result<EventBatchReader>::Error(
+                    "Batch frame record " + std::to_string(i) + " out of bounds");
+            }
+
+            offset += AlignRecord(record->length);
+        }
+
+        return common::Result<EventBatchReader>::Success(
+            EventBatchReader(payload, header->length, header->record_count, true));
+    }
+
+    EventBatchReader::Iterator EventBatchReader::begin() const {
+        if (framed_) {
+            return Iterator(payload_ + sizeof(KernelBatchHeader), count_, true, EventRecord{});
+        }
+        return Iterator(payload_, count_, false, EventRecord{ payload_, size_ });
+    }
+
+    EventBatchReader::Iterator EventBatchReader::end() const {
+        return Iterator(nullptr, 0, framed_, EventRecord{});
+    }
+
+} // namespace kubearmor::comm
\ No newline at end of file
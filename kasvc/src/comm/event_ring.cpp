@@ -0,0 +1,215 @@
+#include "comm/event_ring.h"
+#include <cstring>
+#include <new>
+
+namespace kubearmor::comm {
+
+    namespace {
+
+        constexpr size_t AlignRecord(size_t size) {
+            return (size + EVENT_RECORD_ALIGNMENT - 1) / EVENT_RECORD_ALIGNMENT * EVENT_RECORD_ALIGNMENT;
+        }
+
+        constexpr uint32_t RecordType(EventRingRecordType type) {
+            return static_cast<uint32_t>(type);
+        }
+
+    } // namespace
+
+    EventRingWriter::EventRingWriter(EventRingHeader* header)
+        : header_(header)
+        , data_(reinterpret_cast<uint8_t*>(header) + header->header_size)
+        , mask_(header->capacity - 1)
+        , write_index_(header->write_index.load(std::memory_order_relaxed))
+        , read_index_(header->read_index.load(std::memory_order_relaxed)) {
+    }
+
+    common::Result<EventRingWriter> EventRingWriter::Format(void* region, size_t size) {
+        if (!region || reinterpret_cast<uintptr_t>(region) % alignof(EventRingHeader) != 0) {
+            return common::Result<EventRingWriter>::Error("Ring region is missing or misaligned");
+        }
+
+        if (size < sizeof(EventRingHeader) + 2 * sizeof(KernelEvent)) {
+            return common::Result<EventRingWriter>::Error("Ring region of " +
+                std::to_string(size) + " bytes is too small");
+        }
+
+        uint64_t capacity = 1;
+        while (capacity * 2 <= size - sizeof(EventRingHeader)) {
+            capacity *= 2;
+        }
+
+        auto* header = new (region) EventRingHeader{};
+        header->magic = EVENT_RING_MAGIC;
+        header->version = EVENT_RING_VERSION;
+        header->header_size = sizeof(EventRingHeader);
+        header->capacity = capacity;
+
+        return common::Result<EventRingWriter>::Success(EventRingWriter(header));
+    }
+
+    uint64_t EventRingWriter::Needed(size_t event_size) const {
+        uint64_t padded = AlignRecord(sizeof(EventRingRecordHeader) + event_size);
+        uint64_t tail_room = mask_ + 1 - (write_index_ & mask_);
+        return padded > tail_room ? tail_room + padded : padded;
+    }
+
+    bool EventRingWriter::Fits(size_t event_size) {
+        uint64_t capacity = mask_ + 1;
+        uint64_t needed = Needed(event_size);
+        if (needed > capacity) {
+            return false;
+        }
+
+        // The consumer's index is only read when the space we last saw runs
+        // out, so the producer does not pull its cache line on every write
+        if (needed <= capacity - (write_index_ - read_index_)) {
+            return true;
+        }
+
+        // read_index belongs to the consumer, a value behind or ahead of what
+        // we wrote leaves no free space rather than overwriting records
+        uint64_t read_index = header_->read_index.load(std::memory_order_acquire);
+        if (read_index > write_index_ || write_index_ - read_index > capacity) {
+            return false;
+        }
+        read_index_ = read_index;
+        return needed <= capacity - (write_index_ - read_index_);
+    }
+
+    bool EventRingWriter::Write(const uint8_t* event, size_t event_size, bool& doorbell) {
+        doorbell = false;
+
+        if (!Fits(event_size)) {
+            header_->overflow_records.fetch_add(1, std::memory_order_relaxed);
+            header_->overflow_bytes.fetch_add(event_size, std::memory_order_relaxed);
+            return false;
+        }
+
+        uint64_t length = sizeof(EventRingRecordHeader) + event_size;
+        uint64_t padded = AlignRecord(length);
+        uint64_t position = write_index_ & mask_;
+        uint64_t tail_room = mask_ + 1 - position;
+
+        if (padded > tail_room) {
+            EventRingRecordHeader wrap{ static_cast<uint32_t>(tail_room),
+                RecordType(EventRingRecordType::WRAP) };
+            std::memcpy(data_ + position, &wrap, sizeof(wrap));
+            write_index_ += tail_room;
+            position = 0;
+        }
+
+        EventRingRecordHeader record{ static_cast<uint32_t>(length),
+            RecordType(EventRingRecordType::EVENT) };
+        std::memcpy(data_ + position, &record, sizeof(record));
+        std::memcpy(data_ + position + sizeof(record), event, event_size);
+        std::memset(data_ + position + length, 0, padded - length);
+        write_index_ += padded;
+
+        // Publish, then look for a parked consumer. Both sides use seq_cst so
+        // either the consumer sees the record or we see it waiting.
+        header_->write_index.store(write_index_, std::memory_order_seq_cst);
+        if (header_->consumer_waiting.load(std::memory_order_seq_cst) != 0 &&
+            header_->consumer_waiting.exchange(0, std::memory_order_seq_cst) != 0) {
+            header_->doorbells.fetch_add(1, std::memory_order_relaxed);
+            doorbell = true;
+        }
+        return true;
+    }
+
+    EventRingReader::EventRingReader(EventRingHeader* header)
+        : header_(header)
+        , data_(reinterpret_cast<const uint8_t*>(header) + header->header_size)
+        , mask_(header->capacity - 1)
+        , read_index_(header->read_index.load(std::memory_order_relaxed))
+        , write_index_(read_index_) {
+    }
+
+    common::Result<EventRingReader> EventRingReader::Attach(void* region, size_t size) {
+        if (!region || reinterpret_cast<uintptr_t>(region) % alignof(EventRingHeader) != 0 ||
+            size < sizeof(EventRingHeader)) {
+            return common::Result<EventRingReader>::Error("Ring region is missing or misaligned");
+        }
+
+        auto* header = static_cast<EventRingHeader*>(region);
+        if (header->magic != EVENT_RING_MAGIC) {
+            return common::Result<EventRingReader>::Error("Not an event ring");
+        }
+
+        if (header->version != EVENT_RING_VERSION) {
+            return common::Result<EventRingReader>::Error(
+                "Unsupported event ring version " + std::to_string(header->version));
+        }
+
+        uint64_t capacity = header->capacity;
+        if (header->header_size < sizeof(EventRingHeader) || header->header_size > size ||
+            header->header_size % EVENT_RECORD_ALIGNMENT != 0 ||
+            capacity < sizeof(EventRingRecordHeader) || (capacity & (capacity - 1)) != 0 ||
+            capacity > size - header->header_size) {
+            return common::Result<EventRingReader>::Error("Event ring geometry does not match the " +
+                std::to_string(size) + " bytes mapped");
+        }
+
+        return common::Result<EventRingReader>::Success(EventRingReader(header));
+    }
+
+    EventRingStatus EventRingReader::Read(EventRecord& record) {
+        for (;;) {
+            if (read_index_ == write_index_) {
+                write_index_ = header_->write_index.load(std::memory_order_acquire);
+                if (read_index_ == write_index_) {
+                    return EventRingStatus::EMPTY;
+                }
+            }
+
+            uint64_t available = write_index_ - read_index_;
+            uint64_t position = read_index_ & mask_;
+            uint64_t tail_room = mask_ + 1 - position;
+            if (available > mask_ + 1 || available < sizeof(EventRingRecordHeader)) {
+                return EventRingStatus::CORRUPT;
+            }
+
+            EventRingRecordHeader header;
+            std::memcpy(&header, data_ + position, sizeof(header));
+
+            if (header.type == RecordType(EventRingRecordType::WRAP)) {
+                if (header.length != tail_room || header.length > available) {
+                    return EventRingStatus::CORRUPT;
+                }
+                read_index_ += tail_room;
+                continue;
+            }
+
+            uint64_t padded = AlignRecord(header.length);
+            if (header.type != RecordType(EventRingRecordType::EVENT) ||
+                header.length < sizeof(EventRingRecordHeader) + sizeof(KernelEvent) ||
+                padded > tail_room || padded > available) {
+                return EventRingStatus::CORRUPT;
+            }
+
+            record = EventRecord{ data_ + position + sizeof(header),
+                header.length - sizeof(EventRingRecordHeader) };
+            read_index_ += padded;
+            return EventRingStatus::RECORD;
+        }
+    }
+
+    void EventRingReader::Release() {
+        header_->read_index.store(read_index_, std::memory_order_release);
+    }
+
+    bool EventRingReader::PrepareToWait() {
+        Release();
+        header_->consumer_waiting.store(1, std::memory_order_seq_cst);
+        if (header_->write_index.load(std::memory_order_seq_cst) != read_index_) {
+            header_->consumer_waiting.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void EventRingReader::FinishWait() {
+        header_->consumer_waiting.store(0, std::memory_order_relaxed);
+    }
+
+} // namespace kubearmor::comm
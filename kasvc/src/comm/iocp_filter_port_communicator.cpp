@@ -1,18 +1,32 @@
 #include "comm/iocp_filter_port_communicator.h"
 #include "comm/message_parser.h"
 #include <algorithm>
+#include <iterator>
+#include <new>
 #include "common/logger.h"
 #include "common/constants.h"
+#include "common/placement_planner.h"
 
 namespace kubearmor::comm {
 
-    IOCPFilterPortCommunicator::IOCPFilterPortCommunicator(const IOCPConfig& config)
+    IOCPFilterPortCommunicator::IOCPFilterPortCommunicator(
+        const IOCPConfig& config,
+        std::unique_ptr<IFilterPort> port,
+        std::unique_ptr<IEventRingSection> ring_section)
         : config_(config)
-        , filter_port_(INVALID_HANDLE_VALUE)
-        , iocp_handle_(nullptr)
+        , port_(std::move(port))
         , running_(false)
-        , event_queue_(constants::MAX_EVENT_QUEUE_SIZE)
+        , ring_section_(std::move(ring_section))
         , last_stats_time_(std::chrono::steady_clock::now()) {
+
+        size_t lanes = std::max<size_t>(config.event_lanes, 1);
+        size_t lane_size = (constants::MAX_EVENT_QUEUE_SIZE + lanes - 1) / lanes;
+        lanes_.reserve(lanes);
+        for (size_t i = 0; i < lanes; i++) {
+            lanes_.push_back(std::make_unique<common::MpmcRing<data::Event>>(
+                lane_size, config.consumer_wait, &queue_wait_ns_));
+            queue_capacity_ += lanes_.back()->Capacity();
+        }
     }
 
     IOCPFilterPortCommunicator::~IOCPFilterPortCommunicator() {
@@ -24,66 +38,63 @@ namespace kubearmor::comm {
             return common::Result<void>::Success();
         }
 
-        LOG_INFO("Connecting to filter port with IOCP: " +
-            std::string(config_.port_name.begin(), config_.port_name.end()));
-
-        // Connect to filter port
-        HRESULT hr = FilterConnectCommunicationPort(
-            config_.port_name.c_str(),
-            0,
-            nullptr,
-            0,
-            nullptr,
-            &filter_port_
-        );
-
-        if (FAILED(hr)) {
-            LOG_ERR("FilterConnectCommunicationPort failed: 0x" +
-                std::to_string(hr));
-            return common::Result<void>::Error(
-                "Failed to connect to filter port: 0x" + std::to_string(hr));
+        auto connect_result = port_->Connect(config_.worker_thread_count);
+        if (!connect_result) {
+            return connect_result;
         }
 
-        // Create IOCP
-        iocp_handle_ = CreateIoCompletionPort(
-            filter_port_,
-            nullptr,
-            0,
-            static_cast<DWORD>(config_.worker_thread_count)
-        );
+        // The driver numbers each connection's events from 1
+        driver_sequence_.Reset();
 
-        if (!iocp_handle_) {
-            DWORD error = GetLastError();
-            CloseHandle(filter_port_);
-            filter_port_ = INVALID_HANDLE_VALUE;
+        // Allocate buffer pool: receive buffers, plus as many again to
+        // replace the ones large messages take with them, plus the size
+        // classes smaller messages are copied into
+        std::vector<common::BufferPool::SizeClass> size_classes;
+        for (size_t class_size : constants::MESSAGE_SIZE_CLASSES) {
+            if (class_size < config_.buffer_size) {
+                size_classes.push_back({ class_size, config_.buffers_per_size_class });
+            }
+        }
+        size_classes.push_back({ config_.buffer_size, 2 * config_.buffer_pool_size });
 
-            LOG_ERR("CreateIoCompletionPort failed: " + std::to_string(error));
-            return common::Result<void>::Error(
-                "Failed to create IOCP: " + std::to_string(error));
+        buffer_pool_ = common::BufferPool::Create(std::move(size_classes), config_.numa_node);
+        if (!buffer_pool_) {
+            LOG_ERR("Failed to allocate buffer slabs");
+            port_->Disconnect();
+            return common::Result<void>::Error("Memory allocation failed");
         }
 
-        // Allocate buffer pool
         LOG_INFO("Allocating " + std::to_string(config_.buffer_pool_size) +
             " buffers");
 
         for (size_t i = 0; i < config_.buffer_pool_size; ++i) {
             auto context = std::make_unique<IOContext>();
-            context->message_buffer = static_cast<uint8_t*>(
-                _aligned_malloc(config_.buffer_size, MEMORY_ALLOCATION_ALIGNMENT));
+            context->buffer = buffer_pool_->Acquire(config_.buffer_size);
 
-            if (!context->message_buffer) {
+            if (!context->buffer) {
                 LOG_ERR("Failed to allocate message buffer");
-                Disconnect();
+                ReleaseContextPool();
+                port_->Disconnect();
                 return common::Result<void>::Error("Memory allocation failed");
             }
 
-            context->buffer_size = config_.buffer_size;
+            context->message_buffer = context->buffer.data();
+            context->buffer_size = context->buffer.capacity();
             context->communicator = this;
-            context->in_use = false;
+            context->pool_index = context_pool_.size();
 
+            auto attach_result = port_->Attach(context.get());
             context_pool_.push_back(std::move(context));
+
+            if (!attach_result) {
+                LOG_ERR("Failed to attach receive buffer: " + attach_result.ErrorMessage());
+                ReleaseContextPool();
+                port_->Disconnect();
+                return attach_result;
+            }
         }
 
+        free_contexts_.Reset(context_pool_.size());
         running_ = true;
 
         // Start worker threads
@@ -91,7 +102,33 @@ namespace kubearmor::comm {
             " IOCP worker threads");
 
         for (size_t i = 0; i < config_.worker_thread_count; ++i) {
-            worker_threads_.emplace_back([this] { IOCPWorkerThread(); });
+            auto cpus = common::CpusForThread(config_.cpus, config_.worker_thread_count, i);
+            worker_threads_.emplace_back([this, cpus] {
+                PinThread(cpus, "IOCP worker");
+                IOCPWorkerThread();
+                });
+        }
+
+        // The ring is an addition to the port, a driver without one still
+        // sends every event as a message
+        if (ring_section_) {
+            auto map_result = ring_section_->Map();
+            auto reader = map_result ?
+                EventRingReader::Attach(ring_section_->base(), ring_section_->size()) :
+                common::Result<EventRingReader>::Error(map_result.ErrorMessage());
+
+            if (reader) {
+                LOG_INFO("Reading audit-only events from a " +
+                    std::to_string(reader.Value().capacity()) + " byte shared ring");
+                ring_thread_ = std::thread([this, ring = reader.TakeValue()] {
+                    PinThread(config_.cpus, "event ring");
+                    EventRingThread(ring);
+                    });
+            }
+            else {
+                LOG_WARN("Event ring unavailable, using the filter port only: " + reader.ErrorMessage());
+                ring_section_->Unmap();
+            }
         }
 
         // Submit initial receive operations
@@ -121,19 +158,16 @@ namespace kubearmor::comm {
         LOG_INFO("Disconnecting from filter port");
 
         running_ = false;
+        free_contexts_.Close();
 
         // Cancel outstanding I/O
-        if (filter_port_ != INVALID_HANDLE_VALUE) {
-            LOG_INFO("Cancelling pending I/O...");
-            CancelIoEx(filter_port_, nullptr);
-        }
+        LOG_INFO("Cancelling pending I/O...");
+        port_->CancelReceives();
 
-        // Post completions before closing the IOCP
-        if (iocp_handle_) {
-            LOG_DEBUG("Posting dummy completions to unblock threads...");
-            for (size_t i = 0; i < worker_threads_.size(); ++i) {
-                PostQueuedCompletionStatus(iocp_handle_, 0, 0, nullptr);
-            }
+        // Post completions to unblock the workers
+        LOG_DEBUG("Posting dummy completions to unblock threads...");
+        for (size_t i = 0; i < worker_threads_.size(); ++i) {
+            port_->Wake();
         }
 
         // Wait for worker threads
@@ -144,85 +178,92 @@ namespace kubearmor::comm {
         }
         worker_threads_.clear();
         LOG_DEBUG("worker threads cleared");
-        // Wait for dispatch thread
 
-        // Close iocp handle
-        if (iocp_handle_) {
-            LOG_DEBUG("Now closing IOCP handle...");
-            CloseHandle(iocp_handle_);
-            iocp_handle_ = nullptr;
-            LOG_DEBUG("iocp_handle closed");
+        if (ring_thread_.joinable()) {
+            ring_section_->Wake();
+            ring_thread_.join();
+            ring_section_->Unmap();
         }
 
         // Close filter port
-        if (filter_port_ != INVALID_HANDLE_VALUE) {
-            CloseHandle(filter_port_);
-            filter_port_ = INVALID_HANDLE_VALUE;
-            LOG_DEBUG("filter_port closed");
-        }
+        port_->Disconnect();
+        LOG_DEBUG("filter_port closed");
+
         // Free buffer pool
-        for (auto& context : context_pool_) {
-            if (context->message_buffer) {
-                _aligned_free(context->message_buffer);
-                context->message_buffer = nullptr;
-            }
-        }
-        context_pool_.clear();
+        ReleaseContextPool();
 
-        event_queue_.Close();
+        for (auto& lane : lanes_) {
+            lane->Close();
+        }
         LOG_INFO("Disconnected from filter port");
     }
 
     bool IOCPFilterPortCommunicator::IsConnected() const {
-        return filter_port_ != INVALID_HANDLE_VALUE &&
-            iocp_handle_ != nullptr &&
-            running_.load();
+        return port_->IsConnected() && running_.load();
+    }
+
+    void IOCPFilterPortCommunicator::ReleaseContextPool() {
+        for (auto& context : context_pool_) {
+            port_->Detach(context.get());
+            context->buffer.Reset();
+            context->message_buffer = nullptr;
+        }
+        context_pool_.clear();
     }
 
     std::optional<data::Event> IOCPFilterPortCommunicator::ReceiveEvent(
         std::chrono::milliseconds timeout) {
 
-        return event_queue_.TryPop(timeout);
+        // Look at every lane before waiting on one, starting where the last
+        // call left off so no lane is starved
+        size_t first = next_lane_.fetch_add(1, std::memory_order_relaxed);
+        std::optional<data::Event> event;
+        for (size_t i = 0; i < lanes_.size() && !event; i++) {
+            event = lanes_[(first + i) % lanes_.size()]->TryPop(std::chrono::milliseconds(0));
+        }
+        if (!event && timeout.count() > 0) {
+            event = lanes_[first % lanes_.size()]->TryPop(timeout);
+        }
+        if (event) {
+            events_dequeued_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return event;
     }
 
-    IOCPFilterPortCommunicator::IOContext*
-        IOCPFilterPortCommunicator::AllocateContext(
-        std::chrono::milliseconds timeout) {
+    size_t IOCPFilterPortCommunicator::ReceiveEvents(size_t lane, std::vector<data::Event>& events,
+        size_t max_events, std::chrono::milliseconds timeout) {
 
-        std::unique_lock<std::mutex> lock(context_pool_mutex_);
+        if (lane >= lanes_.size()) {
+            return 0;
+        }
 
-        // Wait with timeout instead of blocking forever
-        if (!context_available_.wait_for(lock, timeout, [this] {
-            return !running_.load() ||
-                std::any_of(context_pool_.begin(), context_pool_.end(),
-                    [](const auto& ctx) { return !ctx->in_use; });
-            })) {
-            return nullptr;
+        size_t received = lanes_[lane]->PopBatch(events, max_events, timeout);
+        if (received) {
+            events_dequeued_.fetch_add(received, std::memory_order_relaxed);
         }
+        return received;
+    }
+
+    IOCPFilterPortCommunicator::IOContext*
+        IOCPFilterPortCommunicator::AllocateContext(
+        std::chrono::milliseconds timeout) {
 
         if (!running_.load()) {
             return nullptr;
         }
 
-        // Find available context
-        for (auto& context : context_pool_) {
-            if (!context->in_use) {
-                context->in_use = true;
-                return context.get();
-            }
+        size_t index = free_contexts_.Acquire(timeout);
+        if (index == common::LockFreeIndexPool::NPOS) {
+            return nullptr;
         }
 
-        return nullptr;
+        return context_pool_[index].get();
     }
 
     void IOCPFilterPortCommunicator::FreeContext(IOContext* context) {
         if (!context) return;
 
-        {
-            std::lock_guard<std::mutex> lock(context_pool_mutex_);
-            context->in_use = false;
-        }
-        context_available_.notify_one();
+        free_contexts_.Release(context->pool_index);
     }
 
     bool IOCPFilterPortCommunicator::SubmitReceive(IOContext* context) {
@@ -230,33 +271,19 @@ namespace kubearmor::comm {
             return false;
         }
 
-        ZeroMemory(&context->overlapped, sizeof(OVERLAPPED));
         context->submit_time = std::chrono::steady_clock::now();
 
-        HRESULT hr = FilterGetMessage(
-            filter_port_,
-            reinterpret_cast<PFILTER_MESSAGE_HEADER>(context->message_buffer),
-            static_cast<DWORD>(context->buffer_size),
-            &context->overlapped
-        );
-
-        if (hr == HRESULT_FROM_WIN32(ERROR_IO_PENDING)) {
-            // Operation pending - this is expected
-            return true;
-        }
-        else if (SUCCEEDED(hr)) {
-            // Completed synchronously - post manually
-            PostQueuedCompletionStatus(
-                iocp_handle_,
-                0,
-                reinterpret_cast<ULONG_PTR>(context),
-                &context->overlapped
-            );
-            return true;
+        return port_->SubmitReceive(context);
+    }
+
+    void IOCPFilterPortCommunicator::PinThread(const std::vector<uint32_t>& cpus, const char* role) {
+        if (cpus.empty()) {
+            return;
         }
-        else {
-            LOG_ERR("FilterGetMessage failed: 0x" + std::to_string(hr));
-            return false;
+
+        auto pinned = common::PinCurrentThread(cpus);
+        if (!pinned) {
+            LOG_WARN(std::string("Unable to pin ") + role + " thread: " + pinned.ErrorMessage());
         }
     }
 
@@ -264,135 +291,369 @@ namespace kubearmor::comm {
 
         LOG_DEBUG("IOCP worker thread started");
 
+        const size_t batch_size = std::clamp<size_t>(
+            config_.completion_batch_size, 1, constants::MAX_COMPLETION_BATCH);
+
+        std::vector<Completion> completions(batch_size);
+        std::vector<data::Event> events;
+        events.reserve(batch_size);
+        std::vector<PendingReply> replies;
+        replies.reserve(batch_size);
+
         while (running_.load()) {
-            LOG_DEBUG("IOCPWorkerThread()");
-            DWORD bytes_transferred = 0;
-            ULONG_PTR completion_key = 0;
-            LPOVERLAPPED overlapped = nullptr;
-
-            BOOL result = GetQueuedCompletionStatus(
-                iocp_handle_,
-                &bytes_transferred,
-                &completion_key,
-                &overlapped,
-                1000  // 1 second timeout
+            size_t count = 0;
+
+            CompletionStatus status = port_->GetCompletions(
+                completions.data(),
+                batch_size,
+                count,
+                std::chrono::milliseconds(1000)  // 1 second timeout
             );
 
-            if (!result) {
-                DWORD error = GetLastError();
+            if (status == CompletionStatus::TIMEOUT) {
+                continue;
+            }
 
-                if (error == WAIT_TIMEOUT) {
-                    LOG_DEBUG("IOCPWorkerThread() WAIT_TIMEOUT");
-                    continue;
-                }
+            if (status == CompletionStatus::CLOSED) {
+                // IOCP closed
+                LOG_DEBUG("IOCPWorkerThread() IOCP closed");
+                break;
+            }
 
-                if (error == ERROR_ABANDONED_WAIT_0) {
-                    // IOCP closed
-                    LOG_DEBUG("IOCPWorkerThread() IOCP closed");
+            if (status == CompletionStatus::WAKEUP) {
+                if (!running_.load()) {
+                    LOG_DEBUG("IOCPWorkerThread() dummy wakeup -> exit");
                     break;
                 }
+                continue;
+            }
 
-                if (overlapped) {
-                    LOG_DEBUG("IOCPWorkerThread() overlapped");
-                    // Get context from overlapped
-                    IOContext* context = CONTAINING_RECORD(
-                        overlapped, IOContext, overlapped);
+            completion_batches_++;
+            ProcessCompletions(completions.data(), count, events, replies);
 
-                    LOG_ERR("GetQueuedCompletionStatus failed: " +
-                        std::to_string(error));
+            // Resubmit for next messages
+            for (size_t i = 0; i < count; ++i) {
+                IOContext* context = static_cast<IOContext*>(completions[i].request);
+                if (!running_.load() || !SubmitReceive(context)) {
+                    FreeContext(context);
+                }
+            }
+        }
+
+        LOG_DEBUG("IOCP worker thread stopped");
+    }
+
+    void IOCPFilterPortCommunicator::ProcessCompletions(
+        const Completion* completions, size_t count,
+        std::vector<data::Event>& events, std::vector<PendingReply>& replies) {
+
+        auto now = std::chrono::steady_clock::now();
+        events.clear();
+        replies.clear();
+        common::SequenceTracker::Batch sequences;
+
+        // Audit-only messages are acknowledged as soon as they are in our
+        // buffer, so the kernel thread in FltSendMessage does not wait on
+        // parsing or on the depth of the event queue
+        for (size_t i = 0; i < count; ++i) {
+            if (RepliesEarly(completions[i])) {
+                auto* message = reinterpret_cast<const KernelMessage*>(
+                    completions[i].request->message_buffer);
+                SendReply(message->header.MessageId, message->event.timestamp, 0, true);
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const Completion& completion = completions[i];
+            IOContext* context = static_cast<IOContext*>(completion.request);
 
-                    // Resubmit
-                    if (running_.load() && !SubmitReceive(context)) {
-                        FreeContext(context);
-                    }
+            if (completion.error != 0) {
+                // receives cancelled by Disconnect() are expected
+                if (running_.load()) {
+                    LOG_ERR("GetQueuedCompletionStatus failed: " +
+                        std::to_string(completion.error));
                 }
+                continue;
+            }
 
+            if (completion.bytes_transferred == 0) {
                 continue;
             }
 
-            if (!overlapped) {
-                LOG_DEBUG("IOCPWorkerThread() Spurious wakeup");
+            // Calculate latency
+            auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                now - context->submit_time);
+
+            auto* kernel_msg = reinterpret_cast<KernelMessage*>(context->message_buffer);
+
+            // The receive buffer may be handed to the events below, keep what
+            // the reply needs
+            if (NeedsReply(completion) && !RepliesEarly(completion)) {
+                bool complete = completion.bytes_transferred >= sizeof(KernelMessage) &&
+                    !EventBatchReader::IsBatch(reinterpret_cast<const uint8_t*>(&kernel_msg->event),
+                        completion.bytes_transferred - sizeof(FILTER_MESSAGE_HEADER));
+                replies.push_back(PendingReply{
+                    kernel_msg->header.MessageId,
+                    complete ? kernel_msg->event.timestamp : 0 });
+            }
 
-                if (!running_.load()) {
-                    LOG_DEBUG("IOCPWorkerThread() dummy wakeup -> exit");
-                    break;
-                }
+            // Every event of the message shares the captured buffer, strings
+            // stay UTF-16 in it until a sink reads them
+            common::BufferRef raw_message = CaptureMessage(context, completion.bytes_transferred);
+            auto records = MessageParser::Records(raw_message.data(), raw_message.size());
+            if (!records) {
+                LOG_WARN("Unable to parse kernel message: " + records.ErrorMessage());
+                parse_failures_++;
+                sequences.Add(0);
+                total_messages_++;
+                total_latency_us_ += latency.count();
                 continue;
             }
 
-            // Get context
-            IOContext* context = CONTAINING_RECORD(overlapped, IOContext, overlapped);
+            const EventBatchReader& reader = records.Value();
+            if (reader.framed()) {
+                batch_frames_++;
+                batched_events_ += reader.count();
+            }
+            total_messages_ += reader.count();
+            total_latency_us_ += latency.count() * reader.count();
+
+            for (const EventRecord& record : reader) {
+                auto e = MessageParser::Parse(record, raw_message);
+                if (!e.IsSuccess()) {
+                    // Dropped here, the driver's number for it is unknown
+                    LOG_WARN("Unable to parse kernel message: " + e.ErrorMessage());
+                    parse_failures_++;
+                    sequences.Add(0);
+                    continue;
+                }
 
-            if (bytes_transferred > 0) {
-                ProcessCompletedIO(context, bytes_transferred);
+                events.push_back(e.TakeValue());
+                sequences.Add(events.back().sequence);
+                events.back().raw_message = raw_message;
             }
+        }
+
+        driver_sequence_.Record(sequences);
+
+        if (!events.empty()) {
+            auto decoded = std::chrono::steady_clock::now();
+            decode_ns_.Record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(decoded - now).count()) / events.size());
+        }
+
+        // Queue the whole batch for dispatch
+        QueueEvents(events);
+
+        // Send remaining replies to driver
+        // current we're sending this ack to kernel driver we'll need to revisit it
+        // once we're done with complemte kernel filter design implementation
+        for (const auto& reply : replies) {
+            SendReply(reply.message_id, reply.kernel_time, 0, false);
+        }
+    }
+
+    void IOCPFilterPortCommunicator::EventRingThread(EventRingReader reader) {
+
+        LOG_DEBUG("Event ring thread started");
+
+        std::vector<data::Event> events;
+        events.reserve(constants::MAX_COMPLETION_BATCH);
+
+        while (running_.load()) {
+            events.clear();
+            common::SequenceTracker::Batch sequences;
+
+            EventRecord record;
+            EventRingStatus status = EventRingStatus::EMPTY;
+            while (events.size() < constants::MAX_COMPLETION_BATCH &&
+                (status = reader.Read(record)) == EventRingStatus::RECORD) {
+
+                // The ring space is reused once released, the event keeps a copy
+                common::BufferRef raw_event = buffer_pool_->Copy(record.data, record.size,
+                    record.size / constants::MESSAGE_ARENA_DIVISOR);
+                auto e = MessageParser::Parse(EventRecord{ raw_event.data(), raw_event.size() }, raw_event);
+                if (!e.IsSuccess()) {
+                    LOG_WARN("Unable to parse ring event: " + e.ErrorMessage());
+                    parse_failures_++;
+                    sequences.Add(0);
+                    continue;
+                }
 
-            // Resubmit for next message
-            if (running_.load() && !SubmitReceive(context)) {
-                FreeContext(context);
+                events.push_back(e.TakeValue());
+                sequences.Add(events.back().sequence);
+                events.back().raw_message = std::move(raw_event);
+            }
+            driver_sequence_.Record(sequences);
+
+            reader.Release();
+            ring_overflows_.store(reader.overflow_records(), std::memory_order_relaxed);
+
+            if (!events.empty()) {
+                ring_events_ += events.size();
+                total_messages_ += events.size();
+                QueueEvents(events);
+            }
+
+            if (status == EventRingStatus::CORRUPT) {
+                // The driver spills to the port once the ring stops draining
+                LOG_ERR("Event ring is corrupt, stopped reading it");
+                break;
+            }
+
+            if (status == EventRingStatus::EMPTY && reader.PrepareToWait()) {
+                if (ring_section_->WaitDoorbell(std::chrono::milliseconds(1000))) {
+                    ring_wakeups_++;
+                }
+                reader.FinishWait();
             }
         }
 
-        LOG_DEBUG("IOCP worker thread stopped");
+        LOG_DEBUG("Event ring thread stopped");
+    }
+
+    size_t IOCPFilterPortCommunicator::LaneOf(const data::Event& event) const {
+        uint64_t key;
+        if (auto process_id = event.ProcessId()) {
+            key = *process_id;
+        }
+        else if (const auto* network = event.GetNetworkData()) {
+            // Kept apart from process ids by bit 32
+            key = (uint64_t(1) << 32) | (uint64_t(network->local_port) << 16) | network->remote_port;
+        }
+        else {
+            key = 0;
+        }
+        // Process ids are multiples of 4 on Windows, mix before reducing
+        return static_cast<size_t>(((key * 0x9E3779B97F4A7C15ull) >> 32) % lanes_.size());
     }
 
-    void IOCPFilterPortCommunicator::ProcessCompletedIO(
-        IOContext* context, DWORD bytes_transferred) {
+    void IOCPFilterPortCommunicator::QueueEvents(std::vector<data::Event>& events) {
+        if (events.empty()) {
+            return;
+        }
+        events_queued_ += events.size();
 
-        LOG_DEBUG("ProcessCompletedIO()");
-        // Calculate latency
-        auto now = std::chrono::steady_clock::now();
-        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
-            now - context->submit_time);
-
-        total_messages_++;
-        total_latency_us_ += latency.count();
-        LOG_DEBUG("parsing message");
-        // Parse message
-        auto* kernel_msg = reinterpret_cast<KernelMessage*>(context->message_buffer);
-
-        // Convert to event data
-        data::Event event;
-        LOG_DEBUG("executing parser!!");
-        auto e = MessageParser::Parse(kernel_msg, bytes_transferred);
-        LOG_DEBUG("parser executed!!!");
-        if (e.IsSuccess()) {
-            event = e.Value();
+        uint64_t alerts = 0;
+        uint64_t logs = 0;
+        auto sheddable = [](const data::Event& event) { return !event.IsAlert(); };
+        auto on_drop = [&](const data::Event& event) { event.IsAlert() ? alerts++ : logs++; };
+
+        if (lanes_.size() == 1) {
+            lanes_[0]->PushBatch(events, config_.overload_policy, config_.overload_deadline,
+                sheddable, on_drop);
         }
         else {
-            LOG_WARN("Unable to parse kernel message: " + e.ErrorMessage());
+            // Split the batch by lane, keeping each lane's events in batch
+            // order; the per-lane vectors keep their capacity between calls
+            thread_local std::vector<std::vector<data::Event>> split;
+            if (split.size() < lanes_.size()) {
+                split.resize(lanes_.size());
+            }
+            for (auto& event : events) {
+                split[LaneOf(event)].push_back(std::move(event));
+            }
+            events.clear();
+            for (size_t lane = 0; lane < lanes_.size(); lane++) {
+                if (!split[lane].empty()) {
+                    lanes_[lane]->PushBatch(split[lane], config_.overload_policy, config_.overload_deadline,
+                        sheddable, on_drop);
+                    split[lane].clear();
+                }
+            }
         }
-        LOG_DEBUG("message parsed, dispatching now!!");
-        // Queue for dispatch
-        if (!event_queue_.TryPush(event, std::chrono::milliseconds(10))) {
-            LOG_WARN("Event queue full, dropping event");
+
+        if (alerts + logs == 0) {
+            return;
+        }
+
+        dropped_messages_ += alerts + logs;
+        dropped_alerts_ += alerts;
+        dropped_logs_ += logs;
+
+        uint64_t suppressed = 0;
+        if (drop_log_throttle_.Allow(suppressed)) {
+            LOG_WARN("Event queue full (" + std::string(common::OverloadPolicyName(config_.overload_policy)) +
+                "), dropped " + std::to_string(alerts) + " alerts and " + std::to_string(logs) +
+                " logs, " + std::to_string(suppressed) + " similar warnings suppressed");
         }
-        // Send reply to driver
-        // current we're sending this ack to kernel driver we'll need to revisit it
-        // once we're done with complemte kernel filter design implementation
-        SendReply(reinterpret_cast<FILTER_MESSAGE_HEADER*>(context->message_buffer), S_OK);
-        LOG_DEBUG("ProcessCompletedIO() completed");
     }
 
-    bool IOCPFilterPortCommunicator::SendReply(
-        const FILTER_MESSAGE_HEADER* msg_header, HRESULT status) {
+    common::BufferRef IOCPFilterPortCommunicator::CaptureMessage(
+        IOContext* context, size_t bytes_transferred) {
 
-        struct FilterReply {
-            FILTER_REPLY_HEADER header;
-            HRESULT result;
-        } reply = {};
+        // Large messages keep the receive buffer they arrived in and the
+        // context is rearmed with a fresh one, smaller ones are copied into
+        // the smallest size class that also fits their arena so they do not
+        // pin a full receive buffer
+        constexpr size_t LARGEST_SIZE_CLASS =
+            constants::MESSAGE_SIZE_CLASSES[std::size(constants::MESSAGE_SIZE_CLASSES) - 1];
 
-        reply.header.Status = status;
-        reply.header.MessageId = msg_header->MessageId;
-        reply.result = status;
+        size_t reserve = bytes_transferred / constants::MESSAGE_ARENA_DIVISOR;
+        if (bytes_transferred + reserve > LARGEST_SIZE_CLASS) {
 
-        HRESULT hr = FilterReplyMessage(
-            filter_port_,
-            &reply.header,
-            sizeof(reply)
-        );
+            common::BufferRef replacement = buffer_pool_->Acquire(context->buffer.capacity());
+            if (replacement) {
+                common::BufferRef filled = std::move(context->buffer);
+                filled.SetSize(bytes_transferred);
 
-        return SUCCEEDED(hr);
+                context->buffer = std::move(replacement);
+                context->message_buffer = context->buffer.data();
+                context->buffer_size = context->buffer.capacity();
+
+                buffer_handoffs_++;
+                return filled;
+            }
+        }
+
+        return buffer_pool_->Copy(context->message_buffer, bytes_transferred, reserve);
+    }
+
+    bool IOCPFilterPortCommunicator::NeedsReply(const Completion& completion) const {
+        if (completion.bytes_transferred < sizeof(FILTER_MESSAGE_HEADER)) {
+            return false;
+        }
+
+        // FltSendMessage without a reply buffer leaves ReplyLength at 0 and
+        // does not wait for us
+        auto* message = reinterpret_cast<const KernelMessage*>(completion.request->message_buffer);
+        return message->header.ReplyLength != 0;
+    }
+
+    bool IOCPFilterPortCommunicator::RepliesEarly(const Completion& completion) const {
+        if (!config_.early_reply || completion.error != 0 ||
+            completion.bytes_transferred < sizeof(KernelMessage) || !NeedsReply(completion)) {
+            return false;
+        }
+
+        auto* message = reinterpret_cast<const KernelMessage*>(completion.request->message_buffer);
+        if (EventBatchReader::IsBatch(reinterpret_cast<const uint8_t*>(&message->event),
+            completion.bytes_transferred - sizeof(FILTER_MESSAGE_HEADER))) {
+            return false;
+        }
+        return !message->event.verdict_required();
+    }
+
+    bool IOCPFilterPortCommunicator::SendReply(
+        uint64_t message_id, uint64_t kernel_time, int32_t status, bool early) {
+
+        if (!port_->SendReply(message_id, status)) {
+            reply_failures_++;
+            return false;
+        }
+
+        replies_sent_++;
+        if (early) {
+            early_replies_++;
+        }
+
+        // Truncated messages carry no timestamp
+        if (kernel_time != 0) {
+            auto waited = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now() - KernelTimeToSystemTime(kernel_time)).count();
+            reply_latency_us_.Record(waited > 0 ? static_cast<uint64_t>(waited) : 0);
+        }
+        return true;
     }
 
     IOCPFilterPortCommunicator::PerformanceMetrics
@@ -402,28 +663,67 @@ namespace kubearmor::comm {
             now - last_stats_time_).count();
 
         uint64_t current_count = total_messages_.load();
+        uint64_t queue_depth = 0;
+        for (const auto& lane : lanes_) {
+            queue_depth += lane->Size();
+        }
         uint64_t messages_delta = current_count - last_message_count_;
 
         uint64_t messages_per_sec = elapsed > 0 ? messages_delta / elapsed : 0;
 
-        uint64_t avg_latency = current_count > 0 ?
-            total_latency_us_.load() / current_count : 0;
+        // Ring events have no receive to measure from
+        uint64_t port_count = current_count - ring_events_.load();
+        uint64_t avg_latency = port_count > 0 ?
+            total_latency_us_.load() / port_count : 0;
 
-        size_t buffers_in_use = 0;
-        {
-            std::lock_guard<std::mutex> lock(
-                const_cast<std::mutex&>(context_pool_mutex_));
-            buffers_in_use = std::count_if(
-                context_pool_.begin(), context_pool_.end(),
-                [](const auto& ctx) { return ctx->in_use; });
-        }
+        size_t buffers_in_use = free_contexts_.InUse();
+
+        // buffer_pool_ is only replaced by Connect(), and outlives Disconnect()
+        uint64_t heap_allocations = buffer_pool_ ?
+            buffer_pool_->GetStatistics().heap_allocations : 0;
+
+        auto sequence = driver_sequence_.GetSnapshot();
 
         return PerformanceMetrics{
             current_count,
             messages_per_sec,
             avg_latency,
             buffers_in_use,
-            config_.buffer_pool_size - buffers_in_use
+            config_.buffer_pool_size - buffers_in_use,
+            dropped_messages_.load(),
+            dropped_alerts_.load(),
+            dropped_logs_.load(),
+            completion_batches_.load(),
+            batch_frames_.load(),
+            batched_events_.load(),
+            ring_events_.load(),
+            ring_wakeups_.load(),
+            ring_overflows_.load(),
+            buffer_handoffs_.load(),
+            heap_allocations,
+            replies_sent_.load(),
+            early_replies_.load(),
+            reply_failures_.load(),
+            reply_latency_us_.ValueAtPercentile(50),
+            reply_latency_us_.ValueAtPercentile(99),
+            reply_latency_us_.Max(),
+            parse_failures_.load(),
+            events_queued_.load(),
+            events_dequeued_.load(),
+            queue_depth,
+            sequence.Span(),
+            sequence.received,
+            sequence.Missing(),
+            sequence.unsequenced,
+            queue_wait_ns_.ValueAtPercentile(50),
+            queue_wait_ns_.ValueAtPercentile(99),
+            queue_wait_ns_.ValueAtPercentile(99.9),
+            queue_wait_ns_.Max(),
+            config_.worker_thread_count,
+            queue_capacity_,
+            decode_ns_.ValueAtPercentile(50),
+            decode_ns_.ValueAtPercentile(99),
+            decode_ns_.Max()
         };
     }
 
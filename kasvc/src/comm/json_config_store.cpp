@@ -1,4 +1,6 @@
 #include "comm/json_config_store.h"
+#include "common/constants.h"
+#include "common/cpu_topology.h"
 #include "common/logger.h"
 #include <fstream>
 #include <sstream>
@@ -8,6 +10,33 @@ using json = nlohmann::json;
 
 namespace kubearmor::comm {
 
+    namespace {
+
+        // "auto" (or missing) is 0, the placement plan sizes the pool
+        size_t ThreadCount(const json& section, const char* key) {
+            if (!section.contains(key)) {
+                return 0;
+            }
+
+            const json& value = section[key];
+            if (value.is_string()) {
+                std::string threads = value;
+                return threads == "auto" ? 0 : std::stoul(threads);
+            }
+            return value.get<size_t>();
+        }
+
+        common::Result<std::vector<uint32_t>> CpuList(const json& section, const char* key) {
+            auto cpus = common::ParseCpuList(section.value(key, ""));
+            if (!cpus) {
+                return common::Result<std::vector<uint32_t>>::Error(
+                    "placement." + std::string(key) + ": " + cpus.ErrorMessage());
+            }
+            return cpus;
+        }
+
+    } // namespace
+
     JsonConfigStore::JsonConfigStore(const std::filesystem::path& config_path)
         : config_path_(config_path)
         , watching_(false) {
@@ -156,24 +185,25 @@ namespace kubearmor::comm {
             config.host_name = j.value("host_name", "winows_host");
 
             // Service settings
+            config.service_worker_threads = 0;
+            config.worker_threads = 0;
+            config.publish_threads = 0;
+            config.publish_queue_size = constants::PUBLISH_QUEUE_SIZE;
             if (j.contains("service")) {
                 config.service_name = j["service"].value("name", "KubeArmorUserService");
                 // Worker threads
-                if (j["service"].contains("worker_threads")) {
-                    std::string threads = j["service"]["worker_threads"];
-                    if (threads == "auto") {
-                        config.service_worker_threads = std::thread::hardware_concurrency();
-                    }
-                    else {
-                        config.service_worker_threads = std::stoul(threads);
-                    }
-                }
-                else {
-                    config.service_worker_threads = std::thread::hardware_concurrency();
-                }
+                config.service_worker_threads = ThreadCount(j["service"], "worker_threads");
+                // Publishing on threads of its own, behind a bounded queue
+                config.publish_threads = j["service"].value("publish_threads", size_t(0));
+                config.publish_queue_size = j["service"].value("publish_queue_size", config.publish_queue_size);
             }
 
             // Driver settings
+            config.completion_batch_size = constants::DEFAULT_COMPLETION_BATCH;
+            config.early_reply = true;
+            config.event_ring = true;
+            config.receive_buffer_size = constants::FILTER_MESSAGE_BUFFER_SIZE;
+            config.buffers_per_size_class = constants::MESSAGE_BUFFERS_PER_CLASS;
             if (j.contains("driver")) {
                 auto& driver = j["driver"];
 
@@ -184,18 +214,46 @@ namespace kubearmor::comm {
                 config.device_path = device_path;
 
                 // Worker threads
-                if (j["driver"].contains("worker_threads")) {
-                    std::string threads = j["driver"]["worker_threads"];
-                    if (threads == "auto") {
-                        config.worker_threads = std::thread::hardware_concurrency();
-                    }
-                    else {
-                        config.worker_threads = std::stoul(threads);
+                config.worker_threads = ThreadCount(driver, "worker_threads");
+
+                // Completions drained per IOCP wakeup
+                config.completion_batch_size = driver.value(
+                    "completion_batch_size", constants::DEFAULT_COMPLETION_BATCH);
+
+                // Acknowledge audit-only events before processing them
+                config.early_reply = driver.value("early_reply", true);
+
+                // Read audit-only events from the driver's shared ring
+                config.event_ring = driver.value("event_ring", true);
+
+                // Receive buffers, defaults to the largest message the driver sends
+                config.receive_buffer_size = driver.value(
+                    "receive_buffer_size", constants::FILTER_MESSAGE_BUFFER_SIZE);
+                config.buffers_per_size_class = driver.value(
+                    "buffers_per_size_class", constants::MESSAGE_BUFFERS_PER_CLASS);
+            }
+
+            // Placement: which CPUs and NUMA node the pools run on, and how
+            // large "auto" pools are
+            config.cpu_budget = 0;
+            config.numa_node = -1;
+            config.pin_threads = true;
+            if (j.contains("placement")) {
+                auto& placement = j["placement"];
+
+                for (auto [key, cpus] : { std::make_pair("cpus", &config.placement_cpus),
+                    std::make_pair("iocp_cpus", &config.iocp_cpus),
+                    std::make_pair("worker_cpus", &config.worker_cpus) }) {
+                    auto parsed = CpuList(placement, key);
+                    if (!parsed) {
+                        return common::Result<app::Configuration>::Error(parsed.ErrorMessage());
                     }
+                    *cpus = parsed.Value();
                 }
-                else {
-                    config.worker_threads = std::thread::hardware_concurrency();
-                }
+
+                config.cpu_budget = placement.value("cpu_budget", static_cast<size_t>(0));
+                config.numa_node = placement.value("numa_node", -1);
+                config.pin_threads = placement.value("pin_threads", true);
             }
 
             // gRPC settings
@@ -206,9 +264,44 @@ namespace kubearmor::comm {
             }
 
             // Event queue settings
+            config.overload_policy = common::OverloadPolicy::SHED_LOGS;
+            config.overload_deadline_ms = constants::DEFAULT_OVERLOAD_DEADLINE.count();
+            config.consumer_wait = common::WaitStrategy::BALANCED;
+            config.sharded_pipeline = false;
             if (j.contains("event_streaming")) {
                 auto& streaming = j["event_streaming"];
                 config.event_queue_size = streaming.value("max_queue_size", 10000);
+
+                // What a full queue does with new events
+                std::string policy = streaming.value("overload_policy",
+                    common::OverloadPolicyName(common::OverloadPolicy::SHED_LOGS));
+                auto parsed = common::ParseOverloadPolicy(policy);
+                if (!parsed) {
+                    return common::Result<app::Configuration>::Error(
+                        "Unknown event_streaming.overload_policy: " + policy);
+                }
+                config.overload_policy = *parsed;
+                config.overload_deadline_ms = streaming.value(
+                    "overload_deadline_ms", config.overload_deadline_ms);
+
+                // How idle workers wait for events: latency, balanced or cpu
+                std::string wait = streaming.value("consumer_wait",
+                    common::WaitStrategyName(common::WaitStrategy::BALANCED));
+                auto strategy = common::ParseWaitStrategy(wait);
+                if (!strategy) {
+                    return common::Result<app::Configuration>::Error(
+                        "Unknown event_streaming.consumer_wait: " + wait);
+                }
+                config.consumer_wait = *strategy;
+
+                // shared: any worker takes any event, sharded: each worker
+                // has its own lane and a process's events stay in order
+                std::string pipeline = streaming.value("pipeline", "shared");
+                if (pipeline != "shared" && pipeline != "sharded") {
+                    return common::Result<app::Configuration>::Error(
+                        "Unknown event_streaming.pipeline: " + pipeline);
+                }
+                config.sharded_pipeline = pipeline == "sharded";
             }
 
             // Logging
@@ -238,6 +331,10 @@ namespace kubearmor::comm {
         
         // Service
         j["service"]["name"] = config.service_name;
+        j["service"]["worker_threads"] = config.service_worker_threads ?
+            json(config.service_worker_threads) : json("auto");
+        j["service"]["publish_threads"] = config.publish_threads;
+        j["service"]["publish_queue_size"] = config.publish_queue_size;
 
         // Driver
         std::string port_name(config.filter_port_name.begin(),
@@ -247,7 +344,21 @@ namespace kubearmor::comm {
 
         j["driver"]["filter_port_name"] = port_name;
         j["driver"]["device_path"] = device_path;
-        j["driver"]["worker_threads"] = config.worker_threads;
+        j["driver"]["worker_threads"] = config.worker_threads ?
+            json(config.worker_threads) : json("auto");
+        j["driver"]["completion_batch_size"] = config.completion_batch_size;
+        j["driver"]["early_reply"] = config.early_reply;
+        j["driver"]["event_ring"] = config.event_ring;
+        j["driver"]["receive_buffer_size"] = config.receive_buffer_size;
+        j["driver"]["buffers_per_size_class"] = config.buffers_per_size_class;
+
+        // Placement
+        j["placement"]["cpus"] = common::FormatCpuList(config.placement_cpus);
+        j["placement"]["cpu_budget"] = config.cpu_budget;
+        j["placement"]["numa_node"] = config.numa_node;
+        j["placement"]["iocp_cpus"] = common::FormatCpuList(config.iocp_cpus);
+        j["placement"]["worker_cpus"] = common::FormatCpuList(config.worker_cpus);
+        j["placement"]["pin_threads"] = config.pin_threads;
 
         // gRPC
         j["grpc"]["address"] = config.grpc_address;
@@ -255,6 +366,10 @@ namespace kubearmor::comm {
 
         // Event streaming
         j["event_streaming"]["max_queue_size"] = config.event_queue_size;
+        j["event_streaming"]["overload_policy"] = common::OverloadPolicyName(config.overload_policy);
+        j["event_streaming"]["overload_deadline_ms"] = config.overload_deadline_ms;
+        j["event_streaming"]["consumer_wait"] = common::WaitStrategyName(config.consumer_wait);
+        j["event_streaming"]["pipeline"] = config.sharded_pipeline ? "sharded" : "shared";
 
         // Logging
         j["logging"]["file"] = config.log_file;
@@ -0,0 +1,34 @@
+#include "comm/kernel_event_view.h"
+
+namespace kubearmor::comm {
+
+    common::Result<KernelEventView> KernelEventView::Create(const uint8_t* event, size_t size) {
+        if (!event) {
+            return common::Result<KernelEventView>::Error("Null kernel event");
+        }
+
+        if (size < sizeof(KernelEvent)) {
+            return common::Result<KernelEventView>::Error(
+                "Truncated kernel event: " + std::to_string(size) + " bytes");
+        }
+
+        // The strings are read in place as char16_t
+        if (reinterpret_cast<uintptr_t>(event) % alignof(char16_t) != 0) {
+            return common::Result<KernelEventView>::Error("Misaligned kernel event");
+        }
+
+        KernelEventView view(reinterpret_cast<const KernelEvent*>(event), size);
+
+        switch (DecodeKernelStrings(*view.event_, size, view.strings_)) {
+        case KernelDecodeStatus::OK:
+            break;
+        case KernelDecodeStatus::UNKNOWN_OPERATION:
+            return common::Result<KernelEventView>::Error("Unknown event type");
+        case KernelDecodeStatus::OUT_OF_BOUNDS:
+            return common::Result<KernelEventView>::Error("Kernel message string out of bounds");
+        }
+
+        return common::Result<KernelEventView>::Success(view);
+    }
+
+} // namespace kubearmor::comm
@@ -1,172 +1,150 @@
 #include "comm/message_parser.h"
-#include "common/logger.h"
+#include "common/unicode.h"
+#include "data/device_path_table.h"
+#include <cstring>
+
+#ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
 
 #pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
 
 namespace kubearmor::comm {
 
-    common::Result<data::Event> MessageParser::Parse(const KernelMessage* kernel_msg, size_t buffer_size) {
-        if (!kernel_msg) {
-            return common::Result<data::Event>::Error("Null kernel message");
-        }
-
+    common::Result<data::Event> MessageParser::Parse(const KernelEventView& view, const common::BufferRef& owner) {
         data::Event event;
-        event.event_id = 1;
-        event.timestamp = std::chrono::system_clock::time_point(
-            std::chrono::microseconds(kernel_msg->timestamp / 10));
-        event.blocked = kernel_msg->blocked;
+        event.event_id = EventIds().Next();
+        event.sequence = view.sequence();
+        event.type = static_cast<data::EventType>(view.event_type());
+        event.timestamp = KernelTimeToSystemTime(view.timestamp());
+        event.blocked = view.blocked();
 
-        LOG_DEBUG("parsing event operation data");
-
-        switch (kernel_msg->event_operation) {
+        switch (view.event_operation()) {
         case KernelEventOperation::FILE_EVENT:
             event.operation_type = data::EventOperationType::FILE_EVENT;
-            event.data = ParseFileEvent(kernel_msg, buffer_size);
+            event.data = ParseFileEvent(view, owner);
             break;
         case KernelEventOperation::PROCESS_EVENT:
             event.operation_type = data::EventOperationType::PROCESS_EVENT;
-            //event.data = ParseProcessEvent(kernel_msg, buffer_size);
+            event.data = ParseProcessEvent(view, owner);
             break;
         case KernelEventOperation::NETWORK_EVENT:
             event.operation_type = data::EventOperationType::NETWORK_EVENT;
-            //event.data = ParseNetworkEvent(kernel_msg, buffer_size);
+            event.data = ParseNetworkEvent(view);
             break;
         default:
             return common::Result<data::Event>::Error("Unknown event type");
         }
 
-        return common::Result<data::Event>::Success(event);
+        return common::Result<data::Event>::Success(std::move(event));
+    }
+
+    common::Result<EventBatchReader> MessageParser::Records(const uint8_t* message, size_t size) {
+        if (!message || size < sizeof(FILTER_MESSAGE_HEADER)) {
+            return common::Result<EventBatchReader>::Error("Truncated kernel message");
+        }
+
+        return EventBatchReader::Create(message + sizeof(FILTER_MESSAGE_HEADER),
+            size - sizeof(FILTER_MESSAGE_HEADER));
+    }
+
+    common::Result<data::Event> MessageParser::Parse(const EventRecord& record, const common::BufferRef& owner) {
+        auto view = KernelEventView::Create(record.data, record.size);
+        if (!view) {
+            return common::Result<data::Event>::Error(view.ErrorMessage());
+        }
+
+        return Parse(view.Value(), owner);
+    }
+
+    common::Result<data::Event> MessageParser::Parse(const KernelMessage* kernel_msg, size_t buffer_size) {
+        if (!kernel_msg || buffer_size < sizeof(FILTER_MESSAGE_HEADER)) {
+            return common::Result<data::Event>::Error("Truncated kernel message");
+        }
+
+        EventRecord record{ reinterpret_cast<const uint8_t*>(&kernel_msg->event),
+            buffer_size - sizeof(FILTER_MESSAGE_HEADER) };
+        return Parse(record, common::BufferRef());
     }
 
-    data::FileEventData MessageParser::ParseFileEvent(const KernelMessage* km, size_t buffer_size) {
-        const auto& file_data = km->data.file;
+    data::FileEventData MessageParser::ParseFileEvent(const KernelEventView& view, const common::BufferRef& owner) {
+        const auto& file_data = view.file();
 
         data::FileEventData fd;
 
         fd.operation = static_cast<data::FileOperation>(file_data.operation);
         fd.process_id = file_data.process_id;
+        fd.process_path = ProcessPaths().Intern(file_data.process_id, view.process_path());
+        fd.file_path = MakePath(view.file_path(), owner);
 
-        LOG_DEBUG("parsing file event wstring data");
-
-        if (file_data.process_path_length > 0) {
-            const wchar_t* process_path = km->get_string_at_offset(
-                file_data.process_path_offset,
-                buffer_size
-            );
-            
-            if (process_path){
-                size_t char_count = file_data.process_path_length / sizeof(wchar_t);
-                std::string path_str = WStringToString(process_path, char_count);
-                fd.process_path = path_str;
-                LOG_DEBUG("Process path: " + path_str);
-            }
-        }
-        LOG_DEBUG("parsed event operation process path data");
-        
-        if (file_data.file_path_length > 0) {
-            
-            const wchar_t* file_path = km->get_string_at_offset(
-                file_data.file_path_offset,
-                buffer_size
-            );
-
-            if (file_path) {
-                size_t char_count = file_data.file_path_length / sizeof(wchar_t);
-                std::string path_str = WStringToString(file_path, char_count);
-                fd.file_path = path_str;
-                LOG_DEBUG("file path: " + path_str);
-            }
-        }
-        LOG_DEBUG("returned event operation data");
         return fd;
     }
 
-    data::ProcessEventData MessageParser::ParseProcessEvent(const KernelMessage* km, size_t buffer_size) {
-        LOG_DEBUG("parsing process event operation data");
-        const auto& process_data = km->data.process;
+    data::ProcessEventData MessageParser::ParseProcessEvent(const KernelEventView& view, const common::BufferRef& owner) {
+        const auto& process_data = view.process();
 
         data::ProcessEventData pd;
 
         pd.operation = static_cast<data::ProcessOperation>(process_data.operation);
         pd.process_id = process_data.process_id;
+        pd.parent_process_id = process_data.parent_process_id;
+        pd.process_path = ProcessPaths().Intern(process_data.process_id, view.process_path());
+        pd.command_line = MakeString(view.command_line(), owner);
+        pd.parent_process_path = ProcessPaths().Intern(process_data.parent_process_id,
+            view.parent_process_path());
 
-        // TODO 
-        // parse process data
-
-        LOG_DEBUG("returned process event operation data");
         return pd;
     }
 
-    data::NetworkEventData MessageParser::ParseNetworkEvent(const KernelMessage* km, size_t buffer_size) {
-        LOG_DEBUG("parsing network operation data");
-        const auto& network_data = km->data.network;
+    data::NetworkEventData MessageParser::ParseNetworkEvent(const KernelEventView& view) {
+        const auto& network_data = view.network();
 
         data::NetworkEventData nd;
         nd.operation = static_cast<data::NetworkOperation>(network_data.operation);
         nd.protocol = network_data.protocol;
         nd.local_port = ntohs(network_data.local_port);
         nd.remote_port = ntohs(network_data.remote_port);
-        nd.local_address = FormatIPAddress(network_data.local_address, network_data.address_family);
-        nd.remote_address = FormatIPAddress(network_data.remote_address, network_data.address_family);
+        data::AddressFamily family = ToAddressFamily(network_data.address_family);
+        nd.local_address = data::IpAddress::FromBytes(network_data.local_address, family);
+        nd.remote_address = data::IpAddress::FromBytes(network_data.remote_address, family);
         nd.data_length = network_data.data_length;
-        LOG_DEBUG("returned network event operation data");
         return nd;
     }
 
-    std::string MessageParser::WStringToString(const wchar_t* wstr, size_t length) {
-        if (!wstr || length == 0) {
-            return std::string();
-        }
-
-        int size_needed = WideCharToMultiByte(
-            CP_UTF8,
-            0,
-            wstr,
-            static_cast<int>(length),
-            nullptr,
-            0,
-            nullptr,
-            nullptr
-        );
-
-        if (size_needed <= 0) {
-            return std::string();
-        }
-
-        std::string result(size_needed, 0);
-        WideCharToMultiByte(
-            CP_UTF8,
-            0,
-            wstr,
-            static_cast<int>(length),
-            &result[0],
-            size_needed,
-            nullptr,
-            nullptr
-        );
-
-        return result;
+    common::EventIdGenerator& MessageParser::EventIds() {
+        static common::EventIdGenerator* generator = new common::EventIdGenerator();
+        return *generator;
     }
 
+    data::PathCache& MessageParser::ProcessPaths() {
+        thread_local data::PathCache cache(data::PathTable::GetInstance());
+        return cache;
+    }
 
-
-    std::string MessageParser::FormatIPAddress(const uint8_t* addr, uint8_t family) {
-        char buffer[INET6_ADDRSTRLEN] = { 0 };
-
-        if (family == AF_INET) {
-            struct in_addr addr4;
-            memcpy(&addr4, addr, sizeof(addr4));
-            inet_ntop(AF_INET, &addr4, buffer, sizeof(buffer));
+    data::LazyString MessageParser::MakeString(std::u16string_view value, const common::BufferRef& owner) {
+        if (owner) {
+            return data::LazyString::FromUtf16(value.data(), value.size(), owner);
         }
-        else if (family == AF_INET6) {
-            struct in6_addr addr6;
-            memcpy(&addr6, addr, sizeof(addr6));
-            inet_ntop(AF_INET6, &addr6, buffer, sizeof(buffer));
+        return data::LazyString(common::Utf16ToUtf8(value.data(), value.size()));
+    }
+
+    data::LazyString MessageParser::MakePath(std::u16string_view value, const common::BufferRef& owner) {
+        if (owner) {
+            return data::LazyString::FromUtf16Path(value.data(), value.size(), owner);
         }
+        return data::LazyString(data::DevicePathTable::GetInstance().ToUtf8(value));
+    }
 
-        return std::string(buffer);
+    data::AddressFamily MessageParser::ToAddressFamily(uint8_t family) {
+        switch (static_cast<KernelAddressFamily>(family)) {
+        case KernelAddressFamily::INET: return data::AddressFamily::IPV4;
+        case KernelAddressFamily::INET6: return data::AddressFamily::IPV6;
+        }
+        return data::AddressFamily::NONE;
     }
 
 } // namespace kubearmor::comm
\ No newline at end of file
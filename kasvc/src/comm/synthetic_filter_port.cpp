@@ -0,0 +1,559 @@
+#include "comm/synthetic_filter_port.h"
+#include "comm/event_batch.h"
+#include "comm/kernel_message.h"
+#include "common/constants.h"
+#include "common/logger.h"
+#include <cstring>
+
+namespace kubearmor::comm {
+
+    namespace {
+
+        // Win32 error codes the real port reports for these conditions
+        constexpr uint32_t ERROR_OPERATION_ABORTED_CODE = 995;
+        constexpr uint32_t ERROR_INSUFFICIENT_BUFFER_CODE = 122;
+
+        std::u16string ToUtf16(const std::string& ascii) {
+            return std::u16string(ascii.begin(), ascii.end());
+        }
+
+        const char* const IMAGE_NAMES[] = {
+            "svchost.exe", "explorer.exe", "msedge.exe", "powershell.exe",
+            "cmd.exe", "MsMpEng.exe", "SearchIndexer.exe", "RuntimeBroker.exe"
+        };
+
+        const char* const FILE_DIRECTORIES[] = {
+            "\\Windows\\System32\\",
+            "\\Windows\\SysWOW64\\",
+            "\\Program Files\\Common Files\\microsoft shared\\",
+            "\\Users\\kubearmor\\AppData\\Local\\Temp\\",
+            "\\ProgramData\\Microsoft\\Windows Defender\\Scans\\History\\Service\\"
+        };
+
+        const char* const FILE_EXTENSIONS[] = {
+            ".dll", ".tmp", ".log", ".dat", ".mui", ".json"
+        };
+
+        // Non-ASCII path components, including a surrogate pair
+        const char16_t* const UNICODE_COMPONENTS[] = {
+            u"\\Users\\kubearmor\\Документы\\",
+            u"\\Users\\kubearmor\\文档\\",
+            u"\\Users\\kubearmor\\Desktop\\\U0001F4C1 notes\\"
+        };
+
+        template<typename T, size_t N>
+        constexpr size_t CountOf(const T(&)[N]) { return N; }
+
+    } // namespace
+
+    uint64_t SyntheticFilterPort::Rng::Next() {
+        // xorshift64*
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+
+    SyntheticFilterPort::SyntheticFilterPort(const SyntheticConfig& config)
+        : config_(config)
+        , connected_(false)
+        , stopping_(false)
+        , send_times_(new std::atomic<int64_t>[SEND_TIME_SLOTS]) {
+        if (config_.producer_threads == 0) config_.producer_threads = 1;
+        if (config_.process_count == 0) config_.process_count = 1;
+        if (config_.file_count == 0) config_.file_count = 1;
+        if (config_.file_weight + config_.process_weight + config_.network_weight == 0) {
+            config_.file_weight = 1;
+        }
+        for (size_t i = 0; i < SEND_TIME_SLOTS; ++i) {
+            send_times_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    SyntheticFilterPort::~SyntheticFilterPort() {
+        Disconnect();
+    }
+
+    common::Result<void> SyntheticFilterPort::Connect(size_t /*concurrency*/) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (connected_) {
+                return common::Result<void>::Success();
+            }
+            connected_ = true;
+        }
+
+        LOG_INFO("Connecting to synthetic filter port (" +
+            std::to_string(config_.producer_threads) + " producers, " +
+            (config_.events_per_second ?
+                std::to_string(config_.events_per_second) + " events/s)" :
+                std::string("unthrottled)")));
+
+        BuildCorpus();
+
+        last_sequence_ = 0;
+        stopping_ = false;
+        for (size_t i = 0; i < config_.producer_threads; ++i) {
+            producers_.emplace_back([this, i] { ProducerThread(i); });
+        }
+
+        return common::Result<void>::Success();
+    }
+
+    void SyntheticFilterPort::Disconnect() {
+        stopping_ = true;
+        receive_posted_.notify_all();
+
+        for (auto& producer : producers_) {
+            if (producer.joinable()) {
+                producer.join();
+            }
+        }
+        producers_.clear();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected_ = false;
+        pending_receives_.clear();
+        completions_.clear();
+        completion_ready_.notify_all();
+    }
+
+    bool SyntheticFilterPort::IsConnected() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connected_;
+    }
+
+    common::Result<void> SyntheticFilterPort::Attach(ReceiveRequest* request) {
+        request->port_context = nullptr;
+        return common::Result<void>::Success();
+    }
+
+    void SyntheticFilterPort::Detach(ReceiveRequest* request) {
+        request->port_context = nullptr;
+    }
+
+    bool SyntheticFilterPort::SubmitReceive(ReceiveRequest* request) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!connected_ || stopping_.load()) {
+                return false;
+            }
+            pending_receives_.push_back(request);
+        }
+        receive_posted_.notify_one();
+        return true;
+    }
+
+    CompletionStatus SyntheticFilterPort::GetCompletion(
+        Completion& completion, std::chrono::milliseconds timeout) {
+
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (!completion_ready_.wait_for(lock, timeout, [this] {
+            return !completions_.empty() || !connected_;
+            })) {
+            return CompletionStatus::TIMEOUT;
+        }
+
+        if (completions_.empty()) {
+            return CompletionStatus::CLOSED;
+        }
+
+        completion = completions_.front();
+        completions_.pop_front();
+
+        return completion.request ? CompletionStatus::COMPLETED : CompletionStatus::WAKEUP;
+    }
+
+    CompletionStatus SyntheticFilterPort::GetCompletions(Completion* completions,
+        size_t max_count, size_t& count, std::chrono::milliseconds timeout) {
+
+        count = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (!completion_ready_.wait_for(lock, timeout, [this] {
+            return !completions_.empty() || !connected_;
+            })) {
+            return CompletionStatus::TIMEOUT;
+        }
+
+        if (completions_.empty()) {
+            return CompletionStatus::CLOSED;
+        }
+
+        if (!completions_.front().request) {
+            completions_.pop_front();
+            return CompletionStatus::WAKEUP;
+        }
+
+        // Drain what is queued, leaving a wakeup for the next waiter
+        while (count < max_count && !completions_.empty() && completions_.front().request) {
+            completions[count++] = completions_.front();
+            completions_.pop_front();
+        }
+
+        return CompletionStatus::COMPLETED;
+    }
+
+    void SyntheticFilterPort::CancelReceives() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (ReceiveRequest* request : pending_receives_) {
+            completions_.push_back(Completion{ request, 0, ERROR_OPERATION_ABORTED_CODE });
+        }
+        pending_receives_.clear();
+        completion_ready_.notify_all();
+    }
+
+    void SyntheticFilterPort::Wake() {
+        Complete(Completion{});
+    }
+
+    bool SyntheticFilterPort::SendReply(uint64_t message_id, int32_t status) {
+        (void)status;
+
+        int64_t sent = send_times_[message_id & SEND_TIME_MASK].load(std::memory_order_relaxed);
+        if (sent != 0) {
+            int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+            int64_t waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::duration(now - sent)).count();
+            reply_latency_.Record(waited > 0 ? static_cast<uint64_t>(waited) : 0);
+        }
+
+        replies_received_++;
+        return true;
+    }
+
+    SyntheticFilterPort::Statistics SyntheticFilterPort::GetStatistics() const {
+        return Statistics{
+            events_sent_.load(),
+            replies_received_.load(),
+            receive_stalls_.load(),
+            oversized_events_.load(),
+            batches_sent_.load()
+        };
+    }
+
+    bool SyntheticFilterPort::Finished() const {
+        return config_.total_events > 0 && events_sent_.load() >= config_.total_events;
+    }
+
+    void SyntheticFilterPort::BuildCorpus() {
+        Rng rng{ config_.seed | 1 };
+
+        process_paths_.clear();
+        file_paths_.clear();
+        command_lines_.clear();
+
+        for (size_t i = 0; i < config_.process_count; ++i) {
+            std::string image = IMAGE_NAMES[i % CountOf(IMAGE_NAMES)];
+            std::string dir = i < CountOf(IMAGE_NAMES) ?
+                "\\Device\\HarddiskVolume3\\Windows\\System32\\" :
+                "\\Device\\HarddiskVolume3\\Program Files\\Vendor" + std::to_string(i) + "\\";
+            process_paths_.push_back(ToUtf16(dir + image));
+            command_lines_.push_back(ToUtf16(
+                "\"" + dir.substr(std::strlen("\\Device\\HarddiskVolume3")) + image +
+                "\" -k netsvcs -p -s Schedule --instance " + std::to_string(i)));
+        }
+
+        for (size_t i = 0; i < config_.file_count; ++i) {
+            std::u16string path;
+            if (rng.Below(100) < config_.unicode_percent) {
+                path = UNICODE_COMPONENTS[rng.Below(static_cast<uint32_t>(CountOf(UNICODE_COMPONENTS)))];
+            }
+            else {
+                path = ToUtf16(FILE_DIRECTORIES[rng.Below(static_cast<uint32_t>(CountOf(FILE_DIRECTORIES)))]);
+            }
+            if (rng.Below(100) < config_.long_path_percent) {
+                // deep trees (node_modules, build outputs) well past MAX_PATH
+                size_t target = 4096 + rng.Below(26 * 1024);
+                while (path.size() < target) {
+                    path += ToUtf16("nested_directory_" + std::to_string(path.size() % 97) + "\\");
+                }
+            }
+            path += ToUtf16("file_" + std::to_string(i) +
+                FILE_EXTENSIONS[rng.Below(static_cast<uint32_t>(CountOf(FILE_EXTENSIONS)))]);
+            file_paths_.push_back(std::move(path));
+        }
+    }
+
+    ReceiveRequest* SyntheticFilterPort::TakeReceive() {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (pending_receives_.empty()) {
+            receive_stalls_++;
+            receive_posted_.wait(lock, [this] {
+                return !pending_receives_.empty() || stopping_.load();
+                });
+        }
+
+        if (stopping_.load() || pending_receives_.empty()) {
+            return nullptr;
+        }
+
+        ReceiveRequest* request = pending_receives_.front();
+        pending_receives_.pop_front();
+        return request;
+    }
+
+    void SyntheticFilterPort::Complete(const Completion& completion) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            completions_.push_back(completion);
+        }
+        completion_ready_.notify_one();
+    }
+
+    void SyntheticFilterPort::ProducerThread(size_t index) {
+        Rng rng{ (config_.seed + 0x9E3779B97F4A7C15ULL * (index + 1)) | 1 };
+
+        // Open-loop pacing: the schedule does not slow down when the service
+        // falls behind, so queueing delay shows up in the measured latency
+        std::chrono::nanoseconds interval(0);
+        if (config_.events_per_second > 0) {
+            interval = std::chrono::nanoseconds(
+                1000000000ULL * config_.producer_threads / config_.events_per_second);
+        }
+        auto next_send = std::chrono::steady_clock::now();
+
+        // The producer's frame stands in for a per-CPU staging area; it goes
+        // out when full, at batch_size events or batch_flush_us after its
+        // first event, whichever comes first
+        const bool batching = config_.batch_size > 1;
+        std::vector<uint8_t> event(batching ? constants::MAX_FILTER_EVENT_SIZE : 0);
+        std::vector<uint8_t> frame(batching ? constants::MAX_FILTER_EVENT_SIZE : 0);
+        EventBatchWriter batch(frame.data(), frame.size());
+        uint64_t batch_id = 0;
+        auto batch_deadline = std::chrono::steady_clock::time_point::max();
+
+        auto flush = [&]() {
+            if (batch.empty()) {
+                return true;
+            }
+            size_t size = batch.Finish();
+            uint16_t count = batch.count();
+            batch.Reset();
+            batch_deadline = std::chrono::steady_clock::time_point::max();
+            batches_sent_++;
+            // frames are sent without a reply buffer, nothing waits on them
+            return SendMessage(batch_id, false, frame.data(), size, count);
+        };
+
+        while (!stopping_.load()) {
+            if (std::chrono::steady_clock::now() >= batch_deadline && !flush()) {
+                break;
+            }
+
+            uint64_t message_id = next_message_id_.fetch_add(1);
+            if (config_.total_events > 0 && message_id > config_.total_events) {
+                break;
+            }
+
+            if (interval.count() > 0) {
+                next_send += interval;
+                if (batch_deadline < next_send) {
+                    std::this_thread::sleep_until(batch_deadline);
+                    if (!flush()) {
+                        break;
+                    }
+                }
+                if (next_send > std::chrono::steady_clock::now()) {
+                    std::this_thread::sleep_until(next_send);
+                }
+            }
+
+            if (!batching) {
+                ReceiveRequest* request = TakeReceive();
+                if (!request) {
+                    break;
+                }
+
+                size_t bytes = 0;
+                if (request->buffer_size > sizeof(FILTER_MESSAGE_HEADER)) {
+                    bytes = EncodeEvent(rng, request->message_buffer + sizeof(FILTER_MESSAGE_HEADER),
+                        request->buffer_size - sizeof(FILTER_MESSAGE_HEADER));
+                }
+
+                send_times_[message_id & SEND_TIME_MASK].store(
+                    std::chrono::steady_clock::now().time_since_epoch().count(),
+                    std::memory_order_relaxed);
+
+                if (bytes == 0) {
+                    oversized_events_++;
+                    Complete(Completion{ request, 0, ERROR_INSUFFICIENT_BUFFER_CODE });
+                }
+                else {
+                    auto* msg = reinterpret_cast<KernelMessage*>(request->message_buffer);
+                    msg->header.ReplyLength = 1; // sizeof(EVENT_REPLY)
+                    msg->header.MessageId = message_id;
+                    Complete(Completion{ request, sizeof(FILTER_MESSAGE_HEADER) + bytes, 0 });
+                }
+                events_sent_++;
+                continue;
+            }
+
+            size_t bytes = EncodeEvent(rng, event.data(), event.size());
+            bool verdict_required = bytes > 0 &&
+                reinterpret_cast<const KernelEvent*>(event.data())->verdict_required();
+
+            // Events the kernel waits on, and ones no frame can hold, go out
+            // on their own as before
+            if (verdict_required || bytes == 0 ||
+                sizeof(KernelBatchHeader) + EventBatchWriter::RecordSize(bytes) > frame.size()) {
+                if (!SendMessage(message_id, true, event.data(), bytes, 1)) {
+                    break;
+                }
+                continue;
+            }
+
+            if (!batch.Fits(bytes) && !flush()) {
+                break;
+            }
+            if (batch.empty()) {
+                batch_id = message_id;
+                batch_deadline = std::chrono::steady_clock::now() +
+                    std::chrono::microseconds(config_.batch_flush_us);
+            }
+            batch.Append(event.data(), bytes);
+
+            if (batch.count() >= config_.batch_size && !flush()) {
+                break;
+            }
+        }
+
+        flush();
+    }
+
+    bool SyntheticFilterPort::SendMessage(uint64_t message_id, bool reply_expected,
+        const uint8_t* payload, size_t payload_size, uint64_t events) {
+
+        ReceiveRequest* request = TakeReceive();
+        if (!request) {
+            return false;
+        }
+
+        size_t bytes = sizeof(FILTER_MESSAGE_HEADER) + payload_size;
+
+        if (reply_expected) {
+            send_times_[message_id & SEND_TIME_MASK].store(
+                std::chrono::steady_clock::now().time_since_epoch().count(),
+                std::memory_order_relaxed);
+        }
+
+        if (payload_size == 0 || bytes > request->buffer_size) {
+            oversized_events_ += events;
+            Complete(Completion{ request, 0, ERROR_INSUFFICIENT_BUFFER_CODE });
+        }
+        else {
+            FILTER_MESSAGE_HEADER header{};
+            header.ReplyLength = reply_expected ? 1 : 0; // sizeof(EVENT_REPLY)
+            header.MessageId = message_id;
+            std::memcpy(request->message_buffer, &header, sizeof(header));
+            std::memcpy(request->message_buffer + sizeof(header), payload, payload_size);
+            Complete(Completion{ request, bytes, 0 });
+        }
+
+        events_sent_ += events;
+        return true;
+    }
+
+    uint64_t SyntheticFilterPort::KernelTimeNow() {
+        auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+        auto ticks = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count() / 100;
+        return UNIX_EPOCH_IN_KERNEL_TICKS + static_cast<uint64_t>(ticks);
+    }
+
+    size_t SyntheticFilterPort::EncodeEvent(Rng& rng, uint8_t* buffer, size_t capacity) {
+
+        uint64_t sequence = last_sequence_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (capacity < sizeof(KernelEvent)) {
+            return 0;
+        }
+
+        std::memset(buffer, 0, sizeof(KernelEvent));
+        auto* event = reinterpret_cast<KernelEvent*>(buffer);
+
+        // Strings follow the EVENT record, offsets are relative to the EVENT,
+        // exactly as Filter.cpp lays them out
+        size_t used = sizeof(KernelEvent);
+        bool fits = true;
+        auto append = [&](const std::u16string& str, uint32_t& offset, uint32_t& length) {
+            size_t bytes = str.size() * sizeof(char16_t);
+            if (used + bytes > capacity) {
+                fits = false;
+                return;
+            }
+            std::memcpy(buffer + used, str.data(), bytes);
+            offset = static_cast<uint32_t>(used);
+            length = static_cast<uint32_t>(bytes);
+            used += bytes;
+        };
+
+        event->timestamp = KernelTimeNow();
+        event->sequence = sequence;
+        event->event_type = rng.Below(100) < config_.alert_percent ?
+            KernelEventType::MATCH_HOST_POLICY : KernelEventType::HOST_LOG;
+        event->blocked = false;
+        // policy matches stand in for events the kernel waits on a verdict for
+        event->flags = static_cast<uint8_t>(event->event_type == KernelEventType::MATCH_HOST_POLICY ?
+            KernelEventFlags::VERDICT_REQUIRED : KernelEventFlags::NONE);
+
+        uint32_t process_index = rng.Below(static_cast<uint32_t>(process_paths_.size()));
+        uint32_t pid = 1000 + process_index * 4;
+
+        uint32_t total_weight = config_.file_weight + config_.process_weight + config_.network_weight;
+        uint32_t pick = rng.Below(total_weight);
+
+        if (pick < config_.file_weight) {
+            event->event_operation = KernelEventOperation::FILE_EVENT;
+            auto& file = event->data.file;
+            file.operation = 0; // PreOperationCreate only reports creates
+            file.process_id = pid;
+            append(process_paths_[process_index], file.process_path_offset, file.process_path_length);
+            append(file_paths_[rng.Below(static_cast<uint32_t>(file_paths_.size()))],
+                file.file_path_offset, file.file_path_length);
+        }
+        else if (pick < config_.file_weight + config_.process_weight) {
+            event->event_operation = KernelEventOperation::PROCESS_EVENT;
+            auto& process = event->data.process;
+            uint32_t parent_index = rng.Below(static_cast<uint32_t>(process_paths_.size()));
+            process.operation = rng.Below(2); // P_CREATE / P_TERMINATE
+            process.process_id = pid;
+            process.parent_process_id = 1000 + parent_index * 4;
+            append(process_paths_[process_index], process.process_path_offset, process.process_path_length);
+            append(command_lines_[process_index], process.command_line_offset, process.command_line_length);
+            append(process_paths_[parent_index],
+                process.parent_process_path_offset, process.parent_process_path_length);
+        }
+        else {
+            event->event_operation = KernelEventOperation::NETWORK_EVENT;
+            auto& network = event->data.network;
+            bool v6 = rng.Below(4) == 0;
+            network.operation = rng.Below(6);
+            network.protocol = rng.Below(2) ? 6 : 17; // TCP / UDP
+            // ports travel in network byte order
+            uint16_t local_port = static_cast<uint16_t>(49152 + rng.Below(16384));
+            uint16_t remote_port = rng.Below(2) ? 443 : 53;
+            network.local_port = static_cast<uint16_t>((local_port >> 8) | (local_port << 8));
+            network.remote_port = static_cast<uint16_t>((remote_port >> 8) | (remote_port << 8));
+            network.address_family = static_cast<uint8_t>(
+                v6 ? KernelAddressFamily::INET6 : KernelAddressFamily::INET);
+            uint64_t local = rng.Next();
+            uint64_t remote = rng.Next();
+            if (v6) {
+                std::memcpy(network.local_address, &local, sizeof(local));
+                std::memcpy(network.local_address + 8, &remote, sizeof(remote));
+                std::memcpy(network.remote_address, &remote, sizeof(remote));
+                std::memcpy(network.remote_address + 8, &local, sizeof(local));
+            }
+            else {
+                network.local_address[0] = 10;
+                std::memcpy(network.local_address + 1, &local, 3);
+                std::memcpy(network.remote_address, &remote, 4);
+            }
+            network.data_length = rng.Below(1500);
+        }
+
+        return fits ? used : 0;
+    }
+
+} // namespace kubearmor::comm
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "comm/win_event_ring_section.h"
+#include "common/logger.h"
+
+namespace kubearmor::comm {
+
+    WinEventRingSection::WinEventRingSection(const std::wstring& device_path)
+        : device_path_(device_path)
+        , device_(INVALID_HANDLE_VALUE)
+        , doorbell_(nullptr)
+        , base_(nullptr)
+        , size_(0) {
+    }
+
+    WinEventRingSection::~WinEventRingSection() {
+        Unmap();
+    }
+
+    common::Result<void> WinEventRingSection::Map() {
+        if (base_) {
+            return common::Result<void>::Success();
+        }
+
+        device_ = CreateFileW(device_path_.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            0,
+            nullptr,
+            OPEN_EXISTING,
+            0,
+            nullptr);
+
+        if (device_ == INVALID_HANDLE_VALUE) {
+            DWORD error = GetLastError();
+            return common::Result<void>::Error(
+                "Failed to open driver device: " + std::to_string(error));
+        }
+
+        // auto-reset, one wakeup per doorbell
+        doorbell_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (!doorbell_) {
+            DWORD error = GetLastError();
+            Unmap();
+            return common::Result<void>::Error(
+                "Failed to create ring doorbell: " + std::to_string(error));
+        }
+
+        EventRingMapRequest request{ reinterpret_cast<uint64_t>(doorbell_) };
+        EventRingMapResponse response{};
+        DWORD returned = 0;
+
+        if (!DeviceIoControl(device_, IOCTL_MAP_EVENT_RING,
+            &request, sizeof(request), &response, sizeof(response), &returned, nullptr) ||
+            returned < sizeof(response) || response.base == 0) {
+            DWORD error = GetLastError();
+            Unmap();
+            return common::Result<void>::Error(
+                "Driver did not map its event ring: " + std::to_string(error));
+        }
+
+        base_ = reinterpret_cast<void*>(response.base);
+        size_ = static_cast<size_t>(response.size);
+
+        LOG_INFO("Mapped driver event ring: " + std::to_string(size_) + " bytes");
+        return common::Result<void>::Success();
+    }
+
+    void WinEventRingSection::Unmap() {
+        // The driver unmaps the view when the handle it was mapped through
+        // is cleaned up
+        if (device_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(device_);
+            device_ = INVALID_HANDLE_VALUE;
+        }
+
+        if (doorbell_) {
+            CloseHandle(doorbell_);
+            doorbell_ = nullptr;
+        }
+
+        base_ = nullptr;
+        size_ = 0;
+    }
+
+    bool WinEventRingSection::WaitDoorbell(std::chrono::milliseconds timeout) {
+        if (!doorbell_) {
+            return false;
+        }
+        return WaitForSingleObject(doorbell_, static_cast<DWORD>(timeout.count())) == WAIT_OBJECT_0;
+    }
+
+    void WinEventRingSection::Wake() {
+        if (doorbell_) {
+            SetEvent(doorbell_);
+        }
+    }
+
+} // namespace kubearmor::comm
@@ -0,0 +1,278 @@
+#include "comm/win_filter_port.h"
+#include "common/constants.h"
+#include "common/logger.h"
+#include <algorithm>
+
+namespace kubearmor::comm {
+
+    WinFilterPort::WinFilterPort(const std::wstring& port_name)
+        : port_name_(port_name)
+        , filter_port_(INVALID_HANDLE_VALUE)
+        , iocp_handle_(nullptr) {
+    }
+
+    WinFilterPort::~WinFilterPort() {
+        Disconnect();
+    }
+
+    common::Result<void> WinFilterPort::Connect(size_t concurrency) {
+        if (IsConnected()) {
+            return common::Result<void>::Success();
+        }
+
+        LOG_INFO("Connecting to filter port with IOCP: " +
+            std::string(port_name_.begin(), port_name_.end()));
+
+        // Connect to filter port
+        HRESULT hr = FilterConnectCommunicationPort(
+            port_name_.c_str(),
+            0,
+            nullptr,
+            0,
+            nullptr,
+            &filter_port_
+        );
+
+        if (FAILED(hr)) {
+            LOG_ERR("FilterConnectCommunicationPort failed: 0x" +
+                std::to_string(hr));
+            return common::Result<void>::Error(
+                "Failed to connect to filter port: 0x" + std::to_string(hr));
+        }
+
+        // Create IOCP
+        iocp_handle_ = CreateIoCompletionPort(
+            filter_port_,
+            nullptr,
+            0,
+            static_cast<DWORD>(concurrency)
+        );
+
+        if (!iocp_handle_) {
+            DWORD error = GetLastError();
+            CloseHandle(filter_port_);
+            filter_port_ = INVALID_HANDLE_VALUE;
+
+            LOG_ERR("CreateIoCompletionPort failed: " + std::to_string(error));
+            return common::Result<void>::Error(
+                "Failed to create IOCP: " + std::to_string(error));
+        }
+
+        return common::Result<void>::Success();
+    }
+
+    void WinFilterPort::Disconnect() {
+        // Close iocp handle
+        if (iocp_handle_) {
+            LOG_DEBUG("Now closing IOCP handle...");
+            CloseHandle(iocp_handle_);
+            iocp_handle_ = nullptr;
+            LOG_DEBUG("iocp_handle closed");
+        }
+
+        // Close filter port
+        if (filter_port_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(filter_port_);
+            filter_port_ = INVALID_HANDLE_VALUE;
+            LOG_DEBUG("filter_port closed");
+        }
+    }
+
+    bool WinFilterPort::IsConnected() const {
+        return filter_port_ != INVALID_HANDLE_VALUE &&
+            iocp_handle_ != nullptr;
+    }
+
+    common::Result<void> WinFilterPort::Attach(ReceiveRequest* request) {
+        auto* pending = new (std::nothrow) PendingIo{};
+        if (!pending) {
+            return common::Result<void>::Error("Memory allocation failed");
+        }
+
+        pending->request = request;
+        request->port_context = pending;
+        return common::Result<void>::Success();
+    }
+
+    void WinFilterPort::Detach(ReceiveRequest* request) {
+        delete static_cast<PendingIo*>(request->port_context);
+        request->port_context = nullptr;
+    }
+
+    bool WinFilterPort::SubmitReceive(ReceiveRequest* request) {
+        if (!IsConnected()) {
+            return false;
+        }
+
+        auto* pending = static_cast<PendingIo*>(request->port_context);
+        ZeroMemory(&pending->overlapped, sizeof(OVERLAPPED));
+
+        HRESULT hr = FilterGetMessage(
+            filter_port_,
+            reinterpret_cast<PFILTER_MESSAGE_HEADER>(request->message_buffer),
+            static_cast<DWORD>(request->buffer_size),
+            &pending->overlapped
+        );
+
+        if (hr == HRESULT_FROM_WIN32(ERROR_IO_PENDING)) {
+            // Operation pending - this is expected
+            return true;
+        }
+        else if (SUCCEEDED(hr)) {
+            // Completed synchronously - post manually
+            PostQueuedCompletionStatus(
+                iocp_handle_,
+                0,
+                reinterpret_cast<ULONG_PTR>(request),
+                &pending->overlapped
+            );
+            return true;
+        }
+        else {
+            LOG_ERR("FilterGetMessage failed: 0x" + std::to_string(hr));
+            return false;
+        }
+    }
+
+    CompletionStatus WinFilterPort::GetCompletion(
+        Completion& completion, std::chrono::milliseconds timeout) {
+
+        DWORD bytes_transferred = 0;
+        ULONG_PTR completion_key = 0;
+        LPOVERLAPPED overlapped = nullptr;
+
+        BOOL result = GetQueuedCompletionStatus(
+            iocp_handle_,
+            &bytes_transferred,
+            &completion_key,
+            &overlapped,
+            static_cast<DWORD>(timeout.count())
+        );
+
+        if (!result) {
+            DWORD error = GetLastError();
+
+            if (error == WAIT_TIMEOUT) {
+                return CompletionStatus::TIMEOUT;
+            }
+
+            if (error == ERROR_ABANDONED_WAIT_0 || error == ERROR_INVALID_HANDLE) {
+                return CompletionStatus::CLOSED;
+            }
+
+            if (!overlapped) {
+                return CompletionStatus::TIMEOUT;
+            }
+
+            // Failed receive, hand the request back so it can be resubmitted
+            completion.request = CONTAINING_RECORD(overlapped, PendingIo, overlapped)->request;
+            completion.bytes_transferred = 0;
+            completion.error = error;
+            return CompletionStatus::COMPLETED;
+        }
+
+        if (!overlapped) {
+            return CompletionStatus::WAKEUP;
+        }
+
+        completion.request = CONTAINING_RECORD(overlapped, PendingIo, overlapped)->request;
+        completion.bytes_transferred = bytes_transferred;
+        completion.error = 0;
+        return CompletionStatus::COMPLETED;
+    }
+
+    CompletionStatus WinFilterPort::GetCompletions(Completion* completions,
+        size_t max_count, size_t& count, std::chrono::milliseconds timeout) {
+
+        count = 0;
+        OVERLAPPED_ENTRY entries[constants::MAX_COMPLETION_BATCH];
+        ULONG removed = 0;
+
+        BOOL result = GetQueuedCompletionStatusEx(
+            iocp_handle_,
+            entries,
+            static_cast<ULONG>(std::min(max_count, constants::MAX_COMPLETION_BATCH)),
+            &removed,
+            static_cast<DWORD>(timeout.count()),
+            FALSE
+        );
+
+        if (!result) {
+            DWORD error = GetLastError();
+
+            if (error == ERROR_ABANDONED_WAIT_0 || error == ERROR_INVALID_HANDLE) {
+                return CompletionStatus::CLOSED;
+            }
+            return CompletionStatus::TIMEOUT;
+        }
+
+        size_t wakeups = 0;
+        for (ULONG i = 0; i < removed; ++i) {
+            LPOVERLAPPED overlapped = entries[i].lpOverlapped;
+            if (!overlapped) {
+                wakeups++;
+                continue;
+            }
+
+            Completion& completion = completions[count++];
+            completion.request = CONTAINING_RECORD(overlapped, PendingIo, overlapped)->request;
+            completion.bytes_transferred = entries[i].dwNumberOfBytesTransferred;
+            completion.error = 0;
+
+            // Internal holds the NTSTATUS, only failed receives pay for the
+            // translation to a Win32 error
+            if (overlapped->Internal != 0) {
+                DWORD bytes = 0;
+                if (!GetOverlappedResult(filter_port_, overlapped, &bytes, FALSE)) {
+                    completion.bytes_transferred = 0;
+                    completion.error = GetLastError();
+                }
+            }
+        }
+
+        if (count == 0) {
+            // Only wakeups: consume one, pass the rest on to other waiters
+            for (size_t i = 1; i < wakeups; ++i) {
+                Wake();
+            }
+            return CompletionStatus::WAKEUP;
+        }
+
+        for (size_t i = 0; i < wakeups; ++i) {
+            Wake();
+        }
+        return CompletionStatus::COMPLETED;
+    }
+
+    void WinFilterPort::CancelReceives() {
+        if (filter_port_ != INVALID_HANDLE_VALUE) {
+            CancelIoEx(filter_port_, nullptr);
+        }
+    }
+
+    void WinFilterPort::Wake() {
+        if (iocp_handle_) {
+            PostQueuedCompletionStatus(iocp_handle_, 0, 0, nullptr);
+        }
+    }
+
+    bool WinFilterPort::SendReply(uint64_t message_id, int32_t status) {
+        struct FilterReply {
+            FILTER_REPLY_HEADER header;
+            HRESULT result;
+        } reply = {};
+
+        reply.header.Status = status;
+        reply.header.MessageId = message_id;
+        reply.result = status;
+
+        HRESULT hr = FilterReplyMessage(
+            filter_port_,
+            &reply.header,
+            sizeof(reply)
+        );
+
+        return SUCCEEDED(hr);
+    }
+
+} // namespace kubearmor::comm
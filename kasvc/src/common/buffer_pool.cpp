@@ -0,0 +1,212 @@
+#include "common/buffer_pool.h"
+#include "common/constants.h"
+#include "common/cpu_topology.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace kubearmor::common {
+
+    namespace {
+
+        constexpr size_t CACHE_LINE = 64;
+
+        constexpr size_t RoundUp(size_t value, size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        static_assert(CACHE_LINE % constants::MESSAGE_BUFFER_ALIGNMENT == 0,
+            "slots must keep the message buffer alignment");
+
+    } // namespace
+
+    void* BufferArena::do_allocate(size_t bytes, size_t alignment) {
+        size_t offset = next_.load(std::memory_order_relaxed);
+        while (buffer_) {
+            size_t begin = RoundUp(offset, alignment);
+            if (begin + bytes > buffer_->capacity) {
+                buffer_->pool->arena_overflows_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            if (next_.compare_exchange_weak(offset, begin + bytes, std::memory_order_relaxed)) {
+                return buffer_->data() + begin;
+            }
+        }
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void BufferArena::do_deallocate(void* p, size_t bytes, size_t alignment) {
+        // Arena space comes back with the buffer
+        auto address = reinterpret_cast<uintptr_t>(p);
+        auto begin = reinterpret_cast<uintptr_t>(buffer_ ? buffer_->data() : nullptr);
+        if (!buffer_ || address < begin || address >= begin + buffer_->capacity) {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+    }
+
+    void BufferRef::Unref() {
+        if (buffer_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            buffer_->pool->Release(buffer_);
+        }
+        buffer_ = nullptr;
+    }
+
+    std::shared_ptr<BufferPool> BufferPool::Create(std::vector<SizeClass> classes, int numa_node) {
+        auto* pool = new (std::nothrow) BufferPool(std::move(classes), numa_node);
+        if (!pool) {
+            return nullptr;
+        }
+
+        if (!pool->Initialize()) {
+            pool->Unref();
+            return nullptr;
+        }
+
+        // The owner's reference, buffers still in flight keep the slabs alive
+        return std::shared_ptr<BufferPool>(pool, [](BufferPool* p) { p->Unref(); });
+    }
+
+    BufferPool::BufferPool(std::vector<SizeClass> classes, int numa_node)
+        : classes_(std::move(classes))
+        , numa_node_(numa_node) {
+
+        std::sort(classes_.begin(), classes_.end(),
+            [](const SizeClass& a, const SizeClass& b) { return a.buffer_size < b.buffer_size; });
+    }
+
+    BufferPool::~BufferPool() {
+        for (auto& slab : slabs_) {
+            FreeNodeMemory(slab.memory, slab.bytes);
+        }
+    }
+
+    bool BufferPool::Initialize() {
+        for (const auto& size_class : classes_) {
+            if (size_class.buffer_count == 0) {
+                continue;
+            }
+
+            Slab slab;
+            slab.buffer_size = size_class.buffer_size;
+            slab.stride = RoundUp(POOLED_BUFFER_DATA_OFFSET + size_class.buffer_size, CACHE_LINE);
+            slab.count = size_class.buffer_count;
+            slab.bytes = slab.stride * slab.count;
+
+            // Page aligned, which keeps the slots on cache lines
+            slab.memory = static_cast<uint8_t*>(AllocateNodeMemory(slab.bytes, numa_node_));
+
+            if (!slab.memory) {
+                return false;
+            }
+
+            slab.free = std::make_unique<LockFreeIndexPool>();
+            slab.free->Reset(slab.count);
+
+            uint32_t class_index = static_cast<uint32_t>(slabs_.size());
+            for (size_t i = 0; i < slab.count; ++i) {
+                PooledBuffer* buffer = SlotAt(slab, i);
+                new (buffer) PooledBuffer{};
+                buffer->size_class = class_index;
+                buffer->index = static_cast<uint32_t>(i);
+                buffer->capacity = slab.buffer_size;
+                buffer->pool = this;
+            }
+
+            slabs_.push_back(std::move(slab));
+        }
+        return true;
+    }
+
+    PooledBuffer* BufferPool::SlotAt(const Slab& slab, size_t index) const {
+        return reinterpret_cast<PooledBuffer*>(slab.memory + index * slab.stride);
+    }
+
+    BufferRef BufferPool::Acquire(size_t size) {
+        PooledBuffer* buffer = nullptr;
+
+        for (auto& slab : slabs_) {
+            if (slab.buffer_size < size) {
+                continue;
+            }
+
+            size_t index = slab.free->TryAcquire();
+            if (index != LockFreeIndexPool::NPOS) {
+                buffer = SlotAt(slab, index);
+                break;
+            }
+        }
+
+        if (!buffer) {
+            buffer = AllocateFromHeap(size);
+            if (!buffer) {
+                return BufferRef();
+            }
+        }
+
+        Ref();
+        buffer->refs.store(1, std::memory_order_relaxed);
+        buffer->length = 0;
+        buffer->arena.Reset(buffer, 0);
+        return BufferRef(buffer);
+    }
+
+    BufferRef BufferPool::Copy(const uint8_t* data, size_t size, size_t reserve) {
+        BufferRef buffer = Acquire(size + reserve);
+        if (buffer) {
+            std::memcpy(buffer.data(), data, size);
+            buffer.SetSize(size);
+        }
+        return buffer;
+    }
+
+    PooledBuffer* BufferPool::AllocateFromHeap(size_t size) {
+        void* memory = ::operator new(POOLED_BUFFER_DATA_OFFSET + size,
+            std::align_val_t(constants::MESSAGE_BUFFER_ALIGNMENT), std::nothrow);
+        if (!memory) {
+            return nullptr;
+        }
+
+        auto* buffer = new (memory) PooledBuffer{};
+        buffer->size_class = HEAP_CLASS;
+        buffer->capacity = size;
+        buffer->pool = this;
+
+        heap_allocations_.fetch_add(1, std::memory_order_relaxed);
+        heap_in_use_.fetch_add(1, std::memory_order_relaxed);
+        return buffer;
+    }
+
+    void BufferPool::Release(PooledBuffer* buffer) {
+        if (buffer->size_class == HEAP_CLASS) {
+            heap_in_use_.fetch_sub(1, std::memory_order_relaxed);
+            buffer->~PooledBuffer();
+            ::operator delete(buffer, std::align_val_t(constants::MESSAGE_BUFFER_ALIGNMENT));
+        }
+        else {
+            slabs_[buffer->size_class].free->Release(buffer->index);
+        }
+        Unref();
+    }
+
+    void BufferPool::Unref() {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    size_t BufferPool::LargestClassSize() const {
+        return slabs_.empty() ? 0 : slabs_.back().buffer_size;
+    }
+
+    BufferPool::Statistics BufferPool::GetStatistics() const {
+        Statistics stats;
+        for (const auto& slab : slabs_) {
+            stats.classes.push_back({ slab.buffer_size, slab.count, slab.free->InUse() });
+        }
+        stats.heap_allocations = heap_allocations_.load(std::memory_order_relaxed);
+        stats.heap_in_use = heap_in_use_.load(std::memory_order_relaxed);
+        stats.arena_overflows = arena_overflows_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+} // namespace kubearmor::common
\ No newline at end of file
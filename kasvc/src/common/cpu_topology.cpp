@@ -0,0 +1,347 @@
+#include "common/cpu_topology.h"
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace kubearmor::common {
+
+    namespace {
+
+        CpuTopology SingleNode(uint32_t count) {
+            CpuTopology topology;
+            for (uint32_t id = 0; id < std::max<uint32_t>(1, count); ++id) {
+                topology.cpus.push_back({ id, 0, id });
+            }
+            return topology;
+        }
+
+#ifdef _WIN32
+
+        std::vector<uint32_t> MaskToCpus(WORD group, KAFFINITY mask) {
+            std::vector<uint32_t> cpus;
+            for (uint32_t bit = 0; bit < sizeof(KAFFINITY) * 8; ++bit) {
+                if (mask & (static_cast<KAFFINITY>(1) << bit)) {
+                    cpus.push_back(group * 64 + bit);
+                }
+            }
+            return cpus;
+        }
+
+        std::vector<uint8_t> ProcessorInformation(LOGICAL_PROCESSOR_RELATIONSHIP relationship) {
+            DWORD length = 0;
+            GetLogicalProcessorInformationEx(relationship, nullptr, &length);
+            std::vector<uint8_t> buffer(length);
+            if (length == 0 || !GetLogicalProcessorInformationEx(relationship,
+                reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length)) {
+                buffer.clear();
+            }
+            return buffer;
+        }
+
+        template<typename Visit>
+        void ForEachRelation(const std::vector<uint8_t>& buffer, Visit visit) {
+            size_t offset = 0;
+            while (offset < buffer.size()) {
+                auto* info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(
+                    buffer.data() + offset);
+                visit(*info);
+                offset += info->Size;
+            }
+        }
+
+#elif defined(__linux__)
+
+        std::string ReadLine(const std::string& path) {
+            std::ifstream file(path);
+            std::string line;
+            std::getline(file, line);
+            return line;
+        }
+
+#endif
+
+    } // namespace
+
+    CpuTopology CpuTopology::Detect() {
+        uint32_t fallback_count = std::thread::hardware_concurrency();
+
+#ifdef _WIN32
+        std::map<uint32_t, CpuTopology::Cpu> found;
+
+        auto cores = ProcessorInformation(RelationProcessorCore);
+        uint32_t core_index = 0;
+        ForEachRelation(cores, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info) {
+            for (WORD i = 0; i < info.Processor.GroupCount; ++i) {
+                const GROUP_AFFINITY& affinity = info.Processor.GroupMask[i];
+                for (uint32_t id : MaskToCpus(affinity.Group, affinity.Mask)) {
+                    found[id] = { id, 0, core_index };
+                }
+            }
+            core_index++;
+            });
+
+        auto nodes = ProcessorInformation(RelationNumaNode);
+        ForEachRelation(nodes, [&](const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info) {
+            const GROUP_AFFINITY& affinity = info.NumaNode.GroupMask;
+            for (uint32_t id : MaskToCpus(affinity.Group, affinity.Mask)) {
+                auto cpu = found.find(id);
+                if (cpu != found.end()) {
+                    cpu->second.node = info.NumaNode.NodeNumber;
+                }
+            }
+            });
+
+        // The process affinity mask only describes a process that lives in
+        // one group, which is what a service that never asked for more is
+        USHORT group_count = 1;
+        USHORT group = 0;
+        DWORD_PTR process_mask = 0;
+        DWORD_PTR system_mask = 0;
+        if (GetProcessGroupAffinity(GetCurrentProcess(), &group_count, &group) &&
+            GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+            auto allowed = MaskToCpus(group, process_mask);
+            for (auto it = found.begin(); it != found.end();) {
+                it = std::binary_search(allowed.begin(), allowed.end(), it->first) ?
+                    std::next(it) : found.erase(it);
+            }
+        }
+
+        CpuTopology topology;
+        for (const auto& [id, cpu] : found) {
+            topology.cpus.push_back(cpu);
+        }
+        return topology.cpus.empty() ? SingleNode(fallback_count) : topology;
+
+#elif defined(__linux__)
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            return SingleNode(fallback_count);
+        }
+
+        std::map<uint32_t, uint32_t> node_of;
+        for (uint32_t node = 0; node < 1024; ++node) {
+            std::string path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+            if (!std::ifstream(path)) {
+                if (node > 0 && node_of.empty()) break;
+                continue;
+            }
+
+            auto cpus = ParseCpuList(ReadLine(path));
+            if (cpus) {
+                for (uint32_t id : cpus.Value()) {
+                    node_of[id] = node;
+                }
+            }
+        }
+
+        // Cores are numbered per package, key them by both
+        std::map<std::pair<long, long>, uint32_t> core_index;
+        CpuTopology topology;
+        for (uint32_t id = 0; id < CPU_SETSIZE; ++id) {
+            if (!CPU_ISSET(id, &allowed)) {
+                continue;
+            }
+
+            std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+            std::string core_id = ReadLine(base + "core_id");
+            std::string package_id = ReadLine(base + "physical_package_id");
+            auto key = core_id.empty() ?
+                std::make_pair(-1L, static_cast<long>(id)) :
+                std::make_pair(std::strtol(package_id.c_str(), nullptr, 10),
+                    std::strtol(core_id.c_str(), nullptr, 10));
+            auto core = core_index.emplace(key, static_cast<uint32_t>(core_index.size())).first->second;
+
+            auto node = node_of.find(id);
+            topology.cpus.push_back({ id, node != node_of.end() ? node->second : 0, core });
+        }
+        return topology.cpus.empty() ? SingleNode(fallback_count) : topology;
+
+#else
+        return SingleNode(fallback_count);
+#endif
+    }
+
+    CpuTopology CpuTopology::Synthetic(uint32_t nodes, uint32_t cores_per_node, uint32_t threads_per_core) {
+        CpuTopology topology;
+        uint32_t core_count = nodes * cores_per_node;
+        for (uint32_t thread = 0; thread < threads_per_core; ++thread) {
+            for (uint32_t core = 0; core < core_count; ++core) {
+                topology.cpus.push_back({ thread * core_count + core, core / cores_per_node, core });
+            }
+        }
+        return topology;
+    }
+
+    std::vector<uint32_t> CpuTopology::Nodes() const {
+        std::vector<uint32_t> nodes;
+        for (const auto& cpu : cpus) {
+            if (std::find(nodes.begin(), nodes.end(), cpu.node) == nodes.end()) {
+                nodes.push_back(cpu.node);
+            }
+        }
+        std::sort(nodes.begin(), nodes.end());
+        return nodes;
+    }
+
+    size_t CpuTopology::CpuCount(uint32_t node) const {
+        return std::count_if(cpus.begin(), cpus.end(),
+            [node](const Cpu& cpu) { return cpu.node == node; });
+    }
+
+    const CpuTopology::Cpu* CpuTopology::Find(uint32_t id) const {
+        auto it = std::lower_bound(cpus.begin(), cpus.end(), id,
+            [](const Cpu& cpu, uint32_t value) { return cpu.id < value; });
+        return it != cpus.end() && it->id == id ? &*it : nullptr;
+    }
+
+    Result<std::vector<uint32_t>> ParseCpuList(const std::string& list) {
+        constexpr unsigned long MAX_CPU = 4095;
+        std::vector<uint32_t> cpus;
+
+        size_t pos = 0;
+        while (pos < list.size()) {
+            size_t end = list.find(',', pos);
+            std::string item = list.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+            pos = end == std::string::npos ? list.size() : end + 1;
+
+            item.erase(std::remove(item.begin(), item.end(), ' '), item.end());
+            if (item.empty()) {
+                continue;
+            }
+
+            char* rest = nullptr;
+            unsigned long first = std::strtoul(item.c_str(), &rest, 10);
+            unsigned long last = first;
+            if (*rest == '-') {
+                last = std::strtoul(rest + 1, &rest, 10);
+            }
+
+            if (rest == item.c_str() || *rest != '\0' || last < first || last > MAX_CPU) {
+                return Result<std::vector<uint32_t>>::Error("Invalid CPU list entry: " + item);
+            }
+
+            for (unsigned long id = first; id <= last; ++id) {
+                cpus.push_back(static_cast<uint32_t>(id));
+            }
+        }
+
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        return Result<std::vector<uint32_t>>::Success(std::move(cpus));
+    }
+
+    std::string FormatCpuList(const std::vector<uint32_t>& cpus) {
+        std::string list;
+        for (size_t i = 0; i < cpus.size();) {
+            size_t j = i;
+            while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+                j++;
+            }
+
+            if (!list.empty()) list += ',';
+            list += std::to_string(cpus[i]);
+            if (j > i) list += '-' + std::to_string(cpus[j]);
+            i = j + 1;
+        }
+        return list;
+    }
+
+    Result<void> PinCurrentThread(const std::vector<uint32_t>& cpus) {
+        if (cpus.empty()) {
+            return Result<void>::Error("No CPUs to pin to");
+        }
+
+#ifdef _WIN32
+        GROUP_AFFINITY affinity{};
+        affinity.Group = static_cast<WORD>(cpus.front() / 64);
+        for (uint32_t id : cpus) {
+            if (id / 64 == affinity.Group) {
+                affinity.Mask |= static_cast<KAFFINITY>(1) << (id % 64);
+            }
+        }
+
+        if (!SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr)) {
+            return Result<void>::Error("SetThreadGroupAffinity failed: " + std::to_string(GetLastError()));
+        }
+        return Result<void>::Success();
+
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (uint32_t id : cpus) {
+            if (id < CPU_SETSIZE) {
+                CPU_SET(id, &set);
+            }
+        }
+
+        int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (error != 0) {
+            return Result<void>::Error("pthread_setaffinity_np failed: " + std::to_string(error));
+        }
+        return Result<void>::Success();
+
+#else
+        return Result<void>::Error("Thread affinity is not supported on this platform");
+#endif
+    }
+
+    void* AllocateNodeMemory(size_t size, int node) {
+#ifdef _WIN32
+        return node < 0 ?
+            VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE) :
+            VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT,
+                PAGE_READWRITE, static_cast<DWORD>(node));
+
+#elif defined(__linux__)
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return nullptr;
+        }
+
+        // MPOL_PREFERRED, pages still come from elsewhere when the node is
+        // full. Called directly so we do not need libnuma.
+        constexpr int MPOL_PREFERRED_MODE = 1;
+        if (node >= 0 && node < 64) {
+            unsigned long mask = 1UL << node;
+            syscall(SYS_mbind, memory, size, MPOL_PREFERRED_MODE, &mask, sizeof(mask) * 8, 0);
+        }
+        return memory;
+
+#else
+        (void)node;
+        return ::operator new(size, std::align_val_t(4096), std::nothrow);
+#endif
+    }
+
+    void FreeNodeMemory(void* memory, size_t size) {
+        if (!memory) {
+            return;
+        }
+
+#ifdef _WIN32
+        (void)size;
+        VirtualFree(memory, 0, MEM_RELEASE);
+#elif defined(__linux__)
+        munmap(memory, size);
+#else
+        (void)size;
+        ::operator delete(memory, std::align_val_t(4096));
+#endif
+    }
+
+} // namespace kubearmor::common
@@ -0,0 +1,93 @@
+#include "common/event_sequence.h"
+
+namespace kubearmor::common {
+
+    namespace {
+
+        std::atomic<size_t> g_next_shard{ 0 };
+
+        static_assert((OrderTracker::SLOTS & (OrderTracker::SLOTS - 1)) == 0,
+            "ORDER_TRACKER_SLOTS must be a power of two");
+
+    } // namespace
+
+    size_t EventIdGenerator::ThreadShard() {
+        thread_local size_t shard = g_next_shard.fetch_add(1, std::memory_order_relaxed) & (SHARDS - 1);
+        return shard;
+    }
+
+    OrderTracker::OrderTracker()
+        : slots_(new Slot[SLOTS]) {
+    }
+
+    bool OrderTracker::Record(uint32_t process_id, uint64_t sequence) {
+        if (sequence == 0) {
+            return true;
+        }
+
+        // Windows process ids are multiples of 4, spread them over the table
+        uint64_t key = uint64_t(process_id) + 1;
+        size_t index = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (SLOTS - 1);
+
+        // The process's own slot wins over a free or stale one before it
+        Slot* vacant = nullptr;
+        uint64_t vacant_owner = 0;
+        for (size_t probe = 0; probe < constants::ORDER_TRACKER_PROBES; ++probe) {
+            Slot& slot = slots_[(index + probe) & (SLOTS - 1)];
+            uint64_t owner = slot.key.load(std::memory_order_acquire);
+            if (owner == 0) {
+                // Slots are taken in probe order, none of the rest is used
+                if (!vacant) {
+                    vacant = &slot;
+                    vacant_owner = 0;
+                }
+                break;
+            }
+            if (owner != key) {
+                if (!vacant && Stale(slot.highest.load(std::memory_order_relaxed), sequence)) {
+                    vacant = &slot;
+                    vacant_owner = owner;
+                }
+                continue;
+            }
+
+            uint64_t highest = slot.highest.load(std::memory_order_relaxed);
+            if (sequence < highest && Stale(highest, sequence)) {
+                // The driver numbers a new connection from 1 again
+                slot.highest.compare_exchange_strong(highest, sequence, std::memory_order_relaxed);
+                return true;
+            }
+            while (sequence > highest &&
+                !slot.highest.compare_exchange_weak(highest, sequence, std::memory_order_relaxed)) {
+            }
+            if (sequence < highest) {
+                violations_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+
+        // Claimed by this call, or by another process racing for it
+        if (vacant && vacant->key.compare_exchange_strong(vacant_owner, key, std::memory_order_acq_rel)) {
+            vacant->highest.store(sequence, std::memory_order_relaxed);
+            if (vacant_owner != 0) {
+                evictions_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        untracked_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void OrderTracker::Reset() {
+        for (size_t i = 0; i < SLOTS; ++i) {
+            slots_[i].key.store(0, std::memory_order_relaxed);
+            slots_[i].highest.store(0, std::memory_order_relaxed);
+        }
+        violations_.store(0, std::memory_order_relaxed);
+        untracked_.store(0, std::memory_order_relaxed);
+        evictions_.store(0, std::memory_order_relaxed);
+    }
+
+} // namespace kubearmor::common
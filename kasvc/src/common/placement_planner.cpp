@@ -0,0 +1,165 @@
+#include "common/placement_planner.h"
+#include <algorithm>
+#include <map>
+
+namespace kubearmor::common {
+
+    namespace {
+
+        // Receive side share of the budget, parsing and queueing is cheap
+        // next to what a worker does to publish an event
+        constexpr size_t IOCP_SHARE_DIVISOR = 4;
+
+        Result<void> CheckKnown(const CpuTopology& topology, const std::vector<uint32_t>& cpus,
+            const char* what) {
+            for (uint32_t id : cpus) {
+                if (!topology.Find(id)) {
+                    return Result<void>::Error(std::string(what) + " names CPU " +
+                        std::to_string(id) + ", which this process cannot run on");
+                }
+            }
+            return Result<void>::Success();
+        }
+
+        // Preferred node first, then the others; within a node the first
+        // hardware thread of every core, then the siblings
+        std::vector<uint32_t> OrderCpus(const std::vector<CpuTopology::Cpu>& cpus, uint32_t node) {
+            std::map<uint32_t, uint32_t> rank_in_core;
+            std::vector<uint32_t> sibling_rank(cpus.size());
+            for (size_t i = 0; i < cpus.size(); ++i) {
+                sibling_rank[i] = rank_in_core[cpus[i].core]++;
+            }
+
+            std::vector<size_t> index(cpus.size());
+            for (size_t i = 0; i < index.size(); ++i) index[i] = i;
+            std::stable_sort(index.begin(), index.end(), [&](size_t a, size_t b) {
+                bool a_local = cpus[a].node == node;
+                bool b_local = cpus[b].node == node;
+                if (a_local != b_local) return a_local;
+                if (cpus[a].node != cpus[b].node) return cpus[a].node < cpus[b].node;
+                return sibling_rank[a] < sibling_rank[b];
+                });
+
+            std::vector<uint32_t> ids;
+            for (size_t i : index) {
+                ids.push_back(cpus[i].id);
+            }
+            return ids;
+        }
+
+    } // namespace
+
+    Result<PlacementPlan> PlanPlacement(const CpuTopology& topology, const PlacementRequest& request) {
+        for (const auto& [cpus, what] : { std::make_pair(&request.allowed_cpus, "placement.cpus"),
+            std::make_pair(&request.iocp_cpus, "placement.iocp_cpus"),
+            std::make_pair(&request.worker_cpus, "placement.worker_cpus") }) {
+            auto known = CheckKnown(topology, *cpus, what);
+            if (!known) {
+                return Result<PlacementPlan>::Error(known.ErrorMessage());
+            }
+        }
+
+        std::vector<CpuTopology::Cpu> candidates;
+        for (const auto& cpu : topology.cpus) {
+            if (request.allowed_cpus.empty() || std::find(request.allowed_cpus.begin(),
+                request.allowed_cpus.end(), cpu.id) != request.allowed_cpus.end()) {
+                candidates.push_back(cpu);
+            }
+        }
+        if (candidates.empty()) {
+            return Result<PlacementPlan>::Error("No CPUs to place threads on");
+        }
+
+        std::map<uint32_t, size_t> per_node;
+        std::map<uint32_t, std::vector<uint32_t>> cores_per_node;
+        for (const auto& cpu : candidates) {
+            per_node[cpu.node]++;
+            auto& cores = cores_per_node[cpu.node];
+            if (std::find(cores.begin(), cores.end(), cpu.core) == cores.end()) {
+                cores.push_back(cpu.core);
+            }
+        }
+
+        uint32_t node = 0;
+        if (request.numa_node >= 0) {
+            node = static_cast<uint32_t>(request.numa_node);
+            if (per_node.count(node) == 0) {
+                return Result<PlacementPlan>::Error("NUMA node " + std::to_string(node) +
+                    " has no allowed CPUs");
+            }
+        }
+        else {
+            node = std::max_element(per_node.begin(), per_node.end(),
+                [](const auto& a, const auto& b) { return a.second < b.second; })->first;
+        }
+
+        // SMT siblings only when the budget asks for more than the cores
+        size_t budget = request.cpu_budget ?
+            std::min(request.cpu_budget, candidates.size()) : cores_per_node[node].size();
+
+        auto ordered = OrderCpus(candidates, node);
+        ordered.resize(budget);
+
+        // Explicit lists keep their CPUs, the rest of the budget fills in
+        // whichever side was left to us
+        PlacementPlan plan{};
+        plan.numa_node = topology.Nodes().size() > 1 ? static_cast<int>(node) : -1;
+        plan.iocp_cpus = request.iocp_cpus;
+        plan.worker_cpus = request.worker_cpus;
+        std::sort(plan.iocp_cpus.begin(), plan.iocp_cpus.end());
+        std::sort(plan.worker_cpus.begin(), plan.worker_cpus.end());
+
+        std::vector<uint32_t> rest;
+        for (uint32_t id : ordered) {
+            bool taken = std::binary_search(plan.iocp_cpus.begin(), plan.iocp_cpus.end(), id) ||
+                std::binary_search(plan.worker_cpus.begin(), plan.worker_cpus.end(), id);
+            if (!taken) {
+                rest.push_back(id);
+            }
+        }
+
+        if (plan.iocp_cpus.empty() && plan.worker_cpus.empty()) {
+            if (rest.size() == 1) {
+                plan.iocp_cpus = rest;
+                plan.worker_cpus = rest;
+            }
+            else {
+                size_t iocp_count = std::max<size_t>(1, rest.size() / IOCP_SHARE_DIVISOR);
+                plan.iocp_cpus.assign(rest.begin(), rest.begin() + iocp_count);
+                plan.worker_cpus.assign(rest.begin() + iocp_count, rest.end());
+            }
+        }
+        else if (plan.iocp_cpus.empty()) {
+            plan.iocp_cpus = rest.empty() ? std::vector<uint32_t>(ordered.begin(), ordered.begin() + 1) : rest;
+        }
+        else if (plan.worker_cpus.empty()) {
+            plan.worker_cpus = rest.empty() ? std::vector<uint32_t>(ordered.begin(), ordered.begin() + 1) : rest;
+        }
+
+        std::sort(plan.iocp_cpus.begin(), plan.iocp_cpus.end());
+        std::sort(plan.worker_cpus.begin(), plan.worker_cpus.end());
+
+        plan.iocp_threads = request.iocp_threads ? request.iocp_threads : plan.iocp_cpus.size();
+        plan.worker_threads = request.worker_threads ? request.worker_threads : plan.worker_cpus.size();
+        plan.concurrent_operations = 2 * plan.iocp_threads;
+        plan.buffer_pool_size = 4 * plan.iocp_threads;
+
+        return Result<PlacementPlan>::Success(std::move(plan));
+    }
+
+    std::vector<uint32_t> CpusForThread(const std::vector<uint32_t>& cpus, size_t thread_count, size_t index) {
+        if (cpus.empty() || thread_count > cpus.size()) {
+            return cpus;
+        }
+        return { cpus[index % cpus.size()] };
+    }
+
+    std::string DescribePlan(const PlacementPlan& plan) {
+        return "node " + (plan.numa_node < 0 ? std::string("any") : std::to_string(plan.numa_node)) +
+            ", " + std::to_string(plan.iocp_threads) + " IOCP threads on [" + FormatCpuList(plan.iocp_cpus) +
+            "], " + std::to_string(plan.worker_threads) + " workers on [" + FormatCpuList(plan.worker_cpus) +
+            "], " + std::to_string(plan.concurrent_operations) + " receives posted, " +
+            std::to_string(plan.buffer_pool_size) + " receive buffers";
+    }
+
+} // namespace kubearmor::common
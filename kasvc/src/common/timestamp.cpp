@@ -0,0 +1,110 @@
+#include "common/timestamp.h"
+#include <cstring>
+#include <limits>
+
+namespace kubearmor::common {
+
+    namespace {
+
+        using Clock = std::chrono::system_clock;
+
+        // Largest FILETIME tick count past the Unix epoch system_clock holds
+        const uint64_t MAX_UNIX_TICKS = static_cast<uint64_t>(
+            std::chrono::duration_cast<FileTimeTicks>(Clock::duration::max()).count());
+
+        // Writes value as exactly width digits, zero padded
+        inline void WriteDigits(char* out, uint32_t value, int width) {
+            for (int i = width - 1; i >= 0; --i) {
+                out[i] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            }
+        }
+
+        // civil_from_days (H. Hinnant): days since 1970-01-01 to a date in
+        // the proleptic Gregorian calendar
+        void CivilFromDays(int64_t days, int64_t& year, uint32_t& month, uint32_t& day) {
+            days += 719468;
+            int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+            uint32_t doe = static_cast<uint32_t>(days - era * 146097);
+            uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            uint32_t mp = (5 * doy + 2) / 153;
+            day = doy - (153 * mp + 2) / 5 + 1;
+            month = mp < 10 ? mp + 3 : mp - 9;
+            year = static_cast<int64_t>(yoe) + era * 400 + (month <= 2);
+        }
+
+        constexpr size_t PREFIX_SIZE = 19;     // YYYY-MM-DDTHH:MM:SS
+
+        void FormatPrefix(int64_t unix_seconds, char* out) {
+            int64_t days = unix_seconds >= 0 ? unix_seconds / 86400 : (unix_seconds - 86399) / 86400;
+            uint32_t second_of_day = static_cast<uint32_t>(unix_seconds - days * 86400);
+
+            int64_t year;
+            uint32_t month;
+            uint32_t day;
+            CivilFromDays(days, year, month, day);
+
+            // RFC 3339 has four-digit years only
+            WriteDigits(out, static_cast<uint32_t>(year < 0 ? 0 : year > 9999 ? 9999 : year), 4);
+            out[4] = '-';
+            WriteDigits(out + 5, month, 2);
+            out[7] = '-';
+            WriteDigits(out + 8, day, 2);
+            out[10] = 'T';
+            WriteDigits(out + 11, second_of_day / 3600, 2);
+            out[13] = ':';
+            WriteDigits(out + 14, second_of_day / 60 % 60, 2);
+            out[16] = ':';
+            WriteDigits(out + 17, second_of_day % 60, 2);
+        }
+
+        // The second this thread formatted last
+        struct PrefixCache {
+            int64_t second = std::numeric_limits<int64_t>::min();
+            char text[PREFIX_SIZE];
+        };
+
+    } // namespace
+
+    std::chrono::system_clock::time_point FileTimeToSystemTime(uint64_t filetime) {
+        uint64_t unix_ticks = filetime > UNIX_EPOCH_IN_FILETIME_TICKS ? filetime - UNIX_EPOCH_IN_FILETIME_TICKS : 0;
+        if (unix_ticks > MAX_UNIX_TICKS) {
+            return Clock::time_point::max();
+        }
+        return Clock::time_point(std::chrono::duration_cast<Clock::duration>(
+            FileTimeTicks(static_cast<int64_t>(unix_ticks))));
+    }
+
+    int64_t ToUnixSeconds(std::chrono::system_clock::time_point time) {
+        return std::chrono::floor<std::chrono::seconds>(time.time_since_epoch()).count();
+    }
+
+    FormattedTime FormatTimestamp(std::chrono::system_clock::time_point time, TimestampPrecision precision) {
+        thread_local PrefixCache cache;
+
+        auto since_epoch = time.time_since_epoch();
+        auto seconds = std::chrono::floor<std::chrono::seconds>(since_epoch);
+        if (cache.second != seconds.count()) {
+            FormatPrefix(seconds.count(), cache.text);
+            cache.second = seconds.count();
+        }
+
+        FormattedTime formatted;
+        char* out = formatted.text_;
+        std::memcpy(out, cache.text, PREFIX_SIZE);
+        size_t size = PREFIX_SIZE;
+
+        if (precision == TimestampPrecision::MICROSECONDS) {
+            auto micros = std::chrono::duration_cast<std::chrono::microseconds>(since_epoch - seconds).count();
+            out[size++] = '.';
+            WriteDigits(out + size, static_cast<uint32_t>(micros), 6);
+            size += 6;
+        }
+
+        out[size++] = 'Z';
+        formatted.size_ = static_cast<uint8_t>(size);
+        return formatted;
+    }
+
+} // namespace kubearmor::common
@@ -0,0 +1,246 @@
+#include "common/unicode.h"
+#include "common/utf16_kernels.h"
+#include <atomic>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define KASVC_TRANSCODE_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace kubearmor::common {
+
+    namespace {
+
+        // Four code units in a 64-bit word
+        struct ScalarKernel {
+            static constexpr size_t WIDTH = 4;
+
+            static uint64_t Load(const char16_t* p) {
+                uint64_t v;
+                std::memcpy(&v, p, sizeof(v));
+                return v;
+            }
+
+            static bool AllAscii(const char16_t* p) {
+                return (Load(p) & 0xFF80FF80FF80FF80ULL) == 0;
+            }
+
+            static void Narrow(const char16_t* p, char* out) {
+                for (size_t i = 0; i < WIDTH; ++i) {
+                    out[i] = static_cast<char>(p[i]);
+                }
+            }
+
+            static bool HasSurrogate(const char16_t* p) {
+                for (size_t i = 0; i < WIDTH; ++i) {
+                    if ((p[i] & 0xF800) == 0xD800) return true;
+                }
+                return false;
+            }
+
+            static size_t Utf8Bytes(const char16_t* p) {
+                size_t bytes = WIDTH;
+                for (size_t i = 0; i < WIDTH; ++i) {
+                    bytes += (p[i] >= 0x80) + (p[i] >= 0x800);
+                }
+                return bytes;
+            }
+        };
+
+#ifdef KASVC_TRANSCODE_SSE2
+
+        // Eight code units in an XMM register
+        struct Sse2Kernel {
+            static constexpr size_t WIDTH = 8;
+
+            static __m128i Load(const char16_t* p) {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            }
+
+            // Bit pair per unit where (unit & mask) == 0
+            static uint32_t ZeroUnder(__m128i v, int16_t mask) {
+                return static_cast<uint32_t>(_mm_movemask_epi8(
+                    _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(mask)), _mm_setzero_si128())));
+            }
+
+            static bool AllAscii(const char16_t* p) {
+                return ZeroUnder(Load(p), static_cast<int16_t>(0xFF80)) == 0xFFFF;
+            }
+
+            static void Narrow(const char16_t* p, char* out) {
+                __m128i v = Load(p);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(v, v));
+            }
+
+            static bool HasSurrogate(const char16_t* p) {
+                __m128i top = _mm_and_si128(Load(p), _mm_set1_epi16(static_cast<int16_t>(0xF800)));
+                return _mm_movemask_epi8(_mm_cmpeq_epi16(top, _mm_set1_epi16(static_cast<int16_t>(0xD800)))) != 0;
+            }
+
+            // One byte per unit, one more from 0x80 and another from 0x800
+            static size_t Utf8Bytes(const char16_t* p) {
+                __m128i v = Load(p);
+                size_t below_80 = CountBits(ZeroUnder(v, static_cast<int16_t>(0xFF80))) / 2;
+                size_t below_800 = CountBits(ZeroUnder(v, static_cast<int16_t>(0xF800))) / 2;
+                return 3 * WIDTH - below_80 - below_800;
+            }
+        };
+
+#endif
+
+#ifdef KASVC_TRANSCODE_SSE2
+
+        // AVX2 in the CPU and YMM state saved by the OS
+        bool CpuHasAvx2() {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+                return false;
+            }
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+
+#endif
+
+        template<typename Kernel>
+        const TranscodeFunctions* FunctionsFor() {
+            static const TranscodeFunctions functions{
+                &Utf8LengthBlocks<Kernel>,
+                &NarrowAsciiBlocks<Kernel>,
+                &EncodeBlocks<Kernel>
+            };
+            return &functions;
+        }
+
+        const TranscodeFunctions* FunctionsFor(TranscodeKernel kernel) {
+            switch (kernel) {
+            case TranscodeKernel::SCALAR:
+                return FunctionsFor<ScalarKernel>();
+#ifdef KASVC_TRANSCODE_SSE2
+            case TranscodeKernel::SSE2:
+                return FunctionsFor<Sse2Kernel>();
+#endif
+#ifdef KASVC_TRANSCODE_SSE2
+            case TranscodeKernel::AVX2: {
+                static const bool supported = CpuHasAvx2();
+                return supported ? Avx2TranscodeFunctions() : nullptr;
+            }
+#endif
+            default:
+                return nullptr;
+            }
+        }
+
+        TranscodeKernel BestKernel() {
+            for (TranscodeKernel kernel : { TranscodeKernel::AVX2, TranscodeKernel::SSE2 }) {
+                if (FunctionsFor(kernel)) {
+                    return kernel;
+                }
+            }
+            return TranscodeKernel::SCALAR;
+        }
+
+        struct ActiveKernel {
+            std::atomic<TranscodeKernel> kernel{ BestKernel() };
+            std::atomic<const TranscodeFunctions*> functions{ FunctionsFor(kernel.load()) };
+        };
+
+        ActiveKernel& Active() {
+            static ActiveKernel active;
+            return active;
+        }
+
+        const TranscodeFunctions& Functions() {
+            return *Active().functions.load(std::memory_order_relaxed);
+        }
+
+        // Every code unit takes at least one byte, so length more bytes are
+        // exact for ASCII and a lower bound otherwise
+        template<typename String>
+        void Append(const char16_t* src, size_t length, String& out) {
+            if (!src || length == 0) {
+                return;
+            }
+
+            const TranscodeFunctions& functions = Functions();
+            size_t start = out.size();
+            out.resize(start + length);
+            size_t ascii = functions.narrow_ascii(src, length, &out[start]);
+            if (ascii == length) {
+                return;
+            }
+
+            out.resize(start + ascii + functions.utf8_length(src + ascii, length - ascii));
+            functions.encode(src + ascii, length - ascii, &out[start + ascii]);
+        }
+
+    } // namespace
+
+    size_t Utf8Length(const char16_t* src, size_t length) {
+        if (!src) return 0;
+        return Functions().utf8_length(src, length);
+    }
+
+    std::string Utf16ToUtf8(const char16_t* src, size_t length) {
+        std::string result;
+        Append(src, length, result);
+        return result;
+    }
+
+    void AppendUtf8(const char16_t* src, size_t length, std::string& out) {
+        Append(src, length, out);
+    }
+
+    void AppendUtf8(const char16_t* src, size_t length, std::pmr::string& out) {
+        Append(src, length, out);
+    }
+
+    size_t Utf16ToUtf8(const char16_t* src, size_t length, char* out) {
+        if (!src || length == 0) {
+            return 0;
+        }
+
+        const TranscodeFunctions& functions = Functions();
+        size_t ascii = functions.narrow_ascii(src, length, out);
+        if (ascii == length) {
+            return length;
+        }
+        return static_cast<size_t>(functions.encode(src + ascii, length - ascii, out + ascii) - out);
+    }
+
+    TranscodeKernel ActiveTranscodeKernel() {
+        return Active().kernel.load(std::memory_order_relaxed);
+    }
+
+    const char* TranscodeKernelName(TranscodeKernel kernel) {
+        switch (kernel) {
+        case TranscodeKernel::SCALAR: return "scalar";
+        case TranscodeKernel::SSE2: return "sse2";
+        case TranscodeKernel::AVX2: return "avx2";
+        default: return "unknown";
+        }
+    }
+
+    bool SelectTranscodeKernel(TranscodeKernel kernel) {
+        const TranscodeFunctions* functions = FunctionsFor(kernel);
+        if (!functions) {
+            return false;
+        }
+
+        Active().functions.store(functions, std::memory_order_relaxed);
+        Active().kernel.store(kernel, std::memory_order_relaxed);
+        return true;
+    }
+
+} // namespace kubearmor::common
@@ -0,0 +1,76 @@
+// AVX2 block kernel for the UTF-16 -> UTF-8 transcoder. This file is the
+// only one built with AVX2 code generation enabled (see CMakeLists.txt), so
+// nothing in it may run before unicode.cpp has checked the CPU.
+
+#include "common/utf16_kernels.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+
+#include <immintrin.h>
+
+namespace kubearmor::common {
+
+    namespace {
+
+        // Sixteen code units in a YMM register
+        struct Avx2Kernel {
+            static constexpr size_t WIDTH = 16;
+
+            static __m256i Load(const char16_t* p) {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            }
+
+            static uint32_t ZeroUnder(__m256i v, int16_t mask) {
+                return static_cast<uint32_t>(_mm256_movemask_epi8(
+                    _mm256_cmpeq_epi16(_mm256_and_si256(v, _mm256_set1_epi16(mask)), _mm256_setzero_si256())));
+            }
+
+            static bool AllAscii(const char16_t* p) {
+                return _mm256_testz_si256(Load(p), _mm256_set1_epi16(static_cast<int16_t>(0xFF80))) != 0;
+            }
+
+            // packus works within 128-bit lanes, pack the two halves instead
+            static void Narrow(const char16_t* p, char* out) {
+                __m256i v = Load(p);
+                __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+            }
+
+            static bool HasSurrogate(const char16_t* p) {
+                __m256i top = _mm256_and_si256(Load(p), _mm256_set1_epi16(static_cast<int16_t>(0xF800)));
+                return _mm256_movemask_epi8(
+                    _mm256_cmpeq_epi16(top, _mm256_set1_epi16(static_cast<int16_t>(0xD800)))) != 0;
+            }
+
+            static size_t Utf8Bytes(const char16_t* p) {
+                __m256i v = Load(p);
+                size_t below_80 = CountBits(ZeroUnder(v, static_cast<int16_t>(0xFF80))) / 2;
+                size_t below_800 = CountBits(ZeroUnder(v, static_cast<int16_t>(0xF800))) / 2;
+                return 3 * WIDTH - below_80 - below_800;
+            }
+        };
+
+    } // namespace
+
+    const TranscodeFunctions* Avx2TranscodeFunctions() {
+        static const TranscodeFunctions functions{
+            &Utf8LengthBlocks<Avx2Kernel>,
+            &NarrowAsciiBlocks<Avx2Kernel>,
+            &EncodeBlocks<Avx2Kernel>
+        };
+        return &functions;
+    }
+
+} // namespace kubearmor::common
+
+#else
+
+namespace kubearmor::common {
+
+    const TranscodeFunctions* Avx2TranscodeFunctions() {
+        return nullptr;
+    }
+
+} // namespace kubearmor::common
+
+#endif
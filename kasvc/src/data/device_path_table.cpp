@@ -0,0 +1,121 @@
+#include "data/device_path_table.h"
+#include "common/unicode.h"
+#include <algorithm>
+
+namespace kubearmor::data {
+
+    namespace {
+
+        char16_t FoldAscii(char16_t c) {
+            return c >= u'a' && c <= u'z' ? static_cast<char16_t>(c - (u'a' - u'A')) : c;
+        }
+
+        // Backwards: devices share \Device\ and differ in their last characters
+        bool SameDevice(const char16_t* a, const char16_t* b, size_t length) {
+            while (length > 0) {
+                --length;
+                if (a[length] != b[length] && FoldAscii(a[length]) != FoldAscii(b[length])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<typename String>
+        void Translate(const DevicePathTable& table, std::u16string_view path, String& out) {
+            auto match = table.Find(path);
+            std::u16string_view rest = path.substr(match.device_length);
+
+            out.clear();
+            out.reserve(match.dos.size() + rest.size());
+            common::AppendUtf8(match.dos.data(), match.dos.size(), out);
+            common::AppendUtf8(rest.data(), rest.size(), out);
+        }
+
+    } // namespace
+
+    DevicePathTable& DevicePathTable::GetInstance() {
+        // Leaked so strings converted while objects are destroyed at exit
+        // still find it
+        static DevicePathTable* instance = new DevicePathTable();
+        return *instance;
+    }
+
+    DevicePathTable::DevicePathTable() {
+        mappings_.push_back(std::make_unique<Mapping>());
+        current_.store(mappings_.back().get(), std::memory_order_release);
+    }
+
+    DevicePathTable::~DevicePathTable() = default;
+
+    bool DevicePathTable::Update(std::vector<DevicePrefix> prefixes) {
+        auto mapping = std::make_unique<Mapping>();
+
+        for (auto& prefix : prefixes) {
+            while (!prefix.device.empty() && prefix.device.back() == u'\\') {
+                prefix.device.pop_back();
+            }
+            if (prefix.device.empty()) {
+                continue;
+            }
+            bool duplicate = std::any_of(mapping->prefixes.begin(), mapping->prefixes.end(),
+                [&](const DevicePrefix& kept) {
+                    return kept.device.size() == prefix.device.size() &&
+                        SameDevice(kept.device.data(), prefix.device.data(), prefix.device.size());
+                });
+            if (!duplicate) {
+                mapping->prefixes.push_back(std::move(prefix));
+            }
+        }
+
+        // Longest first, so the first match is the longest
+        std::stable_sort(mapping->prefixes.begin(), mapping->prefixes.end(),
+            [](const DevicePrefix& a, const DevicePrefix& b) { return a.device.size() > b.device.size(); });
+
+        std::lock_guard<std::mutex> lock(update_mutex_);
+        const Mapping* current = current_.load(std::memory_order_relaxed);
+        bool unchanged = std::equal(mapping->prefixes.begin(), mapping->prefixes.end(),
+            current->prefixes.begin(), current->prefixes.end(),
+            [](const DevicePrefix& a, const DevicePrefix& b) { return a.device == b.device && a.dos == b.dos; });
+        if (unchanged) {
+            return false;
+        }
+
+        mapping->generation = current->generation + 1;
+        mappings_.push_back(std::move(mapping));
+        current_.store(mappings_.back().get(), std::memory_order_release);
+        return true;
+    }
+
+    DevicePathTable::Match DevicePathTable::Find(std::u16string_view path) const {
+        const Mapping* mapping = current_.load(std::memory_order_acquire);
+
+        for (const auto& prefix : mapping->prefixes) {
+            size_t length = prefix.device.size();
+            if (path.size() >= length && (path.size() == length || path[length] == u'\\') &&
+                SameDevice(path.data(), prefix.device.data(), length)) {
+                return Match{ length, prefix.dos };
+            }
+        }
+        return Match{ 0, {} };
+    }
+
+    std::string DevicePathTable::ToUtf8(std::u16string_view path) const {
+        std::string utf8;
+        Translate(*this, path, utf8);
+        return utf8;
+    }
+
+    void DevicePathTable::ToUtf8(std::u16string_view path, std::pmr::string& out) const {
+        Translate(*this, path, out);
+    }
+
+    uint64_t DevicePathTable::Generation() const {
+        return current_.load(std::memory_order_acquire)->generation;
+    }
+
+    size_t DevicePathTable::Size() const {
+        return current_.load(std::memory_order_acquire)->prefixes.size();
+    }
+
+} // namespace kubearmor::data
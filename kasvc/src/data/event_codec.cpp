@@ -0,0 +1,358 @@
+#include "data/event_codec.h"
+#include "common/timestamp.h"
+#include "common/unicode.h"
+#include "data/device_path_table.h"
+#include <cstring>
+
+namespace kubearmor::data {
+
+    namespace {
+
+        using Clock = std::chrono::system_clock;
+
+        constexpr uint32_t UTF16_STRING = 0x1;
+        constexpr size_t MAX_STRINGS = 3;
+        constexpr size_t MAX_STRING_BYTES = UINT32_MAX >> 1;
+
+        constexpr size_t Align4(size_t size) {
+            return (size + 3) & ~static_cast<size_t>(3);
+        }
+
+        // A string as it goes into the record, in the form the event holds it
+        struct StringBytes {
+            const void* data;
+            size_t bytes;
+            bool utf16;
+        };
+
+        StringBytes BytesOf(const PathRef& path) {
+            auto text = path.utf16();
+            return StringBytes{ text.data(), text.size() * sizeof(char16_t), true };
+        }
+
+        StringBytes BytesOf(const LazyString& value) {
+            if (!value.utf16().empty()) {
+                auto text = value.utf16();
+                return StringBytes{ text.data(), text.size() * sizeof(char16_t), true };
+            }
+            auto text = value.str();
+            return StringBytes{ text.data(), text.size(), false };
+        }
+
+        // Everything but the string bytes, worked out before anything is written
+        struct RecordPlan {
+            EncodedEventHeader header{};
+            union {
+                EncodedFileBody file;
+                EncodedProcessBody process;
+                EncodedNetworkBody network;
+            } body{};
+            size_t body_size = 0;
+            StringBytes strings[MAX_STRINGS]{};
+            size_t string_count = 0;
+            size_t size = 0;
+        };
+
+        // The operation comes from the variant, so the strings written always
+        // match the operation_type a decoder reads
+        void Plan(const Event& event, RecordPlan& plan) {
+            auto& header = plan.header;
+            header.magic = EVENT_CODEC_MAGIC;
+            header.version = EVENT_CODEC_VERSION;
+            header.type = static_cast<uint8_t>(event.type);
+            header.flags = event.blocked ? EVENT_CODEC_BLOCKED : 0;
+            header.event_id = event.event_id;
+            header.sequence = event.sequence;
+            header.timestamp = std::chrono::duration_cast<common::FileTimeTicks>(
+                event.timestamp.time_since_epoch()).count();
+
+            if (const auto* file = event.GetFileData()) {
+                header.operation_type = static_cast<uint8_t>(EventOperationType::FILE_EVENT);
+                header.operation = static_cast<uint8_t>(file->operation);
+                plan.body.file.process_id = file->process_id;
+                plan.body_size = sizeof(EncodedFileBody);
+                plan.strings[plan.string_count++] = BytesOf(file->process_path);
+                plan.strings[plan.string_count++] = BytesOf(file->file_path);
+            }
+            else if (const auto* process = event.GetProcessData()) {
+                header.operation_type = static_cast<uint8_t>(EventOperationType::PROCESS_EVENT);
+                header.operation = static_cast<uint8_t>(process->operation);
+                plan.body.process.process_id = process->process_id;
+                plan.body.process.parent_process_id = process->parent_process_id;
+                plan.body_size = sizeof(EncodedProcessBody);
+                plan.strings[plan.string_count++] = BytesOf(process->process_path);
+                plan.strings[plan.string_count++] = BytesOf(process->command_line);
+                plan.strings[plan.string_count++] = BytesOf(process->parent_process_path);
+            }
+            else if (const auto* network = event.GetNetworkData()) {
+                header.operation_type = static_cast<uint8_t>(EventOperationType::NETWORK_EVENT);
+                header.operation = static_cast<uint8_t>(network->operation);
+                auto& body = plan.body.network;
+                body.protocol = network->protocol;
+                body.data_length = network->data_length;
+                body.local_port = network->local_port;
+                body.remote_port = network->remote_port;
+                body.local_family = static_cast<uint8_t>(network->local_address.family);
+                body.remote_family = static_cast<uint8_t>(network->remote_address.family);
+                std::memcpy(body.local_address, network->local_address.bytes, sizeof(body.local_address));
+                std::memcpy(body.remote_address, network->remote_address.bytes, sizeof(body.remote_address));
+                plan.body_size = sizeof(EncodedNetworkBody);
+            }
+
+            header.header_size = static_cast<uint16_t>(sizeof(EncodedEventHeader) + plan.body_size);
+            plan.size = header.header_size;
+            for (size_t i = 0; i < plan.string_count; ++i) {
+                plan.size += sizeof(uint32_t) + Align4(plan.strings[i].bytes);
+            }
+        }
+
+        bool Encodable(const RecordPlan& plan) {
+            for (size_t i = 0; i < plan.string_count; ++i) {
+                if (plan.strings[i].bytes > MAX_STRING_BYTES) {
+                    return false;
+                }
+            }
+            return plan.size <= UINT32_MAX;
+        }
+
+        // Walks the strings of a record, checking each against its length
+        class StringReader {
+        public:
+            StringReader(const uint8_t* record, size_t begin, size_t end)
+                : record_(record), position_(begin), end_(end) {
+            }
+
+            bool Next(StringBytes& out) {
+                uint32_t prefix;
+                if (end_ - position_ < sizeof(prefix)) {
+                    return false;
+                }
+                std::memcpy(&prefix, record_ + position_, sizeof(prefix));
+                position_ += sizeof(prefix);
+
+                size_t bytes = prefix >> 1;
+                bool utf16 = (prefix & UTF16_STRING) != 0;
+                if (bytes > end_ - position_ || (utf16 && bytes % sizeof(char16_t) != 0)) {
+                    return false;
+                }
+                out = StringBytes{ record_ + position_, bytes, utf16 };
+                position_ += Align4(bytes);
+                return position_ <= end_;
+            }
+
+        private:
+            const uint8_t* record_;
+            size_t position_;
+            size_t end_;
+        };
+
+        std::u16string_view Utf16Of(const StringBytes& s) {
+            return std::u16string_view(static_cast<const char16_t*>(s.data), s.bytes / sizeof(char16_t));
+        }
+
+        // Paths are interned by their UTF-16 text, the encoder never writes
+        // them as UTF-8
+        PathRef DecodePath(uint32_t process_id, const StringBytes& s) {
+            thread_local PathCache cache(PathTable::GetInstance());
+            return cache.Intern(process_id, Utf16Of(s));
+        }
+
+        // Takes the owner: an event has at most one string that can refer to
+        // it. UTF-8 paths were written after their device was replaced.
+        LazyString DecodeString(const StringBytes& s, common::BufferRef&& owner, bool device_path = false) {
+            if (!s.utf16) {
+                return LazyString::FromUtf8(std::string_view(static_cast<const char*>(s.data), s.bytes),
+                    std::move(owner));
+            }
+            if (owner) {
+                auto* data = static_cast<const char16_t*>(s.data);
+                return device_path ?
+                    LazyString::FromUtf16Path(data, s.bytes / sizeof(char16_t), std::move(owner)) :
+                    LazyString::FromUtf16(data, s.bytes / sizeof(char16_t), std::move(owner));
+            }
+            if (device_path) {
+                return LazyString(DevicePathTable::GetInstance().ToUtf8(Utf16Of(s)));
+            }
+            return LazyString(common::Utf16ToUtf8(static_cast<const char16_t*>(s.data), s.bytes / sizeof(char16_t)));
+        }
+
+        bool KnownFamily(uint8_t family) {
+            switch (static_cast<AddressFamily>(family)) {
+            case AddressFamily::NONE:
+            case AddressFamily::IPV4:
+            case AddressFamily::IPV6:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        // Body each operation type's header_size has to leave room for, 0 if unknown
+        size_t BodySize(uint8_t operation_type) {
+            switch (static_cast<EventOperationType>(operation_type)) {
+            case EventOperationType::FILE_EVENT: return sizeof(EncodedFileBody);
+            case EventOperationType::PROCESS_EVENT: return sizeof(EncodedProcessBody);
+            case EventOperationType::NETWORK_EVENT: return sizeof(EncodedNetworkBody);
+            default: return 0;
+            }
+        }
+
+        bool ReadStrings(const uint8_t* data, const EncodedEventHeader& header, StringBytes* strings,
+            size_t count) {
+
+            StringReader reader(data, header.header_size, header.length);
+            for (size_t i = 0; i < count; ++i) {
+                if (!reader.Next(strings[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    } // namespace
+
+    size_t EncodedEventSize(const Event& event) {
+        RecordPlan plan;
+        Plan(event, plan);
+        return plan.size;
+    }
+
+    size_t EncodeEvent(const Event& event, uint8_t* out, size_t capacity) {
+        RecordPlan plan;
+        Plan(event, plan);
+        if (!out || plan.size > capacity || !Encodable(plan)) {
+            return 0;
+        }
+
+        plan.header.length = static_cast<uint32_t>(plan.size);
+        std::memcpy(out, &plan.header, sizeof(plan.header));
+        std::memcpy(out + sizeof(plan.header), &plan.body, plan.body_size);
+
+        size_t position = plan.header.header_size;
+        for (size_t i = 0; i < plan.string_count; ++i) {
+            const auto& s = plan.strings[i];
+            uint32_t prefix = static_cast<uint32_t>(s.bytes << 1) | (s.utf16 ? UTF16_STRING : 0);
+            std::memcpy(out + position, &prefix, sizeof(prefix));
+            position += sizeof(prefix);
+            if (s.bytes) {
+                std::memcpy(out + position, s.data, s.bytes);
+            }
+            // zero the padding so records are byte-for-byte reproducible
+            std::memset(out + position + s.bytes, 0, Align4(s.bytes) - s.bytes);
+            position += Align4(s.bytes);
+        }
+        return plan.size;
+    }
+
+    common::Result<Event> DecodeEvent(const uint8_t* data, size_t size, common::BufferRef owner) {
+        if (!data || reinterpret_cast<uintptr_t>(data) % alignof(char16_t) != 0) {
+            return common::Result<Event>::Error("Encoded event is missing or misaligned");
+        }
+        if (size < sizeof(EncodedEventHeader)) {
+            return common::Result<Event>::Error("Truncated encoded event");
+        }
+
+        EncodedEventHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != EVENT_CODEC_MAGIC || header.version != EVENT_CODEC_VERSION) {
+            return common::Result<Event>::Error("Not an encoded event of version " +
+                std::to_string(EVENT_CODEC_VERSION));
+        }
+        if (header.length > size || header.header_size > header.length || header.header_size % 4 != 0 ||
+            header.length % 4 != 0) {
+            return common::Result<Event>::Error("Encoded event length exceeds its buffer");
+        }
+        // The body sits between the header and the strings, header_size
+        // must cover both before body_size is worked out from it
+        if (header.header_size < sizeof(EncodedEventHeader) + BodySize(header.operation_type)) {
+            return common::Result<Event>::Error("Encoded event header size is too small");
+        }
+
+        // Ticks past what the clock holds would overflow converting them
+        const int64_t max_ticks = std::chrono::duration_cast<common::FileTimeTicks>(Clock::duration::max()).count();
+        if (header.timestamp > max_ticks || header.timestamp < -max_ticks) {
+            return common::Result<Event>::Error("Encoded event timestamp is out of range");
+        }
+
+        size_t body_size = header.header_size - sizeof(EncodedEventHeader);
+        const uint8_t* body = data + sizeof(EncodedEventHeader);
+        StringBytes strings[MAX_STRINGS];
+
+        Event event(Clock::time_point(std::chrono::duration_cast<Clock::duration>(
+            common::FileTimeTicks(header.timestamp))));
+        event.type = static_cast<EventType>(header.type);
+        event.operation_type = static_cast<EventOperationType>(header.operation_type);
+        event.event_id = header.event_id;
+        event.sequence = header.sequence;
+        event.blocked = (header.flags & EVENT_CODEC_BLOCKED) != 0;
+        if (event.type != EventType::HOST_LOG && event.type != EventType::MATCH_HOST_POLICY) {
+            return common::Result<Event>::Error("Unknown encoded event type");
+        }
+
+        switch (event.operation_type) {
+        case EventOperationType::FILE_EVENT: {
+            EncodedFileBody encoded;
+            if (body_size < sizeof(encoded) || header.operation > static_cast<uint8_t>(FileOperation::F_CLOSE) ||
+                !ReadStrings(data, header, strings, 2) || !strings[0].utf16) {
+                return common::Result<Event>::Error("Malformed encoded file event");
+            }
+            std::memcpy(&encoded, body, sizeof(encoded));
+
+            FileEventData file;
+            file.operation = static_cast<FileOperation>(header.operation);
+            file.process_id = encoded.process_id;
+            file.process_path = DecodePath(encoded.process_id, strings[0]);
+            file.file_path = DecodeString(strings[1], std::move(owner), true);
+            event.data = std::move(file);
+            break;
+        }
+        case EventOperationType::PROCESS_EVENT: {
+            EncodedProcessBody encoded;
+            if (body_size < sizeof(encoded) ||
+                header.operation > static_cast<uint8_t>(ProcessOperation::P_DUPLICATE_HANDLE) ||
+                !ReadStrings(data, header, strings, 3) || !strings[0].utf16 || !strings[2].utf16) {
+                return common::Result<Event>::Error("Malformed encoded process event");
+            }
+            std::memcpy(&encoded, body, sizeof(encoded));
+
+            ProcessEventData process;
+            process.operation = static_cast<ProcessOperation>(header.operation);
+            process.process_id = encoded.process_id;
+            process.parent_process_id = encoded.parent_process_id;
+            process.process_path = DecodePath(encoded.process_id, strings[0]);
+            process.command_line = DecodeString(strings[1], std::move(owner));
+            process.parent_process_path = DecodePath(encoded.parent_process_id, strings[2]);
+            event.data = std::move(process);
+            break;
+        }
+        case EventOperationType::NETWORK_EVENT: {
+            EncodedNetworkBody encoded;
+            if (body_size >= sizeof(encoded)) {
+                std::memcpy(&encoded, body, sizeof(encoded));
+            }
+            if (body_size < sizeof(encoded) || header.operation > static_cast<uint8_t>(NetworkOperation::UDP_RECEIVE) ||
+                !KnownFamily(encoded.local_family) || !KnownFamily(encoded.remote_family)) {
+                return common::Result<Event>::Error("Malformed encoded network event");
+            }
+
+            NetworkEventData network;
+            network.operation = static_cast<NetworkOperation>(header.operation);
+            network.protocol = encoded.protocol;
+            network.data_length = encoded.data_length;
+            network.local_port = encoded.local_port;
+            network.remote_port = encoded.remote_port;
+            network.local_address = IpAddress::FromBytes(encoded.local_address,
+                static_cast<AddressFamily>(encoded.local_family));
+            network.remote_address = IpAddress::FromBytes(encoded.remote_address,
+                static_cast<AddressFamily>(encoded.remote_family));
+            event.data = std::move(network);
+            break;
+        }
+        default:
+            return common::Result<Event>::Error("Unknown encoded event operation");
+        }
+
+        return common::Result<Event>::Success(std::move(event));
+    }
+
+} // namespace kubearmor::data
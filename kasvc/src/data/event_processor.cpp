@@ -1,27 +1,25 @@
 #include "data/event_processor.h"
 #include <algorithm>
-#include <iterator>
 
 namespace kubearmor::data {
 
     std::vector<Event> EventProcessor::Filter(
-        const std::vector<Event>& events,
+        std::vector<Event> events,
         FilterPredicate predicate) const {
 
-        std::vector<Event> filtered;
-        std::copy_if(events.begin(), events.end(),
-            std::back_inserter(filtered), predicate);
-        return filtered;
+        events.erase(std::remove_if(events.begin(), events.end(),
+            [&](const Event& event) { return !predicate(event); }), events.end());
+        return events;
     }
 
-    Event EventProcessor::Enrich(const Event& event) const {
+    void EventProcessor::Enrich(Event& event) const {
         /*
         TODO:
         This is where we can enrich the received event by updating it with
         any information that is not available in kernel space i.e. namespace, pod,
         etc
         */
-        return event;
+        (void)event;
     }
 
     EventProcessor::AggregatedStats EventProcessor::Aggregate(
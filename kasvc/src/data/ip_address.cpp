@@ -0,0 +1,78 @@
+#include "data/ip_address.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+namespace kubearmor::data {
+
+    AddressFormatCache& AddressFormatCache::GetInstance() {
+        static AddressFormatCache* instance = new AddressFormatCache();
+        return *instance;
+    }
+
+    AddressFormatCache::AddressFormatCache(size_t slots) {
+        size_t count = 1;
+        while (count < slots) {
+            count <<= 1;
+        }
+        mask_ = count - 1;
+        slots_.reset(new Slot[count]);
+    }
+
+    FormattedAddress AddressFormatCache::Format(const IpAddress& address) {
+        if (address.empty()) {
+            return FormattedAddress();
+        }
+
+        Slot& slot = slots_[address.Hash() & mask_];
+        if (slot.busy.exchange(true, std::memory_order_acquire)) {
+            // Someone else is on this slot, do not wait for them
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return FormatUncached(address);
+        }
+
+        if (slot.used && slot.address == address) {
+            FormattedAddress text = slot.text;
+            slot.busy.store(false, std::memory_order_release);
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return text;
+        }
+
+        FormattedAddress text = FormatUncached(address);
+        slot.address = address;
+        slot.text = text;
+        slot.used = true;
+        slot.busy.store(false, std::memory_order_release);
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return text;
+    }
+
+    AddressFormatCache::Statistics AddressFormatCache::GetStatistics() const {
+        return Statistics{ hits_.load(), misses_.load() };
+    }
+
+    FormattedAddress AddressFormatCache::FormatUncached(const IpAddress& address) {
+        FormattedAddress text;
+        const char* result = nullptr;
+
+        if (address.family == AddressFamily::IPV4) {
+            struct in_addr addr4;
+            std::memcpy(&addr4, address.bytes, sizeof(addr4));
+            result = inet_ntop(AF_INET, &addr4, text.text_, sizeof(text.text_));
+        }
+        else if (address.family == AddressFamily::IPV6) {
+            struct in6_addr addr6;
+            std::memcpy(&addr6, address.bytes, sizeof(addr6));
+            result = inet_ntop(AF_INET6, &addr6, text.text_, sizeof(text.text_));
+        }
+
+        text.size_ = result ? static_cast<uint8_t>(std::strlen(text.text_)) : 0;
+        return text;
+    }
+
+} // namespace kubearmor::data
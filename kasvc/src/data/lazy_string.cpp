@@ -0,0 +1,19 @@
+#include "data/lazy_string.h"
+#include "common/unicode.h"
+#include "data/device_path_table.h"
+
+namespace kubearmor::data {
+
+    void LazyString::Convert() const {
+        std::pmr::memory_resource* resource = owner_ ? owner_.arena() : std::pmr::get_default_resource();
+        if (device_path_) {
+            DevicePathTable::GetInstance().ToUtf8(utf16_, utf8_.emplace(resource));
+        }
+        else {
+            auto& utf8 = utf8_.emplace(common::Utf8Length(utf16_.data(), utf16_.size()), '\0', resource);
+            common::Utf16ToUtf8(utf16_.data(), utf16_.size(), utf8.data());
+        }
+        converted_ = true;
+    }
+
+} // namespace kubearmor::data
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "data/path_table.h"
+#include "data/device_path_table.h"
+#include <algorithm>
+#include <functional>
+
+namespace kubearmor::data {
+
+    const std::string& PathRef::str() const {
+        static const std::string empty_path;
+        if (!path_) {
+            return empty_path;
+        }
+
+        std::call_once(path_->converted, [path = path_] {
+            path->utf8 = DevicePathTable::GetInstance().ToUtf8(path->utf16);
+            });
+        return path_->utf8;
+    }
+
+    PathTable& PathTable::GetInstance() {
+        // Leaked so handles held by objects destroyed at exit stay valid
+        static PathTable* instance = new PathTable();
+        return *instance;
+    }
+
+    PathTable::PathTable(size_t idle_limit)
+        : shard_idle_limit_(std::max<size_t>(1, idle_limit / constants::PATH_TABLE_SHARDS)),
+        shards_(new Shard[constants::PATH_TABLE_SHARDS]) {
+        for (size_t i = 0; i < constants::PATH_TABLE_SHARDS; ++i) {
+            shards_[i].trim_at = shard_idle_limit_;
+        }
+    }
+
+    PathTable::~PathTable() {
+        for (size_t i = 0; i < constants::PATH_TABLE_SHARDS; ++i) {
+            for (auto& entry : shards_[i].paths) {
+                delete entry.second;
+            }
+        }
+    }
+
+    PathRef PathTable::Intern(std::u16string_view path) {
+        if (path.empty()) {
+            return PathRef();
+        }
+
+        size_t hash = std::hash<std::u16string_view>()(path);
+        size_t index = (hash >> 16) % constants::PATH_TABLE_SHARDS;
+        Shard& shard = shards_[index];
+
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.paths.find(Key{ path, hash });
+            if (it != shard.paths.end()) {
+                return Acquire(it->second);
+            }
+        }
+
+        // Copy the key outside the lock, another thread may insert it first
+        auto entry = std::make_unique<InternedPath>();
+        entry->hash = hash;
+        entry->utf16.assign(path.data(), path.size());
+
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.paths.find(Key{ path, hash });
+        if (it != shard.paths.end()) {
+            return Acquire(it->second);
+        }
+
+        if (shard.paths.size() >= shard.trim_at) {
+            Trim(shard);
+        }
+
+        uint32_t slot = shard.next_id;
+        if (!shard.free_ids.empty()) {
+            slot = shard.free_ids.back();
+            shard.free_ids.pop_back();
+        }
+        else {
+            shard.next_id++;
+        }
+        entry->id = static_cast<uint32_t>(slot * constants::PATH_TABLE_SHARDS + index);
+
+        InternedPath* interned = entry.release();
+        shard.paths.emplace(Key{ interned->utf16, hash }, interned);
+        shard.inserts++;
+        return Acquire(interned);
+    }
+
+    PathRef PathTable::Acquire(InternedPath* path) {
+        path->refs.fetch_add(1, std::memory_order_relaxed);
+        return PathRef(path);
+    }
+
+    void PathTable::Trim(Shard& shard) {
+        // Handles are only created under the shard lock, so an entry seen
+        // unreferenced here cannot be picked up again while it is removed
+        for (auto it = shard.paths.begin(); it != shard.paths.end();) {
+            InternedPath* path = it->second;
+            if (path->refs.load(std::memory_order_acquire) != 0) {
+                ++it;
+                continue;
+            }
+
+            shard.free_ids.push_back(path->id / constants::PATH_TABLE_SHARDS);
+            it = shard.paths.erase(it);
+            delete path;
+            shard.evictions++;
+        }
+
+        // Paths still referenced cannot go, don't rescan for every insert
+        shard.trim_at = std::max(shard_idle_limit_, 2 * shard.paths.size());
+    }
+
+    PathTable::Statistics PathTable::GetStatistics() const {
+        Statistics stats{};
+        for (size_t i = 0; i < constants::PATH_TABLE_SHARDS; ++i) {
+            const Shard& shard = shards_[i];
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+            stats.paths += shard.paths.size();
+            stats.inserts += shard.inserts;
+            stats.evictions += shard.evictions;
+            for (const auto& entry : shard.paths) {
+                if (entry.second->refs.load(std::memory_order_relaxed) != 0) {
+                    stats.referenced++;
+                }
+                stats.bytes += sizeof(InternedPath) + entry.second->utf16.capacity() * sizeof(char16_t);
+            }
+        }
+        return stats;
+    }
+
+} // namespace kubearmor::data
@@ -0,0 +1,157 @@
+#include "data/win_volume_watcher.h"
+#include "common/constants.h"
+#include "common/logger.h"
+#include <initguid.h>
+#include <winioctl.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kubearmor::data {
+
+    WinVolumeWatcher::WinVolumeWatcher(DevicePathTable& table)
+        : table_(table)
+        , notification_(nullptr)
+        , changed_(nullptr)
+        , running_(false) {
+    }
+
+    WinVolumeWatcher::~WinVolumeWatcher() {
+        Stop();
+    }
+
+    common::Result<void> WinVolumeWatcher::Start() {
+        if (running_.load()) {
+            return common::Result<void>::Success();
+        }
+
+        auto refreshed = Refresh();
+        if (!refreshed) {
+            return refreshed;
+        }
+
+        // auto-reset, a burst of notifications is one refresh
+        changed_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (!changed_) {
+            DWORD error = GetLastError();
+            return common::Result<void>::Error(
+                "Failed to create volume change event: " + std::to_string(error));
+        }
+
+        CM_NOTIFY_FILTER filter{};
+        filter.cbSize = sizeof(filter);
+        filter.FilterType = CM_NOTIFY_FILTER_TYPE_DEVICEINTERFACE;
+        filter.u.DeviceInterface.ClassGuid = GUID_DEVINTERFACE_VOLUME;
+
+        CONFIGRET result = CM_Register_Notification(&filter, this, OnVolumeChange, &notification_);
+        if (result != CR_SUCCESS) {
+            // Still refreshed on the interval
+            LOG_WARN("Unable to register for volume notifications: " + std::to_string(result));
+            notification_ = nullptr;
+        }
+
+        running_ = true;
+        thread_ = std::thread([this] { WatchThread(); });
+        return common::Result<void>::Success();
+    }
+
+    void WinVolumeWatcher::Stop() {
+        if (notification_) {
+            // Waits for callbacks in progress
+            CM_Unregister_Notification(notification_);
+            notification_ = nullptr;
+        }
+
+        if (running_.exchange(false)) {
+            SetEvent(changed_);
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+        }
+
+        if (changed_) {
+            CloseHandle(changed_);
+            changed_ = nullptr;
+        }
+    }
+
+    common::Result<void> WinVolumeWatcher::Refresh() {
+        DWORD drives = GetLogicalDrives();
+        if (drives == 0) {
+            DWORD error = GetLastError();
+            return common::Result<void>::Error("Failed to list drive letters: " + std::to_string(error));
+        }
+
+        std::vector<DevicePrefix> prefixes;
+        wchar_t target[MAX_PATH];
+
+        for (wchar_t letter = L'A'; letter <= L'Z'; ++letter) {
+            if (!(drives & (1u << (letter - L'A')))) {
+                continue;
+            }
+
+            const wchar_t name[] = { letter, L':', L'\0' };
+            if (!QueryDosDeviceW(name, target, MAX_PATH)) {
+                continue;   // removed since GetLogicalDrives()
+            }
+
+            // subst letters point at \??\C:\dir, their files are reported
+            // under the volume the directory is on
+            std::wstring_view device(target);
+            if (device.rfind(L"\\Device\\", 0) != 0) {
+                continue;
+            }
+
+            prefixes.push_back(DevicePrefix{
+                std::u16string(device.begin(), device.end()),
+                std::u16string(name, name + 2) });
+        }
+
+        prefixes.push_back(DevicePrefix{ u"\\Device\\Mup", u"\\" });
+
+        size_t volumes = prefixes.size() - 1;
+        if (table_.Update(std::move(prefixes))) {
+            LOG_INFO("Device paths: " + std::to_string(volumes) + " drive letters mapped");
+        }
+        return common::Result<void>::Success();
+    }
+
+    DWORD CALLBACK WinVolumeWatcher::OnVolumeChange(HCMNOTIFICATION /*notification*/, PVOID context,
+        CM_NOTIFY_ACTION action, PCM_NOTIFY_EVENT_DATA /*data*/, DWORD /*size*/) {
+
+        if (action == CM_NOTIFY_ACTION_DEVICEINTERFACEARRIVAL ||
+            action == CM_NOTIFY_ACTION_DEVICEINTERFACEREMOVAL) {
+            SetEvent(static_cast<WinVolumeWatcher*>(context)->changed_);
+        }
+        return ERROR_SUCCESS;
+    }
+
+    void WinVolumeWatcher::WatchThread() {
+        const DWORD interval = static_cast<DWORD>(
+            std::chrono::milliseconds(constants::VOLUME_REFRESH_INTERVAL).count());
+        const DWORD settle = static_cast<DWORD>(constants::VOLUME_SETTLE_DELAY.count());
+
+        while (running_.load()) {
+            DWORD wait = WaitForSingleObject(changed_, interval);
+            if (!running_.load()) {
+                break;
+            }
+
+            // The mount manager assigns the letter after the volume arrives;
+            // notifications that come in meanwhile are covered by this refresh
+            if (wait == WAIT_OBJECT_0) {
+                while (WaitForSingleObject(changed_, settle) == WAIT_OBJECT_0 && running_.load()) {
+                }
+                if (!running_.load()) {
+                    break;
+                }
+            }
+
+            auto refreshed = Refresh();
+            if (!refreshed) {
+                LOG_WARN("Unable to refresh device paths: " + refreshed.ErrorMessage());
+            }
+        }
+    }
+
+} // namespace kubearmor::data
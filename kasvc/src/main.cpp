@@ -1,8 +1,13 @@
 #include "common/logger.h"
 #include "common/constants.h"
+#include "common/placement_planner.h"
 #include "data/event_processor.h"
+#include "data/path_table.h"
+#include "data/win_volume_watcher.h"
 #include "app/monitoring_service.h"
 #include "comm/iocp_filter_port_communicator.h"
+#include "comm/win_event_ring_section.h"
+#include "comm/win_filter_port.h"
 #include "comm/json_config_store.h"
 #include "rpc/feeder_event_publisher.h"
 #include "rpc/feeder_service.h"
@@ -70,13 +75,12 @@ int main(int argc, char** argv) {
             return 1;
         }
 
-        auto config = config_result.Value();
+        auto config = config_result.TakeValue();
 
         LOG_INFO("Configuration loaded successfully");
         LOG_INFO("  Service: " + config.service_name);
         LOG_INFO("  gRPC: " + config.grpc_address + ":" +
             std::to_string(config.grpc_port));
-        LOG_INFO("  Worker threads: " + std::to_string(config.worker_threads));
 
         // Update logger
         common::Logger::GetInstance().SetLevel(ParseLogLevel(config.log_level));
@@ -88,25 +92,87 @@ int main(int argc, char** argv) {
             LOG_INFO("Configuration changed");
             });
 
+        // Place the IOCP and monitoring pools
+        auto topology = common::CpuTopology::Detect();
+
+        common::PlacementRequest placement_request;
+        placement_request.allowed_cpus = config.placement_cpus;
+        placement_request.cpu_budget = config.cpu_budget;
+        placement_request.numa_node = config.numa_node;
+        placement_request.iocp_cpus = config.iocp_cpus;
+        placement_request.worker_cpus = config.worker_cpus;
+        placement_request.iocp_threads = config.worker_threads;
+        placement_request.worker_threads = config.service_worker_threads;
+
+        auto placement_result = common::PlanPlacement(topology, placement_request);
+        if (!placement_result) {
+            LOG_FATAL("Invalid placement: " + placement_result.ErrorMessage());
+            return 1;
+        }
+
+        auto placement = placement_result.TakeValue();
+        LOG_INFO("Placement: " + std::to_string(topology.cpus.size()) + " CPUs on " +
+            std::to_string(topology.Nodes().size()) + " NUMA nodes, " +
+            common::DescribePlan(placement) + (config.pin_threads ? ", pinned" : ", unpinned"));
+
         // Create data services
         auto event_processor = std::make_shared<data::EventProcessor>();
 
         // Configure IOCP
         comm::IOCPFilterPortCommunicator::IOCPConfig iocp_config;
-        iocp_config.port_name = std::wstring(config.filter_port_name.begin(), config.filter_port_name.end());
-        iocp_config.worker_thread_count = config.worker_threads;
-        iocp_config.concurrent_operations = 2* config.worker_threads;
-        iocp_config.buffer_size = 4096;
-        iocp_config.buffer_pool_size = 4 * config.worker_threads;
+        iocp_config.worker_thread_count = placement.iocp_threads;
+        iocp_config.concurrent_operations = placement.concurrent_operations;
+        iocp_config.buffer_size = config.receive_buffer_size;
+        iocp_config.buffer_pool_size = placement.buffer_pool_size;
+        iocp_config.completion_batch_size = config.completion_batch_size;
+        iocp_config.early_reply = config.early_reply;
+        iocp_config.buffers_per_size_class = config.buffers_per_size_class;
+        iocp_config.overload_policy = config.overload_policy;
+        iocp_config.overload_deadline = std::chrono::milliseconds(config.overload_deadline_ms);
+        iocp_config.consumer_wait = config.consumer_wait;
+        iocp_config.event_lanes = config.sharded_pipeline ? placement.worker_threads : 0;
+        iocp_config.numa_node = placement.numa_node;
+        if (config.pin_threads) {
+            iocp_config.cpus = placement.iocp_cpus;
+        }
 
         LOG_INFO("IOCP Configuration:");
         LOG_INFO("  Worker threads: " + std::to_string(iocp_config.worker_thread_count));
         LOG_INFO("  Concurrent ops: " + std::to_string(iocp_config.concurrent_operations));
-        LOG_INFO("  Buffer pool: " + std::to_string(iocp_config.buffer_pool_size));
+        LOG_INFO("  Buffer pool: " + std::to_string(iocp_config.buffer_pool_size) +
+            " x " + std::to_string(iocp_config.buffer_size) + " bytes");
+        LOG_INFO("  Completion batch: " + std::to_string(iocp_config.completion_batch_size));
+        LOG_INFO("  Early reply: " + std::string(iocp_config.early_reply ? "on" : "off"));
+        LOG_INFO("  Event ring: " + std::string(config.event_ring ? "on" : "off"));
+        LOG_INFO("  Queue overload: " + std::string(common::OverloadPolicyName(iocp_config.overload_policy)) +
+            ", deadline " + std::to_string(config.overload_deadline_ms) + " ms");
+        LOG_INFO("  Consumer wait: " + std::string(common::WaitStrategyName(iocp_config.consumer_wait)));
+        LOG_INFO("  Pipeline: " + std::string(config.sharded_pipeline ?
+            "sharded, " + std::to_string(iocp_config.event_lanes) + " lanes" : "shared") +
+            ", " + std::to_string(placement.worker_threads) + " enrich threads, " +
+            (config.publish_threads ? std::to_string(config.publish_threads) + " publish threads behind " +
+                std::to_string(config.publish_queue_size) + " events" : std::string("publishing inline")));
+
+        // The driver reports \Device\HarddiskVolumeN\... paths, sinks get
+        // drive letters
+        data::WinVolumeWatcher volume_watcher(data::DevicePathTable::GetInstance());
+        auto watching = volume_watcher.Start();
+        if (!watching) {
+            LOG_WARN("Device paths are reported unmapped: " + watching.ErrorMessage());
+        }
 
         // Create comm components
-        auto event_receiver =
-            std::make_shared<comm::IOCPFilterPortCommunicator>(iocp_config);
+        auto filter_port = std::make_unique<comm::WinFilterPort>(
+            std::wstring(config.filter_port_name.begin(), config.filter_port_name.end()));
+
+        std::unique_ptr<comm::IEventRingSection> ring_section;
+        if (config.event_ring) {
+            ring_section = std::make_unique<comm::WinEventRingSection>(
+                std::wstring(config.device_path.begin(), config.device_path.end()));
+        }
+
+        auto event_receiver = std::make_shared<comm::IOCPFilterPortCommunicator>(
+            iocp_config, std::move(filter_port), std::move(ring_section));
 
         auto feeder_publisher = std::make_shared<kubearmor::rpc::FeederEventPublisher>(
             config.cluster_name,
@@ -117,7 +183,10 @@ int main(int argc, char** argv) {
             event_receiver,
             feeder_publisher,
             event_processor,
-            config.service_worker_threads);
+            placement.worker_threads,
+            config.pin_threads ? placement.worker_cpus : std::vector<uint32_t>{},
+            config.publish_threads,
+            config.publish_queue_size);
 
         g_monitoring_service = monitoring_service;
 
@@ -177,10 +246,33 @@ int main(int argc, char** argv) {
                         std::to_string(iocp_metrics.messages_per_second));
                     LOG_INFO("  Avg latency: " +
                         std::to_string(iocp_metrics.average_latency_us) + " ?s");
+                    LOG_INFO("  Dropped: " +
+                        std::to_string(iocp_metrics.dropped_messages) + " (" +
+                        std::to_string(iocp_metrics.dropped_alerts) + " alerts, " +
+                        std::to_string(iocp_metrics.dropped_logs) + " logs)");
+                    LOG_INFO("  Ring events: " +
+                        std::to_string(iocp_metrics.ring_events) + " (" +
+                        std::to_string(iocp_metrics.ring_overflows) + " overflowed to the port)");
+                    LOG_INFO("  Driver replies: " +
+                        std::to_string(iocp_metrics.replies_sent) + " (" +
+                        std::to_string(iocp_metrics.early_replies) + " early, " +
+                        std::to_string(iocp_metrics.reply_failures) + " failed), p99 " +
+                        std::to_string(iocp_metrics.reply_latency_p99_us) + " us");
+                    LOG_INFO("  Queue wait: p50 " +
+                        std::to_string(iocp_metrics.queue_wait_p50_ns / 1000) + " us, p99 " +
+                        std::to_string(iocp_metrics.queue_wait_p99_ns / 1000) + " us, p99.9 " +
+                        std::to_string(iocp_metrics.queue_wait_p999_ns / 1000) + " us, max " +
+                        std::to_string(iocp_metrics.queue_wait_max_ns / 1000) + " us");
                     LOG_INFO("  Buffers: " +
                         std::to_string(iocp_metrics.buffers_in_use) + "/" +
                         std::to_string(iocp_metrics.buffers_in_use +
                             iocp_metrics.buffers_available));
+                    auto paths = data::PathTable::GetInstance().GetStatistics();
+                    LOG_INFO("  Process paths: " +
+                        std::to_string(paths.paths) + " interned (" +
+                        std::to_string(paths.referenced) + " in use, " +
+                        std::to_string(paths.bytes / 1024) + " KB), " +
+                        std::to_string(paths.evictions) + " evicted");
                     LOG_INFO("  Events processed: " +
                         std::to_string(mon_stats.events_processed));
                     LOG_INFO("  Events published: " +
@@ -189,6 +281,26 @@ int main(int argc, char** argv) {
                         std::to_string(pub_stats.active_subscribers));
                     LOG_INFO("  Processing errors: " +
                         std::to_string(mon_stats.processing_errors));
+                    LOG_INFO("  Ordering violations: " +
+                        std::to_string(mon_stats.ordering_violations) + " (" +
+                        std::to_string(mon_stats.ordering_untracked) + " events untracked)");
+                    for (const auto& stage : monitoring_service->GetStageMetrics()) {
+                        LOG_INFO("  Stage " + std::string(stage.stage) + ": " +
+                            std::to_string(stage.workers) + " threads, queue " +
+                            std::to_string(stage.queue_depth) + "/" +
+                            std::to_string(stage.queue_capacity) + ", " +
+                            std::to_string(stage.events) + " events, service p50 " +
+                            std::to_string(stage.service_p50_ns) + " ns, p99 " +
+                            std::to_string(stage.service_p99_ns) + " ns");
+                    }
+                    for (const auto& stage : monitoring_service->GetLossLedger()) {
+                        LOG_INFO("  Ledger " + std::string(stage.stage) + ": " +
+                            std::to_string(stage.received) + " in, " +
+                            std::to_string(stage.forwarded) + " on, " +
+                            std::to_string(stage.dropped) + " dropped, " +
+                            std::to_string(stage.pending) + " pending, " +
+                            std::to_string(stage.Unaccounted()) + " unaccounted");
+                    }
                 }
                 catch (const std::exception& e) {
                     LOG_ERR("Perf monitoring error: " + std::string(e.what()));
@@ -203,6 +315,7 @@ int main(int argc, char** argv) {
         g_monitoring_service->Stop();
 
         // Cleanup
+        volume_watcher.Stop();
         config_store->StopWatching();
 
     }
@@ -1,7 +1,6 @@
 #include "rpc/feeder_event_publisher.h"
 #include "common/logger.h"
-#include <sstream>
-#include <iomanip>
+#include <optional>
 
 namespace kubearmor::rpc {
 
@@ -12,73 +11,148 @@ namespace kubearmor::rpc {
         , host_name_(host_name) {
     }
 
-    void FeederEventPublisher::Publish(const data::Event& event) {
+    namespace {
+
+        // Reused by each publishing thread, emptied after every call so no
+        // subscriber is kept alive by a stale copy
+        template<typename List>
+        List& ThreadSnapshot() {
+            thread_local List subscribers;
+            return subscribers;
+        }
+
+    } // namespace
+
+    void FeederEventPublisher::Publish(data::Event&& event) {
+        // Ours now, released on return
+        data::Event owned(std::move(event));
+
         // Publish to appropriate streams based on whether it's an alert or log
-        if (event.IsAlert()) {
+        if (owned.IsAlert()) {
             // Publish as Alert (matched a rule)
-            std::shared_lock lock(alert_subscribers_mutex_);
+            auto& alerts = ThreadSnapshot<AlertSubscriberList>();
+            SnapshotAlertSubscribers(alerts);
+            PublishAlert(owned, alerts);
+            alerts.clear();
+        }
+        else {
+            auto& logs = ThreadSnapshot<LogSubscriberList>();
+            SnapshotLogSubscribers(logs);
+            PublishLog(owned, logs);
+            logs.clear();
+        }
+    }
+
+    void FeederEventPublisher::PublishBatch(
+        std::vector<data::Event>&& events) {
+        // Subscriber lists are copied once for the batch
+        auto& alerts = ThreadSnapshot<AlertSubscriberList>();
+        auto& logs = ThreadSnapshot<LogSubscriberList>();
+        SnapshotAlertSubscribers(alerts);
+        SnapshotLogSubscribers(logs);
+
+        for (const auto& event : events) {
+            if (event.IsAlert()) {
+                PublishAlert(event, alerts);
+            }
+            else {
+                PublishLog(event, logs);
+            }
+        }
+
+        // Written out to every subscriber, release the kernel messages
+        events.clear();
+        alerts.clear();
+        logs.clear();
+    }
 
-            feeder::Alert alert = ConvertToAlert(event);
+    void FeederEventPublisher::SnapshotAlertSubscribers(AlertSubscriberList& subscribers) const {
+        std::shared_lock lock(alert_subscribers_mutex_);
+        subscribers.clear();
+        for (const auto& [id, subscriber] : alert_subscribers_) {
+            subscribers.push_back(subscriber);
+        }
+    }
 
-            for (auto& [id, subscriber] : alert_subscribers_) {
-                if (!subscriber->active) continue;
+    void FeederEventPublisher::SnapshotLogSubscribers(LogSubscriberList& subscribers) const {
+        std::shared_lock lock(log_subscribers_mutex_);
+        subscribers.clear();
+        for (const auto& [id, subscriber] : log_subscribers_) {
+            subscribers.push_back(subscriber);
+        }
+    }
 
-                if (!ShouldSendToSubscriber(event, subscriber->filter)) continue;
+    void FeederEventPublisher::PublishAlert(const data::Event& event,
+        const AlertSubscriberList& subscribers) {
+        // Built for the first subscriber that takes the event, so the
+        // event's strings are not converted when nobody reads them
+        std::optional<feeder::Alert> alert;
 
-                std::lock_guard<std::mutex> write_lock(subscriber->write_mutex);
+        for (const auto& subscriber : subscribers) {
+            if (!subscriber->active) continue;
 
-                try {
-                    if (subscriber->writer->Write(alert)) {
-                        subscriber->last_activity = std::chrono::steady_clock::now();
-                        alerts_published_++;
-                    }
-                    else {
-                        subscriber->active = false;
-                        events_dropped_++;
-                    }
+            if (!ShouldSendToSubscriber(event, subscriber->filter)) continue;
+
+            if (!alert) {
+                alert = ConvertToAlert(event);
+            }
+
+            std::lock_guard<std::mutex> write_lock(subscriber->write_mutex);
+
+            // Unsubscribed since the snapshot, its writer may be gone
+            if (!subscriber->active) continue;
+
+            try {
+                if (subscriber->writer->Write(*alert)) {
+                    subscriber->last_activity = std::chrono::steady_clock::now();
+                    alerts_published_++;
                 }
-                catch (const std::exception& e) {
-                    LOG_ERR("Error writing to alert stream: " + std::string(e.what()));
+                else {
                     subscriber->active = false;
                     events_dropped_++;
                 }
             }
-        } 
-        else {
-            std::shared_lock lock(log_subscribers_mutex_);
+            catch (const std::exception& e) {
+                LOG_ERR("Error writing to alert stream: " + std::string(e.what()));
+                subscriber->active = false;
+                events_dropped_++;
+            }
+        }
+    }
+
+    void FeederEventPublisher::PublishLog(const data::Event& event,
+        const LogSubscriberList& subscribers) {
+        std::optional<feeder::Log> log;
 
-            feeder::Log log = ConvertToLog(event);
+        for (const auto& subscriber : subscribers) {
+            if (!subscriber->active) continue;
 
-            for (auto& [id, subscriber] : log_subscribers_) {
-                if (!subscriber->active) continue;
+            if (!ShouldSendToSubscriber(event, subscriber->filter)) continue;
 
-                if (!ShouldSendToSubscriber(event, subscriber->filter)) continue;
+            if (!log) {
+                log = ConvertToLog(event);
+            }
+
+            std::lock_guard<std::mutex> write_lock(subscriber->write_mutex);
 
-                std::lock_guard<std::mutex> write_lock(subscriber->write_mutex);
+            // Unsubscribed since the snapshot, its writer may be gone
+            if (!subscriber->active) continue;
 
-                try {
-                    if (subscriber->writer->Write(log)) {
-                        subscriber->last_activity = std::chrono::steady_clock::now();
-                        logs_published_++;
-                    }
-                    else {
-                        subscriber->active = false;
-                        events_dropped_++;
-                    }
+            try {
+                if (subscriber->writer->Write(*log)) {
+                    subscriber->last_activity = std::chrono::steady_clock::now();
+                    logs_published_++;
                 }
-                catch (const std::exception& e) {
-                    LOG_ERR("Error writing to log stream: " + std::string(e.what()));
+                else {
                     subscriber->active = false;
                     events_dropped_++;
                 }
             }
-        }
-    }
-
-    void FeederEventPublisher::PublishBatch(
-        const std::vector<data::Event>& events) {
-        for (const auto& event : events) {
-            Publish(event);
+            catch (const std::exception& e) {
+                LOG_ERR("Error writing to log stream: " + std::string(e.what()));
+                subscriber->active = false;
+                events_dropped_++;
+            }
         }
     }
 
@@ -119,7 +193,7 @@ namespace kubearmor::rpc {
         std::unique_lock lock(alert_subscribers_mutex_);
 
         AlertStreamId id = next_alert_id_++;
-        auto subscriber = std::make_unique<AlertSubscriber>();
+        auto subscriber = std::make_shared<AlertSubscriber>();
         subscriber->writer = writer;
         subscriber->filter = filter;
         subscriber->active = true;
@@ -132,14 +206,24 @@ namespace kubearmor::rpc {
     }
 
     void FeederEventPublisher::UnsubscribeAlerts(AlertStreamId id) {
-        std::unique_lock lock(alert_subscribers_mutex_);
-
-        auto it = alert_subscribers_.find(id);
-        if (it != alert_subscribers_.end()) {
-            it->second->active = false;
+        std::shared_ptr<AlertSubscriber> subscriber;
+        {
+            std::unique_lock lock(alert_subscribers_mutex_);
+            auto it = alert_subscribers_.find(id);
+            if (it == alert_subscribers_.end()) {
+                return;
+            }
+            subscriber = std::move(it->second);
             alert_subscribers_.erase(it);
-            LOG_INFO("Alert subscriber unregistered: " + std::to_string(id));
         }
+
+        // Waits out a write in progress; publishers still holding it in a
+        // snapshot skip it from here on, the caller may free the writer
+        {
+            std::lock_guard<std::mutex> write_lock(subscriber->write_mutex);
+            subscriber->active = false;
+        }
+        LOG_INFO("Alert subscriber unregistered: " + std::to_string(id));
     }
 
     FeederEventPublisher::LogStreamId FeederEventPublisher::SubscribeLogs(
@@ -149,7 +233,7 @@ namespace kubearmor::rpc {
         std::unique_lock lock(log_subscribers_mutex_);
 
         LogStreamId id = next_log_id_++;
-        auto subscriber = std::make_unique<LogSubscriber>();
+        auto subscriber = std::make_shared<LogSubscriber>();
         subscriber->writer = writer;
         subscriber->filter = filter;
         subscriber->active = true;
@@ -162,14 +246,24 @@ namespace kubearmor::rpc {
     }
 
     void FeederEventPublisher::UnsubscribeLogs(LogStreamId id) {
-        std::unique_lock lock(log_subscribers_mutex_);
-
-        auto it = log_subscribers_.find(id);
-        if (it != log_subscribers_.end()) {
-            it->second->active = false;
+        std::shared_ptr<LogSubscriber> subscriber;
+        {
+            std::unique_lock lock(log_subscribers_mutex_);
+            auto it = log_subscribers_.find(id);
+            if (it == log_subscribers_.end()) {
+                return;
+            }
+            subscriber = std::move(it->second);
             log_subscribers_.erase(it);
-            LOG_INFO("Log subscriber unregistered: " + std::to_string(id));
         }
+
+        // Waits out a write in progress; publishers still holding it in a
+        // snapshot skip it from here on, the caller may free the writer
+        {
+            std::lock_guard<std::mutex> write_lock(subscriber->write_mutex);
+            subscriber->active = false;
+        }
+        LOG_INFO("Log subscriber unregistered: " + std::to_string(id));
     }
 
     feeder::Alert FeederEventPublisher::ConvertToAlert(
@@ -179,7 +273,8 @@ namespace kubearmor::rpc {
 
         // Timestamps
         alert.set_timestamp(ToUnixTimestamp(event.timestamp));
-        alert.set_updatedtime(ToFormattedTime(event.timestamp));
+        auto updated = ToFormattedTime(event.timestamp);
+        alert.set_updatedtime(updated.data(), updated.size());
 
         // Cluster/Host info
         alert.set_clustername(cluster_name_);
@@ -198,23 +293,27 @@ namespace kubearmor::rpc {
             alert.set_operation("File");
             alert.set_hostpid(fe->process_id);
             alert.set_pid(fe->process_id);
-            alert.set_processname(fe->process_path);
+            alert.set_processname(fe->process_path.str());
             alert.set_parentprocessname("");
-            alert.set_resource(fe->file_path);
-            alert.set_source(fe->process_path);
+            auto resource = fe->file_path.str();
+            alert.set_resource(resource.data(), resource.size());
+            alert.set_source(fe->process_path.str());
         }
         else if (event.IsProcessEvent()) {
             auto pe = event.GetProcessData();
             alert.set_operation("Process");
             alert.set_hostpid(pe->process_id);
             alert.set_pid(pe->process_id);
-            alert.set_processname(pe->process_path);
-            alert.set_parentprocessname(pe->parent_process_path);
-            alert.set_resource(pe->process_path);
-            alert.set_source(pe->command_line);
+            alert.set_processname(pe->process_path.str());
+            alert.set_parentprocessname(pe->parent_process_path.str());
+            alert.set_resource(pe->process_path.str());
+            auto source = pe->command_line.str();
+            alert.set_source(source.data(), source.size());
         }
         else if (event.IsNetworkEvent()) {
+            auto ne = event.GetNetworkData();
             alert.set_operation("Network");
+            alert.set_resource(FormatNetworkResource(*ne));
         }
         alert.set_policyname("");
         alert.set_severity("");
@@ -233,7 +332,8 @@ namespace kubearmor::rpc {
 
         // Timestamps
         log.set_timestamp(ToUnixTimestamp(event.timestamp));
-        log.set_updatedtime(ToFormattedTime(event.timestamp));
+        auto updated = ToFormattedTime(event.timestamp);
+        log.set_updatedtime(updated.data(), updated.size());
 
         // Cluster/Host info
         log.set_clustername(cluster_name_);
@@ -251,23 +351,27 @@ namespace kubearmor::rpc {
             log.set_operation("File");
             log.set_hostpid(fe->process_id);
             log.set_pid(fe->process_id);
-            log.set_processname(fe->process_path);
+            log.set_processname(fe->process_path.str());
             log.set_parentprocessname("");
-            log.set_resource(fe->file_path);
-            log.set_source(fe->process_path);
+            auto resource = fe->file_path.str();
+            log.set_resource(resource.data(), resource.size());
+            log.set_source(fe->process_path.str());
         }
         else if (event.IsProcessEvent()) {
             auto pe = event.GetProcessData();
             log.set_operation("Process");
             log.set_hostpid(pe->process_id);
             log.set_pid(pe->process_id);
-            log.set_processname(pe->process_path);
-            log.set_parentprocessname(pe->parent_process_path);
-            log.set_resource(pe->process_path);
-            log.set_source(pe->command_line);
+            log.set_processname(pe->process_path.str());
+            log.set_parentprocessname(pe->parent_process_path.str());
+            log.set_resource(pe->process_path.str());
+            auto source = pe->command_line.str();
+            log.set_source(source.data(), source.size());
         }
         else if (event.IsNetworkEvent()) {
+            auto ne = event.GetNetworkData();
             log.set_operation("Network");
+            log.set_resource(FormatNetworkResource(*ne));
         }
         log.set_type("HostLog");
         log.set_result(event.blocked ? "Blocked" : "Passed");
@@ -285,17 +389,25 @@ namespace kubearmor::rpc {
     int64_t FeederEventPublisher::ToUnixTimestamp(
         std::chrono::system_clock::time_point tp) {
 
-        return std::chrono::duration_cast<std::chrono::seconds>(
-            tp.time_since_epoch()).count();
+        return common::ToUnixSeconds(tp);
     }
 
-    std::string FeederEventPublisher::ToFormattedTime(
+    common::FormattedTime FeederEventPublisher::ToFormattedTime(
         std::chrono::system_clock::time_point tp) {
 
-        auto time = std::chrono::system_clock::to_time_t(tp);
-        std::ostringstream oss;
-        oss << std::put_time(std::gmtime(&time), "%Y-%m-%dT%H:%M:%SZ");
-        return oss.str();
+        return common::FormatTimestamp(tp);
+    }
+
+    std::string FeederEventPublisher::FormatNetworkResource(
+        const data::NetworkEventData& network) {
+
+        auto remote = data::FormatAddress(network.remote_address);
+
+        std::string resource = "remoteip=";
+        resource.append(remote.view());
+        resource += " port=" + std::to_string(network.remote_port);
+        resource += network.protocol == 6 ? " protocol=TCP" : network.protocol == 17 ? " protocol=UDP" : "";
+        return resource;
     }
 
 } // namespace kubearmor::rpc
\ No newline at end of file